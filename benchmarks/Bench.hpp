@@ -0,0 +1,43 @@
+#pragma once
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cstddef>
+#include <string_view>
+
+namespace Bench {
+
+    using Clock = std::chrono::steady_clock;
+
+    // Keeps the optimizer from discarding a computed value.
+    template <typename T>
+    inline void doNotOptimize(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Seconds elapsed while running `fn` once.
+    template <typename Fn>
+    auto time(Fn&& fn) -> double {
+        auto start = Clock::now();
+        fn();
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // Runs `fn` `iterations` times after a short warm-up and reports the
+    // mean cost of one call. Returns nanoseconds per call.
+    template <typename Fn>
+    auto run(std::string_view name, std::size_t iterations, Fn&& fn)
+        -> double {
+        for (std::size_t i = 0; i < iterations / 10 + 1; ++i) {
+            fn();
+        }
+        auto seconds = time([&] {
+            for (std::size_t i = 0; i < iterations; ++i) {
+                fn();
+            }
+        });
+        auto nsPerOp = seconds * 1e9 / static_cast<double>(iterations);
+        fmt::print("{:<44} {:>12.2f} ns/op\n", name, nsPerOp);
+        return nsPerOp;
+    }
+}  // namespace Bench
@@ -0,0 +1,154 @@
+// Array builtins over ten million numbers: `sum`, `indexOf` for a value
+// that is not there, `map` of a simple function, `+ - * /` by element and
+// `sort`. Each against the same work written as a loop over `a[i]` in
+// every engine, and against the builtin on a boxed array, which holds the
+// same numbers but lost its packing to a string stored once.
+
+#include "Bench.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Program.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+    constexpr std::size_t COUNT = 10'000'000;
+
+    constexpr std::string_view SUM = R"(
+print a.sum();
+)";
+
+    constexpr std::string_view SUM_LOOP = R"(
+var total = 0;
+for (var i = 0; i < a.length; i += 1) total += a[i];
+print total;
+)";
+
+    constexpr std::string_view INDEX_OF = R"(
+print a.indexOf(-1);
+)";
+
+    constexpr std::string_view INDEX_OF_LOOP = R"(
+var found = -1;
+for (var i = 0; i < a.length && found == -1; i += 1) {
+    if (a[i] == -1) found = i;
+}
+print found;
+)";
+
+    constexpr std::string_view MAP = R"(
+func f(x) { return x * 2 + 1; }
+print a.map(f).sum();
+)";
+
+    constexpr std::string_view MAP_LOOP = R"(
+func f(x) { return x * 2 + 1; }
+val b = [];
+for (var i = 0; i < a.length; i += 1) b.push(f(a[i]));
+print b.sum();
+)";
+
+    constexpr std::string_view ARITH = R"(
+print (a * 2 + a).sum();
+)";
+
+    constexpr std::string_view ARITH_LOOP = R"(
+val b = [];
+for (var i = 0; i < a.length; i += 1) b.push(a[i] * 2 + a[i]);
+print b.sum();
+)";
+
+    constexpr std::string_view SORT = R"(
+a.sort(); print a[0] + a[a.length - 1];
+)";
+
+    struct Engine {
+        std::string_view    name;
+        Interpreter::Engine engine;
+    };
+
+    constexpr Engine ENGINES[] = {
+        {"tree walker", Interpreter::Engine::TREE},
+        {"closures", Interpreter::Engine::CLOSURE},
+        {"tiered", Interpreter::Engine::TIERED},
+        {"register VM", Interpreter::Engine::VM},
+    };
+
+    // A permutation of 0 to COUNT - 1, so sorting has work to do.
+    auto makeNumbers() -> std::vector<double> {
+        std::vector<double> numbers(COUNT);
+        for (std::size_t i = 0; i < COUNT; ++i) {
+            numbers[i] = static_cast<double>(i * 7'919 % COUNT);
+        }
+        return numbers;
+    }
+
+    auto boxed(const std::vector<double>& numbers) -> Runtime::Array {
+        Runtime::Array array(numbers);
+        array.set(0, Token::Literal{std::string("boxed")});
+        array.set(0, Token::Literal{numbers[0]});
+        return array;
+    }
+
+    struct Row {
+        double      seconds;
+        std::string output;
+        bool        ok;
+    };
+
+    // Runs `script` once on a fresh copy of `a`, made before the clock
+    // starts; `sort` works in place.
+    auto run(std::string_view script, Runtime::Array a,
+             Interpreter::Engine engine) -> Row {
+        auto program = Thor::compile(script, engine);
+        auto inputs  = program.inputs();
+        inputs.set("a", Token::Literal{std::move(a)});
+        Thor::Outputs outputs;
+        auto seconds = Bench::time([&] { outputs = program.run(inputs); });
+        Bench::doNotOptimize(outputs);
+        return {seconds, outputs.output, outputs.diagnostics.empty()};
+    }
+
+    void compare(std::string_view name, std::string_view builtin,
+                 std::optional<std::string_view> loop,
+                 const std::vector<double>& numbers) {
+        fmt::print("{}: {} elements\n", name, COUNT);
+        double      baseline = 0;
+        std::string expected;
+        auto        print    = [&](std::string_view label, const Row& row) {
+            if (baseline == 0) {
+                baseline = row.seconds;
+                expected = row.output;
+            }
+            auto same = row.output == expected && row.ok;
+            fmt::print("  {:<16} {:>9.3f} s  {:>7.2f} ns/element  {:.2f}x{}\n",
+                       label, row.seconds,
+                       row.seconds * 1e9 / static_cast<double>(COUNT),
+                       baseline / row.seconds, same ? "" : "  MISMATCH");
+        };
+
+        if (loop) {
+            for (const auto& [label, engine] : ENGINES) {
+                print(std::string(label) + " loop",
+                      run(*loop, Runtime::Array(numbers), engine));
+            }
+        }
+        const auto vm = Interpreter::Engine::VM;
+        print("boxed builtin", run(builtin, boxed(numbers), vm));
+        print("packed builtin", run(builtin, Runtime::Array(numbers), vm));
+    }
+}  // namespace
+
+auto main() -> int {
+    auto numbers = makeNumbers();
+    compare("sum", SUM, SUM_LOOP, numbers);
+    compare("indexOf absent", INDEX_OF, INDEX_OF_LOOP, numbers);
+    compare("map", MAP, MAP_LOOP, numbers);
+    compare("a * 2 + a", ARITH, ARITH_LOOP, numbers);
+    compare("sort", SORT, std::nullopt, numbers);
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Runs a directory of short generated scripts in batch mode with 1..N
+// workers. Given the path to the Thor executable, it also measures the
+// one-process-per-script baseline the batch mode replaces:
+//
+//   bench_batch ./bin/Thor
+
+#include "Bench.hpp"
+#include "Thor/Batch.hpp"
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+extern char** environ;
+
+namespace {
+
+    constexpr std::size_t SCRIPTS = 1'000;
+
+    auto makeScripts(const std::filesystem::path& directory)
+        -> std::vector<std::filesystem::path> {
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        for (std::size_t i = 0; i < SCRIPTS; ++i) {
+            std::ofstream script(directory / fmt::format("s{:04}.krp", i));
+            for (std::size_t line = 0; line < 10 + i % 20; ++line) {
+                script << fmt::format(
+                    "print $\"{}: {{({} + 1.5) * 3}}\" + \" done\";\n", i,
+                    line);
+            }
+        }
+        return Runtime::findScripts(directory);
+    }
+
+    // Spawns `thor script` for every script, one after the other, with
+    // output sent to /dev/null.
+    auto runProcesses(const std::string&                        thor,
+                      const std::vector<std::filesystem::path>& scripts)
+        -> double {
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null",
+                                         O_WRONLY, 0);
+        auto seconds = Bench::time([&] {
+            for (const auto& script : scripts) {
+                auto  path   = script.string();
+                char* argv[] = {const_cast<char*>(thor.c_str()),
+                                const_cast<char*>(path.c_str()), nullptr};
+                pid_t pid    = 0;
+                if (posix_spawn(&pid, thor.c_str(), &actions, nullptr, argv,
+                                environ) == 0) {
+                    waitpid(pid, nullptr, 0);
+                }
+            }
+        });
+        posix_spawn_file_actions_destroy(&actions);
+        return seconds;
+    }
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+    auto directory =
+        std::filesystem::temp_directory_path() / "thor_bench_batch";
+    auto scripts   = makeScripts(directory);
+    auto perSecond = [&scripts](double seconds) {
+        return static_cast<double>(scripts.size()) / seconds;
+    };
+
+    fmt::print("{} scripts, {} hardware threads\n", scripts.size(),
+               std::thread::hardware_concurrency());
+    if (argc > 1) {
+        // Thor writes its log file to the working directory.
+        auto thor = std::filesystem::absolute(argv[1]).string();
+        std::filesystem::current_path(directory);
+        fmt::print("  one process per script {:>10.1f} scripts/s\n",
+                   perSecond(runProcesses(thor, scripts)));
+    }
+    for (std::size_t workers = 1; workers <= 8; workers *= 2) {
+        auto report = Runtime::runBatch(scripts, workers);
+        Bench::doNotOptimize(report);
+        fmt::print("  batch, {} workers       {:>10.1f} scripts/s\n", workers,
+                   perSecond(report.seconds));
+    }
+    std::filesystem::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,178 @@
+// Closure-heavy callback code per engine: a closure made per iteration
+// and called once, a callback handed to a higher-order function, and a
+// counter whose captured variable is assigned, so shared through a cell.
+//
+// Then memory: a chain of 20k closures, each capturing only the one
+// before it out of a frame of ten locals. A closure keeps only what
+// it captures, so what each one retains is printed next to the frame it
+// would keep alive if closures held on to their caller's locals.
+
+#include "Bench.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Program.hpp"
+
+#include <malloc.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+
+namespace {
+
+    // Bytes the heap has handed out and not had back, and the most it has.
+    std::size_t live = 0;
+    std::size_t peak = 0;
+}  // namespace
+
+auto operator new(std::size_t size) -> void* {
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    live += malloc_usable_size(memory);
+    peak  = live > peak ? live : peak;
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    if (memory != nullptr) {
+        live -= malloc_usable_size(memory);
+        std::free(memory);
+    }
+}
+
+void operator delete(void* memory, std::size_t /*size*/) noexcept {
+    operator delete(memory);
+}
+
+namespace {
+
+    constexpr double COUNT = 2'000'000;
+    constexpr double CHAIN = 20'000;
+    constexpr double FRAME = 10;  // Locals of `build` below
+
+    constexpr std::string_view MAKE = R"(
+func make(n) {
+    var total = 0;
+    for (var i = 0; i < n; i += 1) {
+        val k = i;
+        func add(x) { return x + k; }
+        total += add(1);
+    }
+    return total;
+}
+print make(n);
+)";
+
+    constexpr std::string_view CALLBACK = R"(
+func each(n, callback) {
+    var total = 0;
+    for (var i = 0; i < n; i += 1) total += callback(i);
+    return total;
+}
+func scaled(n) {
+    val scale = 3;
+    val offset = 1;
+    func step(i) { return i * scale + offset; }
+    return each(n, step);
+}
+print scaled(n);
+)";
+
+    constexpr std::string_view COUNTER = R"(
+func counter() {
+    var count = 0;
+    func next() { count += 1; return count; }
+    return next;
+}
+val next = counter();
+for (var i = 0; i < n; i += 1) next();
+print next();
+)";
+
+    constexpr std::string_view RETAINED = R"(
+func build(n) {
+    var last = nil;
+    for (var i = 0; i < n; i += 1) {
+        val previous = last;
+        val a = i;
+        val b = i + 1;
+        val c = i + 2;
+        val d = i + 3;
+        val e = i + 4;
+        func link() { return previous; }
+        last = link;
+    }
+    return last;
+}
+val chain = build(n);
+print chain() != nil;
+)";
+
+    struct Engine {
+        std::string_view    name;
+        Interpreter::Engine engine;
+    };
+
+    constexpr Engine ENGINES[] = {
+        {"tree walker", Interpreter::Engine::TREE},
+        {"closures", Interpreter::Engine::CLOSURE},
+        {"tiered", Interpreter::Engine::TIERED},
+        {"register VM", Interpreter::Engine::VM},
+    };
+
+    void compare(std::string_view name, std::string_view script, double n) {
+        fmt::print("{}: {:.0f} iterations\n", name, n);
+
+        double      tree = 0;
+        std::string expected;
+        for (const auto& [label, engine] : ENGINES) {
+            auto          program = Thor::compile(script, engine);
+            Thor::Outputs outputs;
+            auto          seconds = Bench::time([&] {
+                auto inputs = program.inputs();
+                inputs.set("n", Token::Literal{n});
+                outputs = program.run(inputs);
+            });
+            Bench::doNotOptimize(outputs);
+            if (tree == 0) {
+                tree     = seconds;
+                expected = outputs.output;
+            }
+            auto same =
+                outputs.output == expected && outputs.diagnostics.empty();
+            fmt::print("  {:<12} {:>9.3f} s  {:>7.2f} ns/iter  {:.2f}x{}\n",
+                       label, seconds, seconds * 1e9 / n, tree / seconds,
+                       same ? "" : "  MISMATCH");
+        }
+    }
+
+    // Heap each closure of the chain holds at its longest, per engine.
+    void retained() {
+        fmt::print("retained: {:.0f} closures, a frame of {:.0f} locals is "
+                   "{:.0f} bytes\n",
+                   CHAIN, FRAME, FRAME * sizeof(Token::Literal));
+        for (const auto& [label, engine] : ENGINES) {
+            auto program = Thor::compile(RETAINED, engine);
+            auto inputs  = program.inputs();
+            inputs.set("n", Token::Literal{CHAIN});
+            auto before  = live;
+            peak         = live;
+            auto outputs = program.run(inputs);
+            auto same    = outputs.output == "true\n";
+            fmt::print("  {:<12} {:>7.1f} bytes/closure{}\n", label,
+                       static_cast<double>(peak - before) / CHAIN,
+                       same ? "" : "  MISMATCH");
+        }
+    }
+}  // namespace
+
+auto main() -> int {
+    compare("closure per iteration", MAKE, COUNT);
+    compare("callback", CALLBACK, COUNT);
+    compare("counter through a cell", COUNTER, COUNT);
+    retained();
+    return 0;
+}
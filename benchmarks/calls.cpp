@@ -0,0 +1,103 @@
+// Call throughput per engine: the naive fib(30), Ackermann's function
+// A(2, 1000), whose calls nest 2000 deep, and a tail-recursive count to
+// 10M, which only finishes because tail calls reuse their frame.
+//
+// Every engine runs the same compiled program and has to print the same
+// result. The limits frames run under are printed first: the tree walker
+// and closures recurse on the native stack for each call, the register
+// machine only on the value stack.
+
+#include "Bench.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Program.hpp"
+#include "Thor/Stack.hpp"
+
+#include <string>
+#include <string_view>
+
+namespace {
+
+    constexpr double FIB       = 30;
+    constexpr double FIB_CALLS = 2'692'537;  // fib(30) calls, itself included
+    constexpr double ACK_N     = 1000;
+    constexpr double COUNT     = 10'000'000;
+
+    constexpr std::string_view FIBONACCI = R"(
+func fib(n) {
+    if (n < 2) return n;
+    return fib(n - 1) + fib(n - 2);
+}
+print fib(n);
+)";
+
+    constexpr std::string_view ACKERMANN = R"(
+func ack(m, n) {
+    if (m == 0) return n + 1;
+    if (n == 0) return ack(m - 1, 1);
+    return ack(m - 1, ack(m, n - 1));
+}
+print ack(2, n);
+)";
+
+    constexpr std::string_view TAIL = R"(
+func count(n, total) {
+    if (n == 0) return total;
+    return count(n - 1, total + 1);
+}
+print count(n, 0);
+)";
+
+    struct Engine {
+        std::string_view    name;
+        Interpreter::Engine engine;
+    };
+
+    constexpr Engine ENGINES[] = {
+        {"tree walker", Interpreter::Engine::TREE},
+        {"closures", Interpreter::Engine::CLOSURE},
+        {"tiered", Interpreter::Engine::TIERED},
+        {"register VM", Interpreter::Engine::VM},
+    };
+
+    void compare(std::string_view name, std::string_view script, double n,
+                 double calls) {
+        fmt::print("{}: {:.0f} calls\n", name, calls);
+
+        double      tree = 0;
+        std::string expected;
+        for (const auto& [label, engine] : ENGINES) {
+            auto          program = Thor::compile(script, engine);
+            Thor::Outputs outputs;
+            auto          seconds = Bench::time([&] {
+                auto inputs = program.inputs();
+                inputs.set("n", Token::Literal{n});
+                outputs = program.run(inputs);
+            });
+            Bench::doNotOptimize(outputs);
+            if (tree == 0) {
+                tree     = seconds;
+                expected = outputs.output;
+            }
+            auto same =
+                outputs.output == expected && outputs.diagnostics.empty();
+            fmt::print("  {:<12} {:>9.3f} s  {:>7.2f} ns/call  {:.2f}x{}\n",
+                       label, seconds, seconds * 1e9 / calls, tree / seconds,
+                       same ? "" : "  MISMATCH");
+        }
+    }
+
+    // Calls A(2, n) makes, itself included.
+    auto ackermannCalls(double n) -> double {
+        return 2 * n * n + 7 * n + 5;
+    }
+}  // namespace
+
+auto main() -> int {
+    const auto& limits = Interpreter::limits();
+    fmt::print("limits: {} value slots, {} KiB of native stack\n",
+               limits.slots, limits.nativeBytes / 1024);
+    compare("fib(30)", FIBONACCI, FIB, FIB_CALLS);
+    compare("ack(2, 1000)", ACKERMANN, ACK_N, ackermannCalls(ACK_N));
+    compare("tail count", TAIL, COUNT, COUNT + 1);
+    return 0;
+}
@@ -0,0 +1,78 @@
+// Runs an `examples/exprs.krp`-style script, scaled up to a few thousand
+// statements, with the tree-walking interpreter and the closure engine.
+// Each compiles the script once and runs it with an input `n` bound per
+// run.
+
+#include "Bench.hpp"
+#include "Thor/Closure.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Lexer.hpp"
+#include "Thor/Parser.hpp"
+#include "Thor/Program.hpp"
+
+#include <string>
+
+namespace {
+
+    constexpr std::size_t COPIES = 500;
+    constexpr std::size_t RUNS   = 200;
+
+    auto makeScript() -> std::string {
+        std::string script;
+        for (std::size_t i = 0; i < COPIES; ++i) {
+            script += fmt::format(
+                "var a{0} = (5 + (n + {0}) * 2 ** 2 - -1) >> 1 & 7 | 15 ^ 10;\n"
+                "var b{0} = a{0} * 4 - n / 2 + (a{0} % 3);\n"
+                "var c{0} = a{0} > b{0} && b{0} != 0 || !(a{0} == 3);\n"
+                "var d{0} = c{0} ? b{0} * 2 : a{0} - b{0};\n"
+                "\"label \" + d{0} == \"label 4\";\n"
+                "(a{0} + b{0}) * (d{0} - 1) <= 1000;\n",
+                i);
+        }
+        script += "print d0 + d1;\n";
+        return script;
+    }
+
+    auto measure(const std::string& script, Interpreter::Engine engine)
+        -> double {
+        Runtime::Context context;
+        auto             program = Thor::compile(script, engine);
+        return Bench::time([&] {
+            for (std::size_t i = 0; i < RUNS; ++i) {
+                auto inputs = program.inputs();
+                inputs.set("n", Token::Literal{static_cast<double>(i % 9)});
+                Bench::doNotOptimize(program.run(context, inputs));
+            }
+        });
+    }
+}  // namespace
+
+auto main() -> int {
+    auto script  = makeScript();
+    auto tree    = measure(script, Interpreter::Engine::TREE);
+    auto closure = measure(script, Interpreter::Engine::CLOSURE);
+
+    // What the command line pays to compile before running once.
+    Runtime::Context context;
+    Thor::Lexer      lexer(context);
+    Parser::Parser   parser(context);
+    auto             tokens     = lexer.tokenize(script);
+    auto             statements = parser.parse(tokens);
+    constexpr std::size_t COMPILES = 20;
+    auto                  compile  = Bench::time([&] {
+        for (std::size_t i = 0; i < COMPILES; ++i) {
+            Bench::doNotOptimize(Closure::compile(statements));
+        }
+    });
+
+    auto perRun = [](double seconds) {
+        return seconds * 1e3 / static_cast<double>(RUNS);
+    };
+    fmt::print("{} statements, {} runs\n", statements.size(), RUNS);
+    fmt::print("  tree walker     {:>8.3f} ms/run\n", perRun(tree));
+    fmt::print("  closures        {:>8.3f} ms/run  {:.2f}x\n",
+               perRun(closure), tree / closure);
+    fmt::print("  closure compile {:>8.3f} ms once\n",
+               compile * 1e3 / static_cast<double>(COMPILES));
+    return 0;
+}
@@ -0,0 +1,58 @@
+// Runs a small script repeatedly on 1..64 threads, each with its own
+// runtime context, and reports throughput relative to one thread. Contexts
+// share no mutable state, so scaling is bounded by the number of cores.
+
+#include "Bench.hpp"
+#include "Thor/Thor.hpp"
+
+#include <thread>
+#include <vector>
+
+namespace {
+
+    constexpr std::size_t RUNS_PER_THREAD = 2'000;
+
+    constexpr std::string_view SCRIPT =
+        "print \"total: \" + \"items\";\n"
+        "print (1 + 2.5) * 4 - 6 / 3;\n"
+        "print $\"{7 * 6} and {1 < 2}\";\n"
+        "print !(3 >= 4) == true;\n";
+
+    void runScripts() {
+        Runtime::Context         context;
+        Thor::Lexer              lexer(context);
+        Parser::Parser           parser(context);
+        Interpreter::Interpreter interpreter(context);
+        for (std::size_t run = 0; run < RUNS_PER_THREAD; ++run) {
+            std::string source(SCRIPT);
+            auto        tokens = lexer.tokenize(source);
+            interpreter.interpret(parser.parse(tokens));
+            Bench::doNotOptimize(context.output().takeCaptured());
+        }
+    }
+}  // namespace
+
+auto main() -> int {
+    fmt::print("{} hardware threads\n", std::thread::hardware_concurrency());
+
+    double single = 0;
+    for (std::size_t threads = 1; threads <= 64; threads *= 2) {
+        auto seconds = Bench::time([threads] {
+            std::vector<std::thread> workers;
+            for (std::size_t i = 0; i < threads; ++i) {
+                workers.emplace_back(runScripts);
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        });
+        auto perSecond =
+            static_cast<double>(threads * RUNS_PER_THREAD) / seconds;
+        if (threads == 1) {
+            single = perSecond;
+        }
+        fmt::print("{:>3} threads {:>12.0f} scripts/s {:>6.2f}x\n", threads,
+                   perSecond, perSecond / single);
+    }
+    return 0;
+}
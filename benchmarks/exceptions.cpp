@@ -0,0 +1,153 @@
+// try/catch per engine, on both paths. Not throwing: a hot loop whose
+// body is wrapped in a try, and one calling a function whose body is,
+// against the same loops without the try; entering a try should cost
+// nothing. Throwing: every iteration throws from the bottom of a recursion
+// `depth` calls deep and catches it at the top, against the same recursion
+// returning, so the difference is what a throw costs over a return,
+// unwinding included.
+
+#include "Bench.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Program.hpp"
+
+#include <string>
+#include <string_view>
+
+namespace {
+
+    constexpr double COUNT  = 200'000;
+    constexpr double THROWS = 50'000;
+
+    struct Engine {
+        std::string_view    name;
+        Interpreter::Engine engine;
+    };
+
+    constexpr Engine ENGINES[] = {
+        {"tree walker", Interpreter::Engine::TREE},
+        {"closures", Interpreter::Engine::CLOSURE},
+        {"tiered", Interpreter::Engine::TIERED},
+        {"register VM", Interpreter::Engine::VM},
+    };
+
+    constexpr std::string_view PLAIN_LOOP = R"(
+var total = 0;
+for (var i = 0; i < n; i += 1) {
+    total += i % 7;
+}
+print total;
+)";
+
+    constexpr std::string_view TRY_LOOP = R"(
+var total = 0;
+for (var i = 0; i < n; i += 1) {
+    try {
+        total += i % 7;
+    } catch (e) {
+        total = -1;
+    }
+}
+print total;
+)";
+
+    constexpr std::string_view PLAIN_CALL = R"(
+func step(i) {
+    return i % 7;
+}
+var total = 0;
+for (var i = 0; i < n; i += 1) total += step(i);
+print total;
+)";
+
+    constexpr std::string_view TRY_CALL = R"(
+func step(i) {
+    try {
+        return i % 7;
+    } catch (e) {
+        return -1;
+    }
+}
+var total = 0;
+for (var i = 0; i < n; i += 1) total += step(i);
+print total;
+)";
+
+    // `down(depth, i)` returns `i` from the bottom of the recursion, or
+    // throws it; not as a tail call, so each level keeps its frame.
+    auto recursion(bool throws) -> std::string {
+        return std::string("func down(d, i) {\n    if (d == 0) ") +
+               (throws ? "throw i;\n" : "return i;\n") +
+               "    val found = down(d - 1, i);\n    return found;\n}\n"
+               "var total = 0;\n"
+               "for (var i = 0; i < n; i += 1) {\n"
+               "    try {\n        total += down(depth, i);\n"
+               "    } catch (e) {\n        total += e;\n    }\n}\n"
+               "print total;\n";
+    }
+
+    auto measure(const Thor::Program& program, double n, double depth,
+                 std::string& output) -> double {
+        Thor::Outputs outputs;
+        auto          seconds = Bench::time([&] {
+            auto inputs = program.inputs();
+            inputs.set("n", Token::Literal{n});
+            inputs.set("depth", Token::Literal{depth});
+            outputs = program.run(inputs);
+        });
+        Bench::doNotOptimize(outputs);
+        output = outputs.diagnostics.empty() ? outputs.output : "";
+        return seconds;
+    }
+
+    // The same work, with and without a try around it.
+    void overhead(std::string_view name, std::string_view plain,
+                  std::string_view guarded) {
+        fmt::print("{}: {:.0f} iterations, nothing thrown\n", name, COUNT);
+        fmt::print("  {:<12} {:>10} {:>10} {:>10}\n", "", "plain ns",
+                   "try ns", "overhead");
+        for (const auto& [engineName, engine] : ENGINES) {
+            auto        without = Thor::compile(plain, engine);
+            auto        with    = Thor::compile(guarded, engine);
+            std::string bare;
+            std::string tried;
+            auto        plainSeconds = measure(without, COUNT, 0, bare);
+            auto        trySeconds   = measure(with, COUNT, 0, tried);
+            fmt::print("  {:<12} {:>10.1f} {:>10.1f} {:>9.1f}%{}\n",
+                       engineName, plainSeconds * 1e9 / COUNT,
+                       trySeconds * 1e9 / COUNT,
+                       (trySeconds / plainSeconds - 1) * 100,
+                       !bare.empty() && bare == tried ? "" : "  MISMATCH");
+        }
+    }
+
+    void throwing(double depth) {
+        auto returnScript = recursion(false);
+        auto throwScript  = recursion(true);
+        fmt::print("throwing: {:.0f} throws from {:.0f} calls deep\n", THROWS,
+                   depth);
+        fmt::print("  {:<12} {:>10} {:>10} {:>10}\n", "", "return ns",
+                   "throw ns", "per throw");
+        for (const auto& [engineName, engine] : ENGINES) {
+            auto        returning = Thor::compile(returnScript, engine);
+            auto        thrown    = Thor::compile(throwScript, engine);
+            std::string byReturn;
+            std::string byThrow;
+            auto        returned = measure(returning, THROWS, depth, byReturn);
+            auto        threw    = measure(thrown, THROWS, depth, byThrow);
+            fmt::print("  {:<12} {:>10.1f} {:>10.1f} {:>10.1f}{}\n",
+                       engineName, returned * 1e9 / THROWS,
+                       threw * 1e9 / THROWS, (threw - returned) * 1e9 / THROWS,
+                       !byReturn.empty() && byReturn == byThrow
+                           ? ""
+                           : "  MISMATCH");
+        }
+    }
+}  // namespace
+
+auto main() -> int {
+    overhead("try around a loop body", PLAIN_LOOP, TRY_LOOP);
+    overhead("try in a called function", PLAIN_CALL, TRY_CALL);
+    throwing(0);
+    throwing(32);
+    return 0;
+}
@@ -0,0 +1,183 @@
+// Runtime::HashMap against std::unordered_map at 10 to 10M entries:
+// inserting every key, looking each up in a shuffled order, iterating
+// over all of them, and erasing them in another order. Integer keys, so
+// both maps hash alike and the difference is the layout.
+//
+// Then names, as dictionary objects and globals key them: text hashed at
+// every lookup in std::unordered_map<std::string>, next to symbols, which
+// carry a hash worked out when they were interned.
+
+#include "Bench.hpp"
+#include "Thor/HashMap.hpp"
+#include "Thor/Symbol.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+    // Operations each measurement does at least, over as many rounds.
+    constexpr std::size_t WORK = 10'000'000;
+
+    constexpr std::size_t SIZES[] = {10, 1'000, 100'000, 1'000'000,
+                                     10'000'000};
+
+    constexpr std::size_t NAMES = 1'000;
+
+    struct Times {
+        double insert  = 0;
+        double lookup  = 0;
+        double iterate = 0;
+        double erase   = 0;
+    };
+
+    // Nanoseconds per key for each operation on a `Map`, filled from
+    // `keys` and looked up and erased in the order of `shuffled`. `total`
+    // iterates, adding up the values.
+    template <typename Map, typename Insert, typename Find, typename Total,
+              typename Erase>
+    auto measure(const std::vector<std::uint64_t>& keys,
+                 const std::vector<std::uint64_t>& shuffled, Insert insert,
+                 Find find, Total total, Erase erase) -> Times {
+        auto          rounds = std::max<std::size_t>(1, WORK / keys.size());
+        Times         times;
+        std::uint64_t sum = 0;
+        for (std::size_t round = 0; round < rounds; ++round) {
+            Map map;
+            times.insert += Bench::time([&] {
+                for (auto key : keys) {
+                    insert(map, key);
+                }
+            });
+            times.lookup += Bench::time([&] {
+                for (auto key : shuffled) {
+                    sum += find(map, key);
+                }
+            });
+            times.iterate += Bench::time([&] { sum += total(map); });
+            times.erase += Bench::time([&] {
+                for (auto key : shuffled) {
+                    erase(map, key);
+                }
+            });
+        }
+        Bench::doNotOptimize(sum);
+        auto scale = 1e9 / static_cast<double>(rounds * keys.size());
+        return {times.insert * scale, times.lookup * scale,
+                times.iterate * scale, times.erase * scale};
+    }
+
+    using Flat = Runtime::HashMap<std::uint64_t, std::uint64_t>;
+    using Node = std::unordered_map<std::uint64_t, std::uint64_t>;
+
+    void compare(std::size_t size) {
+        std::vector<std::uint64_t> keys(size);
+        std::mt19937_64            random(size);
+        for (auto& key : keys) {
+            key = random();
+        }
+        auto shuffled = keys;
+        std::shuffle(shuffled.begin(), shuffled.end(), random);
+
+        auto flat = measure<Flat>(
+            keys, shuffled,
+            [](Flat& map, std::uint64_t key) { map.tryEmplace(key, key); },
+            [](const Flat& map, std::uint64_t key) { return *map.find(key); },
+            [](const Flat& map) {
+                std::uint64_t sum = 0;
+                for (const auto& entry : map) {
+                    sum += entry.value;
+                }
+                return sum;
+            },
+            [](Flat& map, std::uint64_t key) { map.erase(key); });
+        auto node = measure<Node>(
+            keys, shuffled,
+            [](Node& map, std::uint64_t key) { map.try_emplace(key, key); },
+            [](const Node& map, std::uint64_t key) {
+                return map.find(key)->second;
+            },
+            [](const Node& map) {
+                std::uint64_t sum = 0;
+                for (const auto& entry : map) {
+                    sum += entry.second;
+                }
+                return sum;
+            },
+            [](Node& map, std::uint64_t key) { map.erase(key); });
+
+        fmt::print("{} entries (ns/entry)      HashMap  unordered_map\n",
+                   size);
+        auto row = [](std::string_view name, double flat, double node) {
+            fmt::print("  {:<24} {:>9.2f} {:>14.2f}  {:.2f}x\n", name, flat,
+                       node, node / flat);
+        };
+        row("insert", flat.insert, node.insert);
+        row("lookup", flat.lookup, node.lookup);
+        row("iterate", flat.iterate, node.iterate);
+        row("erase", flat.erase, node.erase);
+    }
+
+    // Lookups of NAMES field names, once by text and once by symbol.
+    void names() {
+        std::vector<std::string> texts(NAMES);
+        for (std::size_t i = 0; i < NAMES; ++i) {
+            texts[i] = "field_name_" + std::to_string(i);
+        }
+        std::vector<Runtime::Symbol> symbols;
+        for (const auto& text : texts) {
+            symbols.push_back(Runtime::Symbol::intern(text));
+        }
+        std::vector<std::size_t> order(NAMES);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), std::mt19937_64(NAMES));
+
+        std::unordered_map<std::string, double> byText;
+        Runtime::HashMap<Runtime::Symbol, double, Runtime::Symbol::Hash>
+            bySymbol;
+        for (std::size_t i = 0; i < NAMES; ++i) {
+            byText.emplace(texts[i], double(i));
+            bySymbol.tryEmplace(symbols[i], double(i));
+        }
+
+        auto   rounds = WORK / NAMES;
+        double sum    = 0;
+        auto   text   = Bench::time([&] {
+            for (std::size_t round = 0; round < rounds; ++round) {
+                for (auto i : order) {
+                    sum += byText.find(texts[i])->second;
+                }
+            }
+        });
+        auto symbol = Bench::time([&] {
+            for (std::size_t round = 0; round < rounds; ++round) {
+                for (auto i : order) {
+                    sum += *bySymbol.find(symbols[i]);
+                }
+            }
+        });
+        Bench::doNotOptimize(sum);
+
+        auto scale = 1e9 / static_cast<double>(rounds * NAMES);
+        fmt::print("{} names, lookup (ns)\n", NAMES);
+        fmt::print("  {:<24} {:>9.2f}\n", "unordered_map<string>",
+                   text * scale);
+        fmt::print("  {:<24} {:>9.2f}  {:.2f}x\n", "HashMap<Symbol>",
+                   symbol * scale, text / symbol);
+    }
+}  // namespace
+
+auto main() -> int {
+    for (auto size : SIZES) {
+        compare(size);
+    }
+    names();
+    return 0;
+}
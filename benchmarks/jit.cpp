@@ -0,0 +1,64 @@
+// Arithmetic kernels evaluated one million times each with fresh inputs:
+// the tree-walking interpreter against the same trees once the JIT has
+// compiled them.
+
+#include "Bench.hpp"
+#include "Thor/Columnar.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Jit.hpp"
+
+#include <array>
+
+namespace {
+
+    constexpr std::size_t RUNS = 1'000'000;
+
+    constexpr std::array<std::string_view, 4> KERNELS = {
+        "a * b + c * d - a / (b + 1)",
+        "(a + b) * (c - d) > 100 ? a * 2 + c : b * 3 - d",
+        "((a * a + b * b) ** 0.5 < c || d > 5) && a != b",
+        "((a & 255) | (b << 2)) % 7 + (c >> 1)",
+    };
+
+    // Seconds for RUNS evaluations of `source` under `mode`, on a tree
+    // parsed for this run alone so no compiled code carries over.
+    auto measure(std::string_view source, Jit::Mode mode, double& sum)
+        -> double {
+        Runtime::Context context;
+        auto expr = Columnar::parseExpression(context, std::string(source));
+        Interpreter::Interpreter interpreter(context);
+        auto bind = [&](std::uint32_t slot, std::size_t value) {
+            interpreter.bind(slot, Token::Literal{static_cast<double>(value)});
+        };
+        Jit::setMode(mode);
+        auto seconds = Bench::time([&] {
+            for (std::size_t i = 0; i < RUNS; ++i) {
+                bind(0, i % 97);
+                bind(1, i % 13);
+                bind(2, i % 7);
+                bind(3, i % 11);
+                auto value = interpreter.evaluate(expr);
+                sum += value.isNumber() ? value.asNumber()
+                                        : static_cast<double>(value.asBool());
+            }
+        });
+        Jit::setMode(Jit::Mode::OFF);
+        return seconds;
+    }
+}  // namespace
+
+auto main() -> int {
+    double sum = 0;
+    fmt::print("{} evaluations per kernel, ns per evaluation{}\n", RUNS,
+               Jit::available() ? "" : " (no JIT on this platform)");
+    fmt::print("  {:<50} {:>8} {:>8} {:>8}\n", "kernel", "tree", "jit",
+               "speedup");
+    for (auto kernel : KERNELS) {
+        auto tree = measure(kernel, Jit::Mode::OFF, sum);
+        auto jit  = measure(kernel, Jit::Mode::ON, sum);
+        fmt::print("  {:<50} {:>8.1f} {:>8.1f} {:>7.1f}x\n", kernel,
+                   tree * 1e9 / RUNS, jit * 1e9 / RUNS, tree / jit);
+    }
+    Bench::doNotOptimize(sum);
+    return 0;
+}
@@ -0,0 +1,59 @@
+// Lexes and parses a large generated script with the runtime log level at
+// WARN, so every DEBUG/INFO call site is filtered out. Build with
+// -DTHOR_MIN_LOG_LEVEL=WARN to compile those call sites out entirely.
+
+#include "Bench.hpp"
+#include "Thor/Parser.hpp"
+
+namespace {
+
+    constexpr std::size_t LINES  = 20'000;
+    constexpr std::size_t ROUNDS = 10;
+
+    auto makeSource() -> std::string {
+        std::string source;
+        for (std::size_t i = 0; i < LINES; ++i) {
+            source += fmt::format(
+                "print (({} + {}.5) * -{} - {} / 2) ** 2 == \"item {}\" || "
+                "!({} < {});\n",
+                i, i % 97, i % 13, i * 3, i, i, i % 7);
+        }
+        return source;
+    }
+}  // namespace
+
+auto main() -> int {
+    Logger::getLogger().setLevel(Logger::LogLevel::WARN);
+
+    auto        source     = makeSource();
+    std::size_t tokens     = 0;
+    std::size_t statements = 0;
+    double      lexing     = 0;
+    double      parsing    = 0;
+    for (std::size_t round = 0; round < ROUNDS; ++round) {
+        Thor::Lexer               lexer;
+        Parser::Parser            parser;
+        auto                      copy = source;
+        std::vector<Token::Token> lexed;
+        std::vector<Stmt::Stmt>   parsed;
+        lexing += Bench::time([&] { lexed = lexer.tokenize(copy); });
+        parsing += Bench::time([&] { parsed = parser.parse(lexed); });
+        tokens += lexed.size();
+        statements += parsed.size();
+        Bench::doNotOptimize(parsed);
+    }
+
+    auto perToken = [tokens](double seconds) {
+        return seconds * 1e9 / static_cast<double>(tokens);
+    };
+    fmt::print("lex+parse {} bytes, {} statements x {} (compiled-in minimum "
+               "level {})\n",
+               source.size(), statements / ROUNDS, ROUNDS, THOR_MIN_LOG_LEVEL);
+    fmt::print("  lex   {:>8.1f} ms/round {:>7.1f} ns/token\n",
+               lexing * 1e3 / ROUNDS, perToken(lexing));
+    fmt::print("  parse {:>8.1f} ms/round {:>7.1f} ns/token\n",
+               parsing * 1e3 / ROUNDS, perToken(parsing));
+    fmt::print("  total {:>8.1f} ms/round {:>7.1f} ns/token\n",
+               (lexing + parsing) * 1e3 / ROUNDS, perToken(lexing + parsing));
+    return 0;
+}
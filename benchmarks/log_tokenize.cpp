@@ -0,0 +1,93 @@
+// Tokenizes a large generated script with DEBUG logging on (one log line
+// per token), with the synchronous logger and with the asynchronous one.
+// Log lines go to /dev/null and to a log file (argv[1], default
+// /tmp/bench_log_tokenize.log); timings are reported on stderr.
+
+#include "Bench.hpp"
+#include "Thor/Lexer.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+    constexpr std::size_t LINES  = 20'000;
+    constexpr std::size_t ROUNDS = 5;
+
+    auto makeSource() -> std::string {
+        std::string source;
+        for (std::size_t i = 0; i < LINES; ++i) {
+            source += fmt::format(
+                "print ({} + {}.5) * \"item {}\" == {} and !false;\n", i,
+                i % 97, i, i * 3);
+        }
+        return source;
+    }
+
+    struct Timing {
+        double      tokenize;  // Time spent in the lexer (the caller)
+        double      total;     // Until every line has been written
+        std::size_t tokens;
+    };
+
+    auto run(Logger::Mode mode, const std::string& source) -> Timing {
+        auto& logger = Logger::getLogger();
+        logger.setMode(mode);
+
+        Timing timing{0, 0, 0};
+        for (std::size_t round = 0; round < ROUNDS; ++round) {
+            auto start = Bench::Clock::now();
+            {
+                Thor::Lexer lexer;
+                auto        copy   = source;
+                auto        tokens = lexer.tokenize(copy);
+                timing.tokens += tokens.size();
+                Bench::doNotOptimize(tokens);
+            }
+            auto lexed = Bench::Clock::now();
+            logger.flush();
+            auto done = Bench::Clock::now();
+
+            timing.tokenize +=
+                std::chrono::duration<double>(lexed - start).count();
+            timing.total += std::chrono::duration<double>(done - start).count();
+        }
+        return timing;
+    }
+}  // namespace
+
+auto main(int argc, char const* argv[]) -> int {
+    const char* logFile = argc > 1 ? argv[1] : "/tmp/bench_log_tokenize.log";
+    int         fd      = ::open("/dev/null", O_WRONLY);
+    if (fd < 0 || ::dup2(fd, STDOUT_FILENO) < 0) {
+        fmt::print(stderr, "cannot redirect stdout to /dev/null\n");
+        return 1;
+    }
+    ::close(fd);
+    ::unlink(logFile);
+
+    auto& logger = Logger::getLogger();
+    logger.setLogFile(logFile);
+    logger.setLevel(Logger::LogLevel::DEBUG);
+
+    auto source = makeSource();
+    auto sync   = run(Logger::Mode::SYNC, source);
+    auto async  = run(Logger::Mode::ASYNC, source);
+
+    auto report = [](const char* name, const Timing& timing) {
+        auto tokens = static_cast<double>(timing.tokens);
+        fmt::print(stderr,
+                   "  {:<8} tokenize {:>8.1f} ms ({:>6.1f} ns/token)"
+                   "   until written {:>8.1f} ms\n",
+                   name, timing.tokenize * 1e3, timing.tokenize * 1e9 / tokens,
+                   timing.total * 1e3);
+    };
+    fmt::print(stderr, "tokenizing {} bytes x {} with DEBUG logging\n",
+               source.size(), ROUNDS);
+    report("sync", sync);
+    report("async", async);
+    fmt::print(stderr, "  speedup (tokenize): {:.2f}x  (end to end): {:.2f}x\n",
+               sync.tokenize / async.tokenize, sync.total / async.total);
+    fmt::print(stderr, "  dropped: {}\n", logger.droppedCount());
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Loop throughput per engine: a counting loop of 100M iterations, and a
+// triple loop shaped like a matrix product, C[i][j] += A[i][k] * B[k][j]
+// with A and B computed from their indices and C summed into a scalar.
+// The product also reads a factor no loop writes, which the register
+// machine computes once per run rather than once per iteration.
+//
+// Every engine runs the same compiled program and has to print the same
+// result; the tiered engine starts each loop in the tree walker and
+// moves it up while it runs.
+
+#include "Bench.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Program.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace {
+
+    constexpr double COUNT = 100'000'000;
+    constexpr double SIZE  = 200;  // 8M iterations of the innermost loop
+
+    constexpr std::string_view COUNTING = R"(
+var count = 0;
+for (var i = 0; i < n; i += 1) {
+    count += 1;
+}
+print count;
+)";
+
+    constexpr std::string_view MATRIX = R"(
+var alpha = 3;
+var beta = 0.5;
+var c = 0;
+for (var i = 0; i < n; i += 1) {
+    for (var j = 0; j < n; j += 1) {
+        for (var k = 0; k < n; k += 1) {
+            c += (i * n + k) * (k * n + j) * (alpha * beta + 1);
+        }
+    }
+}
+print c;
+)";
+
+    struct Engine {
+        std::string_view    name;
+        Interpreter::Engine engine;
+    };
+
+    constexpr Engine ENGINES[] = {
+        {"tree walker", Interpreter::Engine::TREE},
+        {"closures", Interpreter::Engine::CLOSURE},
+        {"tiered", Interpreter::Engine::TIERED},
+        {"register VM", Interpreter::Engine::VM},
+    };
+
+    void compare(std::string_view name, std::string_view script, double n,
+                 double iterations) {
+        fmt::print("{}: {:.0f} iterations\n", name, iterations);
+
+        double      tree = 0;
+        std::string expected;
+        for (const auto& [label, engine] : ENGINES) {
+            auto          program = Thor::compile(script, engine);
+            Thor::Outputs outputs;
+            auto          seconds = Bench::time([&] {
+                auto inputs = program.inputs();
+                inputs.set("n", Token::Literal{n});
+                outputs = program.run(inputs);
+            });
+            Bench::doNotOptimize(outputs);
+            if (tree == 0) {
+                tree     = seconds;
+                expected = outputs.output;
+            }
+            fmt::print("  {:<12} {:>9.3f} s  {:>7.2f} ns/iteration  {:.2f}x{}\n",
+                       label, seconds, seconds * 1e9 / iterations,
+                       tree / seconds,
+                       outputs.output == expected ? "" : "  MISMATCH");
+        }
+    }
+}  // namespace
+
+auto main() -> int {
+    compare("counting", COUNTING, COUNT, COUNT);
+    compare("matrix", MATRIX, SIZE, SIZE * SIZE * SIZE);
+    return 0;
+}
@@ -0,0 +1,208 @@
+// Property access per engine: a field read and a method call on one
+// class, where every site sees one shape; a site that sees four, which
+// its cache still holds; and one that sees six, which it gives up on and
+// looks the name up each time. Then a field written in place.
+//
+// Then memory: 100k objects of four fields, kept in a dense array behind a
+// shared shape, next to the same objects as a hash map from name to value
+// each, the layout objects would have without shapes.
+
+#include "Bench.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Program.hpp"
+
+#include <malloc.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+    // Bytes the heap has handed out and not had back.
+    std::size_t live = 0;
+}  // namespace
+
+auto operator new(std::size_t size) -> void* {
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    live += malloc_usable_size(memory);
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    if (memory != nullptr) {
+        live -= malloc_usable_size(memory);
+        std::free(memory);
+    }
+}
+
+void operator delete(void* memory, std::size_t /*size*/) noexcept {
+    operator delete(memory);
+}
+
+namespace {
+
+    constexpr double      COUNT   = 2'000'000;
+    constexpr std::size_t OBJECTS = 100'000;
+
+    constexpr std::string_view FIELD = R"(
+class Point { init(x, y) { this.x = x; this.y = y; } }
+val p = Point(1, 2);
+var total = 0;
+for (var i = 0; i < n; i += 1) total += p.x + p.y;
+print total;
+)";
+
+    constexpr std::string_view METHOD = R"(
+class Point {
+    init(x, y) { this.x = x; this.y = y; }
+    sum() { return this.x + this.y; }
+}
+val p = Point(1, 2);
+var total = 0;
+for (var i = 0; i < n; i += 1) total += p.sum();
+print total;
+)";
+
+    constexpr std::string_view POLYMORPHIC = R"(
+val a = {v: 1};
+val b = {u: 0, v: 1};
+val c = {t: 0, u: 0, v: 1};
+val d = {s: 0, v: 1};
+var total = 0;
+for (var i = 0; i < n; i += 4) {
+    total += a.v;
+    val o = i % 8 < 4 ? b : c;
+    total += o.v + d.v;
+}
+func read(o) { return o.v; }
+for (var i = 0; i < n; i += 4) {
+    total += read(a) + read(b) + read(c) + read(d);
+}
+print total;
+)";
+
+    constexpr std::string_view MEGAMORPHIC = R"(
+val a = {v: 1};
+val b = {u: 0, v: 1};
+val c = {t: 0, u: 0, v: 1};
+val d = {s: 0, v: 1};
+val e = {r: 0, v: 1};
+val f = {q: 0, v: 1};
+func read(o) { return o.v; }
+var total = 0;
+for (var i = 0; i < n; i += 6) {
+    total += read(a) + read(b) + read(c) + read(d) + read(e) + read(f);
+}
+print total;
+)";
+
+    constexpr std::string_view WRITE = R"(
+class Counter { init() { this.count = 0; } }
+val c = Counter();
+for (var i = 0; i < n; i += 1) c.count += 1;
+print c.count;
+)";
+
+    struct Engine {
+        std::string_view    name;
+        Interpreter::Engine engine;
+    };
+
+    constexpr Engine ENGINES[] = {
+        {"tree walker", Interpreter::Engine::TREE},
+        {"closures", Interpreter::Engine::CLOSURE},
+        {"tiered", Interpreter::Engine::TIERED},
+        {"register VM", Interpreter::Engine::VM},
+    };
+
+    void compare(std::string_view name, std::string_view script, double n) {
+        fmt::print("{}: {:.0f} iterations\n", name, n);
+
+        double      tree = 0;
+        std::string expected;
+        for (const auto& [label, engine] : ENGINES) {
+            auto          program = Thor::compile(script, engine);
+            Thor::Outputs outputs;
+            auto          misses  = Runtime::InlineCache::misses();
+            auto          seconds = Bench::time([&] {
+                auto inputs = program.inputs();
+                inputs.set("n", Token::Literal{n});
+                outputs = program.run(inputs);
+            });
+            misses  = Runtime::InlineCache::misses() - misses;
+            Bench::doNotOptimize(outputs);
+            if (tree == 0) {
+                tree     = seconds;
+                expected = outputs.output;
+            }
+            auto same =
+                outputs.output == expected && outputs.diagnostics.empty();
+            fmt::print(
+                "  {:<12} {:>9.3f} s  {:>7.2f} ns/iter  {:.2f}x  {} misses{}\n",
+                label, seconds, seconds * 1e9 / n, tree / seconds, misses,
+                same ? "" : "  MISMATCH");
+        }
+    }
+
+    // Heap per object of four fields, in each layout.
+    void memory() {
+        const std::vector<std::string> names = {"x", "y", "z", "w"};
+        fmt::print("memory: {} objects of {} fields\n", OBJECTS,
+                   names.size());
+
+        Runtime::Class point("Point", nullptr,
+                             {{"init", Runtime::Function{nullptr}}});
+        std::vector<std::shared_ptr<const Runtime::Shape>> shapes;
+        shapes.push_back(point.shape());
+        for (const auto& name : names) {
+            shapes.push_back(shapes.back()->with(name));
+        }
+        std::vector<Runtime::Object> objects;
+        objects.reserve(OBJECTS);
+        auto before = live;
+        for (std::size_t i = 0; i < OBJECTS; ++i) {
+            // Grown one field at a time, as `init` does.
+            objects.emplace_back(point.shape(), &point);
+            for (std::size_t field = 0; field < names.size(); ++field) {
+                objects.back().reshape(shapes[field + 1],
+                                       Token::Literal{double(i)});
+            }
+        }
+        auto shaped = static_cast<double>(live - before) / OBJECTS;
+        Bench::doNotOptimize(objects);
+
+        std::vector<std::unordered_map<std::string, Token::Literal>> maps;
+        maps.reserve(OBJECTS);
+        before = live;
+        for (std::size_t i = 0; i < OBJECTS; ++i) {
+            auto& map = maps.emplace_back();
+            for (const auto& name : names) {
+                map.emplace(name, Token::Literal{double(i)});
+            }
+        }
+        auto hashed = static_cast<double>(live - before) / OBJECTS;
+        Bench::doNotOptimize(maps);
+
+        fmt::print("  {:<12} {:>7.1f} bytes/object\n", "shapes", shaped);
+        fmt::print("  {:<12} {:>7.1f} bytes/object  {:.2f}x\n", "hash maps",
+                   hashed, hashed / shaped);
+    }
+}  // namespace
+
+auto main() -> int {
+    compare("field read", FIELD, COUNT);
+    compare("method call", METHOD, COUNT);
+    compare("polymorphic site", POLYMORPHIC, COUNT);
+    compare("megamorphic site", MEGAMORPHIC, COUNT);
+    compare("field write", WRITE, COUNT);
+    memory();
+    return 0;
+}
@@ -0,0 +1,161 @@
+// Mixed-type infix evaluation: kernel table vs the original `switch`.
+
+#include "Bench.hpp"
+#include "Thor/Exceptions.hpp"
+#include "Thor/Operators.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+
+    using Token::Literal;
+
+    // The dispatch `Interpreter::visit(InfixExpr)` used before the kernel
+    // table, kept here as the baseline.
+    auto legacySwitch(const Token::Token& op, const Literal& left,
+                      const Literal& right) -> Literal {
+        auto ints = [&] {
+            if (!left.isNumber() || !right.isNumber()) {
+                throw Error::RuntimeException(
+                    op, "operator can't work on this type");
+            }
+            int l = left.toInt();
+            int r = right.toInt();
+            if (l < 0 || r < 0) {
+                throw Error::RuntimeException(
+                    op, "Operands must be non-negative integers");
+            }
+            return std::pair{l, r};
+        };
+        auto numbers = [&] {
+            if (!left.isNumber() || !right.isNumber()) {
+                throw Error::RuntimeException(
+                    op, "operator can't work on this type");
+            }
+        };
+
+        switch (op.type) {
+            case Token::Type::LOGICAL_OR:
+                return Literal{Operators::isTruthy(left) ||
+                               Operators::isTruthy(right)};
+            case Token::Type::LOGICAL_AND:
+                return Literal{Operators::isTruthy(left) &&
+                               Operators::isTruthy(right)};
+            case Token::Type::BIT_OR: {
+                auto [l, r] = ints();
+                return Literal{static_cast<double>(l | r)};
+            }
+            case Token::Type::BIT_AND: {
+                auto [l, r] = ints();
+                return Literal{static_cast<double>(l & r)};
+            }
+            case Token::Type::LEFT_SHIFT: {
+                auto [l, r] = ints();
+                return Literal{static_cast<double>(l << r)};
+            }
+            case Token::Type::EQUAL_EQUAL:
+                return Literal{Operators::isEqual(left, right)};
+            case Token::Type::BANG_EQUAL:
+                return Literal{!Operators::isEqual(left, right)};
+            case Token::Type::LESS:
+                if (left.isNumber() && right.isNumber()) {
+                    return Literal(left.asNumber() < right.asNumber());
+                }
+                if (left.isString() && right.isString()) {
+                    return Literal(left.asString() < right.asString());
+                }
+                throw Error::RuntimeException(
+                    op, "operator can't work on this type");
+            case Token::Type::MINUS:
+                numbers();
+                return Literal(left.asNumber() - right.asNumber());
+            case Token::Type::STAR:
+                numbers();
+                return Literal(left.asNumber() * right.asNumber());
+            case Token::Type::PLUS:
+                if (left.isNumber() && right.isNumber()) {
+                    return Literal(left.asNumber() + right.asNumber());
+                }
+                if (left.isString() && right.isString()) {
+                    return Literal(left.asString() + right.asString());
+                }
+                if (left.isString() || right.isString()) {
+                    return Literal(left.stringify() + right.stringify());
+                }
+                throw Error::RuntimeException(
+                    op, "operator can't work on these types");
+            default:
+                return {};
+        }
+    }
+
+    struct Case {
+        Token::Token op;
+        Literal      left;
+        Literal      right;
+    };
+
+    auto makeCases() -> std::vector<Case> {
+        auto tok = [](Token::Type type) {
+            return Token::Token{type, "", nullptr, 0, 0, 0};
+        };
+        return {
+            {tok(Token::Type::PLUS), Literal{1.5}, Literal{2.0}},
+            {tok(Token::Type::STAR), Literal{3.0}, Literal{4.0}},
+            {tok(Token::Type::MINUS), Literal{9.0}, Literal{4.0}},
+            {tok(Token::Type::LESS), Literal{1.0}, Literal{2.0}},
+            {tok(Token::Type::LESS), Literal{std::string("ab")},
+             Literal{std::string("ac")}},
+            {tok(Token::Type::EQUAL_EQUAL), Literal{true}, Literal{}},
+            {tok(Token::Type::EQUAL_EQUAL), Literal{2.0}, Literal{2.0}},
+            {tok(Token::Type::BANG_EQUAL), Literal{std::string("x")},
+             Literal{1.0}},
+            {tok(Token::Type::LOGICAL_AND), Literal{true}, Literal{0.0}},
+            {tok(Token::Type::LOGICAL_OR), Literal{},
+             Literal{std::string("s")}},
+            {tok(Token::Type::BIT_OR), Literal{5.0}, Literal{2.0}},
+            {tok(Token::Type::BIT_AND), Literal{6.0}, Literal{3.0}},
+            {tok(Token::Type::LEFT_SHIFT), Literal{1.0}, Literal{4.0}},
+            {tok(Token::Type::PLUS), Literal{std::string("n=")},
+             Literal{7.0}},
+        };
+    }
+
+    void compare(const std::string& label, const std::vector<Case>& cases) {
+        const auto iterations = std::size_t{2'000'000};
+
+        fmt::print("{}: {} infix operations per iteration\n", label,
+                   cases.size());
+        auto legacy = Bench::run("  legacy switch", iterations, [&] {
+            for (const auto& c : cases) {
+                Bench::doNotOptimize(legacySwitch(c.op, c.left, c.right));
+            }
+        });
+        auto table = Bench::run("  kernel table", iterations, [&] {
+            for (const auto& c : cases) {
+                Bench::doNotOptimize(
+                    Operators::apply(c.op, c.left, c.right));
+            }
+        });
+        fmt::print("  speedup: {:.2f}x\n", legacy / table);
+    }
+}  // namespace
+
+auto main() -> int {
+    auto cases = makeCases();
+    compare("mixed types", cases);
+
+    // Without the string-producing cases the allocator no longer dominates.
+    cases.erase(std::remove_if(cases.begin(), cases.end(),
+                               [](const Case& c) {
+                                   return c.op.type == Token::Type::PLUS &&
+                                          (c.left.isString() ||
+                                           c.right.isString());
+                               }),
+                cases.end());
+    compare("mixed types, no allocation", cases);
+    return 0;
+}
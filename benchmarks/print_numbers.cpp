@@ -0,0 +1,88 @@
+// Prints 10M numbers through `print` statements, buffered and unbuffered.
+// Script output goes to /dev/null (or the file named by argv[1]); timings
+// are reported on stderr.
+
+#include "Bench.hpp"
+#include "Thor/Interpreter.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <vector>
+
+namespace {
+
+    constexpr std::size_t STATEMENTS = 100'000;
+    constexpr std::size_t ROUNDS     = 100;
+
+    auto makeProgram() -> std::vector<Stmt::Stmt> {
+        std::vector<Stmt::Stmt> program;
+        program.reserve(STATEMENTS);
+        for (std::size_t i = 0; i < STATEMENTS; ++i) {
+            auto value = static_cast<double>(i) * (i % 4 == 0 ? 1.0 : 0.25);
+            program.push_back(Stmt::makeStmt(Stmt::Print{
+                Expr::makeExpr(Expr::LiteralExpr(Token::Literal{value}))}));
+        }
+        return program;
+    }
+
+    auto run(const Interpreter::Interpreter&  interpreter,
+             const std::vector<Stmt::Stmt>& program) -> double {
+        return Bench::time([&] {
+            for (std::size_t round = 0; round < ROUNDS; ++round) {
+                interpreter.interpret(program);
+            }
+            Output::Writer::standard().flush();
+            std::fflush(stdout);
+        });
+    }
+}  // namespace
+
+auto main(int argc, char const* argv[]) -> int {
+    const char* target = argc > 1 ? argv[1] : "/dev/null";
+    int         fd     = ::open(target, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ::dup2(fd, STDOUT_FILENO) < 0) {
+        fmt::print(stderr, "cannot redirect stdout to {}\n", target);
+        return 1;
+    }
+    ::close(fd);
+    Logger::getLogger().setLevel(Logger::LogLevel::ERROR);
+
+    auto                     program = makeProgram();
+    Interpreter::Interpreter interpreter;
+    auto&                    output = Output::Writer::standard();
+    auto                     lines  = static_cast<double>(STATEMENTS * ROUNDS);
+
+    output.setUnbuffered(true);
+    auto unbuffered = run(interpreter, program);
+    output.setUnbuffered(false);
+    auto buffered = run(interpreter, program);
+
+    // The same lines without the interpreter around them.
+    auto writeAll = [&] {
+        for (std::size_t round = 0; round < ROUNDS; ++round) {
+            for (std::size_t i = 0; i < STATEMENTS; ++i) {
+                output.writeLine(Token::Literal{static_cast<double>(i)});
+            }
+        }
+        output.flush();
+        std::fflush(stdout);
+    };
+    output.setUnbuffered(true);
+    auto rawUnbuffered = Bench::time(writeAll);
+    output.setUnbuffered(false);
+    auto rawBuffered = Bench::time(writeAll);
+
+    auto report = [lines](const char* name, double seconds) {
+        fmt::print(stderr, "  {:<34} {:>8.1f} ms {:>6.1f} ns/line\n", name,
+                   seconds * 1e3, seconds * 1e9 / lines);
+    };
+    fmt::print(stderr, "printing {:.0f} numbers to {}\n", lines, target);
+    report("print, --unbuffered", unbuffered);
+    report("print, buffered writer", buffered);
+    fmt::print(stderr, "  speedup: {:.2f}x\n", unbuffered / buffered);
+    report("writer only, --unbuffered", rawUnbuffered);
+    report("writer only, buffered", rawBuffered);
+    fmt::print(stderr, "  speedup: {:.2f}x\n", rawUnbuffered / rawBuffered);
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Evaluates a small rule one million times with different inputs: compiled
+// once and run with fresh bindings, against lexing and parsing it every
+// time as the command line does.
+
+#include "Bench.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Program.hpp"
+
+namespace {
+
+    constexpr std::size_t RUNS = 1'000'000;
+
+    constexpr std::string_view RULE =
+        "val total = price * qty;\n"
+        "val approved = total > 100 && region == \"EU\";\n"
+        "print approved ? $\"approve {total}\" : \"reject\";\n";
+}  // namespace
+
+auto main() -> int {
+    auto program = Thor::compile(RULE);
+    auto inputs  = program.inputs();
+    auto price   = *program.slot("price");
+    auto qty     = *program.slot("qty");
+    auto region  = *program.slot("region");
+    inputs[region] = Token::Literal{std::string("EU")};
+
+    Runtime::Context context;
+    std::size_t      approved = 0;
+    auto             run      = [&](std::size_t i) {
+        inputs[price] = Token::Literal{static_cast<double>(i % 50)};
+        inputs[qty]   = Token::Literal{static_cast<double>(i % 7)};
+        auto outputs  = program.run(context, inputs);
+        approved += outputs.output[0] == 'a' ? 1 : 0;
+    };
+
+    auto compiled = Bench::time([&] {
+        for (std::size_t i = 0; i < RUNS; ++i) {
+            run(i);
+        }
+    });
+
+    // The same rule lexed and parsed per evaluation, fewer times.
+    constexpr std::size_t REPARSED_RUNS = RUNS / 20;
+    auto                  reparsed      = Bench::time([&] {
+        for (std::size_t i = 0; i < REPARSED_RUNS; ++i) {
+            auto each    = Thor::Program::compile(context, RULE);
+            auto binding = each.inputs();
+            binding.set("price", Token::Literal{static_cast<double>(i % 50)})
+                .set("qty", Token::Literal{static_cast<double>(i % 7)})
+                .set("region", Token::Literal{std::string("EU")});
+            approved += each.run(context, binding).output[0] == 'a' ? 1 : 0;
+        }
+    });
+    Bench::doNotOptimize(approved);
+
+    auto perRun = [](double seconds, std::size_t runs) {
+        return seconds * 1e9 / static_cast<double>(runs);
+    };
+    fmt::print("{} runs of a 3-line rule\n", RUNS);
+    fmt::print("  compiled once     {:>9.1f} ns/run {:>10.0f} runs/s\n",
+               perRun(compiled, RUNS), static_cast<double>(RUNS) / compiled);
+    fmt::print("  parsed every run  {:>9.1f} ns/run {:>10.0f} runs/s\n",
+               perRun(reparsed, REPARSED_RUNS),
+               static_cast<double>(REPARSED_RUNS) / reparsed);
+    return 0;
+}
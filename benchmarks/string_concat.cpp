@@ -0,0 +1,60 @@
+// Builds a large string by repeated `s = s + piece`, the way a script loop
+// would, and checks that the cost per byte stays flat as the size grows.
+
+#include "Bench.hpp"
+#include "Thor/Operators.hpp"
+
+#include <string>
+
+namespace {
+
+    using Token::Literal;
+
+    auto plusToken() -> Token::Token {
+        return Token::Token{Token::Type::PLUS, "+", nullptr, 0, 0, 0};
+    }
+
+    // Appends through the interpreter's PLUS kernel, then reads the result
+    // once so that a rope is flattened inside the timed region.
+    auto buildRuntime(std::size_t bytes, const Literal& piece) -> double {
+        auto op = plusToken();
+        return Bench::time([&] {
+            Literal acc{std::string()};
+            while (acc.asString().size() < bytes) {
+                acc = Operators::apply(op, acc, piece);
+            }
+            Bench::doNotOptimize(acc.asString().view().back());
+        });
+    }
+
+    // What `PLUS` did before: a fresh std::string holding both operands.
+    auto buildCopying(std::size_t bytes, const std::string& piece) -> double {
+        return Bench::time([&] {
+            std::string acc;
+            while (acc.size() < bytes) {
+                acc = acc + piece;
+            }
+            Bench::doNotOptimize(acc.back());
+        });
+    }
+}  // namespace
+
+auto main() -> int {
+    const std::string piece = "0123456789abcdef";
+    const Literal     pieceLiteral{piece};
+
+    fmt::print("appending {}-byte pieces\n", piece.size());
+    for (std::size_t mb : {1, 2, 5, 10}) {
+        auto bytes   = mb << 20U;
+        auto seconds = buildRuntime(bytes, pieceLiteral);
+        fmt::print("  Runtime::String {:>3} MB {:>10.2f} ms {:>8.2f} ns/byte\n",
+                   mb, seconds * 1e3, seconds * 1e9 / bytes);
+    }
+    for (std::size_t kb : {128, 256, 512, 1024}) {
+        auto bytes   = kb << 10U;
+        auto seconds = buildCopying(bytes, piece);
+        fmt::print("  copy on append  {:>4} KB {:>9.2f} ms {:>8.2f} ns/byte\n",
+                   kb, seconds * 1e3, seconds * 1e9 / bytes);
+    }
+    return 0;
+}
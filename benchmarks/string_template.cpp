@@ -0,0 +1,75 @@
+// Log-line style `$"..."` template with five holes against the equivalent
+// chain of `+` concatenations.
+
+#include "Bench.hpp"
+#include "Thor/Interpreter.hpp"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+    using Token::Literal;
+
+    auto token(Token::Type type, const std::string& lexeme) -> Token::Token {
+        return Token::Token{type, lexeme, nullptr, 0, 0, 1};
+    }
+
+    // A variable that already carries its value, standing in for a lookup.
+    auto bound(const std::string& name, Literal value) -> Expr::Expr {
+        return Expr::makeExpr(Expr::Variable(
+            token(Token::Type::IDENTIFIER, name), std::move(value)));
+    }
+
+    auto text(const std::string& value) -> Expr::Expr {
+        return Expr::makeExpr(Expr::LiteralExpr(Literal{value}));
+    }
+
+    struct Fields {
+        std::vector<std::string> segments = {
+            "[", "] ", " user=", " status=", " took=", "ms"};
+        std::vector<Expr::Expr> holes = {
+            bound("level", Literal{std::string("INFO")}),
+            bound("ts", Literal{1712345678.0}),
+            bound("user", Literal{std::string("alice")}),
+            bound("code", Literal{200.0}),
+            bound("ms", Literal{12.5}),
+        };
+    };
+
+    auto makeTemplate(const Fields& fields) -> Expr::Expr {
+        return Expr::makeExpr(Expr::TemplateExpr(
+            token(Token::Type::STRING, "log"), fields.segments, fields.holes));
+    }
+
+    auto makeConcatenation(const Fields& fields) -> Expr::Expr {
+        auto plus = token(Token::Type::PLUS, "+");
+        auto expr = text(fields.segments.front());
+        for (std::size_t i = 0; i < fields.holes.size(); ++i) {
+            expr = Expr::makeExpr(Expr::InfixExpr(expr, plus, fields.holes[i]));
+            expr = Expr::makeExpr(
+                Expr::InfixExpr(expr, plus, text(fields.segments[i + 1])));
+        }
+        return expr;
+    }
+}  // namespace
+
+auto main() -> int {
+    Fields                   fields;
+    Interpreter::Interpreter interpreter;
+
+    auto tmpl   = makeTemplate(fields);
+    auto concat = makeConcatenation(fields);
+    fmt::print("{}\n", interpreter.evaluate(tmpl).stringify());
+
+    const auto iterations = std::size_t{1'000'000};
+
+    auto chain = Bench::run("`+` chain", iterations, [&] {
+        Bench::doNotOptimize(interpreter.evaluate(concat));
+    });
+    auto compiled = Bench::run("compiled template", iterations, [&] {
+        Bench::doNotOptimize(interpreter.evaluate(tmpl));
+    });
+    fmt::print("speedup: {:.2f}x\n", chain / compiled);
+    return 0;
+}
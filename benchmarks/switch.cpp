@@ -0,0 +1,132 @@
+// A switch of 256 cases in a hot loop, per engine, against the chain of
+// 256 `if`/`else if` that does the same: the chain compares the subject
+// with every label up to the one that matches, 128 on average, where the
+// switch looks it up once. Three kinds of labels, one per lookup:
+// consecutive integers (a jump table), integers 7919 apart (a binary
+// search) and strings (a perfect hash).
+
+#include "Bench.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Program.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace {
+
+    constexpr double      COUNT = 200'000;
+    constexpr std::size_t CASES = 256;
+
+    struct Engine {
+        std::string_view    name;
+        Interpreter::Engine engine;
+    };
+
+    constexpr Engine ENGINES[] = {
+        {"tree walker", Interpreter::Engine::TREE},
+        {"closures", Interpreter::Engine::CLOSURE},
+        {"tiered", Interpreter::Engine::TIERED},
+        {"register VM", Interpreter::Engine::VM},
+    };
+
+    enum class Labels { DENSE, SPARSE, STRINGS };
+
+    auto label(Labels labels, std::size_t index) -> std::string {
+        switch (labels) {
+            case Labels::DENSE:
+                return std::to_string(index);
+            case Labels::SPARSE:
+                return std::to_string(index * 7919 + 3);
+            case Labels::STRINGS:
+                return "\"key" + std::to_string(index) + "\"";
+        }
+        return {};
+    }
+
+    // The loop, with `k` running over every label, and the dispatch on it
+    // as a switch or as a chain of comparisons.
+    auto script(Labels labels, bool chain) -> std::string {
+        std::string text;
+        if (labels == Labels::STRINGS) {
+            text += "val keys = [";
+            for (std::size_t i = 0; i < CASES; ++i) {
+                text += (i > 0 ? ", " : "") + label(labels, i);
+            }
+            text += "];\n";
+        }
+        text += "var total = 0;\nfor (var i = 0; i < n; i += 1) {\n";
+        switch (labels) {
+            case Labels::DENSE:
+                text += "    val k = i % 256;\n";
+                break;
+            case Labels::SPARSE:
+                text += "    val k = i % 256 * 7919 + 3;\n";
+                break;
+            case Labels::STRINGS:
+                text += "    val k = keys[i % 256];\n";
+                break;
+        }
+        if (!chain) {
+            text += "    switch (k) {\n";
+        }
+        for (std::size_t i = 0; i < CASES; ++i) {
+            auto body = "total += " + std::to_string(i % 7) + ";\n";
+            if (chain) {
+                text += std::string(i == 0 ? "    if" : "    else if") +
+                        " (k == " + label(labels, i) + ") " + body;
+            } else {
+                text += "        case " + label(labels, i) + ": " + body;
+            }
+        }
+        text += chain ? "}\nprint total;\n" : "    }\n}\nprint total;\n";
+        return text;
+    }
+
+    auto measure(const Thor::Program& program, std::string& output)
+        -> double {
+        Thor::Outputs outputs;
+        auto          seconds = Bench::time([&] {
+            auto inputs = program.inputs();
+            inputs.set("n", Token::Literal{COUNT});
+            outputs = program.run(inputs);
+        });
+        Bench::doNotOptimize(outputs);
+        output = outputs.diagnostics.empty() ? outputs.output : "";
+        return seconds;
+    }
+
+    void compare(std::string_view name, Labels labels) {
+        auto cases  = script(labels, false);
+        auto chains = script(labels, true);
+        fmt::print("{}: {:.0f} iterations, {} cases\n", name, COUNT, CASES);
+        fmt::print("  {:<12} {:>10} {:>10} {:>10}\n", "", "switch ns",
+                   "if/else ns", "speedup");
+
+        std::string expected;
+        for (const auto& [engineName, engine] : ENGINES) {
+            auto        dispatch = Thor::compile(cases, engine);
+            auto        chain    = Thor::compile(chains, engine);
+            std::string byCase;
+            std::string byChain;
+            auto        switched = measure(dispatch, byCase);
+            auto        chained  = measure(chain, byChain);
+            if (expected.empty()) {
+                expected = byChain;
+            }
+            auto same = !expected.empty() && byCase == expected &&
+                        byChain == expected;
+            fmt::print("  {:<12} {:>10.1f} {:>10.1f} {:>9.2f}x{}\n",
+                       engineName, switched * 1e9 / COUNT,
+                       chained * 1e9 / COUNT, chained / switched,
+                       same ? "" : "  MISMATCH");
+        }
+    }
+}  // namespace
+
+auto main() -> int {
+    compare("dense integers", Labels::DENSE);
+    compare("sparse integers", Labels::SPARSE);
+    compare("strings", Labels::STRINGS);
+    return 0;
+}
@@ -0,0 +1,109 @@
+// Scripts run once against programs run many times, per engine. Run once,
+// as from the command line, the tiered engine should cost no more than the
+// tree walker; run many times, as by the server, it should end up as fast
+// as the closure engine, or faster where statements are big enough for the
+// JIT. `small` is the script from `closure.cpp`; `numeric` is made of long
+// arithmetic expressions.
+
+#include "Bench.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Lexer.hpp"
+#include "Thor/Parser.hpp"
+#include "Thor/Program.hpp"
+#include "Thor/Tiering.hpp"
+
+#include <string>
+
+namespace {
+
+    constexpr std::size_t COPIES = 500;
+    constexpr std::size_t ONCE   = 10;
+    constexpr std::size_t RUNS   = 1000;
+
+    auto smallScript() -> std::string {
+        std::string script = "var n = 3;\n";
+        for (std::size_t i = 0; i < COPIES; ++i) {
+            script += fmt::format(
+                "var a{0} = (5 + (n + {0}) * 2 ** 2 - -1) >> 1 & 7 | 15 ^ 10;\n"
+                "var b{0} = a{0} * 4 - n / 2 + (a{0} % 3);\n"
+                "var c{0} = a{0} > b{0} && b{0} != 0 || !(a{0} == 3);\n"
+                "var d{0} = c{0} ? b{0} * 2 : a{0} - b{0};\n"
+                "\"label \" + d{0} == \"label 4\";\n"
+                "(a{0} + b{0}) * (d{0} - 1) <= 1000;\n",
+                i);
+        }
+        return script;
+    }
+
+    auto numericScript() -> std::string {
+        std::string script = "var a = 5;\nvar b = 7;\nvar c = 3;\nvar d = 9;\n";
+        for (std::size_t i = 0; i < COPIES; ++i) {
+            script += fmt::format(
+                "var x{0} = a * b + c * d - a / (b + {0}) + (a - c) * "
+                "(b - d) / (c + 1) - d * a;\n"
+                "var y{0} = (a * a + b * b) ** 0.5 + (c * c + d * d) ** 0.5 "
+                "> a * b - c * x{0} ? a + b * c : d - a / b;\n",
+                i);
+        }
+        return script;
+    }
+
+    // Milliseconds to run `script` once, parsed fresh each time.
+    auto once(std::string script, Interpreter::Engine engine) -> double {
+        Interpreter::setEngine(engine);
+        double seconds = 0;
+        for (std::size_t i = 0; i < ONCE; ++i) {
+            Runtime::Context context;
+            Thor::Lexer      lexer(context);
+            Parser::Parser   parser(context);
+            auto             tokens     = lexer.tokenize(script);
+            auto             statements = parser.parse(tokens);
+            seconds += Bench::time([&] {
+                Interpreter::Interpreter(context).interpret(statements);
+            });
+        }
+        Interpreter::setEngine(Interpreter::Engine::TREE);
+        return seconds * 1e3 / static_cast<double>(ONCE);
+    }
+
+    // Microseconds per run of one program run `RUNS` times.
+    auto many(const std::string& script, Interpreter::Engine engine)
+        -> double {
+        auto             program = Thor::compile(script, engine);
+        Runtime::Context context;
+        auto             seconds = Bench::time([&] {
+            for (std::size_t i = 0; i < RUNS; ++i) {
+                Bench::doNotOptimize(program.run(context, program.inputs()));
+            }
+        });
+        return seconds * 1e6 / static_cast<double>(RUNS);
+    }
+}  // namespace
+
+auto main() -> int {
+    struct Engine {
+        const char*         name;
+        Interpreter::Engine engine;
+    };
+    const Engine engines[] = {
+        {"tree", Interpreter::Engine::TREE},
+        {"closure", Interpreter::Engine::CLOSURE},
+        {"tiered", Interpreter::Engine::TIERED},
+    };
+
+    const auto& options = Tiering::options();
+    fmt::print("Tiers after {} and {} entries; {} runs for the second column\n",
+               options.closureAfter, options.jitAfter, RUNS);
+    for (const auto& [name, script] :
+         {std::pair{"small", smallScript()},
+          std::pair{"numeric", numericScript()}}) {
+        fmt::print("{}\n  {:<8} {:>14} {:>14}\n", name, "engine",
+                   "once (ms)", "many (us/run)");
+        for (const auto& engine : engines) {
+            fmt::print("  {:<8} {:>14.3f} {:>14.1f}\n", engine.name,
+                       once(script, engine.engine),
+                       many(script, engine.engine));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+// Cost of trace events: a bare Trace::emit with tracing off and on, and
+// lexing + parsing a large script untraced, traced, and with DEBUG text
+// logging for comparison. The trace file is argv[1] (default
+// /tmp/bench_trace_events.trace).
+
+#include "Bench.hpp"
+#include "Thor/Parser.hpp"
+#include "Thor/Trace.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+    constexpr std::size_t EVENTS = 50'000'000;
+    constexpr std::size_t LINES  = 20'000;
+
+    auto makeSource() -> std::string {
+        std::string source;
+        for (std::size_t i = 0; i < LINES; ++i) {
+            source += fmt::format("print ({} + {}.5) * \"item {}\" == {};\n", i,
+                                  i % 97, i, i * 3);
+        }
+        return source;
+    }
+
+    auto lexAndParse(const std::string& source) -> double {
+        return Bench::time([&] {
+            Thor::Lexer    lexer;
+            Parser::Parser parser;
+            auto           copy   = source;
+            auto           tokens = lexer.tokenize(copy);
+            auto           parsed = parser.parse(tokens);
+            Bench::doNotOptimize(parsed);
+        });
+    }
+}  // namespace
+
+auto main(int argc, char const* argv[]) -> int {
+    std::string path = argc > 1 ? argv[1] : "/tmp/bench_trace_events.trace";
+    auto&       logger = Logger::getLogger();
+    logger.setLevel(Logger::LogLevel::WARN);
+
+    auto emitAll = [] {
+        for (std::size_t i = 0; i < EVENTS; ++i) {
+            Trace::emit(Trace::Event::MARK, static_cast<std::uint32_t>(i), i);
+        }
+    };
+    auto off = Bench::time(emitAll);
+    Trace::start(path, std::size_t{1} << 20U);
+    auto on = Bench::time(emitAll);
+    Trace::stop();
+
+    auto source   = makeSource();
+    auto untraced = lexAndParse(source);
+    Trace::start(path, std::size_t{1} << 20U);
+    auto traced = lexAndParse(source);
+    Trace::stop();
+
+    // Text logging of the same run, written to /dev/null.
+    int fd = ::open("/dev/null", O_WRONLY);
+    ::dup2(fd, STDOUT_FILENO);
+    ::close(fd);
+    logger.setLevel(Logger::LogLevel::DEBUG);
+    auto logged = lexAndParse(source);
+    logger.flush();
+    logger.setLevel(Logger::LogLevel::WARN);
+
+    auto events = static_cast<double>(EVENTS);
+    fmt::print(stderr, "Trace::emit x {}\n", EVENTS);
+    fmt::print(stderr, "  tracing off {:>8.2f} ns/event\n", off * 1e9 / events);
+    fmt::print(stderr, "  tracing on  {:>8.2f} ns/event\n", on * 1e9 / events);
+    fmt::print(stderr, "lex+parse {} bytes\n", source.size());
+    fmt::print(stderr, "  untraced        {:>8.1f} ms\n", untraced * 1e3);
+    fmt::print(stderr, "  traced          {:>8.1f} ms ({:+.1f}%)\n",
+               traced * 1e3, (traced / untraced - 1) * 100);
+    fmt::print(stderr, "  DEBUG text log  {:>8.1f} ms ({:+.1f}%)\n",
+               logged * 1e3, (logged / untraced - 1) * 100);
+    return 0;
+}
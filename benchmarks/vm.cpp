@@ -0,0 +1,209 @@
+// Runs expression-heavy scripts, `examples/exprs.krp`-style and scaled up
+// to a few thousand statements, with the tree walker, the closure engine
+// and the register machine, each on the same parsed program with an input
+// `n` bound per run.
+//
+// Instruction counts compare the register code with what a stack machine
+// would need for the same trees: one instruction per node, so every leaf
+// is a push. Where the kernel allows it, retired CPU instructions per run
+// are measured as well.
+
+#include "Bench.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Lexer.hpp"
+#include "Thor/Parser.hpp"
+#include "Thor/Program.hpp"
+#include "Thor/Vm.hpp"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace {
+
+    constexpr std::size_t COPIES = 500;
+    constexpr std::size_t RUNS   = 200;
+
+    auto mixedScript() -> std::string {
+        std::string script;
+        for (std::size_t i = 0; i < COPIES; ++i) {
+            script += fmt::format(
+                "var a{0} = (5 + (n + {0}) * 2 ** 2 - -1) >> 1 & 7 | 15 ^ 10;\n"
+                "var b{0} = a{0} * 4 - n / 2 + (a{0} % 3);\n"
+                "var c{0} = a{0} > b{0} && b{0} != 0 || !(a{0} == 3);\n"
+                "var d{0} = c{0} ? b{0} * 2 : a{0} - b{0};\n"
+                "\"label \" + d{0} == \"label 4\";\n"
+                "(a{0} + b{0}) * (d{0} - 1) <= 1000;\n",
+                i);
+        }
+        script += "print d0 + d1;\n";
+        return script;
+    }
+
+    auto numericScript() -> std::string {
+        std::string script;
+        for (std::size_t i = 0; i < COPIES; ++i) {
+            script += fmt::format(
+                "var x{0} = ((n + {0}) * 3 - (n - 1) * (n + 2)) / (n * n + 1)"
+                " + (n * 4 - 2) * (n / 3 + 1);\n"
+                "(x{0} - n) * (x{0} + n) - x{0} * x{0} / (n + 1) > 0;\n",
+                i);
+        }
+        script += "print x0 + x1;\n";
+        return script;
+    }
+
+    // Nodes in the tree under `expr`: what a stack machine executes.
+    auto nodes(const Expr::Expr& expr) -> std::size_t {
+        if (expr == nullptr) {
+            return 1;
+        }
+        if (expr->is<Expr::InfixExpr>()) {
+            const auto& infix = expr->as<Expr::InfixExpr>();
+            return 1 + nodes(infix.left) + nodes(infix.right);
+        }
+        if (expr->is<Expr::PrefixExpr>()) {
+            return 1 + nodes(expr->as<Expr::PrefixExpr>().right);
+        }
+        if (expr->is<Expr::GroupExpr>()) {
+            return nodes(expr->as<Expr::GroupExpr>().expr);
+        }
+        if (expr->is<Expr::TernaryExpr>()) {
+            // The condition and both arms, plus the two jumps.
+            const auto& ternary = expr->as<Expr::TernaryExpr>();
+            return 2 + nodes(ternary.condition) + nodes(ternary.trueExpr) +
+                   nodes(ternary.falseExpr);
+        }
+        return 1;
+    }
+
+    auto stackInstructions(const std::vector<Stmt::Stmt>& statements)
+        -> std::size_t {
+        std::size_t count = 0;
+        for (const auto& stmt : statements) {
+            const Expr::Expr* expr = nullptr;
+            if (stmt->is<Stmt::Expression>()) {
+                expr = &stmt->as<Stmt::Expression>().expression;
+            } else if (stmt->is<Stmt::Print>()) {
+                expr = &stmt->as<Stmt::Print>().expression;
+            } else {
+                expr = &stmt->as<Stmt::Variable>().initializer;
+            }
+            count += 1 + nodes(*expr);  // And the statement's own
+        }
+        return count;
+    }
+
+    // Retired user-space instructions, if perf events are permitted.
+    class Counter {
+      public:
+
+        Counter() {
+            perf_event_attr attr{};
+            attr.type           = PERF_TYPE_HARDWARE;
+            attr.size           = sizeof(attr);
+            attr.config         = PERF_COUNT_HW_INSTRUCTIONS;
+            attr.disabled       = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+            fd_ = static_cast<int>(
+                syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+
+        ~Counter() {
+            if (fd_ >= 0) {
+                close(fd_);
+            }
+        }
+
+        Counter(const Counter&)                    = delete;
+        auto operator=(const Counter&) -> Counter& = delete;
+
+        template <typename Fn>
+        auto count(Fn&& fn) -> std::optional<std::uint64_t> {
+            if (fd_ < 0) {
+                fn();
+                return std::nullopt;
+            }
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+            fn();
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            std::uint64_t value = 0;
+            if (read(fd_, &value, sizeof(value)) != sizeof(value)) {
+                return std::nullopt;
+            }
+            return value;
+        }
+
+      private:
+
+        int fd_ = -1;
+    };
+
+    struct Result {
+        double                       seconds;
+        std::optional<std::uint64_t> instructions;
+    };
+
+    auto measure(const std::string& script, Interpreter::Engine engine)
+        -> Result {
+        auto             program = Thor::compile(script, engine);
+        Runtime::Context context;
+        Counter          counter;
+        Result           result{};
+        auto   runs = [&] {
+            for (std::size_t i = 0; i < RUNS; ++i) {
+                auto inputs = program.inputs();
+                inputs.set("n", Token::Literal{static_cast<double>(i % 9)});
+                Bench::doNotOptimize(program.run(context, inputs));
+            }
+        };
+        result.seconds =
+            Bench::time([&] { result.instructions = counter.count(runs); });
+        return result;
+    }
+
+    void compare(std::string_view name, std::string script) {
+        Runtime::Context context;
+        Thor::Lexer      lexer(context);
+        Parser::Parser   parser(context);
+        auto             tokens     = lexer.tokenize(script);
+        auto             statements = parser.parse(tokens);
+        auto             code       = Vm::Program::compile(statements);
+
+        fmt::print("{}: {} statements, {} runs\n", name, statements.size(),
+                   RUNS);
+        fmt::print("  stack code      {:>8} instructions\n",
+                   stackInstructions(statements));
+        fmt::print("  register code   {:>8} instructions, {} registers\n",
+                   code.instructions().size(), code.registers());
+
+        auto tree = measure(script, Interpreter::Engine::TREE);
+        auto row  = [&](std::string_view engine, const Result& result) {
+            auto perRun = static_cast<double>(RUNS);
+            fmt::print("  {:<15} {:>8.3f} ms/run  {:.2f}x", engine,
+                       result.seconds * 1e3 / perRun,
+                       tree.seconds / result.seconds);
+            if (result.instructions) {
+                fmt::print("  {:>12.0f} CPU instructions/run",
+                           static_cast<double>(*result.instructions) / perRun);
+            }
+            fmt::print("\n");
+        };
+        row("tree walker", tree);
+        row("closures", measure(script, Interpreter::Engine::CLOSURE));
+        row("register VM", measure(script, Interpreter::Engine::VM));
+    }
+}  // namespace
+
+auto main() -> int {
+    compare("mixed", mixedScript());
+    compare("numeric", numericScript());
+    return 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace Runtime {
+
+    // Bump allocator owned by one runtime context.
+    //
+    // Memory is carved out of 64 KiB chunks and is only given back all at
+    // once, by `reset()` or by rewinding to an earlier `mark()`. Chunks are
+    // kept for reuse, so a rewound arena allocates nothing on the next run.
+    // Objects placed in an arena must be trivially destructible, and
+    // alignments up to alignof(std::max_align_t) are supported.
+    class Arena {
+      public:
+
+        static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+        struct Mark {
+            std::size_t chunk;
+            std::size_t offset;
+        };
+
+        Arena() = default;
+
+        Arena(const Arena&)                    = delete;
+        auto operator=(const Arena&) -> Arena& = delete;
+
+        auto allocate(std::size_t size,
+                      std::size_t align = alignof(std::max_align_t)) -> void*;
+
+        // Copy of `text` that lives as long as the arena (or until rewound).
+        auto copy(std::string_view text) -> std::string_view;
+
+        [[nodiscard]] auto mark() const -> Mark {
+            return {current_, offset_};
+        }
+
+        void rewind(Mark mark);
+
+        void reset() {
+            rewind({0, 0});
+        }
+
+        // Bytes up to the current position, earlier chunks counted in full.
+        [[nodiscard]] auto bytesUsed() const -> std::size_t;
+
+        [[nodiscard]] auto bytesReserved() const -> std::size_t;
+
+      private:
+
+        struct Chunk {
+            std::unique_ptr<std::byte[]> data;
+            std::size_t                  size;
+        };
+
+        std::vector<Chunk> chunks_;
+        std::size_t        current_ = 0;
+        std::size_t        offset_  = 0;
+    };
+}  // namespace Runtime
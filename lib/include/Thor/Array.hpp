@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Heap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Token {
+    struct Literal;
+    struct Token;
+}  // namespace Token
+
+// Arrays keep their elements by kind: while every element is a number they
+// are a packed `double[]`, which the builtins run over with SIMD kernels
+// (AVX when the CPU has it) rather than a loop over boxed values. Storing
+// anything else moves the array to boxed values for good, as a later
+// number could not tell which elements were numbers all along.
+namespace Runtime {
+
+    // An array. Copies share the array, whose elements change in place;
+    // two values are equal when they are copies of one.
+    class Array {
+      public:
+
+        // An empty, packed array.
+        Array();
+
+        // Packed.
+        explicit Array(std::vector<double> numbers);
+
+        // Packed if every value is a number.
+        explicit Array(std::vector<Token::Literal> values);
+
+        [[nodiscard]] auto size() const -> std::size_t;
+
+        // Whether the elements are `numbers()` rather than `values()`.
+        [[nodiscard]] auto packed() const -> bool {
+            return data_->packed;
+        }
+
+        [[nodiscard]] auto numbers() const -> std::vector<double>& {
+            return data_->numbers;
+        }
+
+        [[nodiscard]] auto values() const -> std::vector<Token::Literal>& {
+            return data_->values;
+        }
+
+        // Element `index`, which is in range.
+        [[nodiscard]] auto get(std::size_t index) const -> Token::Literal;
+        void               set(std::size_t index, Token::Literal value) const;
+        void               push(Token::Literal value) const;
+
+        // `[1, 2, 3]`, with arrays it is already inside written `[...]`.
+        [[nodiscard]] auto describe() const -> std::string;
+
+        // Writes `describe()` to `out`, which has room for
+        // `describedSizeBound()` characters, and returns its end.
+        auto describeTo(char* out) const -> char*;
+
+        // Upper bound on the length of `describe()`, found without
+        // formatting the elements.
+        [[nodiscard]] auto describedSizeBound() const -> std::size_t;
+
+        // `left <op> right` element by element for `+ - * /`, one side an
+        // array and the other an array as long or a number for every
+        // element. Throws at `op` otherwise.
+        static auto arith(const Token::Literal& left,
+                          const Token::Literal& right, const Token::Token& op)
+            -> Array;
+
+        // For the heap; see Heap.hpp.
+        [[nodiscard]] auto traced() const -> const Traced* {
+            return data_.get();
+        }
+
+        friend auto operator==(const Array& left, const Array& right) -> bool {
+            return left.data_ == right.data_;
+        }
+
+        friend auto operator!=(const Array& left, const Array& right) -> bool {
+            return !(left == right);
+        }
+
+      private:
+
+        struct Data final : Traced {
+            bool                        packed = true;
+            std::vector<double>         numbers;
+            std::vector<Token::Literal> values;
+
+            Data() : Traced(sizeof(Data)) {}
+
+            void trace(Tracer& tracer) const override;
+            void clear() override;
+            [[nodiscard]] auto bytes() const -> std::size_t override;
+        };
+
+        // Moves the elements to `values`.
+        void box() const;
+
+        std::shared_ptr<Data> data_;
+    };
+
+    // Calls a function value with `count` arguments in whichever engine is
+    // running, for builtins that take one.
+    using Caller = std::function<Token::Literal(
+        const Token::Literal& callee, const Token::Literal* arguments,
+        std::size_t count)>;
+
+    // A method arrays have built in: `a.sum()`. It is not a value; calls
+    // go to it straight from the site, with the array as the receiver.
+    struct Builtin {
+        static constexpr std::size_t MAX_ARITY = 1;
+
+        using Run = auto (*)(const Array& self, const Token::Literal* arguments,
+                             const Token::Token& paren, const Caller& call)
+            -> Token::Literal;
+
+        std::string_view name;
+        std::size_t      arity;
+        Run              run;
+
+        // The builtin called `name`, or null.
+        static auto find(std::string_view name) -> const Builtin*;
+    };
+
+    // A builtin on its way from a property site to the call, in an engine
+    // that keeps the callee in a register in between. Never a value a
+    // program sees.
+    struct Method {
+        const Builtin* builtin;
+
+        friend auto operator==(Method left, Method right) -> bool {
+            return left.builtin == right.builtin;
+        }
+
+        friend auto operator!=(Method left, Method right) -> bool {
+            return !(left == right);
+        }
+    };
+}  // namespace Runtime
@@ -12,10 +12,19 @@ namespace AstPrinter {
 
         AstPrinter() = default;
 
-        auto print(Expr::Expr expr) const -> void;
+        explicit AstPrinter(Logger::Logger& logger) : logger_(logger) {}
+
+        // Logs the tree at INFO; does nothing when INFO is disabled.
+        auto print(const Expr::Expr& expr) const -> void {
+            if (logger_.isEnabled(Logger::LogLevel::INFO)) {
+                printTree(expr);
+            }
+        }
 
       private:
 
+        auto printTree(const Expr::Expr& expr) const -> void;
+
         [[nodiscard]] auto visit(const Expr::Variable& expr) const
             -> std::string final;
         [[nodiscard]] auto visit(const Expr::InfixExpr& expr) const
@@ -30,6 +39,26 @@ namespace AstPrinter {
             -> std::string final;
         [[nodiscard]] auto visit(const Expr::TernaryExpr& expr) const
             -> std::string final;
+        [[nodiscard]] auto visit(const Expr::TemplateExpr& expr) const
+            -> std::string final;
+        [[nodiscard]] auto visit(const Expr::AssignExpr& expr) const
+            -> std::string final;
+        [[nodiscard]] auto visit(const Expr::CallExpr& expr) const
+            -> std::string final;
+        [[nodiscard]] auto visit(const Expr::GetExpr& expr) const
+            -> std::string final;
+        [[nodiscard]] auto visit(const Expr::SetExpr& expr) const
+            -> std::string final;
+        [[nodiscard]] auto visit(const Expr::ObjectExpr& expr) const
+            -> std::string final;
+        [[nodiscard]] auto visit(const Expr::SuperExpr& expr) const
+            -> std::string final;
+        [[nodiscard]] auto visit(const Expr::ArrayExpr& expr) const
+            -> std::string final;
+        [[nodiscard]] auto visit(const Expr::IndexExpr& expr) const
+            -> std::string final;
+        [[nodiscard]] auto visit(const Expr::IndexSetExpr& expr) const
+            -> std::string final;
 
         template <typename... ExprPtrs>
         auto parenthesize(std::string name, ExprPtrs&&... exprs) const
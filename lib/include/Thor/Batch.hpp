@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Runtime {
+
+    // Outcome of one script in a batch.
+    struct ScriptResult {
+        std::filesystem::path path;
+        std::string           output;
+        std::string           diagnostics;  // WARN and above
+        double                seconds = 0;
+        bool                  ok      = false;
+    };
+
+    struct BatchReport {
+        std::vector<ScriptResult> scripts;  // In the order given
+        std::size_t               workers = 0;
+        double                    seconds = 0;
+
+        [[nodiscard]] auto failed() const -> std::size_t;
+    };
+
+    // Every `.krp` file under `directory`, sorted by path.
+    auto findScripts(const std::filesystem::path& directory)
+        -> std::vector<std::filesystem::path>;
+
+    // Runs each script on a work-stealing pool of `workers` threads, every
+    // one in its own isolated context. A script fails when it cannot be
+    // read or logs anything at WARN or above.
+    auto runBatch(const std::vector<std::filesystem::path>& scripts,
+                  std::size_t workers) -> BatchReport;
+}  // namespace Runtime
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Environment.hpp"
+#include "Expr.hpp"
+#include "Logger.hpp"
+#include "Output.hpp"
+#include "Stack.hpp"
+#include "Stmt.hpp"
+#include "Tokens.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Closure compilation: each node is turned once into a callable with its
+// operator, constant operands and children already bound, so running it is
+// one indirect call per node, with no visitor or variant dispatch and no
+// operator lookup. Semantics, errors and log lines match the tree-walking
+// interpreter exactly.
+namespace Closure {
+
+    struct Frame;
+
+    using Eval    = std::function<Token::Literal(Frame&)>;
+    using Exec    = std::function<void(Frame&)>;
+    using Program = std::vector<Exec>;
+
+    // How far a loop's running code is optimised: the tree walker, closures,
+    // or closures with JIT sites.
+    enum class Level : std::uint8_t { TREE, CLOSURE, JIT };
+
+    // Told when a loop starts and at each of its back edges, so that a hot
+    // loop can move to better code while it runs; see Tiering.hpp. Both
+    // return code for the whole loop at a level above `level`, to run
+    // instead of the rest of this execution of it, or null to carry on.
+    // Loops keep their state in variables, so the code picks up at the
+    // next test of the condition.
+    //
+    // The tree walker also reports each call it makes, and runs the body
+    // `call` returns, once there is one, instead of walking it.
+    class Loops {
+      public:
+
+        virtual ~Loops() = default;
+
+        virtual auto enter(const Stmt::While& loop, Level level,
+                           const Interpreter::Environment& environment)
+            -> const Exec* = 0;
+        virtual auto backEdge(const Stmt::While& loop, Level level,
+                              const Interpreter::Environment& environment)
+            -> const Exec* = 0;
+        virtual auto call(const Stmt::Definition& function) -> const Exec* = 0;
+    };
+
+    // What compiled code reads and writes while running. Compiled code also
+    // refers to the tree it came from, which has to outlive it.
+    struct Frame {
+        Interpreter::Environment& environment;
+        Output::Writer&           output;
+        Logger::Logger&           logger;
+        Interpreter::Stack&       stack;
+        Stmt::Flow                flow   = Stmt::Flow::NORMAL;
+        Loops*                    loops  = nullptr;  // Only when tiering
+        std::size_t               base   = 0;  // The running call's frame
+        const Runtime::Function*  callee = nullptr;  // Its function, if any
+
+        // The value of a RETURN; for a TAIL_CALL, the function to call.
+        Token::Literal result{};
+    };
+
+    // With `jit`, nodes whose JIT site has compiled code run that code
+    // first and fall back to their closure when it bails out.
+    auto compile(const Expr::Expr& expr, bool jit = false) -> Eval;
+    auto compile(const Stmt::Stmt& stmt, bool jit = false) -> Exec;
+    auto compile(const Stmt::While& loop, bool jit = false) -> Exec;
+    auto compile(const std::vector<Stmt::Stmt>& statements) -> Program;
+
+    // The body of `function`, compiled on first use and kept with it.
+    auto body(const Stmt::Definition& function) -> const Exec&;
+
+    // Runs `function` in the frame at `base`, the top one, with its
+    // arguments in place, then drops the frame and returns the result.
+    // Tail calls run in the same frame.
+    auto call(Frame& frame, Runtime::Function function, std::size_t base)
+        -> Token::Literal;
+
+    // Calls `callee` with `count` arguments from native code, for a
+    // builtin: in a frame of its own on top of the stack, run by `call`.
+    // Throws at `paren` as a call there would.
+    auto apply(Frame& frame, const Token::Literal& callee,
+               const Token::Literal* arguments, std::size_t count,
+               const Token::Token& paren) -> Token::Literal;
+}  // namespace Closure
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "Context.hpp"
+#include "Expr.hpp"
+#include "Interpreter.hpp"
+#include "Tokens.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+// Column-at-a-time evaluation of one expression over many rows.
+//
+// Instead of walking the tree once per row, every `Expr` node is evaluated
+// once for the whole table and produces a column. Numeric arithmetic and
+// comparisons run as SIMD kernels (AVX when the CPU has it), booleans are
+// bitmaps combined 64 rows per word, and strings are dictionary-encoded so
+// comparing against a constant compares integer codes.
+//
+// `&&`, `||` and `?:` narrow a selection vector, so the right-hand side or
+// a branch is only evaluated for the rows that reach it. Nodes without a
+// column kernel fall back to the row interpreter, for the selected rows
+// only. Columns are homogeneous and have no nulls.
+namespace Columnar {
+
+    using Numbers = std::vector<double>;
+
+    // One bit per row, least significant bit first.
+    struct Bitmap {
+        std::vector<std::uint64_t> words;
+
+        [[nodiscard]] auto test(std::size_t row) const -> bool {
+            return ((words[row / 64] >> (row % 64)) & 1U) != 0;
+        }
+    };
+
+    // Each row holds a code into `dictionary`.
+    struct Strings {
+        std::vector<std::uint32_t>                          codes;
+        std::shared_ptr<const std::vector<Runtime::String>> dictionary;
+    };
+
+    // Anything the typed columns cannot hold, one value per row.
+    using Boxed = std::vector<Token::Literal>;
+
+    // A column of one type, or a single value standing for every row.
+    using Column =
+        std::variant<Token::Literal, Numbers, Bitmap, Strings, Boxed>;
+
+    // Columns are shared rather than copied between nodes and tables.
+    using ColumnPtr = std::shared_ptr<const Column>;
+
+    // Ascending indices of the rows still being evaluated.
+    using Selection = std::vector<std::uint32_t>;
+
+    auto makeBitmap(const std::vector<bool>& values) -> Bitmap;
+    auto encodeStrings(const std::vector<std::string>& values) -> Strings;
+
+    // Value of `column` at `row`, as the row interpreter sees it.
+    auto valueAt(const Column& column, std::size_t row) -> Token::Literal;
+
+    // Named input columns, all `rows()` long.
+    class Table {
+      public:
+
+        explicit Table(std::size_t rows) : rows_(rows) {}
+
+        void add(std::string name, Column column);
+
+        // Null if there is no such column.
+        [[nodiscard]] auto find(std::string_view name) const -> ColumnPtr;
+
+        [[nodiscard]] auto rows() const -> std::size_t {
+            return rows_;
+        }
+
+      private:
+
+        std::size_t                                rows_;
+        std::unordered_map<std::string, ColumnPtr> columns_;
+    };
+
+    // Parses a single expression such as `price * qty > 100`.
+    auto parseExpression(Runtime::Context& context, std::string source)
+        -> Expr::Expr;
+
+    // Evaluates `expr` once per row with the tree-walking interpreter,
+    // binding each variable to the row's value of the column with its name.
+    auto evaluateRows(const Expr::Expr& expr, const Table& table) -> Boxed;
+
+    class Evaluator : Expr::Visitor<ColumnPtr> {
+      public:
+
+        explicit Evaluator(const Table& table) : table_(table) {}
+
+        // Evaluates `expr` for every row of the table.
+        auto evaluate(const Expr::Expr& expr) -> ColumnPtr;
+
+      private:
+
+        [[nodiscard]] auto visit(const Expr::Variable& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::InfixExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::GroupExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::LiteralExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::PrefixExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::PostfixExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::TernaryExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::TemplateExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::AssignExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::CallExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::GetExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::SetExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::ObjectExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::SuperExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::ArrayExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::IndexExpr& expr) const
+            -> ColumnPtr final;
+        [[nodiscard]] auto visit(const Expr::IndexSetExpr& expr) const
+            -> ColumnPtr final;
+
+        auto evaluateUnder(const Expr::Expr& expr, const Selection* selection)
+            const -> ColumnPtr;
+        auto logical(const Expr::InfixExpr& expr, bool isAnd) const
+            -> ColumnPtr;
+        auto equality(const Column& left, const Column& right,
+                      bool equal) const -> ColumnPtr;
+        auto truthy(const Column& column) const -> ColumnPtr;
+
+        // The selected rows whose bit in `bits` is `wanted`.
+        auto narrow(const Bitmap& bits, bool wanted) const -> Selection;
+
+        // Runs `expr` through the row interpreter for the selected rows.
+        auto evaluateRowWise(const Expr::Expr& expr) const -> ColumnPtr;
+        auto applyRowWise(const Token::Token& op, const Column& left,
+                          const Column& right) const -> ColumnPtr;
+
+        // Narrows a boxed column to a typed one when the selected rows
+        // all have the same type.
+        auto pack(Boxed values) const -> ColumnPtr;
+
+        [[nodiscard]] auto rows() const -> std::size_t {
+            return table_.rows();
+        }
+
+        [[nodiscard]] auto selectedRows() const -> std::size_t {
+            return selection_ != nullptr ? selection_->size() : rows();
+        }
+
+        // Whether kernels should touch only the selected rows rather than
+        // sweep the whole column.
+        [[nodiscard]] auto sparse() const -> bool {
+            return selection_ != nullptr && selection_->size() < rows() / 4;
+        }
+
+        template <typename Fn>
+        void forEachSelected(Fn&& fn) const {
+            if (selection_ != nullptr) {
+                for (auto row : *selection_) {
+                    fn(row);
+                }
+            } else {
+                for (std::size_t row = 0; row < rows(); ++row) {
+                    fn(row);
+                }
+            }
+        }
+
+        const Table& table_;
+
+        // The rows the node being visited is evaluated for; null means all.
+        mutable const Selection* selection_ = nullptr;
+
+        // Row interpreter for nodes without a column kernel.
+        mutable Runtime::Context         context_;
+        mutable Interpreter::Interpreter interpreter_{context_};
+    };
+}  // namespace Columnar
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Arena.hpp"
+#include "Interner.hpp"
+#include "Logger.hpp"
+#include "Output.hpp"
+
+#include <memory>
+#include <string>
+
+namespace Runtime {
+
+    // Everything one interpreter instance mutates: its logger, script
+    // output, string interner and allocator. The lexer, parser and
+    // interpreter take a context; two contexts share no mutable state, so
+    // independent scripts can run on different threads at the same time.
+    //
+    // `standard()` wraps the process-wide logger and stdout writer and is
+    // what the default constructors use. A default-constructed context is
+    // isolated: script output is captured in memory, and log lines (WARN
+    // and above unless the level is changed) are collected as diagnostics.
+    class Context {
+      public:
+
+        Context();
+        Context(Logger::Logger& logger, Output::Writer& output);
+
+        Context(const Context&)                    = delete;
+        auto operator=(const Context&) -> Context& = delete;
+
+        static auto standard() -> Context&;
+
+        auto logger() -> Logger::Logger& {
+            return logger_;
+        }
+
+        auto output() -> Output::Writer& {
+            return output_;
+        }
+
+        auto interner() -> Interner& {
+            return interner_;
+        }
+
+        auto arena() -> Arena& {
+            return arena_;
+        }
+
+        // Log lines collected by an isolated context.
+        [[nodiscard]] auto diagnostics() const -> const std::string& {
+            return diagnostics_;
+        }
+
+        auto takeDiagnostics() -> std::string;
+
+      private:
+
+        std::unique_ptr<Logger::Logger> ownedLogger_;
+        std::unique_ptr<Output::Writer> ownedOutput_;
+        Logger::Logger&                 logger_;
+        Output::Writer&                 output_;
+        Interner                        interner_;
+        Arena                           arena_;
+        std::string                     diagnostics_;
+    };
+}  // namespace Runtime
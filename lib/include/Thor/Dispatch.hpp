@@ -0,0 +1,143 @@
+#pragma once
+
+#include "Expr.hpp"
+#include "Symbol.hpp"
+#include "Tokens.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Stmt {
+
+    // Picks the case of a switch for its subject. Labels that are number
+    // or string literals are constants, found by a lookup rather than by
+    // comparing the subject with each in turn, in the way their values
+    // suit:
+    //
+    //  - integers spread over not much more than their count index a jump
+    //    table, one slot per value from the least to the greatest;
+    //  - other numbers are in a sorted array, searched by halves;
+    //  - strings are in a perfect hash over their interned symbols: each
+    //    bucket has a seed found when the switch is parsed that sends its
+    //    labels to slots no other label has, so a lookup hashes the subject
+    //    once and compares one string.
+    //
+    // Other labels are evaluated and compared with `==` in order, though
+    // only those before the case the constants found: constants have no
+    // effect to skip, so the first label equal to the subject wins, as if
+    // every label were compared in order.
+    class Dispatch {
+      public:
+
+        static constexpr std::uint32_t NONE = UINT32_MAX;
+
+        // How number labels are looked up.
+        enum class Numbers : std::uint8_t { NONE, TABLE, SEARCH };
+
+        // A label that is not a constant, and its case.
+        struct Label {
+            Expr::Expr    expr;
+            std::uint32_t index;
+        };
+
+        // From `cases`, each with the `labels` of its case.
+        template <typename Cases>
+        explicit Dispatch(const Cases& cases) {
+            std::uint32_t index = 0;
+            for (const auto& each : cases) {
+                for (const auto& label : each.labels) {
+                    add(label, index);
+                }
+                ++index;
+            }
+            build(index);
+        }
+
+        // The case of the first constant label equal to `subject`, or
+        // NONE.
+        [[nodiscard]] auto constant(const Token::Literal& subject) const
+            -> std::uint32_t;
+
+        // The labels that are not constants, in order.
+        [[nodiscard]] auto dynamic() const -> const std::vector<Label>& {
+            return dynamic_;
+        }
+
+        // How many of `dynamic()` are for cases before `index`, and so are
+        // compared before its constants.
+        [[nodiscard]] auto before(std::uint32_t index) const
+            -> std::uint32_t {
+            return before_[index];
+        }
+
+        // The case `subject` picks, or NONE. `evaluate(i)` is the value of
+        // `dynamic()[i]`, asked for in order and only when needed.
+        template <typename Evaluate>
+        auto select(const Token::Literal& subject, Evaluate&& evaluate) const
+            -> std::uint32_t {
+            auto found = constant(subject);
+            for (std::size_t i = 0; i < dynamic_.size(); ++i) {
+                if (dynamic_[i].index >= found) {
+                    break;
+                }
+                if (equal(subject, evaluate(i))) {
+                    return dynamic_[i].index;
+                }
+            }
+            return found;
+        }
+
+        [[nodiscard]] auto numbers() const -> Numbers {
+            return numbers_;
+        }
+
+        // String labels in the perfect hash.
+        [[nodiscard]] auto strings() const -> std::size_t {
+            return strings_.size();
+        }
+
+      private:
+
+        struct String {
+            Runtime::Symbol symbol;
+            Expr::Expr      label;
+            std::uint32_t   index;
+        };
+
+        static auto equal(const Token::Literal& left,
+                          const Token::Literal& right) -> bool;
+
+        void add(const Expr::Expr& label, std::uint32_t index);
+        void build(std::uint32_t cases);
+        void hashStrings();
+
+        [[nodiscard]] auto number(double value) const -> std::uint32_t;
+        [[nodiscard]] auto string(std::string_view text) const
+            -> std::uint32_t;
+
+        [[nodiscard]] auto bucket(std::size_t hash) const -> std::size_t;
+        [[nodiscard]] auto slot(std::size_t hash, std::uint32_t seed) const
+            -> std::size_t;
+
+        Numbers numbers_ = Numbers::NONE;
+
+        // Constant numbers and their cases, sorted by value, each value
+        // once with the first case that has it. TABLE puts them in
+        // `table_`, by their value less `low_`.
+        std::vector<std::pair<double, std::uint32_t>> sorted_;
+        std::vector<std::uint32_t>                    table_;  // Or NONE
+        double                                        low_ = 0;
+
+        // Each string once, with the first case that has it; `slots_`
+        // holds indices into it, or NONE.
+        std::vector<String>        strings_;
+        std::vector<std::uint32_t> seeds_;  // By bucket
+        std::vector<std::uint32_t> slots_;
+
+        std::vector<Label>         dynamic_;
+        std::vector<std::uint32_t> before_;  // By case
+    };
+}  // namespace Stmt
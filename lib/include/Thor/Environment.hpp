@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Arena.hpp"
+#include "HashMap.hpp"
+#include "Tokens.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Interpreter {
+
+    // Names of the globals a script refers to, numbered in order of first
+    // appearance. The parser resolves every variable to its slot, so at run
+    // time a variable is an index into an Environment, not a name lookup.
+    class Globals {
+      public:
+
+        // The slot for `name`, assigning the next one if it is new.
+        auto slotFor(std::string_view name) -> std::uint32_t;
+
+        [[nodiscard]] auto find(std::string_view name) const
+            -> std::optional<std::uint32_t>;
+
+        [[nodiscard]] auto names() const -> const std::vector<std::string>& {
+            return names_;
+        }
+
+        [[nodiscard]] auto size() const -> std::size_t {
+            return names_.size();
+        }
+
+      private:
+
+        using Slots = Runtime::HashMap<std::string, std::uint32_t,
+                                       Runtime::TextHash, Runtime::TextEqual>;
+
+        Slots                    slots_;
+        std::vector<std::string> names_;
+    };
+
+    // Values of the globals of one interpreter, indexed by slot. Slots that
+    // were never defined read as nil.
+    //
+    // By default the slots live on the heap and grow as the script defines
+    // more. An environment can instead be placed in an arena with a fixed
+    // set of initial values, which is what a compiled program does for each
+    // run: the caller rewinds the arena once the environment is destroyed,
+    // so a run allocates nothing for its variables.
+    class Environment {
+      public:
+
+        Environment() = default;
+        Environment(Runtime::Arena& arena, const Token::Literal* initial,
+                    std::size_t count);
+        ~Environment();
+
+        Environment(const Environment&)                    = delete;
+        auto operator=(const Environment&) -> Environment& = delete;
+
+        void define(std::uint32_t slot, Token::Literal value);
+
+        [[nodiscard]] auto get(std::uint32_t slot) const
+            -> const Token::Literal& {
+            return slot < size_ ? values_[slot] : NIL;
+        }
+
+        // The value in `slot`, to overwrite in place; null until the slot
+        // has been defined, as it may first have to grow.
+        [[nodiscard]] auto find(std::uint32_t slot) -> Token::Literal* {
+            return slot < size_ ? values_ + slot : nullptr;
+        }
+
+        [[nodiscard]] auto size() const -> std::size_t {
+            return size_;
+        }
+
+      private:
+
+        static inline const Token::Literal NIL{};
+
+        void destroyArenaValues();
+
+        Token::Literal*             values_  = nullptr;
+        std::size_t                 size_    = 0;
+        bool                        inArena_ = false;
+        std::vector<Token::Literal> heap_;
+    };
+}  // namespace Interpreter
@@ -19,6 +19,36 @@ namespace Error {
         Token::Token token_;
     };
 
+    // A value a script threw with `throw` that no `catch` has taken yet.
+    // The tree walker and closures throw it as it is; the register VM
+    // finds handlers in a table and only throws it out of the code it
+    // runs, to native calls between them or to report it.
+    class Thrown : public RuntimeException {
+      public:
+
+        Thrown(Token::Token keyword, Token::Literal value)
+            : RuntimeException(std::move(keyword),
+                               "Uncaught " + value.stringify()),
+              value_(std::move(value)) {}
+
+        [[nodiscard]] auto value() const -> const Token::Literal& {
+            return value_;
+        }
+
+      private:
+
+        Token::Literal value_;
+    };
+
+    // What `catch` binds for `error`: the value thrown, or the message of
+    // a runtime error.
+    inline auto caught(const RuntimeException& error) -> Token::Literal {
+        if (const auto* thrown = dynamic_cast<const Thrown*>(&error)) {
+            return thrown->value();
+        }
+        return Token::Literal{std::string(error.what())};
+    }
+
     class ParseException : public std::runtime_error {
       public:
 
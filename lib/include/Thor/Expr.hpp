@@ -1,10 +1,15 @@
 #pragma once
 
+#include "Jit.hpp"
 #include "Logger.hpp"
+#include "Operators.hpp"
 #include "Tokens.hpp"
 #include "Visitor.hpp"
 
+#include <cstdint>
+#include <optional>
 #include <utility>
+#include <vector>
 
 namespace Expr {
 
@@ -12,12 +17,33 @@ namespace Expr {
 
     using Expr = std::shared_ptr<const ExprBase>;
 
+    // Where the variable a name resolved to lives, and what `slot`
+    // indexes. The parser settles on CELL and CAPTURED_CELL once it has
+    // seen the whole function that declares the variable.
+    enum class Storage : std::uint8_t {
+        GLOBAL,         // A global slot
+        LOCAL,          // A slot of the running call's frame
+        CELL,           // A frame slot holding a Runtime::Cell
+        CAPTURE,        // One of the running function's captures
+        CAPTURED_CELL,  // A capture holding a Runtime::Cell
+        SELF,           // The running function itself; `slot` is unused
+    };
+
     struct Variable {
+        // Not resolved to a slot; evaluates to `literal`.
+        static constexpr std::uint32_t UNRESOLVED = UINT32_MAX;
+
         const Token::Token name;
         Token::Literal     literal;
+        std::uint32_t      slot    = UNRESOLVED;
+        Storage            storage = Storage::GLOBAL;
 
         explicit Variable(Token::Token name) : name(std::move(name)) {}
 
+        explicit Variable(Token::Token name, std::uint32_t slot,
+                          Storage storage = Storage::GLOBAL)
+            : name(std::move(name)), slot(slot), storage(storage) {}
+
         explicit Variable(Token::Token name, Token::Literal::LiteralVal value)
             : name(std::move(name)), literal(value) {}
 
@@ -41,11 +67,15 @@ namespace Expr {
         Expr               left;
         const Token::Token operator_;
         Expr               right;
+        // Resolved once here, so evaluating is one kernel lookup and call;
+        // empty for operators that evaluate to nil.
+        const std::optional<Operators::BinaryOp> op;
 
         InfixExpr(Expr left, Token::Token operator_, Expr right)
             : left(std::move(left)),
               operator_(std::move(operator_)),
-              right(std::move(right)) {}
+              right(std::move(right)),
+              op(Operators::toBinaryOp(this->operator_.type)) {}
     };
 
     struct GroupExpr {
@@ -91,6 +121,163 @@ namespace Expr {
               falseExpr(std::move(falseExpr)) {}
     };
 
+    // `name = value`, and the compound forms, which the parser expands to
+    // `name = name <op> value`. Evaluates to the value assigned.
+    // Never SELF or CAPTURE: a captured variable that is assigned lives
+    // in a cell.
+    struct AssignExpr {
+        const Token::Token  name;
+        Expr                value;
+        const std::uint32_t slot;
+        Storage             storage;
+
+        AssignExpr(Token::Token name, Expr value, std::uint32_t slot,
+                   Storage storage = Storage::GLOBAL)
+            : name(std::move(name)),
+              value(std::move(value)),
+              slot(slot),
+              storage(storage) {}
+    };
+
+    // `callee(arguments)`. `paren` is the closing parenthesis, for errors.
+    struct CallExpr {
+        Expr               callee;
+        const Token::Token paren;
+        std::vector<Expr>  arguments;
+
+        CallExpr(Expr callee, Token::Token paren, std::vector<Expr> arguments)
+            : callee(std::move(callee)),
+              paren(std::move(paren)),
+              arguments(std::move(arguments)) {}
+    };
+
+    // `$"text {expr} text"`, split at parse time. `segments` always has one
+    // more entry than `holes`: segments[i] precedes holes[i].
+    struct TemplateExpr {
+        const Token::Token       token;
+        std::vector<std::string> segments;
+        std::vector<Expr>        holes;
+        std::size_t              literalSize;  // Combined size of `segments`
+
+        TemplateExpr(Token::Token token, std::vector<std::string> segments,
+                     std::vector<Expr> holes)
+            : token(std::move(token)),
+              segments(std::move(segments)),
+              holes(std::move(holes)),
+              literalSize(0) {
+            for (const auto& segment : this->segments) {
+                literalSize += segment.size();
+            }
+        }
+    };
+
+    // `object.name`: the object's field `name`, else its class's method
+    // `name`, bound to it. `cache` keeps where the name was for the shapes
+    // this site has seen.
+    struct GetExpr {
+        Expr                 object;
+        const Token::Token   name;
+        Runtime::InlineCache cache;
+
+        GetExpr(Expr object, Token::Token name)
+            : object(std::move(object)), name(std::move(name)) {}
+    };
+
+    // `object.name = value`, which adds the field if the object has none
+    // of that name, and the compound forms, which set it to
+    // `object.name <op> value` with `object` evaluated once. Evaluates to
+    // the value assigned.
+    struct SetExpr {
+        Expr                              object;
+        const Token::Token                name;
+        Expr                              value;
+        const std::optional<Token::Token> operator_;  // Compound forms only
+        Runtime::InlineCache              get;  // Reads the compound forms do
+        Runtime::InlineCache              set;
+
+        SetExpr(Expr object, Token::Token name, Expr value,
+                std::optional<Token::Token> operator_)
+            : object(std::move(object)),
+              name(std::move(name)),
+              value(std::move(value)),
+              operator_(std::move(operator_)) {}
+    };
+
+    // `{name: value, ...}`. Its names are known when parsing, and so is
+    // the shape every object it makes starts with; values[i] goes in
+    // slots[i], and a name given twice keeps its first slot.
+    struct ObjectExpr {
+        const Token::Token                    brace;
+        std::vector<Expr>                     values;
+        std::vector<std::uint32_t>            slots;
+        std::shared_ptr<const Runtime::Shape> shape;
+
+        ObjectExpr(Token::Token brace, std::vector<Expr> values,
+                   std::vector<std::uint32_t>            slots,
+                   std::shared_ptr<const Runtime::Shape> shape)
+            : brace(std::move(brace)),
+              values(std::move(values)),
+              slots(std::move(slots)),
+              shape(std::move(shape)) {}
+    };
+
+    // `super.name`: the method `name` of the superclass of the class whose
+    // method this is, bound to `this`. `superclass` reads the variable the
+    // parser declares for it next to the class.
+    struct SuperExpr {
+        const Token::Token keyword;
+        const Token::Token method;
+        Expr               superclass;
+        Expr               receiver;  // `this`
+
+        SuperExpr(Token::Token keyword, Token::Token method, Expr superclass,
+                  Expr receiver)
+            : keyword(std::move(keyword)),
+              method(std::move(method)),
+              superclass(std::move(superclass)),
+              receiver(std::move(receiver)) {}
+    };
+
+    // `[value, ...]`, a new array each time.
+    struct ArrayExpr {
+        const Token::Token bracket;
+        std::vector<Expr>  values;
+
+        ArrayExpr(Token::Token bracket, std::vector<Expr> values)
+            : bracket(std::move(bracket)), values(std::move(values)) {}
+    };
+
+    // `object[index]`. `bracket` is the closing bracket, for errors.
+    struct IndexExpr {
+        Expr               object;
+        const Token::Token bracket;
+        Expr               index;
+
+        IndexExpr(Expr object, Token::Token bracket, Expr index)
+            : object(std::move(object)),
+              bracket(std::move(bracket)),
+              index(std::move(index)) {}
+    };
+
+    // `object[index] = value`, and the compound forms, which set it to
+    // `object[index] <op> value` with `object` and `index` evaluated once.
+    // Evaluates to the value assigned.
+    struct IndexSetExpr {
+        Expr                              object;
+        const Token::Token                bracket;
+        Expr                              index;
+        Expr                              value;
+        const std::optional<Token::Token> operator_;  // Compound forms only
+
+        IndexSetExpr(Expr object, Token::Token bracket, Expr index, Expr value,
+                     std::optional<Token::Token> operator_)
+            : object(std::move(object)),
+              bracket(std::move(bracket)),
+              index(std::move(index)),
+              value(std::move(value)),
+              operator_(std::move(operator_)) {}
+    };
+
     template <class R>
     struct Visitor : VisitorBase<Variable, R>,
                      VisitorBase<InfixExpr, R>,
@@ -98,14 +285,26 @@ namespace Expr {
                      VisitorBase<LiteralExpr, R>,
                      VisitorBase<PrefixExpr, R>,
                      VisitorBase<PostfixExpr, R>,
-                     VisitorBase<TernaryExpr, R> {};
+                     VisitorBase<TernaryExpr, R>,
+                     VisitorBase<TemplateExpr, R>,
+                     VisitorBase<AssignExpr, R>,
+                     VisitorBase<CallExpr, R>,
+                     VisitorBase<GetExpr, R>,
+                     VisitorBase<SetExpr, R>,
+                     VisitorBase<ObjectExpr, R>,
+                     VisitorBase<SuperExpr, R>,
+                     VisitorBase<ArrayExpr, R>,
+                     VisitorBase<IndexExpr, R>,
+                     VisitorBase<IndexSetExpr, R> {};
 
     class ExprBase {
       public:
 
         using ExprVariant =
             std::variant<Variable, InfixExpr, GroupExpr, LiteralExpr,
-                         PrefixExpr, PostfixExpr, TernaryExpr>;
+                         PrefixExpr, PostfixExpr, TernaryExpr, TemplateExpr,
+                         AssignExpr, CallExpr, GetExpr, SetExpr, ObjectExpr,
+                         SuperExpr, ArrayExpr, IndexExpr, IndexSetExpr>;
 
         explicit ExprBase(ExprVariant variant) : expr_(std::move(variant)) {}
 
@@ -143,9 +342,14 @@ namespace Expr {
             expr_ = std::forward<T>(val);
         }
 
+        [[nodiscard]] auto jitSite() const -> Jit::Site& {
+            return jitSite_;
+        }
+
       private:
 
-        ExprVariant expr_;
+        ExprVariant       expr_;
+        mutable Jit::Site jitSite_;
     };
 
     template <typename T>
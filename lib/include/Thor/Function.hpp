@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Heap.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Stmt {
+    struct Definition;
+}  // namespace Stmt
+
+namespace Token {
+    struct Literal;
+}  // namespace Token
+
+namespace Runtime {
+
+    // A variable closures share and assign: the frame that declared it
+    // holds the cell in the variable's slot, and each closure that
+    // captured it holds it among its captures. Only captured locals that
+    // are assigned live in one; see Stmt::Definition. Never a value a
+    // program sees. Copies share the variable.
+    class Cell {
+      public:
+
+        explicit Cell(Token::Literal value);
+
+        // Both defined in Tokens.hpp, with the value the cell holds.
+        [[nodiscard]] auto get() const -> Token::Literal&;
+
+        // For the heap; see Heap.hpp.
+        [[nodiscard]] auto traced() const -> const Traced*;
+
+        friend auto operator==(const Cell& left, const Cell& right) -> bool {
+            return left.data_ == right.data_;
+        }
+
+        friend auto operator!=(const Cell& left, const Cell& right) -> bool {
+            return !(left == right);
+        }
+
+      private:
+
+        struct Data;
+
+        std::shared_ptr<Data> data_;
+    };
+
+    // A function value: the definition it was made from, which it keeps
+    // alive, as a value can outlive the tree it was declared in (the REPL
+    // drops each line's tree once it has run), and the values of the
+    // enclosing functions' locals its body uses, one per entry of the
+    // definition's `captures`, copied when the value was made. Copies
+    // share both. Two values are equal when they are copies of one, or
+    // when neither captures anything and they share the definition.
+    //
+    // A method taken off an object, `point.move`, is bound: it keeps the
+    // object, after its captures, and a call passes it as `this`.
+    class Function {
+      public:
+
+        explicit Function(std::shared_ptr<const Stmt::Definition> definition);
+
+        Function(std::shared_ptr<const Stmt::Definition> definition,
+                 std::vector<Token::Literal>             captures);
+
+        // A function of `definition` declared by a call running
+        // `enclosing`, with its locals at `locals`; captures what it uses
+        // of them. Both are null at the top level, where nothing is
+        // captured.
+        static auto close(std::shared_ptr<const Stmt::Definition> definition,
+                          const Token::Literal*                   locals,
+                          const Function* enclosing) -> Function;
+
+        [[nodiscard]] auto definition() const -> const Stmt::Definition& {
+            return *record_->definition;
+        }
+
+        [[nodiscard]] auto captures() const
+            -> const std::vector<Token::Literal>& {
+            return record_->captures;
+        }
+
+        // This method bound to `receiver`.
+        [[nodiscard]] auto bind(Token::Literal receiver) const -> Function;
+
+        [[nodiscard]] auto bound() const -> bool {
+            return record_->bound;
+        }
+
+        // What a bound method was bound to.
+        [[nodiscard]] auto receiver() const -> const Token::Literal&;
+
+        [[nodiscard]] auto name() const -> std::string_view;
+
+        // Parameters a call has to pass.
+        [[nodiscard]] auto arity() const -> std::size_t;
+
+        // For the heap; see Heap.hpp. Only a record that captures is
+        // tracked, as the rest never hold a value.
+        [[nodiscard]] auto traced() const -> const Traced* {
+            return record_.get();
+        }
+
+        friend auto operator==(const Function& left, const Function& right)
+            -> bool;
+
+        friend auto operator!=(const Function& left, const Function& right)
+            -> bool {
+            return !(left == right);
+        }
+
+      private:
+
+        // Shared by the copies of a value; sized by what it captures.
+        struct Record final : Traced {
+            std::shared_ptr<const Stmt::Definition> definition;
+            std::vector<Token::Literal>             captures;
+            bool                                    bound = false;
+
+            Record(std::shared_ptr<const Stmt::Definition> definition,
+                   std::vector<Token::Literal> captures, bool bound);
+
+            void trace(Tracer& tracer) const override;
+            void clear() override;
+            [[nodiscard]] auto bytes() const -> std::size_t override;
+        };
+
+        std::shared_ptr<const Record> record_;
+    };
+}  // namespace Runtime
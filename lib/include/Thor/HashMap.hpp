@@ -0,0 +1,382 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Runtime {
+
+    // Spreads a hash over all its bits (the MurmurHash3 finalizer): the
+    // table picks a group with the low bits and a tag with the high ones,
+    // and std::hash of an integer is often the integer.
+    [[nodiscard]] inline auto mix(std::size_t hash) -> std::size_t {
+        auto bits = static_cast<std::uint64_t>(hash);
+        bits ^= bits >> 33;
+        bits *= 0xff51afd7ed558ccdULL;
+        bits ^= bits >> 33;
+        bits *= 0xc4ceb9fe1a85ec53ULL;
+        bits ^= bits >> 33;
+        return static_cast<std::size_t>(bits);
+    }
+
+    // For maps keyed by text, so a `std::string` key is found by a view.
+    struct TextHash {
+        auto operator()(std::string_view text) const -> std::size_t {
+            return std::hash<std::string_view>{}(text);
+        }
+    };
+
+    struct TextEqual {
+        auto operator()(std::string_view left, std::string_view right) const
+            -> bool {
+            return left == right;
+        }
+    };
+
+    // An open-addressing hash map in the style of Swiss tables: one control
+    // byte per slot holds seven bits of the key's hash, and a lookup
+    // compares the bytes of a group of 16 slots against them at once (SSE2,
+    // or a loop without it) before it looks at a key. Slots hold indices
+    // into an array of entries kept in the order they went in, which is the
+    // order iterating gives; erasing leaves a hole there until the next
+    // rehash packs the array. One allocation per array rather than a node
+    // per entry.
+    //
+    // Entries move when the map grows, so pointers to values last only
+    // until the next insert. Not safe to write from two threads.
+    template <typename Key, typename Value, typename Hash = std::hash<Key>,
+              typename Equal = std::equal_to<Key>>
+    class HashMap {
+      public:
+
+        struct Entry {
+            Key   key;
+            Value value;
+        };
+
+        template <bool Const>
+        class Iterator;
+
+        using iterator       = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        HashMap() = default;
+
+        [[nodiscard]] auto size() const -> std::size_t {
+            return entries_.size() - holes_;
+        }
+
+        [[nodiscard]] auto empty() const -> bool {
+            return size() == 0;
+        }
+
+        // Room for `count` entries without growing.
+        void reserve(std::size_t count) {
+            if (count > capacity() * 7 / 8) {
+                rehash(count);
+            }
+        }
+
+        // The value for `key`, or null. `key` is anything `Hash` and
+        // `Equal` take along with a Key.
+        template <typename K>
+        [[nodiscard]] auto find(const K& key) -> Value* {
+            auto found = locate(key, mix(Hash{}(key)));
+            return found != NONE ? &entries_[found]->value : nullptr;
+        }
+
+        template <typename K>
+        [[nodiscard]] auto find(const K& key) const -> const Value* {
+            auto found = locate(key, mix(Hash{}(key)));
+            return found != NONE ? &entries_[found]->value : nullptr;
+        }
+
+        // The value for `key`, made from `args` first if there is none;
+        // and whether it was.
+        template <typename... Args>
+        auto tryEmplace(Key key, Args&&... args) -> std::pair<Value*, bool> {
+            auto hash  = mix(Hash{}(key));
+            auto found = locate(key, hash);
+            if (found != NONE) {
+                return {&entries_[found]->value, false};
+            }
+            if (used_ + 1 > capacity() * 7 / 8) {
+                rehash(size() + 1);
+            }
+            auto slot = free(hash);
+            used_ += control(slot) == EMPTY ? 1 : 0;
+            control(slot) = tag(hash);
+            index(slot)   = static_cast<std::uint32_t>(entries_.size());
+            entries_.emplace_back(
+                Entry{std::move(key), Value(std::forward<Args>(args)...)});
+            hashes_.push_back(hash);
+            return {&entries_.back()->value, true};
+        }
+
+        auto insertOrAssign(Key key, Value value) -> Value& {
+            auto* found = tryEmplace(std::move(key)).first;
+            *found      = std::move(value);
+            return *found;
+        }
+
+        // Whether there was an entry for `key` to erase.
+        template <typename K>
+        auto erase(const K& key) -> bool {
+            auto hash = mix(Hash{}(key));
+            auto slot = probe(key, hash);
+            if (slot == NONE) {
+                return false;
+            }
+            control(slot) = DELETED;
+            entries_[index(slot)].reset();
+            ++holes_;
+            if (holes_ > entries_.size() / 2) {
+                rehash(size());
+            }
+            return true;
+        }
+
+        void clear() {
+            groups_.clear();
+            entries_.clear();
+            hashes_.clear();
+            used_  = 0;
+            holes_ = 0;
+        }
+
+        [[nodiscard]] auto begin() -> iterator {
+            return {&entries_, 0};
+        }
+
+        [[nodiscard]] auto end() -> iterator {
+            return {&entries_, entries_.size()};
+        }
+
+        [[nodiscard]] auto begin() const -> const_iterator {
+            return {&entries_, 0};
+        }
+
+        [[nodiscard]] auto end() const -> const_iterator {
+            return {&entries_, entries_.size()};
+        }
+
+      private:
+
+        static constexpr std::size_t GROUP   = 16;
+        static constexpr std::size_t NONE    = SIZE_MAX;
+        static constexpr std::int8_t EMPTY   = -128;  // 0b10000000
+        static constexpr std::int8_t DELETED = -2;    // 0b11111110
+
+        // The control bytes of 16 slots next to the entries they hold, so
+        // the index a matching byte leads to is in the same cache lines.
+        struct Group {
+            std::int8_t   control[GROUP];
+            std::uint32_t slots[GROUP];
+        };
+
+        auto control(std::size_t slot) -> std::int8_t& {
+            return groups_[slot / GROUP].control[slot % GROUP];
+        }
+
+        [[nodiscard]] auto index(std::size_t slot) const -> std::uint32_t {
+            return groups_[slot / GROUP].slots[slot % GROUP];
+        }
+
+        auto index(std::size_t slot) -> std::uint32_t& {
+            return groups_[slot / GROUP].slots[slot % GROUP];
+        }
+
+        // Full slots have the top bit clear and the hash's top seven below.
+        static auto tag(std::size_t hash) -> std::int8_t {
+            return static_cast<std::int8_t>(hash >> (sizeof(hash) * 8 - 7));
+        }
+
+        // Bit `i` set for each byte `i` of the group equal to `byte`.
+        static auto match(const std::int8_t* group, std::int8_t byte)
+            -> std::uint32_t {
+#if defined(__SSE2__)
+            auto bytes =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+            return static_cast<std::uint32_t>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(byte))));
+#else
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < GROUP; ++i) {
+                mask |= static_cast<std::uint32_t>(group[i] == byte) << i;
+            }
+            return mask;
+#endif
+        }
+
+        [[nodiscard]] auto capacity() const -> std::size_t {
+            return groups_.size() * GROUP;
+        }
+
+        // Groups to look in for `hash`, in order: each next one a step
+        // further than the last, which with a power of two of them visits
+        // every group.
+        template <typename Visit>
+        auto walk(std::size_t hash, Visit&& visit) const -> std::size_t {
+            auto groups = capacity() / GROUP;
+            auto group  = hash & (groups - 1);
+            for (std::size_t step = 1;; ++step) {
+                auto found = visit(group * GROUP);
+                if (found != NONE) {
+                    return found;
+                }
+                group = (group + step) & (groups - 1);
+            }
+        }
+
+        // The slot holding `key`, or NONE.
+        template <typename K>
+        auto probe(const K& key, std::size_t hash) const -> std::size_t {
+            if (capacity() == 0) {
+                return NONE;
+            }
+            auto tagged = tag(hash);
+            auto absent = capacity();
+            auto slot   = walk(hash, [&](std::size_t first) {
+                const auto* group = groups_[first / GROUP].control;
+                for (auto mask = match(group, tagged); mask != 0;
+                     mask &= mask - 1) {
+                    auto at    = first + static_cast<std::size_t>(
+                                             __builtin_ctz(mask));
+                    // The tag rules out all but about 1 in 128 others.
+                    if (Equal{}(entries_[index(at)]->key, key)) {
+                        return at;
+                    }
+                }
+                // A group with an empty slot ends the search: an insert
+                // would have stopped there.
+                return match(group, EMPTY) != 0 ? absent : NONE;
+            });
+            return slot == absent ? NONE : slot;
+        }
+
+        template <typename K>
+        auto locate(const K& key, std::size_t hash) const -> std::size_t {
+            auto slot = probe(key, hash);
+            return slot != NONE ? index(slot) : NONE;
+        }
+
+        // The first empty or deleted slot for `hash`; there is one.
+        auto free(std::size_t hash) const -> std::size_t {
+            return walk(hash, [&](std::size_t first) {
+                const auto* group = groups_[first / GROUP].control;
+                auto mask = match(group, EMPTY) | match(group, DELETED);
+                return mask != 0 ? first + static_cast<std::size_t>(
+                                               __builtin_ctz(mask))
+                                 : NONE;
+            });
+        }
+
+        // Room for `count` entries at most 7/8 full, with the entries
+        // packed and every slot made again.
+        void rehash(std::size_t count) {
+            std::size_t slots = GROUP;
+            while (count > slots * 7 / 8) {
+                slots *= 2;
+            }
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < entries_.size(); ++i) {
+                if (entries_[i]) {
+                    if (kept != i) {
+                        entries_[kept] = std::move(entries_[i]);
+                        hashes_[kept]  = hashes_[i];
+                    }
+                    ++kept;
+                }
+            }
+            entries_.resize(kept);
+            hashes_.resize(kept);
+            entries_.reserve(slots * 7 / 8);
+            hashes_.reserve(slots * 7 / 8);
+            Group empty{};
+            std::fill(std::begin(empty.control), std::end(empty.control),
+                      EMPTY);
+            groups_.assign(slots / GROUP, empty);
+            for (std::size_t entry = 0; entry < kept; ++entry) {
+                auto slot     = free(hashes_[entry]);
+                control(slot) = tag(hashes_[entry]);
+                index(slot)   = static_cast<std::uint32_t>(entry);
+            }
+            used_  = kept;
+            holes_ = 0;
+        }
+
+        std::vector<Group>                groups_;
+        std::vector<std::optional<Entry>> entries_;    // Erased ones empty
+        std::vector<std::size_t>          hashes_;     // For rehashing
+        std::size_t                       used_  = 0;  // Slots not EMPTY
+        std::size_t                       holes_ = 0;  // Erased entries
+    };
+
+    // Over the entries still in the map, in the order they went in.
+    template <typename Key, typename Value, typename Hash, typename Equal>
+    template <bool Const>
+    class HashMap<Key, Value, Hash, Equal>::Iterator {
+      public:
+
+        using Entries = std::conditional_t<
+            Const, const std::vector<std::optional<Entry>>,
+            std::vector<std::optional<Entry>>>;
+
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = Entry;
+        using difference_type   = std::ptrdiff_t;
+        using reference = std::conditional_t<Const, const Entry&, Entry&>;
+        using pointer   = std::conditional_t<Const, const Entry*, Entry*>;
+
+        Iterator(Entries* entries, std::size_t index)
+            : entries_(entries), index_(index) {
+            skip();
+        }
+
+        auto operator*() const -> reference {
+            return *(*entries_)[index_];
+        }
+
+        auto operator->() const -> pointer {
+            return &**this;
+        }
+
+        auto operator++() -> Iterator& {
+            ++index_;
+            skip();
+            return *this;
+        }
+
+        friend auto operator==(const Iterator& left, const Iterator& right)
+            -> bool {
+            return left.index_ == right.index_;
+        }
+
+        friend auto operator!=(const Iterator& left, const Iterator& right)
+            -> bool {
+            return !(left == right);
+        }
+
+      private:
+
+        void skip() {
+            while (index_ < entries_->size() && !(*entries_)[index_]) {
+                ++index_;
+            }
+        }
+
+        Entries*    entries_;
+        std::size_t index_;
+    };
+}  // namespace Runtime
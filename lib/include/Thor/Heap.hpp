@@ -0,0 +1,187 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace Token {
+    struct Literal;
+}  // namespace Token
+
+// Values that hold other values (arrays, objects, cells and closures) are
+// reference counted: one is freed when the last reference to it goes, but
+// a cycle never is, as when an object's field holds the object or a
+// closure sits in a cell it captured. The heap finds those.
+//
+// Each such value is tracked by the heap of the thread that made it: young
+// until it survives a collection, old after. A young collection looks only
+// at values made since the last one, which is where most garbage is; a
+// full one, run once old space has grown enough, looks at them all.
+//
+// Roots need no list. A value with more references than tracked values
+// hold is referenced from outside them, by a VM register, a global or a
+// native frame of the tree walker, and is live, as is all it reaches.
+// The rest only reference each other and are freed by clearing them,
+// which breaks their cycles. So an old value pointing at a young one
+// keeps it alive without a write barrier: the reference is in its count.
+//
+// Nothing moves: native frames hold plain references into values. And a
+// value must be dropped on the thread that made it, as a script's values
+// are; only values that hold none (strings, functions that capture
+// nothing) are shared between threads.
+namespace Runtime {
+
+    class Heap;
+
+    // What a tracked value is shown each value it holds with.
+    class Tracer {
+      public:
+
+        virtual void visit(const Token::Literal& value) = 0;
+
+      protected:
+
+        ~Tracer() = default;
+    };
+
+    // The shared part of a value that can hold others. Made with
+    // std::make_shared, whose count of owners is its references.
+    class Traced : public std::enable_shared_from_this<Traced> {
+      public:
+
+        Traced(const Traced&)                    = delete;
+        auto operator=(const Traced&) -> Traced& = delete;
+
+        virtual ~Traced();
+
+        virtual void trace(Tracer& tracer) const = 0;
+
+        // Drops every value this one holds.
+        virtual void clear() = 0;
+
+        // What this value and the storage it owns take.
+        [[nodiscard]] virtual auto bytes() const -> std::size_t = 0;
+
+      protected:
+
+        // Tracked by the heap of this thread, unless `track` is false for
+        // a value that will never hold another. `size` is what it takes
+        // to begin with, for the heap to tell when to collect.
+        explicit Traced(std::size_t size, bool track = true);
+
+      private:
+
+        friend class Heap;
+
+        Heap*   heap_ = nullptr;
+        Traced* prev_ = nullptr;
+        Traced* next_ = nullptr;
+        bool    old_  = false;
+
+        // Kept between collections for old values, whose bytes leave the
+        // old space's total with them.
+        std::size_t size_ = 0;
+
+        // A collection's scratch: references from outside the values it
+        // looks at, and whether it looks at this one and found it live.
+        mutable std::int64_t outside_ = 0;
+        mutable bool         looked_  = false;
+        mutable bool         live_    = false;
+    };
+
+    class Heap {
+      public:
+
+        struct Options {
+            bool enabled = true;
+
+            // Bytes made between young collections; as their pause grows
+            // with what they look at, this bounds it.
+            std::size_t nursery = 256 * 1024;
+
+            // How much old space grows since the last full collection
+            // before the next.
+            double growth = 2.0;
+        };
+
+        // Collections, by pause: under 10 us, 100 us, 1 ms, 10 ms, 100 ms,
+        // and longer.
+        static constexpr std::size_t PAUSE_BUCKETS = 6;
+
+        struct Stats {
+            std::uint64_t young        = 0;  // Collections
+            std::uint64_t full         = 0;
+            std::uint64_t promoted     = 0;  // Bytes moved to old space
+            std::uint64_t freed        = 0;  // Values in cycles cleared
+            std::uint64_t freedBytes   = 0;
+            double        pauseSeconds = 0;
+            double        longestPause = 0;
+            std::size_t   youngValues  = 0;  // Tracked now
+            std::size_t   oldValues    = 0;
+            std::size_t   oldBytes     = 0;
+
+            std::array<std::uint64_t, PAUSE_BUCKETS> pauses{};
+        };
+
+        Heap() = default;
+        ~Heap();
+
+        Heap(const Heap&)                    = delete;
+        auto operator=(const Heap&) -> Heap& = delete;
+
+        // The heap of the calling thread.
+        static auto current() -> Heap&;
+
+        // Collects the young values, or all of them.
+        void collect(bool full = true);
+
+        [[nodiscard]] auto stats() const -> Stats;
+
+      private:
+
+        friend class Traced;
+
+        struct List {
+            Traced*     head  = nullptr;
+            std::size_t count = 0;
+
+            void add(Traced* value);
+            void remove(Traced* value);
+        };
+
+        void track(Traced* value, std::size_t size);
+        void untrack(Traced* value);
+
+        List        young_;
+        List        old_;
+        std::size_t made_         = 0;  // Bytes since the last collection
+        std::size_t oldBytes_     = 0;
+        std::size_t oldAfterFull_ = 0;
+        bool        collecting_   = false;
+        Stats       stats_;
+    };
+
+    // Parses "off" or "<nursery KiB>,<growth>".
+    auto parseHeapOptions(std::string_view text)
+        -> std::optional<Heap::Options>;
+
+    namespace detail {
+        inline Heap::Options heapOptions;
+    }  // namespace detail
+
+    // For every thread's heap; set before running.
+    inline void setHeapOptions(Heap::Options options) {
+        detail::heapOptions = options;
+    }
+
+    inline auto heapOptions() -> const Heap::Options& {
+        return detail::heapOptions;
+    }
+
+    // A table of `stats`, for --gc-report.
+    auto format(const Heap::Stats& stats) -> std::string;
+}  // namespace Runtime
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Arena.hpp"
+#include "String.hpp"
+
+#include <string_view>
+#include <unordered_map>
+
+namespace Runtime {
+
+    // Deduplicates the strings of one runtime context: every occurrence of
+    // the same text shares one `String` (and its heap node, if any). Keys
+    // are copied into the interner's own arena, which is never rewound.
+    class Interner {
+      public:
+
+        Interner() = default;
+
+        Interner(const Interner&)                    = delete;
+        auto operator=(const Interner&) -> Interner& = delete;
+
+        auto intern(std::string_view text) -> const String&;
+
+        [[nodiscard]] auto size() const -> std::size_t {
+            return strings_.size();
+        }
+
+      private:
+
+        Arena                                        keys_;
+        std::unordered_map<std::string_view, String> strings_;
+    };
+}  // namespace Runtime
@@ -1,20 +1,181 @@
 #pragma once
 
+#include "Closure.hpp"
+#include "Context.hpp"
+#include "Environment.hpp"
 #include "Expr.hpp"
-#include "Logger.hpp"
+#include "Stack.hpp"
 #include "Stmt.hpp"
+#include "Tiering.hpp"
 #include "Tokens.hpp"
+#include "Vm.hpp"
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <utility>
 #include <vector>
 
 namespace Interpreter {
+
+    // How `Interpreter::interpret` runs statements.
+    enum class Engine : std::uint8_t {
+        TREE,     // Walk the tree with the visitors
+        CLOSURE,  // Compile to closures first, see Closure.hpp
+        TIERED,   // Start walking, compile what runs often, see Tiering.hpp
+        VM,       // Lower to register-machine code first, see Vm.hpp
+    };
+
+    namespace detail {
+        inline std::atomic<Engine> engine{Engine::TREE};
+    }  // namespace detail
+
+    // Process-wide, like the JIT mode, for the command line; a
+    // Thor::Program keeps the engine it was compiled for.
+    inline void setEngine(Engine engine) {
+        detail::engine.store(engine, std::memory_order_relaxed);
+    }
+
+    inline auto engine() -> Engine {
+        return detail::engine.load(std::memory_order_relaxed);
+    }
+
     class Interpreter : Expr::Visitor<Token::Literal>, Stmt::Visitor<void> {
       public:
 
         Interpreter() = default;
 
+        explicit Interpreter(Runtime::Context& context)
+            : context_(context),
+              logger_(context.logger()),
+              output_(context.output()) {}
+
+        // Starts with `count` globals set to `globals`, held in the
+        // context's arena; see Environment.
+        Interpreter(Runtime::Context& context, const Token::Literal* globals,
+                    std::size_t count)
+            : context_(context),
+              logger_(context.logger()),
+              output_(context.output()),
+              environment_(context.arena(), globals, count) {}
+
+        // Runs `statments` with the process-wide engine, compiling them for
+        // it first unless it is the tree walker.
         void interpret(const std::vector<Stmt::Stmt>& statments) const;
+        // Runs `statements` with the tree walker, whatever the engine.
+        void walk(const std::vector<Stmt::Stmt>& statements) const;
+        void interpret(const Closure::Program& program) const;
+        void interpret(Tiering::Plan& plan) const;
+        void interpret(const Vm::Program& program) const;
+
+        [[nodiscard]] auto evaluate(const Expr::Expr& expr) const
+            -> Token::Literal;
+
+        [[nodiscard]] auto environment() const -> const Environment& {
+            return environment_;
+        }
+
+        void bind(std::uint32_t slot, Token::Literal value) {
+            environment_.define(slot, std::move(value));
+        }
+
+        // Shared with the compiling engines so all agree on every corner.
+        static auto prefix(const Token::Token& op, Token::Literal value)
+            -> Token::Literal;
+        static auto render(const Expr::TemplateExpr& expr,
+                           const Token::Literal*     values) -> Token::Literal;
+
+        // What a call runs: a function, and for a method, the object its
+        // frame starts with as `this`. A class runs its `init` on a new
+        // instance, which the call then evaluates to. An array method runs
+        // `builtin` instead, with no frame, on the array in `receiver`.
+        struct Target {
+            const Runtime::Function* function;
+            Token::Literal           receiver;  // Nil unless a method
+            bool                     construct = false;
+            const Runtime::Builtin*  builtin   = nullptr;
+        };
+
+        // What a call of `callee` with `arguments` arguments runs; throws
+        // at `paren` if it can't be called so.
+        static auto target(const Token::Literal& callee,
+                           std::size_t arguments, const Token::Token& paren)
+            -> Target;
+
+        // What `object.name(...)` runs: a method goes straight to its
+        // function, with `object` as `this`, without binding it first; a
+        // field is copied to `callee` and called as `target` does.
+        static auto invoke(const Token::Literal&       object,
+                           const Token::Token&         name,
+                           const Runtime::InlineCache& cache,
+                           Token::Literal& callee, std::size_t arguments,
+                           const Token::Token& paren) -> Target;
+
+        // Throws at `paren` unless `function` takes `arguments` arguments.
+        static void expect(const Runtime::Function& function,
+                           std::size_t arguments, const Token::Token& paren);
+        static void expect(const Runtime::Builtin& builtin,
+                           std::size_t arguments, const Token::Token& paren);
+
+        // The builtin `object.name(...)` calls, if `object` is an array and
+        // has one called `name`; else null.
+        static auto builtin(const Token::Literal& object,
+                            const Token::Token&   name)
+            -> const Runtime::Builtin*;
+
+        // Runs `builtin` on `receiver`, an array. Both it and `arguments`
+        // are copied first, as they may be in a stack a call of `call`
+        // grows.
+        static auto run(const Runtime::Builtin& builtin,
+                        const Token::Literal&   receiver,
+                        const Token::Literal* arguments,
+                        const Token::Token& paren, const Runtime::Caller& call)
+            -> Token::Literal;
+
+        // Where `object.name` is: one of its fields, or else a method of its
+        // class; the other is null. Throws at `name` if neither is.
+        struct Property {
+            Token::Literal*          field;
+            const Runtime::Function* method;
+        };
+
+        static auto property(const Token::Literal& object,
+                             const Token::Token&   name,
+                             const Runtime::InlineCache& cache) -> Property;
+
+        // `object.name`, with a method bound to the object.
+        static auto get(const Token::Literal& object, const Token::Token& name,
+                        const Runtime::InlineCache& cache) -> Token::Literal;
+
+        // Sets, or adds, the field `name` of `object`.
+        static void set(const Token::Literal& object, const Token::Token& name,
+                        Token::Literal              value,
+                        const Runtime::InlineCache& cache);
+
+        // `object[index]`, and setting it. Throws at `bracket` unless
+        // `object` is an array and `index` a whole number in range, or an
+        // object and `index` a string, which names a property as `.` does.
+        static auto element(const Token::Literal& object,
+                            const Token::Literal& index,
+                            const Token::Token&   bracket) -> Token::Literal;
+        static void setElement(const Token::Literal& object,
+                               const Token::Literal& index,
+                               Token::Literal        value,
+                               const Token::Token&   bracket);
+
+        // The method `name` of `superclass`, for `super.name`.
+        static auto inherited(const Token::Literal& superclass,
+                              const Token::Token&   name)
+            -> const Runtime::Function&;
+
+        // The class `stmt` declares, with its methods closed as Function
+        // does and `superclass` the value of its superclass expression.
+        static auto declare(const Stmt::Class&       stmt,
+                            const Token::Literal&    superclass,
+                            const Token::Literal*    locals,
+                            const Runtime::Function* enclosing)
+            -> Token::Literal;
 
       private:
 
@@ -32,26 +193,107 @@ namespace Interpreter {
             -> Token::Literal final;
         [[nodiscard]] auto visit(const Expr::TernaryExpr& expr) const
             -> Token::Literal final;
+        [[nodiscard]] auto visit(const Expr::TemplateExpr& expr) const
+            -> Token::Literal final;
+        [[nodiscard]] auto visit(const Expr::AssignExpr& expr) const
+            -> Token::Literal final;
+        [[nodiscard]] auto visit(const Expr::CallExpr& expr) const
+            -> Token::Literal final;
+        [[nodiscard]] auto visit(const Expr::GetExpr& expr) const
+            -> Token::Literal final;
+        [[nodiscard]] auto visit(const Expr::SetExpr& expr) const
+            -> Token::Literal final;
+        [[nodiscard]] auto visit(const Expr::ObjectExpr& expr) const
+            -> Token::Literal final;
+        [[nodiscard]] auto visit(const Expr::SuperExpr& expr) const
+            -> Token::Literal final;
+        [[nodiscard]] auto visit(const Expr::ArrayExpr& expr) const
+            -> Token::Literal final;
+        [[nodiscard]] auto visit(const Expr::IndexExpr& expr) const
+            -> Token::Literal final;
+        [[nodiscard]] auto visit(const Expr::IndexSetExpr& expr) const
+            -> Token::Literal final;
 
         auto visit(const Stmt::Expression& stmt) const -> void final;
         auto visit(const Stmt::Variable& stmt) const -> void final;
         auto visit(const Stmt::Print& stmt) const -> void final;
+        auto visit(const Stmt::Block& stmt) const -> void final;
+        auto visit(const Stmt::If& stmt) const -> void final;
+        auto visit(const Stmt::Switch& stmt) const -> void final;
+        auto visit(const Stmt::While& stmt) const -> void final;
+        auto visit(const Stmt::Break& stmt) const -> void final;
+        auto visit(const Stmt::Continue& stmt) const -> void final;
+        auto visit(const Stmt::Function& stmt) const -> void final;
+        auto visit(const Stmt::Class& stmt) const -> void final;
+        auto visit(const Stmt::Return& stmt) const -> void final;
+        auto visit(const Stmt::Try& stmt) const -> void final;
+        auto visit(const Stmt::Throw& stmt) const -> void final;
 
         void execute(const Stmt::Stmt& stmt) const;
 
-        [[nodiscard]] auto evaluate(const Expr::Expr& expr) const
+        // Gives the variable `variable` declares its first value.
+        void define(const Stmt::Variable& variable,
+                    Token::Literal        value) const;
+
+        // A call with its frame open and its arguments in place; or, for
+        // a builtin, which needs no frame, already made.
+        struct Prepared {
+            std::optional<Runtime::Function> function;
+            std::size_t                      base;
+            Token::Literal constructed;  // The instance, for a class
+            Token::Literal result;       // The builtin's
+        };
+
+        // Opens a frame for `call` and evaluates its arguments into it.
+        // `obj.name(...)` goes straight to the method, without binding it.
+        auto prepare(const Expr::CallExpr& call) const -> Prepared;
+
+        // Runs `function` in the frame at `base`, as Closure::call does.
+        auto call(Runtime::Function function, std::size_t base) const
             -> Token::Literal;
 
-        static auto isTruthy(Token::Literal literal) -> bool;
-        static auto isEqual(Token::Literal left, Token::Literal right) -> bool;
-        [[nodiscard]] static auto validateAndGetInts(
-            const Token::Literal& left, const Token::Literal& right,
-            const Token::Token& op) -> std::pair<int, int>;
+        // Calls `callee` with `count` arguments for a builtin, as
+        // Closure::apply does.
+        auto apply(const Token::Literal& callee,
+                   const Token::Literal* arguments, std::size_t count,
+                   const Token::Token& paren) const -> Token::Literal;
+
+        // Runs the rest of a loop in the code tiering handed over.
+        void resume(const Closure::Exec& code) const;
+
+        [[nodiscard]] auto frame() const -> Closure::Frame {
+            return {environment_,       output_, logger_, stack_,
+                    Stmt::Flow::NORMAL, loops_,  base_,   callee_};
+        }
+
+        // Runs `count` statements through `statement(index)`, stopping at
+        // the first runtime error.
+        template <typename Fn>
+        void run(std::uint32_t count, Fn&& statement) const;
 
         static void assertBothNumber(const Token::Literal& left,
                                      const Token::Literal& right,
                                      const Token::Token&   op);
 
-        Logger::Logger& logger_ = Logger::Logger::instance();
+        Runtime::Context& context_ = Runtime::Context::standard();
+        Logger::Logger&   logger_  = context_.logger();
+        Output::Writer&   output_  = context_.output();
+
+        // The visitors are const; declarations still have to land here.
+        mutable Environment environment_;
+
+        // Frames of the calls in progress; the running one starts at
+        // `base_`, and runs `callee_`.
+        mutable Stack                    stack_;
+        mutable std::size_t              base_   = 0;
+        mutable const Runtime::Function* callee_ = nullptr;  // Null at top
+
+        // Set by `break` and `continue`, cleared by the loop they leave,
+        // and by `return`, cleared by the call it leaves.
+        mutable Stmt::Flow     flow_ = Stmt::Flow::NORMAL;
+        mutable Token::Literal result_;  // As in Closure::Frame
+
+        // Set while running a tiering plan.
+        mutable Closure::Loops* loops_ = nullptr;
     };
 }  // namespace Interpreter
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Tokens.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace Expr {
+    class ExprBase;
+}  // namespace Expr
+
+namespace Interpreter {
+    class Environment;
+}  // namespace Interpreter
+
+// Template JIT for numeric expressions, x86-64 Linux only.
+//
+// Every `Expr` node carries a `Site` that counts how often the interpreter
+// evaluates it. Once a node is hot, the whole subtree below it is compiled
+// in one pass, each node expanding to a fixed SSE2 template, into a page of
+// executable memory. Compilation specialises on the types the variables
+// hold at that moment (numbers or booleans); strings, nil, templates and
+// `++`/`--` are not compiled, and their subtrees stay interpreted.
+//
+// Compiled code is entered through a stub that checks each variable still
+// has the type it was compiled for and unboxes it. A failed check, a zero
+// divisor or a bitwise operand that is not a non-negative integer bails out
+// to the interpreter, which evaluates the node as if it had never been
+// compiled and reports any error. A node that keeps bailing out is left to
+// the interpreter for good.
+namespace Jit {
+
+    enum class Mode : std::uint8_t {
+        OFF,     // Never compile
+        ON,      // Compile nodes once they are hot
+        ALWAYS,  // Compile every node the first time it is evaluated
+    };
+
+    // Parses "off", "on" or "always".
+    auto parseMode(std::string_view text) -> std::optional<Mode>;
+
+    namespace detail {
+        inline std::atomic<Mode> mode{Mode::OFF};
+    }  // namespace detail
+
+    // Process-wide, like tracing. Off unless set.
+    inline void setMode(Mode mode) {
+        detail::mode.store(mode, std::memory_order_relaxed);
+    }
+
+    inline auto mode() -> Mode {
+        return detail::mode.load(std::memory_order_relaxed);
+    }
+
+    // Whether this build can generate code at all. Elsewhere every mode
+    // behaves as OFF.
+    auto available() -> bool;
+
+    // Process-wide counters, for tests and benchmarks.
+    struct Stats {
+        std::uint64_t compiled;     // Functions generated
+        std::uint64_t bailouts;     // Runs handed back to the interpreter
+        std::uint64_t deoptimized;  // Functions given up on
+    };
+
+    auto stats() -> Stats;
+
+    class Function;
+
+    // Profile and compiled code of one expression node. Safe to use from
+    // several threads at once, as a shared program is.
+    class Site {
+      public:
+
+        Site() = default;
+
+        // A copied node starts cold.
+        Site(const Site& /*other*/) : Site() {}
+        auto operator=(const Site& /*other*/) -> Site& {
+            return *this;
+        }
+
+        ~Site();
+
+        // Whether the interpreter can skip this site without looking.
+        [[nodiscard]] auto rejected() const -> bool {
+            return state_.load(std::memory_order_relaxed) == State::REJECTED;
+        }
+
+        [[nodiscard]] auto compiled() const -> bool {
+            return state_.load(std::memory_order_acquire) == State::COMPILED;
+        }
+
+        // Evaluates `expr` with compiled code, compiling it first if it has
+        // just become hot. Nullopt means the interpreter has to evaluate it.
+        auto run(const Expr::ExprBase&            expr,
+                 const Interpreter::Environment& environment)
+            -> std::optional<Token::Literal>;
+
+        // Compiles `expr` now, however cold, unless it was tried before.
+        // Returns whether compiled code is available.
+        auto prepare(const Expr::ExprBase&            expr,
+                     const Interpreter::Environment& environment) -> bool;
+
+      private:
+
+        enum class State : std::uint8_t { COLD, COMPILING, COMPILED, REJECTED };
+
+        std::atomic<State>         state_{State::COLD};
+        std::atomic<std::uint32_t> hits_{0};
+        std::atomic<std::uint32_t> bailouts_{0};
+        std::atomic<Function*>     function_{nullptr};
+    };
+}  // namespace Jit
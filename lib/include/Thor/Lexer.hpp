@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Logger.hpp"
+#include "Context.hpp"
 #include "Tokens.hpp"
 
 #include <cctype>
@@ -13,6 +13,7 @@ namespace Thor {
       public:
 
         explicit Lexer();
+        explicit Lexer(Runtime::Context& context);
         ~Lexer();
 
         // Disable copy constructor and copy assignment
@@ -83,6 +84,7 @@ namespace Thor {
         uint column_;     // Total Lenght till the previous line
         uint lineStart_;  // Start of the current line
 
-        Logger::Logger& logger_;
+        Runtime::Context& context_;
+        Logger::Logger&   logger_;
     };
 }  // namespace Thor
@@ -1,21 +1,291 @@
-
 #pragma once
 #include <fmt/chrono.h>
 #include <fmt/color.h>
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 namespace Logger {
 
     enum class LogLevel : uint8_t { DEBUG, INFO, WARN, ERROR, FATAL };
 
+#ifndef THOR_MIN_LOG_LEVEL
+#define THOR_MIN_LOG_LEVEL 0
+#endif
+
+    // Lowest level compiled in (CMake option THOR_MIN_LOG_LEVEL). Calls below
+    // it compile to nothing but the evaluation of their arguments; wrap
+    // costly ones in `lazy()` so that is nothing too.
+    constexpr LogLevel MIN_LEVEL = static_cast<LogLevel>(THOR_MIN_LOG_LEVEL);
+
+    // SYNC formats and writes on the calling thread. ASYNC only copies the
+    // arguments into a per-thread ring; a background thread formats and
+    // writes them in batches.
+    enum class Mode : uint8_t { SYNC, ASYNC };
+
+    // What a caller does when its ring is full.
+    enum class OverflowPolicy : uint8_t { DROP, BLOCK };
+
+    // An argument computed only if its message is emitted, e.g.
+    //     debug("{}", lazy([&] { return value.stringify(); }));
+    template <typename Fn>
+    class Lazy {
+      public:
+
+        explicit Lazy(Fn fn) : fn_(std::move(fn)) {}
+
+        auto operator()() const {
+            return fn_();
+        }
+
+      private:
+
+        Fn fn_;
+    };
+
+    template <typename Fn>
+    auto lazy(Fn fn) -> Lazy<Fn> {
+        return Lazy<Fn>(std::move(fn));
+    }
+
+    namespace detail {
+
+        using DecodeFn = void (*)(const std::byte* args,
+                                  fmt::string_view  format,
+                                  fmt::memory_buffer& out);
+
+        // Fixed part of every record in a ring, followed by the encoded
+        // arguments. `size` covers both and is a multiple of 8.
+        struct RecordHeader {
+            std::uint32_t size;
+            bool          padding;  // Filler up to the end of the ring
+            LogLevel      level;
+            std::int64_t  timestamp;  // Nanoseconds since the epoch
+            const char*   format;
+            std::size_t   formatSize;
+            DecodeFn      decode;
+        };
+
+        constexpr auto alignRecord(std::size_t size) -> std::size_t {
+            return (size + 7) & ~std::size_t{7};
+        }
+
+        // Byte ring with one producer (the owning thread) and one consumer
+        // (the backend thread). Records never wrap: if one does not fit in
+        // front of the end, the rest of the ring is skipped with padding.
+        class Ring {
+          public:
+
+            explicit Ring(std::size_t capacity)
+                : capacity_(capacity),
+                  mask_(capacity - 1),
+                  data_(std::make_unique<std::byte[]>(capacity)) {}
+
+            [[nodiscard]] auto capacity() const -> std::size_t {
+                return capacity_;
+            }
+
+            // Marks the ring as done with: its producer has exited, and
+            // writes nothing more.
+            void retire() {
+                retired_.store(true, std::memory_order_release);
+            }
+
+            [[nodiscard]] auto retired() const -> bool {
+                return retired_.load(std::memory_order_acquire);
+            }
+
+            template <typename Fill>
+            auto tryWrite(std::size_t size, Fill&& fill) -> bool {
+                auto head       = head_.load(std::memory_order_relaxed);
+                auto tail       = tail_.load(std::memory_order_acquire);
+                auto offset     = head & mask_;
+                auto contiguous = capacity_ - offset;
+                auto needed     = contiguous < size ? contiguous + size : size;
+                if (capacity_ - (head - tail) < needed) {
+                    return false;
+                }
+                if (contiguous < size) {
+                    RecordHeader pad{};
+                    pad.size    = static_cast<std::uint32_t>(contiguous);
+                    pad.padding = true;
+                    std::memcpy(data_.get() + offset, &pad,
+                                std::min(contiguous, sizeof(pad)));
+                    head += contiguous;
+                    offset = 0;
+                }
+                fill(data_.get() + offset);
+                head_.store(head + size, std::memory_order_release);
+                return true;
+            }
+
+            // Hands every committed record to `read`. Returns false when the
+            // ring was empty.
+            template <typename Read>
+            auto consume(Read&& read) -> bool {
+                auto tail = tail_.load(std::memory_order_relaxed);
+                auto head = head_.load(std::memory_order_acquire);
+                if (tail == head) {
+                    return false;
+                }
+                while (tail != head) {
+                    const std::byte* record = data_.get() + (tail & mask_);
+                    RecordHeader     header{};
+                    std::memcpy(&header, record,
+                                std::min(capacity_ - (tail & mask_),
+                                         sizeof(header)));
+                    if (!header.padding) {
+                        read(header, record + sizeof(RecordHeader));
+                    }
+                    tail += header.size;
+                }
+                tail_.store(tail, std::memory_order_release);
+                return true;
+            }
+
+          private:
+
+            std::size_t                  capacity_;
+            std::size_t                  mask_;
+            std::unique_ptr<std::byte[]> data_;
+
+            alignas(64) std::atomic<std::size_t> head_{0};
+            alignas(64) std::atomic<std::size_t> tail_{0};
+            std::atomic<bool>                    retired_{false};
+        };
+
+        // How one argument travels through the ring: strings as length +
+        // bytes, other trivially copyable values (numbers, enums) as they
+        // are, and anything else formatted to text on the calling thread.
+        template <typename T>
+        constexpr bool IS_TEXT = std::is_convertible_v<const T&,
+                                                       std::string_view>;
+
+        template <typename T>
+        constexpr bool IS_RAW = !IS_TEXT<T> && std::is_trivially_copyable_v<T>;
+
+        template <typename T>
+        struct Evaluated {
+            using type = T;
+        };
+
+        template <typename Fn>
+        struct Evaluated<Lazy<Fn>> {
+            using type = std::decay_t<std::invoke_result_t<const Fn&>>;
+        };
+
+        template <typename T>
+        auto prepare(const T& arg) {
+            if constexpr (!std::is_same_v<typename Evaluated<T>::type, T>) {
+                // The result is a temporary, so text has to be owned.
+                auto value = arg();
+                if constexpr (IS_RAW<decltype(value)>) {
+                    return value;
+                } else if constexpr (IS_TEXT<decltype(value)>) {
+                    return std::string(value);
+                } else {
+                    return fmt::format("{}", value);
+                }
+            } else if constexpr (IS_TEXT<T>) {
+                return std::string_view(arg);
+            } else if constexpr (IS_RAW<T>) {
+                return arg;
+            } else {
+                return fmt::format("{}", arg);
+            }
+        }
+
+        // What the backend hands to fmt for an argument of type T.
+        template <typename T>
+        using Decoded = std::conditional_t<
+            IS_RAW<typename Evaluated<std::decay_t<T>>::type>,
+            typename Evaluated<std::decay_t<T>>::type, std::string_view>;
+
+        template <typename T>
+        auto encodedSize(const T& value) -> std::size_t {
+            if constexpr (IS_RAW<T>) {
+                return sizeof(T);
+            } else {
+                return sizeof(std::uint32_t) + value.size();
+            }
+        }
+
+        template <typename T>
+        auto encode(std::byte* out, const T& value) -> std::byte* {
+            if constexpr (IS_RAW<T>) {
+                std::memcpy(out, &value, sizeof(T));
+                return out + sizeof(T);
+            } else {
+                auto size = static_cast<std::uint32_t>(value.size());
+                std::memcpy(out, &size, sizeof(size));
+                std::memcpy(out + sizeof(size), value.data(), size);
+                return out + sizeof(size) + size;
+            }
+        }
+
+        template <typename T>
+        auto decodeOne(const std::byte*& in) -> T {
+            if constexpr (IS_RAW<T>) {
+                T value;
+                std::memcpy(&value, in, sizeof(T));
+                in += sizeof(T);
+                return value;
+            } else {
+                std::uint32_t size = 0;
+                std::memcpy(&size, in, sizeof(size));
+                auto text = std::string_view(
+                    reinterpret_cast<const char*>(in + sizeof(size)), size);
+                in += sizeof(size) + size;
+                return text;
+            }
+        }
+
+        template <typename... Ts>
+        void decode([[maybe_unused]] const std::byte* args,
+                    fmt::string_view format, fmt::memory_buffer& out) {
+            // Braced initialisation evaluates left to right.
+            std::tuple<Ts...> values{decodeOne<Ts>(args)...};
+            std::apply(
+                [&](const auto&... value) {
+                    fmt::vformat_to(std::back_inserter(out), format,
+                                    fmt::make_format_args(value...));
+                },
+                values);
+        }
+    }  // namespace detail
+
+    // Format strings must be string literals (or otherwise outlive the
+    // logger): in ASYNC mode only their address is queued.
+    //
+    // `instance()` is the process-wide logger. Runtime contexts own their
+    // own instances, which share nothing with it or with each other.
     class Logger {
       public:
 
+        // Receives finished lines (one or more, newline-terminated, without
+        // colors) in place of the console output.
+        using Sink = std::function<void(std::string_view)>;
+
+        Logger();
+        ~Logger();
+
         Logger(const Logger&)                    = delete;
         auto operator=(const Logger&) -> Logger& = delete;
 
@@ -26,80 +296,166 @@ namespace Logger {
 
         template <typename... Args>
         void debug(fmt::format_string<Args...> fmt, Args&&... args) {
-            log(LogLevel::DEBUG, fmt, std::forward<Args>(args)...);
+            if constexpr (LogLevel::DEBUG >= MIN_LEVEL) {
+                log(LogLevel::DEBUG, fmt, std::forward<Args>(args)...);
+            }
         }
 
         template <typename... Args>
         void info(fmt::format_string<Args...> fmt, Args&&... args) {
-            log(LogLevel::INFO, fmt, std::forward<Args>(args)...);
+            if constexpr (LogLevel::INFO >= MIN_LEVEL) {
+                log(LogLevel::INFO, fmt, std::forward<Args>(args)...);
+            }
         }
 
         template <typename... Args>
         void warn(fmt::format_string<Args...> fmt, Args&&... args) {
-            log(LogLevel::WARN, fmt, std::forward<Args>(args)...);
+            if constexpr (LogLevel::WARN >= MIN_LEVEL) {
+                log(LogLevel::WARN, fmt, std::forward<Args>(args)...);
+            }
         }
 
         template <typename... Args>
         void error(fmt::format_string<Args...> fmt, Args&&... args) {
-            log(LogLevel::ERROR, fmt, std::forward<Args>(args)...);
+            if constexpr (LogLevel::ERROR >= MIN_LEVEL) {
+                log(LogLevel::ERROR, fmt, std::forward<Args>(args)...);
+            }
         }
 
         template <typename... Args>
         void fatal(fmt::format_string<Args...> fmt, Args&&... args) {
-            log(LogLevel::FATAL, fmt, std::forward<Args>(args)...);
-        }
-
-        void setLogFile(const std::string& filename) {
-            if (logFile_.is_open()) {
-                logFile_.close();
+            if constexpr (LogLevel::FATAL >= MIN_LEVEL) {
+                log(LogLevel::FATAL, fmt, std::forward<Args>(args)...);
             }
-            logFile_.open(filename, std::ios::app);
         }
 
+        void setLogFile(const std::string& filename);
+
+        // Called on the logging thread in SYNC mode and on the backend
+        // thread in ASYNC mode.
+        void setSink(Sink sink);
+
         void setLevel(LogLevel level) {
             currentLevel_ = level;
         }
 
-      private:
+        // Whether a message at `level` would be emitted; guards work done
+        // only to produce log output.
+        [[nodiscard]] auto isEnabled(LogLevel level) const -> bool {
+            return level >= MIN_LEVEL && level >= currentLevel_;
+        }
 
-        Logger() = default;
+        void setMode(Mode mode);
 
-        ~Logger() {
-            if (logFile_.is_open()) {
-                logFile_.close();
-            }
+        void setOverflowPolicy(OverflowPolicy policy) {
+            policy_ = policy;
+        }
+
+        // Size of the ring created for each logging thread; rounded up to a
+        // power of two. Rings that already exist keep their size.
+        void setRingCapacity(std::size_t bytes);
+
+        // Blocks until everything logged so far has been written.
+        void flush();
+
+        [[nodiscard]] auto droppedCount() const -> std::uint64_t {
+            return dropped_.load(std::memory_order_relaxed);
         }
 
+        // Rings of threads that have logged through this logger and are
+        // still running, or have exited with records not yet written.
+        [[nodiscard]] auto ringCount() -> std::size_t;
+
+      private:
+
         template <typename... Args>
         void log(LogLevel level, fmt::format_string<Args...> fmt,
                  Args&&... args) {
-            if (level < currentLevel_) {
+            if (!isEnabled(level)) {
                 return;
             }
+            auto timestamp =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch())
+                    .count();
 
-            auto now       = std::chrono::system_clock::now();
-            auto timestamp = std::chrono::system_clock::to_time_t(now);
-
-            std::string levelStr   = getLevelString(level);
-            fmt::color  levelColor = getLevelColor(level);
-
-            // Format the message
-            std::string message = fmt::format(fmt, std::forward<Args>(args)...);
+            if (mode_ == Mode::SYNC) {
+                auto message = fmt::format(fmt, std::forward<Args>(args)...);
+                writeNow(level, timestamp, message);
+                return;
+            }
 
-            // Format the final log line
-            std::string logLine =
-                fmt::format("[{}] [{}] {}", levelStr, timestamp, message);
+            using namespace detail;
+            auto prepared = std::make_tuple(prepare(args)...);
+            auto size     = sizeof(RecordHeader);
+            std::apply(
+                [&size](const auto&... value) {
+                    ((size += encodedSize(value)), ...);
+                },
+                prepared);
+            size = alignRecord(size);
 
-            // Console output with colors
-            fmt::print(fg(levelColor), "{}", logLine);
+            auto format = fmt::string_view(fmt);
+            auto fill   = [&](std::byte* out) {
+                RecordHeader header{};
+                header.size       = static_cast<std::uint32_t>(size);
+                header.level      = level;
+                header.timestamp  = timestamp;
+                header.format     = format.data();
+                header.formatSize = format.size();
+                header.decode     = &decode<Decoded<Args>...>;
+                std::memcpy(out, &header, sizeof(header));
+                out += sizeof(header);
+                std::apply(
+                    [&out](const auto&... value) {
+                        ((out = encode(out, value)), ...);
+                    },
+                    prepared);
+            };
+            enqueue(level, timestamp, size, fill, [&] {
+                return fmt::format(fmt, std::forward<Args>(args)...);
+            });
+        }
 
-            // File output without colors
-            if (logFile_.is_open()) {
-                logFile_ << logLine;
-                logFile_.flush();
+        template <typename Fill, typename Format>
+        void enqueue(LogLevel level, std::int64_t timestamp, std::size_t size,
+                     Fill& fill, Format&& format) {
+            auto* ring = threadRing();
+            if (ring == nullptr || size > ring->capacity()) {
+                // Too large to ever fit, or logged while the thread exits:
+                // keep ordering and write it now.
+                flush();
+                writeNow(level, timestamp, format());
+                return;
+            }
+            while (!ring->tryWrite(size, fill)) {
+                if (policy_ == OverflowPolicy::DROP) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                wakeBackend();
+                std::this_thread::yield();
+            }
+            if (level >= LogLevel::ERROR) {
+                flush();
             }
         }
 
+        auto threadRing() -> detail::Ring*;
+        void startBackend();
+        void wakeBackend();
+        void backendLoop();
+        auto drain() -> bool;
+        void writeNow(LogLevel level, std::int64_t timestamp,
+                      std::string_view message);
+        void writeLines(const fmt::memory_buffer& console,
+                        const fmt::memory_buffer& file);
+        void appendLine(LogLevel level, std::int64_t timestamp,
+                        std::string_view message,
+                        fmt::memory_buffer& console, fmt::memory_buffer& file);
+
+        static void flushOnCrash(int signal);
+
         static auto getLevelString(LogLevel level) -> std::string {
             switch (level) {
                 case LogLevel::DEBUG:
@@ -134,8 +490,33 @@ namespace Logger {
             }
         }
 
-        LogLevel      currentLevel_ = LogLevel::DEBUG;
+        LogLevel       currentLevel_ = LogLevel::DEBUG;
+        Mode           mode_         = Mode::ASYNC;
+        OverflowPolicy policy_       = OverflowPolicy::BLOCK;
+        std::size_t    ringCapacity_ = std::size_t{1} << 20U;
+        std::uint64_t  id_;
+
+        std::mutex    fileMutex_;
         std::ofstream logFile_;
+        Sink          sink_;
+
+        // One ring per thread that has logged through this logger, freed
+        // once the thread has exited and the ring is drained.
+        std::mutex                                 ringsMutex_;
+        std::vector<std::shared_ptr<detail::Ring>> rings_;
+
+        // Background writer.
+        std::mutex                 backendMutex_;
+        std::condition_variable    backendWake_;
+        std::condition_variable    flushed_;
+        std::thread                backend_;
+        std::atomic<bool>          started_{false};
+        bool                       stopping_       = false;
+        std::uint64_t              flushRequested_ = 0;
+        std::uint64_t              flushCompleted_ = 0;
+        std::atomic<std::uint64_t> dropped_{0};
+        std::uint64_t              droppedReported_ = 0;
+        std::atomic<std::uint64_t> drains_{0};  // Passes over the rings
     };
 
     // Global logger access function
@@ -144,3 +525,17 @@ namespace Logger {
     }
 
 }  // namespace Logger
+
+template <typename Fn>
+struct fmt::formatter<Logger::Lazy<Fn>> {
+    static constexpr auto parse(format_parse_context& ctx)
+        -> decltype(ctx.begin()) {
+        return ctx.begin();
+    }
+
+    template <typename FormatContext>
+    auto format(const Logger::Lazy<Fn>& value, FormatContext& ctx) const
+        -> decltype(ctx.out()) {
+        return fmt::format_to(ctx.out(), "{}", value());
+    }
+};
@@ -0,0 +1,307 @@
+#pragma once
+
+#include "Function.hpp"
+#include "HashMap.hpp"
+#include "Heap.hpp"
+#include "Symbol.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Token {
+    struct Literal;
+}  // namespace Token
+
+// Objects keep their fields in a dense array, not a map per object: what
+// names an object has, and in which slot each one is, is a shape (a hidden
+// class) that every object which got the same names in the same order
+// shares. A property site remembers the shapes it has seen and where the
+// name was for each, so reading `point.x` again is a pointer compare and
+// an index.
+//
+// An object that keeps getting new names, as one used as a dictionary
+// does, would make a shape for each; past MAX_FIELDS it leaves shapes for
+// a hash map of its own instead, and sites look its names up every time.
+namespace Runtime {
+
+    // Field names and their slots, in the order they were added. Immutable:
+    // adding a name leads to a child shape, made the first time and reused
+    // after, so objects built the same way end up sharing one. Shapes are
+    // process-wide and safe to share between threads.
+    class Shape : public std::enable_shared_from_this<Shape> {
+      public:
+
+        static constexpr std::uint32_t NONE = UINT32_MAX;
+
+        // The shape of `{}`, which object literals grow from.
+        static auto empty() -> const std::shared_ptr<const Shape>&;
+
+        // The shape of every dictionary object. It has no names, and no
+        // site ever caches it.
+        static auto dictionary() -> const std::shared_ptr<const Shape>&;
+
+        // A new shape with no names, unrelated to any other; each class
+        // has its own, so a shape also tells which class an instance is.
+        static auto root() -> std::shared_ptr<const Shape>;
+
+        // The slot of `name`, or NONE.
+        [[nodiscard]] auto find(std::string_view name) const -> std::uint32_t;
+
+        // This shape with `name` added in the next slot.
+        [[nodiscard]] auto with(const std::string& name) const
+            -> std::shared_ptr<const Shape>;
+
+        [[nodiscard]] auto size() const -> std::uint32_t {
+            return static_cast<std::uint32_t>(names_.size());
+        }
+
+        [[nodiscard]] auto names() const -> const std::vector<std::string>& {
+            return names_;
+        }
+
+      private:
+
+        // Up to this many names are searched in order; more get an index.
+        static constexpr std::size_t LINEAR = 8;
+
+        std::vector<std::string>                                   names_;
+        HashMap<std::string_view, std::uint32_t, TextHash, TextEqual> index_;
+
+        // Children by the name they add. Weak, so shapes no object or site
+        // uses any more go away; guarded by one lock for all shapes.
+        mutable std::unordered_map<std::string, std::weak_ptr<const Shape>>
+            transitions_;
+    };
+
+    // A class value: its name, and its methods with those it inherits
+    // copied in, so finding one never walks the superclass chain. Copies
+    // share the class; two values are equal when they are copies of one.
+    class Class {
+      public:
+
+        static constexpr std::uint32_t NONE = UINT32_MAX;
+
+        // Methods are `(name, function)` pairs; those of `superclass`, if
+        // not null, come first, and a method of the same name overrides.
+        // One of the two has an `init`.
+        Class(std::string name, const Class* superclass,
+              std::vector<std::pair<std::string, Function>> methods);
+
+        [[nodiscard]] auto name() const -> std::string_view {
+            return data_->name;
+        }
+
+        // What instances start as.
+        [[nodiscard]] auto shape() const
+            -> const std::shared_ptr<const Shape>& {
+            return data_->shape;
+        }
+
+        // The index of the method called `name`, or NONE.
+        [[nodiscard]] auto find(std::string_view name) const -> std::uint32_t;
+
+        [[nodiscard]] auto method(std::uint32_t index) const
+            -> const Function& {
+            return data_->methods[index];
+        }
+
+        [[nodiscard]] auto initializer() const -> const Function& {
+            return data_->methods[data_->initializer];
+        }
+
+        // Fields the largest instance so far has had, for new ones to make
+        // room for up front.
+        [[nodiscard]] auto width() const -> std::uint32_t {
+            return data_->width.load(std::memory_order_relaxed);
+        }
+
+        void widen(std::uint32_t fields) const;
+
+        friend auto operator==(const Class& left, const Class& right) -> bool {
+            return left.data_ == right.data_;
+        }
+
+        friend auto operator!=(const Class& left, const Class& right) -> bool {
+            return !(left == right);
+        }
+
+      private:
+
+        friend class Object;
+
+        // Only for objects of no class.
+        Class() = default;
+
+        struct Data {
+            std::string                                              name;
+            std::shared_ptr<const Shape>                             shape;
+            std::vector<Function>                                    methods;
+            HashMap<std::string, std::uint32_t, TextHash, TextEqual> index;
+            std::uint32_t                      initializer = 0;
+            mutable std::atomic<std::uint32_t> width{0};
+        };
+
+        std::shared_ptr<const Data> data_;
+    };
+
+    // An object: an instance of a class, or made by an object literal.
+    // Copies share the object, whose fields change in place; two values
+    // are equal when they are copies of one.
+    class Object {
+      public:
+
+        // Fields an object keeps by shape; adding one more makes it a
+        // dictionary.
+        static constexpr std::uint32_t MAX_FIELDS = 32;
+
+        // Fields by name, in the order they were added.
+        using Dictionary = HashMap<Symbol, Token::Literal, Symbol::Hash>;
+
+        // An object of `shape` with its fields all nil; an instance of
+        // `klass` unless that is null.
+        Object(std::shared_ptr<const Shape> shape, const Class* klass);
+
+        [[nodiscard]] auto shape() const -> const Shape& {
+            return *data_->shape;
+        }
+
+        // Set by `reshape`; `fields` grows with it.
+        [[nodiscard]] auto fields() const -> std::vector<Token::Literal>& {
+            return data_->fields;
+        }
+
+        // Moves the object to `shape`, which has one name more than its
+        // own, with the new field set to `value`.
+        void reshape(std::shared_ptr<const Shape> shape,
+                     Token::Literal              value) const;
+
+        // Null for an object literal.
+        [[nodiscard]] auto klass() const -> const Class* {
+            return data_->klass.data_ != nullptr ? &data_->klass : nullptr;
+        }
+
+        // The fields of a dictionary object; null while it has a shape.
+        [[nodiscard]] auto dictionary() const -> Dictionary* {
+            return data_->dictionary.get();
+        }
+
+        // Moves the fields to a dictionary, in the order of the shape's
+        // names, and the object to `Shape::dictionary()`.
+        void makeDictionary() const;
+
+        // For the heap; see Heap.hpp.
+        [[nodiscard]] auto traced() const -> const Traced* {
+            return data_.get();
+        }
+
+        friend auto operator==(const Object& left, const Object& right)
+            -> bool {
+            return left.data_ == right.data_;
+        }
+
+        friend auto operator!=(const Object& left, const Object& right)
+            -> bool {
+            return !(left == right);
+        }
+
+      private:
+
+        // The class is not traced: classes are not tracked, so what its
+        // methods capture stays live while it is.
+        struct Data final : Traced {
+            std::shared_ptr<const Shape> shape;
+            Class                        klass;
+            std::vector<Token::Literal>  fields;
+            std::unique_ptr<Dictionary>  dictionary;
+
+            Data() : Traced(sizeof(Data)) {}
+
+            void trace(Tracer& tracer) const override;
+            void clear() override;
+            [[nodiscard]] auto bytes() const -> std::size_t override;
+        };
+
+        std::shared_ptr<Data> data_;
+    };
+
+    // What a property site found for the shapes it has seen, up to WAYS of
+    // them; a site that sees more is megamorphic and looks names up every
+    // time. Entries are written once and then only read, so sites are
+    // safe to share between threads without a lock.
+    class InlineCache {
+      public:
+
+        static constexpr std::uint32_t WAYS = 4;
+
+        enum class Kind : std::uint8_t {
+            FIELD,   // `index` is the slot
+            METHOD,  // `index` is the method of the shape's class
+            ADD,     // Setting adds the field; `next` is the new shape
+        };
+
+        struct Entry {
+            Kind                         kind  = Kind::FIELD;
+            std::uint32_t                index = 0;
+            std::shared_ptr<const Shape> next{};
+        };
+
+        InlineCache() = default;
+
+        // A copied node starts cold, as a JIT site does.
+        InlineCache(const InlineCache& /*other*/) : InlineCache() {}
+        auto operator=(const InlineCache& /*other*/) -> InlineCache& {
+            return *this;
+        }
+
+        // The entry for `shape`, or null.
+        [[nodiscard]] auto find(const Shape& shape) const -> const Entry* {
+            for (const auto& way : ways_) {
+                if (way.key.load(std::memory_order_acquire) == &shape) {
+                    return &way.entry;
+                }
+            }
+            return nullptr;
+        }
+
+        // Remembers `entry` for `shape`, unless the site is full. Keeps the
+        // shape alive, so its address stays its own.
+        void add(const Shape& shape, Entry entry) const;
+
+        [[nodiscard]] auto megamorphic() const -> bool {
+            return used_.load(std::memory_order_relaxed) >= WAYS;
+        }
+
+        // The symbol of `name`, the one name this site is for; interned
+        // the first time a dictionary object asks.
+        [[nodiscard]] auto key(std::string_view name) const -> Symbol {
+            const auto* record = key_.load(std::memory_order_acquire);
+            if (record == nullptr) {
+                record = Symbol::intern(name).record_;
+                key_.store(record, std::memory_order_release);
+            }
+            return Symbol(record);
+        }
+
+        // Process-wide count of lookups no site had an entry for.
+        static auto misses() -> std::uint64_t;
+        static void miss();
+
+      private:
+
+        struct Way {
+            std::atomic<const Shape*>    key{nullptr};
+            Entry                        entry;
+            std::shared_ptr<const Shape> keep;
+        };
+
+        mutable std::array<Way, WAYS>              ways_;
+        mutable std::atomic<std::uint32_t>         used_{0};
+        mutable std::atomic<const Symbol::Record*> key_{nullptr};
+    };
+}  // namespace Runtime
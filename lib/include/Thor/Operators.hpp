@@ -0,0 +1,196 @@
+#pragma once
+
+#include "Exceptions.hpp"
+#include "Tokens.hpp"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <variant>
+
+namespace Operators {
+
+    // Dense index of every binary operator the interpreter understands.
+    enum class BinaryOp : std::uint8_t {
+        LOGICAL_OR,
+        LOGICAL_AND,
+        BIT_OR,
+        BIT_XOR,
+        BIT_AND,
+        EQUAL_EQUAL,
+        BANG_EQUAL,
+        GREATER,
+        GREATER_EQUAL,
+        LESS,
+        LESS_EQUAL,
+        LEFT_SHIFT,
+        RIGHT_SHIFT,
+        MINUS,
+        PLUS,
+        SLASH,
+        STAR,
+        PERCENT,
+        STAR_STAR,
+        COUNT_,
+    };
+
+    // A kernel evaluates one operator for one (left type, right type) pair.
+    // The operator token is only used for error reporting.
+    using Kernel = auto (*)(const Token::Literal& left,
+                            const Token::Literal& right,
+                            const Token::Token& op) -> Token::Literal;
+
+    constexpr std::size_t OP_COUNT = static_cast<std::size_t>(BinaryOp::COUNT_);
+    constexpr std::size_t TYPE_COUNT =
+        std::variant_size_v<Token::Literal::LiteralVal>;
+
+    using KernelTable =
+        std::array<std::array<std::array<Kernel, TYPE_COUNT>, TYPE_COUNT>,
+                   OP_COUNT>;
+
+    // Generated once at compile time, see Operators.cpp.
+    extern const KernelTable KERNELS;
+
+    constexpr auto toBinaryOp(Token::Type type) -> std::optional<BinaryOp> {
+        switch (type) {
+            case Token::Type::LOGICAL_OR:
+                return BinaryOp::LOGICAL_OR;
+            case Token::Type::LOGICAL_AND:
+                return BinaryOp::LOGICAL_AND;
+            case Token::Type::BIT_OR:
+                return BinaryOp::BIT_OR;
+            case Token::Type::BIT_XOR:
+                return BinaryOp::BIT_XOR;
+            case Token::Type::BIT_AND:
+                return BinaryOp::BIT_AND;
+            case Token::Type::EQUAL_EQUAL:
+                return BinaryOp::EQUAL_EQUAL;
+            case Token::Type::BANG_EQUAL:
+                return BinaryOp::BANG_EQUAL;
+            case Token::Type::GREATER:
+                return BinaryOp::GREATER;
+            case Token::Type::GREATER_EQUAL:
+                return BinaryOp::GREATER_EQUAL;
+            case Token::Type::LESS:
+                return BinaryOp::LESS;
+            case Token::Type::LESS_EQUAL:
+                return BinaryOp::LESS_EQUAL;
+            case Token::Type::LEFT_SHIFT:
+                return BinaryOp::LEFT_SHIFT;
+            case Token::Type::RIGHT_SHIFT:
+                return BinaryOp::RIGHT_SHIFT;
+            case Token::Type::MINUS:
+                return BinaryOp::MINUS;
+            case Token::Type::PLUS:
+                return BinaryOp::PLUS;
+            case Token::Type::SLASH:
+                return BinaryOp::SLASH;
+            case Token::Type::STAR:
+                return BinaryOp::STAR;
+            case Token::Type::PERCENT:
+                return BinaryOp::PERCENT;
+            case Token::Type::STAR_STAR:
+                return BinaryOp::STAR_STAR;
+            default:
+                return std::nullopt;
+        }
+    }
+
+    // Looks up the specialised kernel for the operand types.
+    inline auto kernel(BinaryOp op, const Token::Literal& left,
+                       const Token::Literal& right) -> Kernel {
+        return KERNELS[static_cast<std::size_t>(op)][left.value.index()]
+                      [right.value.index()];
+    }
+
+    inline auto apply(BinaryOp op, const Token::Literal& left,
+                      const Token::Literal& right, const Token::Token& token)
+        -> Token::Literal {
+        return kernel(op, left, right)(left, right, token);
+    }
+
+    // Operators computed inline when both operands are numbers, by engines
+    // that know the operator when compiling; the rest, and every other
+    // type pair, go through the kernel table.
+    template <BinaryOp Op>
+    constexpr bool INLINE_NUMBERS =
+        Op == BinaryOp::PLUS || Op == BinaryOp::MINUS || Op == BinaryOp::STAR ||
+        Op == BinaryOp::SLASH || Op == BinaryOp::GREATER ||
+        Op == BinaryOp::GREATER_EQUAL || Op == BinaryOp::LESS ||
+        Op == BinaryOp::LESS_EQUAL || Op == BinaryOp::EQUAL_EQUAL ||
+        Op == BinaryOp::BANG_EQUAL;
+
+    template <BinaryOp Op>
+    auto numbers(double left, double right) -> Token::Literal {
+        if constexpr (Op == BinaryOp::PLUS) {
+            return Token::Literal{left + right};
+        } else if constexpr (Op == BinaryOp::MINUS) {
+            return Token::Literal{left - right};
+        } else if constexpr (Op == BinaryOp::STAR) {
+            return Token::Literal{left * right};
+        } else if constexpr (Op == BinaryOp::SLASH) {
+            return Token::Literal{left / right};
+        } else if constexpr (Op == BinaryOp::GREATER) {
+            return Token::Literal{left > right};
+        } else if constexpr (Op == BinaryOp::GREATER_EQUAL) {
+            return Token::Literal{left >= right};
+        } else if constexpr (Op == BinaryOp::LESS) {
+            return Token::Literal{left < right};
+        } else if constexpr (Op == BinaryOp::LESS_EQUAL) {
+            return Token::Literal{left <= right};
+        } else if constexpr (Op == BinaryOp::EQUAL_EQUAL) {
+            return Token::Literal{left == right};
+        } else {
+            static_assert(Op == BinaryOp::BANG_EQUAL);
+            return Token::Literal{left != right};
+        }
+    }
+
+    template <BinaryOp Op>
+    auto apply(const Token::Literal& left, const Token::Literal& right,
+               const Token::Token& token) -> Token::Literal {
+        if constexpr (INLINE_NUMBERS<Op>) {
+            if (left.isNumber() && right.isNumber()) {
+                return numbers<Op>(left.asNumber(), right.asNumber());
+            }
+        }
+        return apply(Op, left, right, token);
+    }
+
+    // Evaluates `left <op> right`. Unknown operators evaluate to nil.
+    inline auto apply(const Token::Token& token, const Token::Literal& left,
+                      const Token::Literal& right) -> Token::Literal {
+        auto op = toBinaryOp(token.type);
+        if (!op) {
+            return {};
+        }
+        return apply(*op, left, right, token);
+    }
+
+    // Folds `fn()` into a constant unless it throws, in which case the
+    // error is left to surface at run time, as in the interpreter. Every run
+    // of a program shares its constants, so a rope result is flattened here
+    // rather than on first read, which is not synchronised.
+    template <typename Fn>
+    auto fold(Fn&& fn) -> std::optional<Token::Literal> {
+        try {
+            Token::Literal value = fn();
+            auto* text = std::get_if<Runtime::String>(&value.value);
+            if (text != nullptr && text->isRope()) {
+                *text = Runtime::String(text->view());
+            }
+            return value;
+        } catch (const Error::RuntimeException& /*error*/) {
+            return std::nullopt;
+        }
+    }
+
+    auto isTruthy(const Token::Literal& literal) -> bool;
+    auto isEqual(const Token::Literal& left, const Token::Literal& right)
+        -> bool;
+
+    [[nodiscard]] auto validateAndGetInts(double left, double right,
+                                          const Token::Token& op)
+        -> std::pair<int, int>;
+}  // namespace Operators
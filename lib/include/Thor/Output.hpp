@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Tokens.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace Output {
+
+    // Buffered writer for script output (`print`).
+    //
+    // Values are formatted straight into one reusable buffer, which is
+    // written out when it fills up, at every newline when the descriptor is
+    // a terminal, on `flush()` and when the writer is destroyed. In
+    // unbuffered mode every line is printed immediately through stdio, as
+    // the interpreter used to. A writer created without a descriptor
+    // captures its output in memory instead.
+    class Writer {
+      public:
+
+        static constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+
+        // Captures into memory; read back with `captured()`.
+        Writer();
+        explicit Writer(int fd);
+        ~Writer();
+
+        Writer(const Writer&)                    = delete;
+        auto operator=(const Writer&) -> Writer& = delete;
+
+        // Writer for the process' standard output, flushed at exit.
+        static auto standard() -> Writer&;
+
+        void setUnbuffered(bool unbuffered);
+
+        [[nodiscard]] auto isUnbuffered() const -> bool {
+            return unbuffered_;
+        }
+
+        void write(std::string_view text);
+        void write(const Token::Literal& value);
+
+        // Writes `value` followed by a newline.
+        void writeLine(const Token::Literal& value);
+
+        void flush();
+
+        // Everything written so far by a capturing writer.
+        [[nodiscard]] auto captured() -> const std::string&;
+
+        // Hands over the captured text and starts a new capture.
+        auto takeCaptured() -> std::string;
+
+      private:
+
+        void writeOut(const char* data, std::size_t size);
+        auto reserve(std::size_t size) -> char*;
+
+        int                     fd_;
+        bool                    terminal_;
+        bool                    unbuffered_ = false;
+        std::unique_ptr<char[]> buffer_;
+        std::size_t             size_ = 0;
+        std::string             captured_;
+    };
+}  // namespace Output
@@ -1,13 +1,18 @@
 #pragma once
 
 #include "AstPrinter.hpp"
+#include "Environment.hpp"
 #include "Exceptions.hpp"
 #include "Expr.hpp"
+#include "Lexer.hpp"
 #include "Stmt.hpp"
 #include "TokenType.hpp"
 #include "Tokens.hpp"
 
 #include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -18,12 +23,23 @@ namespace Parser {
 
         Parser() = default;
 
+        explicit Parser(Runtime::Context& context) : context_(context) {}
+
         explicit Parser(std::vector<Token::Token> tokens)
             : tokens_(std::move(tokens)) {}
 
+        Parser(Runtime::Context& context, std::vector<Token::Token> tokens)
+            : tokens_(std::move(tokens)), context_(context) {}
+
         auto parse(std::vector<Token::Token>& tokens)
             -> std::vector<Stmt::Stmt>;
 
+        // Every global named so far, across all calls to `parse`.
+        [[nodiscard]] auto globals() const
+            -> const std::shared_ptr<Interpreter::Globals>& {
+            return globals_;
+        }
+
       private:
 
         using PrefixFn = std::function<Expr::Expr()>;
@@ -62,6 +78,7 @@ namespace Parser {
 
         // Parsing Expressions
         auto expression() -> Expr::Expr;
+        auto assignment() -> Expr::Expr;
         auto ternaryOperator() -> Expr::Expr;
         auto logicalOr() -> Expr::Expr;
         auto logicalAnd() -> Expr::Expr;
@@ -77,7 +94,15 @@ namespace Parser {
         auto prefix() -> Expr::Expr;
         auto postfix() -> Expr::Expr;
         auto primary() -> Expr::Expr;
+        auto call(Expr::Expr callee) -> Expr::Expr;
+        auto object() -> Expr::Expr;
+        auto array() -> Expr::Expr;
+        auto self() -> Expr::Expr;
+        auto super() -> Expr::Expr;
         auto group() -> Expr::Expr;
+        auto templateString() -> Expr::Expr;
+        auto templateHole(std::string source, const Token::Token& token)
+            -> Expr::Expr;
         auto parseInfix(std::function<Expr::Expr()>        next,
                         std::initializer_list<Token::Type> ops,
                         bool rightAssoc = false) -> Expr::Expr;
@@ -85,9 +110,50 @@ namespace Parser {
         // Parsing Statements
         auto declartion() -> Stmt::Stmt;
         auto varDeclartion(Token::Token type) -> Stmt::Stmt;
+        auto functionDeclaration() -> Stmt::Stmt;
+        auto classDeclaration() -> Stmt::Stmt;
+        // The parameters and body of the function or method `name`, whose
+        // `(` was just consumed.
+        auto definition(Token::Token name, bool method)
+            -> std::shared_ptr<const Stmt::Definition>;
         auto statement() -> Stmt::Stmt;
         auto printStatement() -> Stmt::Stmt;
         auto expressionStatement() -> Stmt::Stmt;
+        auto block() -> std::vector<Stmt::Stmt>;
+        auto ifStatement() -> Stmt::Stmt;
+        auto switchStatement() -> Stmt::Stmt;
+        auto caseBody() -> Stmt::Stmt;
+        auto whileStatement() -> Stmt::Stmt;
+        auto forStatement() -> Stmt::Stmt;
+        auto loopBody() -> Stmt::Stmt;
+        auto returnStatement() -> Stmt::Stmt;
+        auto tryStatement() -> Stmt::Stmt;
+
+        // Where a name lives, for the innermost function, and the local
+        // of a function being parsed it is, if it is one.
+        struct Resolved {
+            static constexpr std::size_t NONE = SIZE_MAX;
+
+            std::uint32_t slot;
+            Expr::Storage storage;
+            std::size_t   owner = NONE;  // Index in `functions_`
+            std::uint32_t local = 0;     // Slot in the owner's frame
+        };
+
+        // Declares `name` in the innermost function, or as a global at the
+        // top level.
+        auto declare(const Token::Token& name) -> Resolved;
+        // The innermost function's local called `name`, else the nearest
+        // enclosing function's, captured by every function in between,
+        // else the global. Inside its body, a nested function's own name
+        // is the function itself, unless `assign`.
+        auto resolve(const Token::Token& name, bool assign = false)
+            -> Resolved;
+        // Makes the node `Node{args..., storage}` and, for a local, keeps
+        // it to settle its storage once the owner is parsed.
+        template <typename Node, typename Made, typename... Args>
+        auto make(const Resolved& resolved, Args&&... args)
+            -> std::shared_ptr<Made>;
 
         auto consume(Token::Type type, std::string error) -> Token::Token;
         static auto error(Token::Token token, std::string error)
@@ -112,7 +178,57 @@ namespace Parser {
         uint                      current_ = 0;
         std::vector<Token::Token> tokens_;
 
-        AstPrinter::AstPrinter astPrinter_;
+        Runtime::Context&      context_ = Runtime::Context::standard();
+        AstPrinter::AstPrinter astPrinter_{context_.logger()};
+
+        // Shared with the parsers of template holes.
+        std::shared_ptr<Interpreter::Globals> globals_ =
+            std::make_shared<Interpreter::Globals>();
+
+        std::uint32_t loopDepth_ = 0;  // Loops around the current statement
+        std::uint32_t tryDepth_  = 0;  // Tries around it, in its function
+        std::uint32_t loops_     = 0;  // Loops parsed so far, for their ids
+
+        // A local of a function being parsed. One that a nested function
+        // captures and anything assigns lives in a cell; the nodes that
+        // use it are kept until that is known.
+        struct Local {
+            struct Use {
+                std::shared_ptr<const void> node;
+                Expr::Storage*              storage;  // In `node`
+            };
+
+            bool             captured = false;
+            bool             assigned = false;
+            std::vector<Use> uses;
+        };
+
+        // Locals and captures of the functions being parsed, innermost
+        // last.
+        struct Scope {
+            std::string                                    name;  // Or empty
+            bool                                           initializer = false;
+            std::unordered_map<std::string, std::uint32_t> slots;
+            std::vector<Local>                             locals;  // By slot
+            std::unordered_map<std::string, std::uint32_t> captured;
+            std::vector<Stmt::Capture>                     captures;
+        };
+
+        // Capture of `name` from `from` in `scope`, added if new.
+        static auto capture(Scope& scope, const std::string& name,
+                            Stmt::Capture from) -> std::uint32_t;
+
+        std::vector<Scope> functions_;
+        std::uint32_t      definitions_ = 0;  // Functions parsed so far
+
+        // The classes being parsed, innermost last, for `super`: their
+        // names, and whether each has a superclass.
+        struct Class {
+            std::string name;
+            bool        inherits;
+        };
+
+        std::vector<Class> classes_;
 
     };  // namespace Parser
 }  // namespace Parser
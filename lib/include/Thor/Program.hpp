@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Closure.hpp"
+#include "Context.hpp"
+#include "Environment.hpp"
+#include "Interpreter.hpp"
+#include "Stmt.hpp"
+#include "Tiering.hpp"
+#include "Tokens.hpp"
+#include "Vm.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Thor {
+
+    // Values for a program's globals, bound before each run. Obtain one from
+    // `Program::inputs()`; every global starts out nil.
+    class Inputs {
+      public:
+
+        // Ignored if the program never mentions `name`.
+        auto set(std::string_view name, Token::Literal value) -> Inputs&;
+
+        auto operator[](std::size_t slot) -> Token::Literal& {
+            return values_[slot];
+        }
+
+        [[nodiscard]] auto values() const
+            -> const std::vector<Token::Literal>& {
+            return values_;
+        }
+
+      private:
+
+        friend class Program;
+
+        explicit Inputs(std::shared_ptr<const Interpreter::Globals> globals);
+
+        std::shared_ptr<const Interpreter::Globals> globals_;
+        std::vector<Token::Literal>                 values_;
+    };
+
+    // Result of one run.
+    struct Outputs {
+        std::string                 output;       // What the script printed
+        std::string                 diagnostics;  // Log lines, WARN and up
+        std::vector<Token::Literal> globals;      // Final values, by slot
+
+        [[nodiscard]] auto ok() const -> bool {
+            return diagnostics.empty();
+        }
+    };
+
+    // A script compiled once, for one engine, and run any number of times.
+    //
+    // A program is immutable: copies share the parsed statements (and
+    // their closures, for the closure engine, their register code, for the
+    // VM, and tiering state, for the tiered one), and any number of threads
+    // may run the same program at once. Only what its engine runs is built.
+    // Each run starts from fresh globals, seeded from its Inputs, and its
+    // per-run state is released by rewinding the running context's arena.
+    class Program {
+      public:
+
+        using Engine = Interpreter::Engine;
+
+        // Compiles in an isolated context private to the calling thread.
+        static auto compile(std::string_view source,
+                            Engine           engine = Engine::TREE)
+            -> Program;
+        static auto compile(Runtime::Context& context, std::string_view source,
+                            Engine engine = Engine::TREE) -> Program;
+
+        [[nodiscard]] auto engine() const -> Engine;
+
+        // Lexing and parsing errors. A program with errors still runs the
+        // statements that did parse, as the command line does.
+        [[nodiscard]] auto diagnostics() const -> const std::string&;
+
+        [[nodiscard]] auto ok() const -> bool {
+            return diagnostics().empty();
+        }
+
+        [[nodiscard]] auto source() const -> const std::string&;
+
+        [[nodiscard]] auto slot(std::string_view name) const
+            -> std::optional<std::size_t>;
+
+        [[nodiscard]] auto inputs() const -> Inputs;
+
+        // Runs in an isolated context private to the calling thread.
+        [[nodiscard]] auto run(const Inputs& inputs) const -> Outputs;
+        [[nodiscard]] auto run(Runtime::Context& context,
+                               const Inputs&     inputs) const -> Outputs;
+
+        // Where each statement stands after the runs so far, for the
+        // tiered engine; empty for the others.
+        [[nodiscard]] auto tiers() const -> std::vector<Tiering::RegionReport>;
+
+      private:
+
+        struct Compiled {
+            Engine                                      engine;
+            std::string                                 source;
+            std::vector<Stmt::Stmt>                     statements;
+            Closure::Program                            closures;   // CLOSURE
+            Vm::Program                                 registers;  // VM
+            std::unique_ptr<Tiering::Plan>              plan;       // TIERED
+            std::shared_ptr<const Interpreter::Globals> globals;
+            std::string                                 diagnostics;
+        };
+
+        explicit Program(std::shared_ptr<const Compiled> compiled)
+            : compiled_(std::move(compiled)) {}
+
+        std::shared_ptr<const Compiled> compiled_;
+    };
+
+    inline auto compile(std::string_view    source,
+                        Interpreter::Engine engine = Interpreter::Engine::TREE)
+        -> Program {
+        return Program::compile(source, engine);
+    }
+}  // namespace Thor
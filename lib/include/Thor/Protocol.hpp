@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Tokens.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Wire format of the evaluation server (`krypton --serve=<socket>`).
+//
+// Every message is a frame: a 4-byte little-endian payload length followed
+// by the payload. A connection carries any number of request/response
+// pairs, in order. Strings are encoded as a 4-byte length plus the bytes.
+//
+//   request   kind:u8 (0 source, 1 path)  text:str  count:u32  param*
+//   param     name:str  tag:u8  value (f64 | str | u8 | nothing for nil)
+//   response  status:u8 (0 ok, 1 failed)  output:str  diagnostics:str
+namespace Protocol {
+
+    // Frames larger than this are rejected rather than allocated.
+    constexpr std::uint32_t MAX_FRAME = 64U * 1024 * 1024;
+
+    enum class RequestKind : std::uint8_t { SOURCE, PATH };
+
+    struct Request {
+        RequestKind kind = RequestKind::SOURCE;
+        std::string text;  // Script source, or a path on the server
+
+        // Bound as globals before the script runs.
+        std::vector<std::pair<std::string, Token::Literal>> params;
+    };
+
+    struct Response {
+        bool        ok = false;
+        std::string output;
+        std::string diagnostics;
+    };
+
+    auto encode(const Request& request) -> std::string;
+    auto encode(const Response& response) -> std::string;
+
+    // Nothing if the payload is malformed.
+    auto decodeRequest(std::string_view payload) -> std::optional<Request>;
+    auto decodeResponse(std::string_view payload) -> std::optional<Response>;
+
+    // Blocking frame I/O on a socket. `readFrame` returns false on EOF,
+    // error or an oversized frame.
+    auto writeFrame(int fd, std::string_view payload) -> bool;
+    auto readFrame(int fd, std::string& payload) -> bool;
+
+    // Client side: connects to a server socket; -1 on failure.
+    auto connectTo(const std::string& path) -> int;
+
+    // Sends one request and waits for its response.
+    auto call(int fd, const Request& request) -> std::optional<Response>;
+}  // namespace Protocol
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Context.hpp"
+#include "Program.hpp"
+#include "Protocol.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Runtime {
+
+    // Compiled programs keyed by a 64-bit hash of their source, least
+    // recently used first out. Programs are immutable and shared by every
+    // thread that runs them.
+    class ProgramCache {
+      public:
+
+        explicit ProgramCache(std::size_t capacity) : capacity_(capacity) {}
+
+        static auto hash(std::string_view source) -> std::uint64_t;
+
+        auto find(std::string_view source) -> std::optional<Thor::Program>;
+        void insert(const Thor::Program& program);
+
+        [[nodiscard]] auto hits() const -> std::size_t {
+            return hits_.load();
+        }
+
+        [[nodiscard]] auto misses() const -> std::size_t {
+            return misses_.load();
+        }
+
+      private:
+
+        struct Slot {
+            Thor::Program                      program;
+            std::list<std::uint64_t>::iterator age;
+        };
+
+        std::size_t                             capacity_;
+        std::mutex                              mutex_;
+        std::unordered_map<std::uint64_t, Slot> slots_;
+        std::list<std::uint64_t>                ages_;  // Most recent first
+        std::atomic<std::size_t>                hits_{0};
+        std::atomic<std::size_t>                misses_{0};
+    };
+
+    // Evaluation daemon on a Unix domain socket.
+    //
+    // Each connection is served by its own thread and may send any number of
+    // requests (see Protocol.hpp). Scripts run in one of `workers` contexts
+    // created up front, so at most that many evaluate at once, and parsed
+    // programs come from a shared ProgramCache, so a repeated script skips
+    // lexing and parsing. Every program is compiled for the `engine` option.
+    //
+    // A path request may only name a script under `scriptRoot`, relative to
+    // it or not, once symbolic links and `..` are resolved; without a root,
+    // only source requests are served.
+    class Server {
+      public:
+
+        struct Options {
+            std::string         socketPath;
+            std::size_t         workers       = 4;
+            std::size_t         cacheCapacity = 1024;
+            Interpreter::Engine engine        = Interpreter::Engine::TREE;
+            std::string         scriptRoot{};
+        };
+
+        explicit Server(Options options);
+        ~Server();
+
+        Server(const Server&)                    = delete;
+        auto operator=(const Server&) -> Server& = delete;
+
+        // Binds and listens on the socket, replacing a stale socket file.
+        auto listen() -> bool;
+
+        // Accepts connections until `stop()`, then closes them all.
+        void serve();
+
+        // Makes `serve()` return. Async-signal-safe.
+        void stop();
+
+        // Evaluates one request; what a connection does for each frame.
+        auto handle(const Protocol::Request& request) -> Protocol::Response;
+
+        [[nodiscard]] auto cache() const -> const ProgramCache& {
+            return cache_;
+        }
+
+      private:
+
+        struct Connection {
+            int               fd = -1;
+            std::thread       thread;
+            std::atomic<bool> done{false};
+        };
+
+        void serveConnection(Connection& connection);
+        void reapConnections(bool all);
+
+        // The script at `path`, which must lie under `root_`.
+        [[nodiscard]] auto readScript(const std::string& path) const
+            -> std::string;
+
+        auto acquireContext() -> Context&;
+        void releaseContext(Context& context);
+
+        Options               options_;
+        std::filesystem::path root_;  // Canonical; empty refuses PATH
+        int                   listenFd_ = -1;
+        std::atomic<bool>     stopping_{false};
+        ProgramCache          cache_;
+
+        std::vector<std::unique_ptr<Context>> contexts_;
+        std::vector<Context*>                 idle_;
+        std::mutex                            idleMutex_;
+        std::condition_variable               contextFreed_;
+
+        std::mutex                             connectionsMutex_;
+        std::list<std::unique_ptr<Connection>> connections_;
+    };
+}  // namespace Runtime
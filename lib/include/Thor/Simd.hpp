@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Operators.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include <cstddef>
+
+// Element-wise `+ - * /` over runs of doubles, shared by Columnar's columns
+// and packed arrays. On x86-64 the kernels are also compiled for AVX,
+// whatever the build flags, and take that path when the CPU reports it.
+namespace Simd {
+
+    using Operators::BinaryOp;
+
+    // Kernel operands: a whole run of values, or one value for every
+    // element.
+    struct Dense {
+        const double* data;
+    };
+
+    struct Broadcast {
+        double value;
+    };
+
+    inline auto at(Dense operand, std::size_t index) -> double {
+        return operand.data[index];
+    }
+
+    inline auto at(Broadcast operand, std::size_t /*index*/) -> double {
+        return operand.value;
+    }
+
+    // `left <Op> right`, for PLUS, MINUS, STAR and SLASH.
+    template <BinaryOp Op>
+    inline auto arith(double left, double right) -> double {
+        if constexpr (Op == BinaryOp::PLUS) {
+            return left + right;
+        } else if constexpr (Op == BinaryOp::MINUS) {
+            return left - right;
+        } else if constexpr (Op == BinaryOp::STAR) {
+            return left * right;
+        } else {
+            static_assert(Op == BinaryOp::SLASH);
+            return left / right;
+        }
+    }
+
+#if defined(__x86_64__)
+#define THOR_AVX __attribute__((target("avx")))
+
+    inline const bool HAS_AVX = __builtin_cpu_supports("avx") != 0;
+
+    THOR_AVX inline auto load4(Dense operand, std::size_t index) -> __m256d {
+        return _mm256_loadu_pd(operand.data + index);
+    }
+
+    THOR_AVX inline auto load4(Broadcast operand, std::size_t /*index*/)
+        -> __m256d {
+        return _mm256_set1_pd(operand.value);
+    }
+
+    template <BinaryOp Op>
+    THOR_AVX inline auto arith4(__m256d left, __m256d right) -> __m256d {
+        if constexpr (Op == BinaryOp::PLUS) {
+            return _mm256_add_pd(left, right);
+        } else if constexpr (Op == BinaryOp::MINUS) {
+            return _mm256_sub_pd(left, right);
+        } else if constexpr (Op == BinaryOp::STAR) {
+            return _mm256_mul_pd(left, right);
+        } else {
+            return _mm256_div_pd(left, right);
+        }
+    }
+
+    template <BinaryOp Op, typename L, typename R>
+    THOR_AVX void arithAvx(L left, R right, double* out, std::size_t n) {
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm256_storeu_pd(out + i,
+                             arith4<Op>(load4(left, i), load4(right, i)));
+        }
+        for (; i < n; ++i) {
+            out[i] = arith<Op>(at(left, i), at(right, i));
+        }
+    }
+#endif
+
+    // `out[i] = left[i] <Op> right[i]` for every `i` below `n`.
+    template <BinaryOp Op, typename L, typename R>
+    void arithKernel(L left, R right, double* out, std::size_t n) {
+#if defined(__x86_64__)
+        if (HAS_AVX) {
+            arithAvx<Op>(left, right, out, n);
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = arith<Op>(at(left, i), at(right, i));
+        }
+    }
+
+    // The same, for an op known only at run time.
+    template <typename L, typename R>
+    void arithKernel(BinaryOp op, L left, R right, double* out,
+                     std::size_t n) {
+        switch (op) {
+            case BinaryOp::PLUS:
+                arithKernel<BinaryOp::PLUS>(left, right, out, n);
+                break;
+            case BinaryOp::MINUS:
+                arithKernel<BinaryOp::MINUS>(left, right, out, n);
+                break;
+            case BinaryOp::STAR:
+                arithKernel<BinaryOp::STAR>(left, right, out, n);
+                break;
+            default:
+                arithKernel<BinaryOp::SLASH>(left, right, out, n);
+                break;
+        }
+    }
+}  // namespace Simd
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Exceptions.hpp"
+#include "Tokens.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Interpreter {
+
+    // How deep calls may go before they fail with "Stack overflow.".
+    struct Limits {
+        // Slots all frames together may hold.
+        std::size_t slots = std::size_t{1} << 20;
+
+        // Bytes of native stack the engines that recurse on it, the tree
+        // walker and closures, may use below where the run started. Far
+        // enough under the 8 MiB a thread gets by default to leave room for
+        // what runs in between calls. A call takes about 1 KiB of it in the
+        // tree walker and half that in closures, so either goes a few
+        // thousand calls deep; the register machine only uses slots.
+        std::size_t nativeBytes = std::size_t{4} << 20;
+    };
+
+    namespace detail {
+        inline Limits limits;
+    }  // namespace detail
+
+    // Process-wide, for interpreters made from then on. Set it before
+    // starting any threads.
+    inline void setLimits(Limits limits) {
+        detail::limits = limits;
+    }
+
+    inline auto limits() -> const Limits& {
+        return detail::limits;
+    }
+
+    // Locals of the calls in progress, one frame after another in a single
+    // growable array. A frame is its function's parameters followed by the
+    // rest of its locals. A caller opens the callee's frame on top and
+    // evaluates the arguments straight into its first slots, so a call
+    // copies no argument list; returning drops the frame again.
+    //
+    // Frames are addressed by the index of their first slot, as growing
+    // moves them all.
+    class Stack {
+      public:
+
+        Stack() : Stack(Interpreter::limits()) {}
+
+        explicit Stack(Limits limits) : limits_(limits) {}
+
+        [[nodiscard]] auto operator[](std::size_t index) -> Token::Literal& {
+            return values_[index];
+        }
+
+        [[nodiscard]] auto data() -> Token::Literal* {
+            return values_.data();
+        }
+
+        // Index of the first free slot.
+        [[nodiscard]] auto top() const -> std::size_t {
+            return top_;
+        }
+
+        // Opens a frame of `size` nil slots on top and returns its first
+        // slot. `call` is blamed if it does not fit.
+        auto push(std::size_t size, const Token::Token& call) -> std::size_t {
+            auto base = top_;
+            reserve(base + size, call);
+            for (auto slot = base; slot < base + size; ++slot) {
+                values_[slot] = Token::Literal{};
+            }
+            top_ = base + size;
+            return base;
+        }
+
+        // Drops every frame from `base` up. Their values stay until
+        // overwritten.
+        void pop(std::size_t base) {
+            top_ = base;
+        }
+
+        // Makes the slots up to `end` usable and the top, without clearing
+        // them; for frames the caller lays out itself.
+        void claim(std::size_t end, const Token::Token& call) {
+            reserve(end, call);
+            top_ = end;
+        }
+
+        // Moves the top `size` slots down to `base`, over the frames there:
+        // a tail call's frame replacing its caller's.
+        void slide(std::size_t base, std::size_t size);
+
+        // Moves the value in each of `slots` of the frame at `base` into a
+        // cell of its own, left in the slot: the locals a call shares with
+        // the closures it makes.
+        void box(std::size_t base, const std::vector<std::uint32_t>& slots);
+
+        // Throws unless this call keeps within the native stack budget. The
+        // budget is measured from the first call after `anchor`.
+        void guard(const Token::Token& call) {
+            char here     = 0;
+            auto position = reinterpret_cast<std::uintptr_t>(&here);
+            if (native_ == 0) {
+                native_ = position;
+            }
+            auto used =
+                native_ > position ? native_ - position : position - native_;
+            if (used > limits_.nativeBytes) {
+                throw Error::RuntimeException(call, "Stack overflow.");
+            }
+        }
+
+        // Starts measuring native stack afresh, for a new run.
+        void anchor() {
+            native_ = 0;
+        }
+
+      private:
+
+        void reserve(std::size_t end, const Token::Token& call) {
+            if (end > values_.size()) {
+                grow(end, call);
+            }
+        }
+
+        void grow(std::size_t end, const Token::Token& call);
+
+        Limits                      limits_;
+        std::vector<Token::Literal> values_;
+        std::size_t                 top_    = 0;
+        std::uintptr_t              native_ = 0;
+    };
+}  // namespace Interpreter
@@ -1,9 +1,18 @@
 #pragma once
 
+#include "Dispatch.hpp"
 #include "Expr.hpp"
 #include "Logger.hpp"
 
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <utility>
+#include <vector>
+
+namespace Closure {
+    struct Frame;
+}  // namespace Closure
 
 namespace Stmt {
 
@@ -25,32 +34,296 @@ namespace Stmt {
             : expression(std::move(expression)) {}
     };
 
+    // With CELL storage, each declaration run puts a new cell in the
+    // slot, so closures made before it keep the variable they captured.
     struct Variable {
-        Expr::Expr         initializer;
-        const Token::Token name;
-        const Token::Token type;
+        Expr::Expr          initializer;
+        const Token::Token  name;
+        const Token::Token  type;
+        const std::uint32_t slot;
+        Expr::Storage       storage;  // GLOBAL, LOCAL or CELL
 
         explicit Variable(Token::Token name, Expr::Expr initializer,
-                          Token::Token type)
+                          Token::Token type, std::uint32_t slot,
+                          Expr::Storage storage = Expr::Storage::GLOBAL)
             : initializer(std::move(initializer)),
               name(std::move(name)),
-              type(std::move(type)){};
+              type(std::move(type)),
+              slot(slot),
+              storage(storage){};
+    };
+
+    // How control leaves a statement. Engines keep it in a flag, checked by
+    // blocks and loops after each statement, instead of throwing. RETURN
+    // and TAIL_CALL leave the whole function; see Return.
+    enum class Flow : std::uint8_t {
+        NORMAL,
+        BREAK,
+        CONTINUE,
+        RETURN,
+        TAIL_CALL,
+    };
+
+    // `{ ... }`. Blocks group statements; they do not open a scope.
+    struct Block {
+        std::vector<Stmt> statements;
+
+        explicit Block(std::vector<Stmt> statements)
+            : statements(std::move(statements)) {}
+    };
+
+    struct If {
+        Expr::Expr condition;
+        Stmt       thenBranch;
+        Stmt       elseBranch;  // Null without `else`
+
+        If(Expr::Expr condition, Stmt thenBranch, Stmt elseBranch)
+            : condition(std::move(condition)),
+              thenBranch(std::move(thenBranch)),
+              elseBranch(std::move(elseBranch)) {}
+    };
+
+    // `switch (subject) { case a, b: ... case c: ... else: ... }` runs
+    // the statements of the first case with a label equal to the subject,
+    // or those of `else`, which comes last. Cases do not fall through, and
+    // `break` and `continue` are for the loop around the switch. How the
+    // case is found is worked out once, in `dispatch`.
+    struct Switch {
+        struct Case {
+            std::vector<Expr::Expr> labels;
+            Stmt                    body;  // A Block
+        };
+
+        const Token::Token keyword;
+        Expr::Expr         subject;
+        std::vector<Case>  cases;
+        Stmt               otherwise;  // Null without `else`
+        const Dispatch     dispatch;
+
+        Switch(Token::Token keyword, Expr::Expr subject,
+               std::vector<Case> cases, Stmt otherwise)
+            : keyword(std::move(keyword)),
+              subject(std::move(subject)),
+              cases(std::move(cases)),
+              otherwise(std::move(otherwise)),
+              dispatch(this->cases) {}
+    };
+
+    // `while`, and the loop of a `for`, which the parser expands to its
+    // initializer followed by a While whose `increment` runs after the body
+    // and after every `continue`. `id` numbers the loops of a parse, so
+    // engines can keep per-loop state in a flat table.
+    struct While {
+        Expr::Expr          condition;
+        Stmt                body;
+        Expr::Expr          increment;  // Null for `while`
+        const std::uint32_t id;
+
+        While(Expr::Expr condition, Stmt body, Expr::Expr increment,
+              std::uint32_t id)
+            : condition(std::move(condition)),
+              body(std::move(body)),
+              increment(std::move(increment)),
+              id(id) {}
+    };
+
+    // `break` and `continue`; the parser only accepts them inside a loop.
+    struct Break {
+        const Token::Token keyword;
+
+        explicit Break(Token::Token keyword) : keyword(std::move(keyword)) {}
+    };
+
+    struct Continue {
+        const Token::Token keyword;
+
+        explicit Continue(Token::Token keyword)
+            : keyword(std::move(keyword)) {}
+    };
+
+    // A value a function copies from where it is declared when it is
+    // made: a local of the enclosing function's frame, one of the
+    // enclosing function's own captures, or the enclosing function.
+    struct Capture {
+        enum class From : std::uint8_t { LOCAL, CAPTURE, SELF };
+
+        From          from;
+        std::uint32_t index;  // The frame slot or capture; unused for SELF
+    };
+
+    // What a `func` declares: its parameters and body, with each of its
+    // locals resolved to a slot of the frame a call opens. Shared by the
+    // declaration and every function value made from it. `id` numbers the
+    // functions of a parse, as for loops.
+    //
+    // A function only captures the variables of enclosing functions its
+    // body, or a function nested in it, uses. Captures are flat: each is
+    // copied into the function value, whatever the depth it comes from,
+    // so reading one is an index. A captured variable that anything
+    // assigns is shared instead, through a cell; the declaring function
+    // lists it in `cells` and keeps the cell in its slot.
+    //
+    // A method's frame starts with `this`, in slot 0, before its
+    // parameters; see Class.
+    struct Definition {
+        const Token::Token         name;
+        std::vector<Token::Token>  params;  // The first slots of the frame
+        std::vector<Stmt>          body;
+        const std::uint32_t        locals;  // Frame slots, parameters included
+        const std::uint32_t        id;
+        std::vector<Capture>       captures;
+        std::vector<std::uint32_t> cells;  // Slots a call starts as cells
+        const bool                 method;
+
+        // The body as closures, compiled on its first call through them;
+        // see Closure::body.
+        mutable std::once_flag                       compiled;
+        mutable std::function<void(Closure::Frame&)> code;
+
+        Definition(Token::Token name, std::vector<Token::Token> params,
+                   std::vector<Stmt> body, std::uint32_t locals,
+                   std::uint32_t id, std::vector<Capture> captures = {},
+                   std::vector<std::uint32_t> cells = {}, bool method = false)
+            : name(std::move(name)),
+              params(std::move(params)),
+              body(std::move(body)),
+              locals(locals),
+              id(id),
+              captures(std::move(captures)),
+              cells(std::move(cells)),
+              method(method) {}
+
+        // The slot of the first parameter.
+        [[nodiscard]] auto first() const -> std::uint32_t {
+            return method ? 1 : 0;
+        }
+    };
+
+    // `func name(params) { body }`: sets `name`, a global, or a local of
+    // the enclosing function, to a function value. With CELL storage the
+    // new cell goes in first, so a function that captures its own name
+    // captures the cell it is stored in.
+    struct Function {
+        std::shared_ptr<const Definition> definition;
+        const std::uint32_t               slot;
+        Expr::Storage                     storage;  // GLOBAL, LOCAL or CELL
+
+        Function(std::shared_ptr<const Definition> definition,
+                 std::uint32_t slot, Expr::Storage storage)
+            : definition(std::move(definition)),
+              slot(slot),
+              storage(storage) {}
+    };
+
+    // `class Name : Super { methods }`: sets `name`, as Function does, to
+    // a class whose methods are closed over where it is declared. Each
+    // class has an `init`; the parser makes an empty one for a class that
+    // neither declares nor inherits one. `superclass` reads the variable
+    // `super Name` the parser declares just before, which `super` in the
+    // methods reads too.
+    struct Class {
+        const Token::Token                             name;
+        Expr::Expr                                     superclass;  // Or null
+        std::vector<std::shared_ptr<const Definition>> methods;
+        const std::uint32_t                            slot;
+        Expr::Storage storage;  // GLOBAL, LOCAL or CELL
+
+        Class(Token::Token name, Expr::Expr superclass,
+              std::vector<std::shared_ptr<const Definition>> methods,
+              std::uint32_t slot, Expr::Storage storage)
+            : name(std::move(name)),
+              superclass(std::move(superclass)),
+              methods(std::move(methods)),
+              slot(slot),
+              storage(storage) {}
+    };
+
+    // `return value;`, only inside a function. With `tail`, `value` is a
+    // call whose result the function returns as it is: engines run it in
+    // the returning function's frame rather than in a new one, so a
+    // recursion through tail calls runs in constant stack.
+    struct Return {
+        const Token::Token keyword;
+        Expr::Expr         value;  // Null for `return;`
+        const bool         tail;
+
+        Return(Token::Token keyword, Expr::Expr value, bool tail)
+            : keyword(std::move(keyword)),
+              value(std::move(value)),
+              tail(tail) {}
+    };
+
+    // `try { ... } catch (error) { ... } finally { ... }`, with `catch`,
+    // `finally` or both. `catch` runs when the body throws, with `error`
+    // the value thrown or the message of a runtime error; `finally` runs
+    // however the body and the catch leave, by falling off the end, by
+    // `break`, `continue` or `return`, or by throwing. Should it leave by
+    // one of those itself, that is how the whole statement leaves.
+    struct Try {
+        const Token::Token keyword;
+        Stmt               body;     // A Block
+        Stmt               caught;   // A Variable; null without `catch`
+        Stmt               handler;  // A Block; null without `catch`
+        Stmt               cleanup;  // A Block; null without `finally`
+
+        Try(Token::Token keyword, Stmt body, Stmt caught, Stmt handler,
+            Stmt cleanup)
+            : keyword(std::move(keyword)),
+              body(std::move(body)),
+              caught(std::move(caught)),
+              handler(std::move(handler)),
+              cleanup(std::move(cleanup)) {}
+    };
+
+    // `throw value;` leaves for the innermost `catch` around it, in this
+    // function or in those that called it.
+    struct Throw {
+        const Token::Token keyword;
+        Expr::Expr         value;
+
+        Throw(Token::Token keyword, Expr::Expr value)
+            : keyword(std::move(keyword)), value(std::move(value)) {}
     };
 
     template <class R>
     struct Visitor : VisitorBase<Expression, R>,
                      VisitorBase<Variable, R>,
-                     VisitorBase<Print, R> {};
+                     VisitorBase<Print, R>,
+                     VisitorBase<Block, R>,
+                     VisitorBase<If, R>,
+                     VisitorBase<Switch, R>,
+                     VisitorBase<While, R>,
+                     VisitorBase<Break, R>,
+                     VisitorBase<Continue, R>,
+                     VisitorBase<Function, R>,
+                     VisitorBase<Class, R>,
+                     VisitorBase<Return, R>,
+                     VisitorBase<Try, R>,
+                     VisitorBase<Throw, R> {};
 
 #define OVERRIDE_STMT_VISITOR                                           \
     [[nodiscard]] auto visit(const Expression& stmt) const->void final; \
     [[nodiscard]] auto visit(const Variable& stmt) const->void final;   \
-    [[nodiscard]] auto visit(const Print& stmt) const->void final;
+    [[nodiscard]] auto visit(const Print& stmt) const->void final;      \
+    [[nodiscard]] auto visit(const Block& stmt) const->void final;      \
+    [[nodiscard]] auto visit(const If& stmt) const->void final;         \
+    [[nodiscard]] auto visit(const Switch& stmt) const->void final;     \
+    [[nodiscard]] auto visit(const While& stmt) const->void final;      \
+    [[nodiscard]] auto visit(const Break& stmt) const->void final;      \
+    [[nodiscard]] auto visit(const Continue& stmt) const->void final;   \
+    [[nodiscard]] auto visit(const Function& stmt) const->void final;   \
+    [[nodiscard]] auto visit(const Class& stmt) const->void final;      \
+    [[nodiscard]] auto visit(const Return& stmt) const->void final;     \
+    [[nodiscard]] auto visit(const Try& stmt) const->void final;        \
+    [[nodiscard]] auto visit(const Throw& stmt) const->void final;
 
     class StmtBase {
       public:
 
-        using StmtVariant = std::variant<Expression, Variable, Print>;
+        using StmtVariant =
+            std::variant<Expression, Variable, Print, Block, If, Switch, While,
+                         Break, Continue, Function, Class, Return, Try,
+                         Throw>;
 
         explicit StmtBase(StmtVariant variant) : stmt_(std::move(variant)) {}
 
@@ -0,0 +1,172 @@
+#pragma once
+#include <fmt/format.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace Runtime {
+
+    // Longest text `formatNumber` produces, e.g. "-1.7976931348623157e+308".
+    constexpr std::size_t MAX_NUMBER_CHARS = 32;
+
+    // Writes `number` as `fmt::format("{}", number)` would, without
+    // allocating, and returns the end of the written text. `out` must have
+    // room for MAX_NUMBER_CHARS characters.
+    auto formatNumber(char* out, double number) -> char*;
+
+    // Immutable runtime string.
+    //
+    // Short strings live inline in the object. Longer strings are stored in
+    // a reference-counted heap node that copies share. Concatenating long
+    // strings builds a rope node instead of copying, and a rope is flattened
+    // into one buffer the first time its characters are read, so building a
+    // string by repeated `+` is linear in the final length.
+    //
+    // Reference counts are atomic, so constants may be shared between
+    // threads. Flattening a rope is not synchronised: a rope built at run time
+    // belongs to the interpreter that built it.
+    class String {
+      public:
+
+        static constexpr std::size_t INLINE_CAPACITY = 23;
+
+        String() noexcept : small_{}, smallSize_(0) {}
+
+        String(std::string_view text);  // NOLINT(google-explicit-constructor)
+
+        String(const std::string& text)  // NOLINT(google-explicit-constructor)
+            : String(std::string_view(text)) {}
+
+        String(const char* text)  // NOLINT(google-explicit-constructor)
+            : String(std::string_view(text)) {}
+
+        String(const String& other) noexcept;
+        String(String&& other) noexcept;
+        auto operator=(const String& other) noexcept -> String&;
+        auto operator=(String&& other) noexcept -> String&;
+        ~String();
+
+        [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+        [[nodiscard]] auto empty() const noexcept -> bool {
+            return size() == 0;
+        }
+
+        // Contents as one contiguous buffer; flattens a rope on first use.
+        [[nodiscard]] auto view() const -> std::string_view;
+
+        [[nodiscard]] auto str() const -> std::string {
+            return std::string(view());
+        }
+
+        [[nodiscard]] auto isInline() const noexcept -> bool {
+            return smallSize_ != HEAP;
+        }
+
+        [[nodiscard]] auto isRope() const noexcept -> bool;
+
+        static auto concat(const String& left, const String& right) -> String;
+
+        class Builder;
+
+        friend auto operator+(const String& left, const String& right)
+            -> String {
+            return concat(left, right);
+        }
+
+        friend auto operator==(const String& left, const String& right)
+            -> bool {
+            return left.size() == right.size() && left.view() == right.view();
+        }
+
+        friend auto operator!=(const String& left, const String& right)
+            -> bool {
+            return !(left == right);
+        }
+
+        friend auto operator<(const String& left, const String& right)
+            -> bool {
+            return left.view() < right.view();
+        }
+
+        friend auto operator>(const String& left, const String& right)
+            -> bool {
+            return right < left;
+        }
+
+        friend auto operator<=(const String& left, const String& right)
+            -> bool {
+            return !(right < left);
+        }
+
+        friend auto operator>=(const String& left, const String& right)
+            -> bool {
+            return !(left < right);
+        }
+
+      private:
+
+        struct Node;
+        struct FlatNode;
+        struct RopeNode;
+
+        static constexpr std::uint8_t HEAP = 0xFF;
+
+        explicit String(Node* node) noexcept : node_(node), smallSize_(HEAP) {}
+
+        static void retain(Node* node) noexcept;
+        static void release(Node* node) noexcept;
+        static auto makeFlat(std::size_t size) -> FlatNode*;
+        static auto flatten(const RopeNode& rope) -> FlatNode*;
+
+        // Hands over the heap node (if any) and leaves this string empty.
+        auto detach() noexcept -> Node*;
+
+        union {
+            char  small_[INLINE_CAPACITY];
+            Node* node_;
+        };
+
+        std::uint8_t smallSize_;
+    };
+
+    // Writes a new string in place with at most one allocation: reserve an
+    // upper bound, fill `data()`, then `finish` with the real size.
+    class String::Builder {
+      public:
+
+        explicit Builder(std::size_t capacity);
+
+        [[nodiscard]] auto data() -> char* {
+            return data_;
+        }
+
+        auto finish(std::size_t size) -> String;
+
+      private:
+
+        String result_;
+        char*  data_;
+    };
+}  // namespace Runtime
+
+template <>
+struct std::hash<Runtime::String> {
+    auto operator()(const Runtime::String& text) const -> std::size_t {
+        return std::hash<std::string_view>{}(text.view());
+    }
+};
+
+template <>
+struct fmt::formatter<Runtime::String> : fmt::formatter<std::string_view> {
+    template <typename FormatContext>
+    auto format(const Runtime::String& text, FormatContext& ctx) const
+        -> decltype(ctx.out()) {
+        return fmt::formatter<std::string_view>::format(text.view(), ctx);
+    }
+};
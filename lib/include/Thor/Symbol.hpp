@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace Runtime {
+
+    // A name interned for the whole process: every symbol of the same text
+    // is the same one, so comparing two is comparing pointers, and its hash
+    // is worked out once, when it is first interned, not at each lookup.
+    // Symbols are never freed; they key the fields of dictionary objects,
+    // whose names a program has a bounded number of. Safe to share and to
+    // intern from any thread.
+    class Symbol {
+      public:
+
+        static auto intern(std::string_view text) -> Symbol;
+
+        // The symbol of `text` if it was interned, without interning it.
+        static auto find(std::string_view text) -> std::optional<Symbol>;
+
+        [[nodiscard]] auto text() const -> std::string_view {
+            return record_->text;
+        }
+
+        [[nodiscard]] auto hash() const -> std::size_t {
+            return record_->hash;
+        }
+
+        // Numbered from 0 in the order symbols were interned.
+        [[nodiscard]] auto id() const -> std::uint32_t {
+            return record_->id;
+        }
+
+        friend auto operator==(Symbol left, Symbol right) -> bool {
+            return left.record_ == right.record_;
+        }
+
+        friend auto operator!=(Symbol left, Symbol right) -> bool {
+            return !(left == right);
+        }
+
+        struct Hash {
+            auto operator()(Symbol symbol) const -> std::size_t {
+                return symbol.hash();
+            }
+        };
+
+      private:
+
+        struct Record {
+            std::string_view text;
+            std::size_t      hash;
+            std::uint32_t    id;
+        };
+
+        explicit Symbol(const Record* record) : record_(record) {}
+
+        friend class InlineCache;
+
+        const Record* record_;
+    };
+}  // namespace Runtime
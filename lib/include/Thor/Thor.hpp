@@ -1,14 +1,31 @@
 #pragma once
 
 // Core headers
+#include "Thor/Arena.hpp"
 #include "Thor/AstPrinter.hpp"
+#include "Thor/Batch.hpp"
+#include "Thor/Closure.hpp"
+#include "Thor/Columnar.hpp"
+#include "Thor/Context.hpp"
+#include "Thor/Environment.hpp"
 #include "Thor/Exceptions.hpp"
 #include "Thor/Expr.hpp"
+#include "Thor/Interner.hpp"
 #include "Thor/Interpreter.hpp"
+#include "Thor/Jit.hpp"
 #include "Thor/Lexer.hpp"
 #include "Thor/Logger.hpp"
+#include "Thor/Operators.hpp"
+#include "Thor/Output.hpp"
 #include "Thor/Parser.hpp"
+#include "Thor/Program.hpp"
+#include "Thor/Protocol.hpp"
+#include "Thor/Server.hpp"
 #include "Thor/Stmt.hpp"
+#include "Thor/String.hpp"
+#include "Thor/ThreadPool.hpp"
+#include "Thor/Trace.hpp"
 #include "Thor/TokenType.hpp"
 #include "Thor/Tokens.hpp"
 #include "Thor/Visitor.hpp"
+#include "Thor/Vm.hpp"
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Runtime {
+
+    // Fixed-size work-stealing thread pool.
+    //
+    // Each worker owns a deque. Work submitted from outside is dealt out
+    // round-robin; work submitted from a worker goes to that worker's own
+    // deque. A worker takes from the back of its own deque and, when it
+    // runs dry, steals from the front of the others, so long and short
+    // tasks even out without a shared queue everyone contends on.
+    class ThreadPool {
+      public:
+
+        using Task = std::function<void()>;
+
+        explicit ThreadPool(std::size_t workers);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&)                    = delete;
+        auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+
+        void submit(Task task);
+
+        // Blocks until every submitted task has finished.
+        void wait();
+
+        [[nodiscard]] auto size() const -> std::size_t {
+            return queues_.size();
+        }
+
+      private:
+
+        struct Queue {
+            std::mutex       mutex;
+            std::deque<Task> tasks;
+        };
+
+        void workerLoop(std::size_t index);
+        auto take(std::size_t index) -> Task;
+
+        std::vector<std::unique_ptr<Queue>> queues_;
+        std::vector<std::thread>            workers_;
+        std::atomic<std::size_t>            nextQueue_{0};
+
+        // `queued_` counts tasks sitting in a deque, `pending_` those not
+        // yet finished. Both change under `idleMutex_` only when a thread
+        // may be sleeping on them.
+        std::atomic<std::size_t> queued_{0};
+        std::atomic<std::size_t> pending_{0};
+        std::mutex               idleMutex_;
+        std::condition_variable  workAvailable_;
+        std::condition_variable  allDone_;
+        bool                     stopping_ = false;
+    };
+}  // namespace Runtime
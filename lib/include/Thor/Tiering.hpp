@@ -0,0 +1,166 @@
+#pragma once
+
+#include "Closure.hpp"
+#include "Environment.hpp"
+#include "Stmt.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Tiered execution: each region of a script starts in the cheapest tier to
+// enter and moves up once it has proven hot, so a script run once pays for
+// no compilation and one run many times ends up in compiled code.
+//
+//   TREE     the tree-walking interpreter, nothing to prepare
+//   CLOSURE  closures compiled from the region, see Closure.hpp
+//   JIT      those closures, with each subtree the JIT accepts and that is
+//            big enough to repay the call running native code first, see
+//            Jit.hpp
+//
+// A region is a top-level statement; its entry count is the number of
+// times it has run. Loops are counted and promoted the same way, by their
+// back edges: a loop that turns hot while it runs moves to the next tier
+// at its next iteration, and the JIT then specialises it on the types its
+// variables have settled into. Functions are counted by their calls and go
+// no further than CLOSURE, as the JIT does not read locals. Promotion
+// compiles the next tier on the thread that crossed the threshold while
+// others keep running the current one. When compiled code in a JIT region
+// keeps failing its guards and the JIT gives up on it, the region drops
+// back to CLOSURE for good. Lower tiers are kept until the plan dies, so a
+// thread still running one is never cut short.
+namespace Tiering {
+
+    using Tier = Closure::Level;
+
+    constexpr std::size_t TIER_COUNT = 3;
+
+    auto name(Tier tier) -> std::string_view;
+
+    struct Options {
+        std::uint32_t closureAfter = 3;      // Entries before CLOSURE
+        std::uint32_t jitAfter     = 100;    // Entries before JIT
+        bool          timing       = false;  // Measure time spent per tier
+    };
+
+    // Parses "<closureAfter>,<jitAfter>".
+    auto parseThresholds(std::string_view text) -> std::optional<Options>;
+
+    namespace detail {
+        inline Options options;
+    }  // namespace detail
+
+    // Process-wide, for plans made from then on. Set it before starting
+    // any threads.
+    inline void setOptions(Options options) {
+        detail::options = options;
+    }
+
+    inline auto options() -> const Options& {
+        return detail::options;
+    }
+
+    // What became of one region, loop or function.
+    struct RegionReport {
+        std::string   label;  // Statement kind, and the name it declares
+        Tier          tier;
+        // Iterations for a loop; for a function, the calls the tree walker
+        // made to it.
+        std::uint64_t entries;
+
+        // Seconds from the plan being made; nullopt if it never happened.
+        std::array<std::optional<double>, TIER_COUNT> promotedAt;
+        std::optional<double>                         deoptimizedAt;
+
+        // Seconds spent running in each tier, when timing.
+        std::array<double, TIER_COUNT> seconds;
+    };
+
+    auto format(const std::vector<RegionReport>& report) -> std::string;
+
+    // Tiering state of a list of statements, shared by every run of them.
+    // Safe to use from several threads at once.
+    class Plan final : public Closure::Loops {
+      public:
+
+        explicit Plan(std::vector<Stmt::Stmt> statements,
+                      Options                 options = Tiering::options());
+
+        ~Plan() override;
+
+        Plan(const Plan&)                    = delete;
+        auto operator=(const Plan&) -> Plan& = delete;
+
+        [[nodiscard]] auto size() const -> std::uint32_t {
+            return static_cast<std::uint32_t>(statements_.size());
+        }
+
+        [[nodiscard]] auto statement(std::uint32_t index) const
+            -> const Stmt::Stmt& {
+            return statements_[index];
+        }
+
+        // One entry into a region; see `enter`.
+        struct Entry {
+            std::uint32_t                         index;
+            Tier                                  tier;
+            const Closure::Exec*                  code;  // Null for TREE
+            std::chrono::steady_clock::time_point start;
+        };
+
+        // Counts an entry into region `index`, promoting or demoting it
+        // first if due, and says how to run it this time. `environment` is
+        // what it is about to run against; the JIT specialises on it.
+        auto enter(std::uint32_t                   index,
+                   const Interpreter::Environment& environment) -> Entry;
+
+        // Closes an entry once the region has run, for timing.
+        void leave(const Entry& entry);
+
+        auto enter(const Stmt::While& loop, Tier level,
+                   const Interpreter::Environment& environment)
+            -> const Closure::Exec* override;
+        auto backEdge(const Stmt::While& loop, Tier level,
+                      const Interpreter::Environment& environment)
+            -> const Closure::Exec* override;
+        auto call(const Stmt::Definition& function)
+            -> const Closure::Exec* override;
+
+        // One row per region, then one per loop and one per function, in
+        // order of their ids.
+        [[nodiscard]] auto report() const -> std::vector<RegionReport>;
+
+      private:
+
+        struct Region;
+        struct Profile;
+        struct Loop;
+        struct Function;
+
+        auto promote(Tier tier, std::uint32_t index,
+                     const Interpreter::Environment& environment) -> Tier;
+        auto promote(Tier tier, Loop& loop,
+                     const Interpreter::Environment& environment) -> Tier;
+        [[nodiscard]] auto find(const Stmt::While& stmt) const -> Loop*;
+        auto deoptimize(std::uint32_t index) -> Tier;
+        [[nodiscard]] auto elapsed() const -> std::int64_t;
+
+        std::vector<Stmt::Stmt>               statements_;
+        Options                               options_;
+        std::chrono::steady_clock::time_point created_;
+        std::unique_ptr<Region[]>             regions_;
+        std::unique_ptr<Profile[]>            profiles_;
+        std::uint32_t                         firstLoop_ = 0;  // Lowest id
+        std::uint32_t                         loopCount_ = 0;
+        std::unique_ptr<Loop[]>               loops_;
+        std::uint32_t                         firstFunction_ = 0;
+        std::uint32_t                         functionCount_ = 0;
+        std::unique_ptr<Function[]>           functions_;
+    };
+}  // namespace Tiering
@@ -3,6 +3,10 @@
 #include <fmt/ostream.h>
 #include <fmt/ranges.h>
 
+#include "Array.hpp"
+#include "Function.hpp"
+#include "Object.hpp"
+#include "String.hpp"
 #include "TokenType.hpp"
 
 #include <string>
@@ -15,7 +19,9 @@ namespace Token {
 
     struct Literal {
         using LiteralVal =
-            std::variant<double, std::string, bool, std::nullptr_t>;
+            std::variant<double, Runtime::String, bool, std::nullptr_t,
+                         Runtime::Function, Runtime::Cell, Runtime::Object,
+                         Runtime::Class, Runtime::Array, Runtime::Method>;
         LiteralVal value;
 
         Literal() : value(nullptr) {}
@@ -28,7 +34,22 @@ namespace Token {
 
         explicit Literal(bool bool_val) : value(bool_val) {}
 
-        explicit Literal(std::string string_val) : value(string_val) {}
+        explicit Literal(std::string string_val)
+            : value(Runtime::String(string_val)) {}
+
+        explicit Literal(Runtime::String string_val)
+            : value(std::move(string_val)) {}
+
+        explicit Literal(Runtime::Function function)
+            : value(std::move(function)) {}
+
+        explicit Literal(Runtime::Object object) : value(std::move(object)) {}
+
+        explicit Literal(Runtime::Class klass) : value(std::move(klass)) {}
+
+        explicit Literal(Runtime::Array array) : value(std::move(array)) {}
+
+        explicit Literal(Runtime::Method method) : value(method) {}
 
         [[nodiscard]] auto toInt() const -> int {
             if (std::holds_alternative<double>(value)) {
@@ -62,7 +83,7 @@ namespace Token {
         }
 
         [[nodiscard]] auto isString() const -> bool {
-            return std::holds_alternative<std::string>(value);
+            return std::holds_alternative<Runtime::String>(value);
         }
 
         [[nodiscard]] auto isNumber() const -> bool {
@@ -77,6 +98,10 @@ namespace Token {
             return std::holds_alternative<bool>(value);
         }
 
+        [[nodiscard]] auto isFunction() const -> bool {
+            return std::holds_alternative<Runtime::Function>(value);
+        }
+
         // Getter for number
         [[nodiscard]] auto asNumber() const -> double {
             if (!isNumber()) {
@@ -86,11 +111,11 @@ namespace Token {
         }
 
         // Getter for string
-        [[nodiscard]] auto asString() const -> const std::string& {
+        [[nodiscard]] auto asString() const -> const Runtime::String& {
             if (!isString()) {
                 throw std::runtime_error("Literal is not a string.");
             }
-            return std::get<std::string>(value);
+            return std::get<Runtime::String>(value);
         }
 
         // Getter for bool
@@ -114,20 +139,110 @@ namespace Token {
                 [](const auto& val) -> std::string {
                     using T = std::decay_t<decltype(val)>;
 
-                    if constexpr (std::is_same_v<T, double> ||
-                                  std::is_same_v<T, std::string>) {
-                        return fmt::format("{}", val);
+                    if constexpr (std::is_same_v<T, double>) {
+                        char buffer[Runtime::MAX_NUMBER_CHARS];
+                        return {buffer, Runtime::formatNumber(buffer, val)};
+
+                    } else if constexpr (std::is_same_v<T, Runtime::String>) {
+                        return val.str();
 
                     } else if constexpr (std::is_same_v<T, bool>) {
                         return val ? "true" : "false";
                     } else if constexpr (std::is_same_v<T, std::nullptr_t>) {
                         return "nil";
+                    } else if constexpr (std::is_same_v<T, Runtime::Function>) {
+                        return fmt::format("<fn {}>", val.name());
+                    } else if constexpr (std::is_same_v<T, Runtime::Object>) {
+                        if (val.klass() == nullptr) {
+                            return "<object>";
+                        }
+                        return fmt::format("<{} instance>",
+                                           val.klass()->name());
+                    } else if constexpr (std::is_same_v<T, Runtime::Class>) {
+                        return fmt::format("<class {}>", val.name());
+                    } else if constexpr (std::is_same_v<T, Runtime::Array>) {
+                        return val.describe();
+                    } else if constexpr (std::is_same_v<T, Runtime::Method>) {
+                        return fmt::format("<builtin {}>",
+                                           val.builtin->name);
+                    } else {
+                        return "<cell>";
                     }
                 },
                 value);
         }
     };
 
+    // Upper bound on the characters `formatTo` writes for `literal`.
+    [[nodiscard]] inline auto formattedSizeBound(const Literal& literal)
+        -> std::size_t {
+        if (literal.isString()) {
+            return literal.asString().size();
+        }
+        if (literal.isFunction()) {
+            return literal.as<Runtime::Function>().name().size() + 5;
+        }
+        if (const auto* object = std::get_if<Runtime::Object>(&literal.value)) {
+            return object->klass() != nullptr
+                       ? object->klass()->name().size() + 11
+                       : 8;
+        }
+        if (const auto* klass = std::get_if<Runtime::Class>(&literal.value)) {
+            return klass->name().size() + 8;
+        }
+        if (const auto* array = std::get_if<Runtime::Array>(&literal.value)) {
+            return array->describedSizeBound();
+        }
+        if (const auto* method = std::get_if<Runtime::Method>(&literal.value)) {
+            return method->builtin->name.size() + 10;
+        }
+        return Runtime::MAX_NUMBER_CHARS;
+    }
+
+    // Writes the text of `stringify()` to `out` without allocating and
+    // returns the end of the written text.
+    inline auto formatTo(char* out, const Literal& literal) -> char* {
+        return std::visit(
+            [out](const auto& val) -> char* {
+                using T = std::decay_t<decltype(val)>;
+                auto copy = [out](std::string_view text) {
+                    std::memcpy(out, text.data(), text.size());
+                    return out + text.size();
+                };
+
+                if constexpr (std::is_same_v<T, double>) {
+                    return Runtime::formatNumber(out, val);
+                } else if constexpr (std::is_same_v<T, Runtime::String>) {
+                    return copy(val.view());
+                } else if constexpr (std::is_same_v<T, bool>) {
+                    return copy(val ? "true" : "false");
+                } else if constexpr (std::is_same_v<T, std::nullptr_t>) {
+                    return copy("nil");
+                } else if constexpr (std::is_same_v<T, Runtime::Cell>) {
+                    return copy("<cell>");
+                } else if constexpr (std::is_same_v<T, Runtime::Object>) {
+                    if (val.klass() == nullptr) {
+                        return copy("<object>");
+                    }
+                    return fmt::format_to(out, "<{} instance>",
+                                          val.klass()->name());
+                } else if constexpr (std::is_same_v<T, Runtime::Class>) {
+                    return fmt::format_to(out, "<class {}>", val.name());
+                } else if constexpr (std::is_same_v<T, Runtime::Array>) {
+                    return val.describeTo(out);
+                } else if constexpr (std::is_same_v<T, Runtime::Method>) {
+                    return fmt::format_to(out, "<builtin {}>",
+                                          val.builtin->name);
+                } else {
+                    auto name = val.name();
+                    std::memcpy(copy("<fn "), name.data(), name.size());
+                    out[4 + name.size()] = '>';
+                    return out + 5 + name.size();
+                }
+            },
+            literal.value);
+    }
+
     struct Token {
         Type        type;
         std::string lexeme;
@@ -154,6 +269,37 @@ namespace Token {
 
 }  // namespace Token
 
+namespace Runtime {
+
+    // Here rather than in Function.hpp, as it holds a whole Literal.
+    struct Cell::Data final : Traced {
+        Token::Literal value;
+
+        explicit Data(Token::Literal value)
+            : Traced(sizeof(Data)), value(std::move(value)) {}
+
+        void trace(Tracer& tracer) const override {
+            tracer.visit(value);
+        }
+
+        void clear() override {
+            value = Token::Literal{};
+        }
+
+        [[nodiscard]] auto bytes() const -> std::size_t override {
+            return sizeof(Data);
+        }
+    };
+
+    inline auto Cell::get() const -> Token::Literal& {
+        return data_->value;
+    }
+
+    inline auto Cell::traced() const -> const Traced* {
+        return data_.get();
+    }
+}  // namespace Runtime
+
 // Add fmt formatting support
 template <>
 struct fmt::formatter<Token::Type> {
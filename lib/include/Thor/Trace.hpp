@@ -0,0 +1,214 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace Trace {
+
+    // Binary trace of lexer, parser and interpreter events.
+    //
+    // Events are fixed-size records written into a ring inside a
+    // memory-mapped file, so a trace survives a crash of the process and
+    // costs a timestamp read and a few stores per event. Strings (error
+    // messages, file names) are interned once into a table in the same file
+    // and referenced by id. `thor-trace` decodes a file into text or Chrome
+    // trace JSON.
+
+    enum class Event : std::uint16_t {
+        NONE,
+        LEX_BEGIN,        // a: source bytes
+        LEX_END,          // a: tokens
+        TOKEN,            // a: token type, b: line << 32 | column
+        LEX_ERROR,        // text: message
+        PARSE_BEGIN,      // a: tokens
+        PARSE_END,        // a: statements
+        PARSE_ERROR,      // text: message
+        INTERPRET_BEGIN,  // a: statements
+        INTERPRET_END,
+        STATEMENT_BEGIN,  // a: statement index
+        STATEMENT_END,    // a: statement index
+        RUNTIME_ERROR,    // text: message
+        MARK,             // text: label, a and b: user values
+        JIT_COMPILE,      // a: code bytes, b: inputs
+        JIT_DEOPT,        // a: bailouts
+        TIER_UP,          // a: statement index, b: new tier
+        TIER_DOWN,        // a: statement index, b: new tier
+        ENGINE_COMPILE,   // a: statements, b: engine
+        COUNT_
+    };
+
+    // How the decoder presents an event.
+    struct EventInfo {
+        const char* name;
+        char        phase;   // Chrome trace phase: 'B' begin, 'E' end, 'i'
+        const char* argA;    // Label of `a`, or nullptr if unused
+        const char* argB;    // Label of `b`, or nullptr if unused
+        bool        hasText;
+    };
+
+    auto eventInfo(Event event) -> const EventInfo&;
+
+    struct Record {
+        std::uint64_t ticks;
+        std::uint32_t sequence;  // Low bits of the slot index + 1; 0: empty
+        Event         event;
+        std::uint16_t thread;
+        std::uint32_t text;  // Interned string id, 0 for none
+        std::uint32_t a;
+        std::uint64_t b;
+    };
+    static_assert(sizeof(Record) == 32);
+
+    constexpr char          MAGIC[8] = {'T', 'H', 'O', 'R', 'T', 'R', 'C', '1'};
+    constexpr std::uint32_t VERSION  = 1;
+
+    // Start of the file. Records follow at `recordsOffset`, the string table
+    // at `stringsOffset` (entries: u32 id, u32 length, bytes).
+    struct FileHeader {
+        char          magic[8];
+        std::uint32_t version;
+        std::uint32_t recordSize;
+        std::uint64_t capacity;  // Records; a power of two
+        std::uint64_t recordsOffset;
+        std::uint64_t stringsOffset;
+        std::uint64_t stringsCapacity;
+        std::uint64_t stringsUsed;
+        std::uint64_t startTicks;
+        std::int64_t  startNanos;    // Wall clock at `startTicks`
+        double        ticksPerNano;  // Recalibrated when the trace is closed
+    };
+
+    inline auto readTicks() -> std::uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(
+            std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    namespace detail {
+        // Slots the current thread has claimed from a tracer.
+        struct Cursor {
+            std::uint64_t owner  = 0;  // Tracer id
+            std::uint64_t next   = 0;
+            std::uint64_t end    = 0;
+            std::uint16_t thread = 0;
+        };
+
+        inline thread_local Cursor cursor{};
+    }  // namespace detail
+
+    class Tracer {
+      public:
+
+        // Slots a thread claims at a time, so recording an event needs no
+        // atomic operation.
+        static constexpr std::uint64_t BLOCK = 64;
+
+        static constexpr std::size_t DEFAULT_CAPACITY = std::size_t{1} << 18U;
+
+        // Creates (or truncates) `path`; returns nullptr and logs an error
+        // if the file cannot be created or mapped.
+        static auto open(const std::string& path,
+                         std::size_t capacity = DEFAULT_CAPACITY)
+            -> std::unique_ptr<Tracer>;
+
+        Tracer(const Tracer&)                    = delete;
+        auto operator=(const Tracer&) -> Tracer& = delete;
+        ~Tracer();
+
+        void record(Event event, std::uint32_t a, std::uint64_t b,
+                    std::uint32_t text) {
+            auto& cursor = detail::cursor;
+            if (cursor.owner != id_ || cursor.next == cursor.end) {
+                claim(cursor);
+            }
+            auto    index = cursor.next++;
+            Record& slot  = records_[index & mask_];
+            slot.ticks    = readTicks();
+            slot.sequence = static_cast<std::uint32_t>(index + 1);
+            slot.event    = event;
+            slot.thread   = cursor.thread;
+            slot.text     = text;
+            slot.a        = a;
+            slot.b        = b;
+        }
+
+        // Id of `text` in the file's string table (0 if the table is full).
+        auto intern(std::string_view text) -> std::uint32_t;
+
+      private:
+
+        Tracer(int fd, std::byte* mapping, std::size_t size,
+               std::size_t capacity);
+
+        void claim(detail::Cursor& cursor);
+
+        int           fd_;
+        std::byte*    mapping_;
+        std::size_t   size_;
+        FileHeader*   header_;
+        Record*       records_;
+        std::uint64_t mask_;
+        std::uint64_t id_;
+        std::int64_t  openedNanos_;  // Steady clock at `startTicks`
+
+        alignas(64) std::atomic<std::uint64_t> head_{0};
+
+        std::mutex                                     stringsMutex_;
+        std::unordered_map<std::string, std::uint32_t> strings_;
+    };
+
+    // A file read back by the decoder.
+    struct TraceFile {
+        FileHeader                                     header;
+        std::vector<Record>                            records;  // By time
+        std::unordered_map<std::uint32_t, std::string> strings;
+    };
+
+    // Throws std::runtime_error if `path` is not a readable trace file.
+    auto readFile(const std::string& path) -> TraceFile;
+
+    namespace detail {
+        inline std::atomic<Tracer*> active{nullptr};
+    }  // namespace detail
+
+    // Starts tracing into `path`. Returns false if the file could not be
+    // created.
+    auto start(const std::string& path,
+               std::size_t capacity = Tracer::DEFAULT_CAPACITY) -> bool;
+
+    // Stops tracing and closes the file. Call once no other thread emits.
+    void stop();
+
+    [[nodiscard]] inline auto enabled() -> bool {
+        return detail::active.load(std::memory_order_relaxed) != nullptr;
+    }
+
+    inline void emit(Event event, std::uint32_t a = 0, std::uint64_t b = 0) {
+        if (auto* tracer = detail::active.load(std::memory_order_relaxed)) {
+            tracer->record(event, a, b, 0);
+        }
+    }
+
+    // Events carrying text intern it only when tracing is on.
+    inline void emitText(Event event, std::string_view text,
+                         std::uint32_t a = 0, std::uint64_t b = 0) {
+        if (auto* tracer = detail::active.load(std::memory_order_relaxed)) {
+            tracer->record(event, a, b, tracer->intern(text));
+        }
+    }
+}  // namespace Trace
@@ -0,0 +1,267 @@
+#pragma once
+
+#include "Closure.hpp"
+#include "Expr.hpp"
+#include "Stmt.hpp"
+#include "Tokens.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Register machine: each statement is lowered once into three-address
+// instructions over a small register file, so an operator is one
+// instruction that names its operands and its result, rather than a
+// visit per node or a push and a pop per operand.
+//
+// Operands name a register, a constant or a global slot directly, so
+// leaves cost no instructions, and constant subtrees are folded while
+// lowering. Temporaries start out in virtual registers, one per value;
+// linear scan over their live ranges then packs them into as few
+// registers as the statement needs. Values, errors and log lines are the
+// interpreter's own.
+//
+// Control flow inside a statement is jumps: a loop is rotated so that an
+// iteration ends in one backward JUMP_TRUE, and `break` and `continue` are
+// plain jumps out of it. A subtree that only reads variables the loop never
+// writes is computed on its first use and kept in a register the loop's
+// preheader clears, so later iterations skip it.
+//
+// A function body is lowered the same way, once per program, into code
+// that runs in a window of the interpreter's stack: its locals are the
+// first registers, its temporaries follow, and the arguments of the calls
+// it makes are built in place above them, where the callee's window then
+// starts. A call is an instruction that switches windows, not a native
+// call, so recursion only costs stack slots and a tail call reuses the
+// window it is made from.
+//
+// A local that closures share lives in a cell in its register, which
+// UNBOX and SET go through; what a function captured is read from the
+// running function by CAPTURE.
+//
+// Property sites keep the node's inline cache, so GET and PUT cost what
+// they do in the interpreter. `obj.name(...)` looks the method up with
+// METHOD, which puts the object where the callee's frame starts, in a
+// slot each call keeps below its arguments, instead of binding it. On an
+// array it leaves the builtin there instead, which CALL runs in place.
+//
+// A try costs no instruction. Each lowered try adds entries to a handler
+// table, one per range of instructions it guards; a throw, or an error
+// from anything an instruction calls, looks up the instruction it came
+// from there, then the call instruction of each caller in turn, dropping
+// their windows, and goes on at the first handler it finds. `finally`
+// blocks are copied onto each path that leaves their try, with another
+// copy in a handler that throws again once it has run.
+namespace Vm {
+
+    // A register of the running frame, a constant of the program or a
+    // global slot, tagged in the top two bits. Operands an instruction does
+    // not use are NONE.
+    class Operand {
+      public:
+
+        enum class Kind : std::uint8_t { REGISTER, CONSTANT, GLOBAL, NONE };
+
+        constexpr Operand() : Operand(Kind::NONE, 0) {}
+        constexpr Operand(Kind kind, std::uint32_t index)
+            : bits_(static_cast<std::uint32_t>(kind) << INDEX_BITS | index) {}
+
+        [[nodiscard]] constexpr auto kind() const -> Kind {
+            return static_cast<Kind>(bits_ >> INDEX_BITS);
+        }
+
+        [[nodiscard]] constexpr auto index() const -> std::uint32_t {
+            return bits_ & INDEX_MASK;
+        }
+
+        constexpr auto operator==(Operand other) const -> bool {
+            return bits_ == other.bits_;
+        }
+
+        static constexpr std::uint32_t INDEX_BITS = 30;
+        static constexpr std::uint32_t INDEX_MASK = (1U << INDEX_BITS) - 1;
+
+      private:
+
+        std::uint32_t bits_;
+    };
+
+    enum class Opcode : std::uint8_t {
+        BINARY,      // target = left <op> right
+        NEGATE,      // target = -left
+        PREFIX,      // target = <token> left
+        POSTFIX,     // throws, as the interpreter does
+        RENDER,      // target = template `aux` over its hole operands
+        MOVE,        // target = left
+        NULL_EXPR,   // logs a missing expression, whose value is nil
+        JUMP,        // to instruction `aux` of the statement
+        JUMP_FALSE,  // to instruction `aux` unless left is truthy
+        JUMP_TRUE,   // to instruction `aux` if left is truthy
+        JUMP_IF,      // to instruction `aux` if left <op> right is truthy
+        JUMP_UNLESS,  // to instruction `aux` unless left <op> right is
+        JUMP_SET,    // to instruction `aux` unless left is nil
+        SWITCH,      // to the case of switch `aux` left picks, if known
+        CLEAR,       // sets the registers of list `aux` to nil
+        DEFINE,      // variable `aux` = left
+        STORE,       // global slot `aux` = left; op 1 logs it as DISCARD
+        PRINT,       // print left
+        DISCARD,     // log left as an expression statement's result
+        CHECK,       // throws unless left can be called with `op` arguments
+        CALL,        // target = left(`op` arguments from register right)
+        TAIL_CALL,   // return left(`op` arguments from register right)
+        RETURN,      // from the running function with left
+        CLOSE,       // target = a function of closure `aux`, capturing
+        CELL,        // target = a new cell holding left
+        UNBOX,       // target = what the cell in left holds
+        SET,         // the cell in left = right
+        CAPTURE,     // target = capture `aux`; op 1 reads the cell in it
+        SELF,        // target = the running function
+        GET,         // target = property of site `aux` of left
+        PUT,         // property of site `aux` of left = right
+        METHOD,      // as GET, but a method is left unbound and left goes
+                     // to register right, below the arguments
+        OBJECT,      // target = object literal `aux` of its field operands
+        SUPER,       // target = method <token> of class left, bound to
+                     // right; op 1 leaves it unbound for a call
+        CLASS,       // target = class `aux`, whose superclass is left
+        ARRAY,       // target = an array of the registers of list `aux`
+        INDEX,       // target = left[right]
+        PUT_INDEX,   // left[right] = target, which is only read
+        THROW,       // throws left
+        CATCH,       // variable `aux` = what was thrown
+        CAUGHT,      // target = what was thrown, kept to throw again
+        RETHROW,     // throws again what CAUGHT kept in left
+        HALT,        // ends a statement
+    };
+
+    struct Instruction {
+        Opcode              opcode;
+        std::uint8_t        op = 0;  // Operators::BinaryOp, or arguments
+        Operand             target{};
+        Operand             left{};
+        Operand             right{};
+        std::uint32_t       aux   = 0;
+        const Token::Token* token = nullptr;  // For errors
+    };
+
+    // Statements lowered for the register machine. Built once and run any
+    // number of times, from any number of threads; like closures, it
+    // refers to the tree it came from, which has to outlive it.
+    class Program {
+      public:
+
+        Program() = default;
+
+        static auto compile(const std::vector<Stmt::Stmt>& statements)
+            -> Program;
+
+        [[nodiscard]] auto size() const -> std::uint32_t {
+            return static_cast<std::uint32_t>(starts_.size()) - 1;
+        }
+
+        // Registers a statement's window needs: the most any one uses.
+        [[nodiscard]] auto registers() const -> std::uint32_t {
+            return registers_;
+        }
+
+        [[nodiscard]] auto instructions() const
+            -> const std::vector<Instruction>& {
+            return code_;
+        }
+
+        // Entries of the handler table.
+        [[nodiscard]] auto handlers() const -> std::size_t {
+            return handlers_.size();
+        }
+
+        // Runs statement `index` against `frame`, in the window of at
+        // least `registers()` slots at the top of its stack, from
+        // `frame.base`.
+        void run(std::uint32_t index, Closure::Frame& frame) const;
+
+      private:
+
+        friend class Lowering;
+
+        struct Template {
+            const Expr::TemplateExpr* expr;
+            std::uint32_t             holes;  // First operand in `holes_`
+        };
+
+        // A lowered function body.
+        struct Function {
+            const Stmt::Definition* definition = nullptr;
+            std::uint32_t           start      = 0;
+            std::uint32_t           window     = 0;  // Registers it needs
+            // Whether its code reads the function value it runs, which
+            // calls then keep at hand.
+            bool closes = false;
+        };
+
+        // A property access, and the cache it goes through.
+        struct Site {
+            const Token::Token*         name;
+            const Runtime::InlineCache* cache;
+        };
+
+        struct Object {
+            const Expr::ObjectExpr* expr;
+            std::uint32_t           values;  // First operand in `holes_`
+        };
+
+        // A SWITCH: the labels it looks left up in, and where in the
+        // statement each case starts, `targets_` from `targets` with the
+        // `else` or the end last. The first `checked` labels that are not
+        // constants were compared before it, and missed; if a constant
+        // label matches and no later one is in the way, it jumps to its
+        // case, and once all have been compared, to the `else`.
+        struct Switch {
+            const Stmt::Dispatch* dispatch;
+            std::uint32_t         targets;
+            std::uint32_t         cases;
+            std::uint32_t         checked;
+        };
+
+        // A range of instructions a try guards, from `from` up to `to`,
+        // and where its handler starts, all in `code_`.
+        struct Handler {
+            std::uint32_t from;
+            std::uint32_t to;
+            std::uint32_t at;
+        };
+
+        // Operands `first` to `first + count` of `holes_`, for CLEAR and
+        // ARRAY.
+        struct List {
+            std::uint32_t first;
+            std::uint32_t count;
+        };
+
+        [[nodiscard]] auto read(Operand operand, const Closure::Frame& frame,
+                                const Token::Literal* registers) const
+            -> const Token::Literal&;
+
+        // The body of `definition` if it was lowered here, else null.
+        [[nodiscard]] auto find(const Stmt::Definition& definition) const
+            -> const Function*;
+
+        std::vector<Instruction>           code_;
+        std::vector<std::uint32_t>         starts_{0};  // Per statement
+        std::vector<Token::Literal>        constants_;
+        std::vector<Operand>               holes_;
+        std::vector<Template>              templates_;
+        std::vector<List>                  lists_;
+        std::vector<Switch>                switches_;
+        std::vector<std::uint32_t>         targets_;
+        std::vector<Handler>               handlers_;  // Innermost first
+        std::vector<const Stmt::Variable*> variables_;
+        std::vector<Site>                  sites_;
+        std::vector<Object>                objects_;
+        std::vector<const Stmt::Class*>    classes_;
+        std::vector<Function>              functions_;  // By id from first
+        std::uint32_t                      firstFunction_ = 0;
+        std::uint32_t                      registers_     = 0;
+
+        // What CLOSE makes functions of.
+        std::vector<std::shared_ptr<const Stmt::Definition>> closures_;
+    };
+}  // namespace Vm
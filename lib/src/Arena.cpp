@@ -0,0 +1,59 @@
+#include "Thor/Arena.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Runtime {
+
+    auto Arena::allocate(std::size_t size, std::size_t align) -> void* {
+        while (current_ < chunks_.size()) {
+            auto& chunk   = chunks_[current_];
+            auto  aligned = (offset_ + align - 1) & ~(align - 1);
+            if (aligned + size <= chunk.size) {
+                offset_ = aligned + size;
+                return chunk.data.get() + aligned;
+            }
+            ++current_;
+            offset_ = 0;
+        }
+
+        // Out of chunks: add one. Fresh chunks are aligned for any
+        // fundamental type.
+        auto chunkSize = std::max(CHUNK_SIZE, size);
+        chunks_.push_back(
+            {std::make_unique<std::byte[]>(chunkSize), chunkSize});
+        current_ = chunks_.size() - 1;
+        offset_  = size;
+        return chunks_.back().data.get();
+    }
+
+    auto Arena::copy(std::string_view text) -> std::string_view {
+        if (text.empty()) {
+            return {};
+        }
+        auto* out = static_cast<char*>(allocate(text.size(), 1));
+        std::memcpy(out, text.data(), text.size());
+        return {out, text.size()};
+    }
+
+    void Arena::rewind(Mark mark) {
+        current_ = mark.chunk;
+        offset_  = mark.offset;
+    }
+
+    auto Arena::bytesUsed() const -> std::size_t {
+        std::size_t used = 0;
+        for (std::size_t i = 0; i < current_ && i < chunks_.size(); ++i) {
+            used += chunks_[i].size;
+        }
+        return used + offset_;
+    }
+
+    auto Arena::bytesReserved() const -> std::size_t {
+        std::size_t reserved = 0;
+        for (const auto& chunk : chunks_) {
+            reserved += chunk.size;
+        }
+        return reserved;
+    }
+}  // namespace Runtime
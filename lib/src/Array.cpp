@@ -0,0 +1,452 @@
+#include "Thor/Array.hpp"
+
+#include "Thor/Columnar.hpp"
+#include "Thor/Exceptions.hpp"
+#include "Thor/Operators.hpp"
+#include "Thor/Simd.hpp"
+#include "Thor/Tokens.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <optional>
+#include <utility>
+
+namespace Runtime {
+
+    namespace {
+
+        using Operators::BinaryOp;
+        using Simd::Broadcast;
+        using Simd::Dense;
+        using Token::Literal;
+
+        auto sumScalar(const double* data, std::size_t n) -> double {
+            double total = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                total += data[i];
+            }
+            return total;
+        }
+
+        auto indexScalar(const double* data, std::size_t n, double value)
+            -> std::size_t {
+            return static_cast<std::size_t>(std::find(data, data + n, value) -
+                                            data);
+        }
+
+#if defined(__x86_64__)
+        // Four accumulators of four lanes, so additions overlap; the order
+        // they add in differs from a loop, and so may the last bits.
+        THOR_AVX auto sumAvx(const double* data, std::size_t n) -> double {
+            __m256d lanes[4] = {_mm256_setzero_pd(), _mm256_setzero_pd(),
+                                _mm256_setzero_pd(), _mm256_setzero_pd()};
+            std::size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                for (std::size_t lane = 0; lane < 4; ++lane) {
+                    lanes[lane] = _mm256_add_pd(
+                        lanes[lane], _mm256_loadu_pd(data + i + lane * 4));
+                }
+            }
+            auto total = _mm256_add_pd(_mm256_add_pd(lanes[0], lanes[1]),
+                                       _mm256_add_pd(lanes[2], lanes[3]));
+            alignas(32) std::array<double, 4> parts{};
+            _mm256_store_pd(parts.data(), total);
+            return parts[0] + parts[1] + parts[2] + parts[3] +
+                   sumScalar(data + i, n - i);
+        }
+
+        THOR_AVX auto indexAvx(const double* data, std::size_t n, double value)
+            -> std::size_t {
+            auto        wanted = _mm256_set1_pd(value);
+            std::size_t i      = 0;
+            for (; i + 4 <= n; i += 4) {
+                auto mask = _mm256_movemask_pd(_mm256_cmp_pd(
+                    _mm256_loadu_pd(data + i), wanted, _CMP_EQ_OQ));
+                if (mask != 0) {
+                    return i + static_cast<std::size_t>(
+                                   __builtin_ctz(static_cast<unsigned>(mask)));
+                }
+            }
+            return i + indexScalar(data + i, n - i, value);
+        }
+#endif
+
+        auto sumKernel(const double* data, std::size_t n) -> double {
+#if defined(__x86_64__)
+            if (Simd::HAS_AVX) {
+                return sumAvx(data, n);
+            }
+#endif
+            return sumScalar(data, n);
+        }
+
+        // The first index of `value`, or `n`.
+        auto indexKernel(const double* data, std::size_t n, double value)
+            -> std::size_t {
+#if defined(__x86_64__)
+            if (Simd::HAS_AVX) {
+                return indexAvx(data, n, value);
+            }
+#endif
+            return indexScalar(data, n, value);
+        }
+
+        // Arrays in the middle of being described, innermost last.
+        thread_local std::vector<const void*> describing;
+
+        auto sum(const Array& self, const Literal* /*arguments*/,
+                 const Token::Token& paren, const Caller& /*call*/)
+            -> Literal {
+            if (self.packed()) {
+                const auto& numbers = self.numbers();
+                return Literal{sumKernel(numbers.data(), numbers.size())};
+            }
+            double total = 0;
+            for (const auto& value : self.values()) {
+                if (!value.isNumber()) {
+                    throw Error::RuntimeException(paren,
+                                                  "Can only sum numbers.");
+                }
+                total += value.asNumber();
+            }
+            return Literal{total};
+        }
+
+        auto indexOf(const Array& self, const Literal* arguments,
+                     const Token::Token& /*paren*/, const Caller& /*call*/)
+            -> Literal {
+            const auto& wanted = arguments[0];
+            if (self.packed()) {
+                if (!wanted.isNumber()) {
+                    return Literal{-1.0};
+                }
+                const auto& numbers = self.numbers();
+                auto index = indexKernel(numbers.data(), numbers.size(),
+                                         wanted.asNumber());
+                return Literal{index < numbers.size()
+                                   ? static_cast<double>(index)
+                                   : -1.0};
+            }
+            const auto& values = self.values();
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                if (Operators::isEqual(values[i], wanted)) {
+                    return Literal{static_cast<double>(i)};
+                }
+            }
+            return Literal{-1.0};
+        }
+
+        // Sorts in place and returns the array. Numbers go in ascending
+        // order, NaN last; boxed elements all have to be numbers or all
+        // strings.
+        auto sort(const Array& self, const Literal* /*arguments*/,
+                  const Token::Token& paren, const Caller& /*call*/)
+            -> Literal {
+            auto before = [](double a, double b) {
+                return !std::isnan(a) && (std::isnan(b) || a < b);
+            };
+            if (self.packed()) {
+                auto& numbers = self.numbers();
+                auto  last    = std::partition(
+                    numbers.begin(), numbers.end(),
+                    [](double x) { return !std::isnan(x); });
+                std::sort(numbers.begin(), last);
+                return Literal{self};
+            }
+            auto& values = self.values();
+            auto  all    = [&](auto is) {
+                return std::all_of(values.begin(), values.end(), is);
+            };
+            if (all([](const Literal& value) { return value.isNumber(); })) {
+                std::sort(values.begin(), values.end(),
+                          [&](const Literal& a, const Literal& b) {
+                              return before(a.asNumber(), b.asNumber());
+                          });
+            } else if (all([](const Literal& value) {
+                           return value.isString();
+                       })) {
+                std::sort(values.begin(), values.end(),
+                          [](const Literal& a, const Literal& b) {
+                              return a.asString() < b.asString();
+                          });
+            } else {
+                throw Error::RuntimeException(
+                    paren, "Can only sort numbers or strings.");
+            }
+            return Literal{self};
+        }
+
+        // Elements a packed map runs through Columnar at least, which
+        // repays setting up its evaluator.
+        constexpr std::size_t COLUMNAR_ELEMENTS = 1024;
+
+        auto numeric(const Expr::Expr& expr) -> bool {
+            if (expr == nullptr) {
+                return false;
+            }
+            if (expr->is<Expr::LiteralExpr>()) {
+                return expr->as<Expr::LiteralExpr>().literal.isNumber();
+            }
+            if (expr->is<Expr::Variable>()) {
+                const auto& variable = expr->as<Expr::Variable>();
+                return variable.storage == Expr::Storage::LOCAL &&
+                       variable.slot == 0;
+            }
+            if (expr->is<Expr::GroupExpr>()) {
+                return numeric(expr->as<Expr::GroupExpr>().expr);
+            }
+            if (expr->is<Expr::PrefixExpr>()) {
+                const auto& prefix = expr->as<Expr::PrefixExpr>();
+                return prefix.operator_.type == Token::Type::MINUS &&
+                       numeric(prefix.right);
+            }
+            if (expr->is<Expr::InfixExpr>()) {
+                const auto& infix = expr->as<Expr::InfixExpr>();
+                switch (infix.operator_.type) {
+                    case Token::Type::PLUS:
+                    case Token::Type::MINUS:
+                    case Token::Type::STAR:
+                    case Token::Type::SLASH:
+                        return numeric(infix.left) && numeric(infix.right);
+                    default:
+                        return false;
+                }
+            }
+            return false;
+        }
+
+        // `numbers` mapped by `callee` as one column, when it is a function
+        // of one parameter whose body is `return <expr>;` over numbers,
+        // `+ - * /` and that parameter alone.
+        auto kernel(const std::vector<double>& numbers, const Literal& callee)
+            -> std::optional<std::vector<double>> {
+            const auto* function =
+                std::get_if<Runtime::Function>(&callee.value);
+            if (function == nullptr || function->bound()) {
+                return std::nullopt;
+            }
+            const auto& definition = function->definition();
+            if (definition.method || definition.params.size() != 1 ||
+                !definition.captures.empty() || definition.body.size() != 1 ||
+                !definition.body[0]->is<Stmt::Return>()) {
+                return std::nullopt;
+            }
+            const auto& value = definition.body[0]->as<Stmt::Return>().value;
+            if (!numeric(value)) {
+                return std::nullopt;
+            }
+            Columnar::Table table(numbers.size());
+            table.add(definition.params[0].lexeme, numbers);
+            Columnar::Evaluator evaluator(table);
+            auto                column = evaluator.evaluate(value);
+            if (auto* mapped = std::get_if<Columnar::Numbers>(column.get())) {
+                return std::move(*mapped);
+            }
+            const auto& constant = std::get<Literal>(*column);
+            return std::vector<double>(numbers.size(), constant.asNumber());
+        }
+
+        auto map(const Array& self, const Literal* arguments,
+                 const Token::Token& /*paren*/, const Caller& call)
+            -> Literal {
+            const auto& callee = arguments[0];
+            if (self.packed() && self.size() >= COLUMNAR_ELEMENTS) {
+                if (auto mapped = kernel(self.numbers(), callee)) {
+                    return Literal{Array{std::move(*mapped)}};
+                }
+            }
+            Array result;
+            // Re-read each time round: the callee may change the array.
+            for (std::size_t i = 0; i < self.size(); ++i) {
+                auto element = self.get(i);
+                result.push(call(callee, &element, 1));
+            }
+            return Literal{std::move(result)};
+        }
+
+        auto push(const Array& self, const Literal* arguments,
+                  const Token::Token& /*paren*/, const Caller& /*call*/)
+            -> Literal {
+            self.push(arguments[0]);
+            return Literal{static_cast<double>(self.size())};
+        }
+
+        constexpr std::array<Builtin, 5> BUILTINS = {{
+            {"sum", 0, &sum},
+            {"indexOf", 1, &indexOf},
+            {"sort", 0, &sort},
+            {"map", 1, &map},
+            {"push", 1, &push},
+        }};
+    }  // namespace
+
+    void Array::Data::trace(Tracer& tracer) const {
+        for (const auto& value : values) {
+            tracer.visit(value);
+        }
+    }
+
+    void Array::Data::clear() {
+        numbers = {};
+        values  = {};
+    }
+
+    auto Array::Data::bytes() const -> std::size_t {
+        return sizeof(Data) + numbers.capacity() * sizeof(double) +
+               values.capacity() * sizeof(Literal);
+    }
+
+    Array::Array() : data_(std::make_shared<Data>()) {}
+
+    Array::Array(std::vector<double> numbers) : Array() {
+        data_->numbers = std::move(numbers);
+    }
+
+    Array::Array(std::vector<Token::Literal> values) : Array() {
+        auto numbers = std::all_of(
+            values.begin(), values.end(),
+            [](const Literal& value) { return value.isNumber(); });
+        if (!numbers) {
+            data_->packed = false;
+            data_->values = std::move(values);
+            return;
+        }
+        data_->numbers.reserve(values.size());
+        for (const auto& value : values) {
+            data_->numbers.push_back(value.asNumber());
+        }
+    }
+
+    auto Array::size() const -> std::size_t {
+        return data_->packed ? data_->numbers.size() : data_->values.size();
+    }
+
+    auto Array::get(std::size_t index) const -> Token::Literal {
+        if (data_->packed) {
+            return Literal{data_->numbers[index]};
+        }
+        return data_->values[index];
+    }
+
+    void Array::set(std::size_t index, Token::Literal value) const {
+        if (data_->packed) {
+            if (const auto* number = std::get_if<double>(&value.value)) {
+                data_->numbers[index] = *number;
+                return;
+            }
+            box();
+        }
+        data_->values[index] = std::move(value);
+    }
+
+    void Array::push(Token::Literal value) const {
+        if (data_->packed) {
+            if (const auto* number = std::get_if<double>(&value.value)) {
+                data_->numbers.push_back(*number);
+                return;
+            }
+            box();
+        }
+        data_->values.push_back(std::move(value));
+    }
+
+    void Array::box() const {
+        data_->values.reserve(data_->numbers.size());
+        for (auto number : data_->numbers) {
+            data_->values.emplace_back(number);
+        }
+        data_->numbers = {};
+        data_->packed  = false;
+    }
+
+    auto Array::describe() const -> std::string {
+        std::string text(describedSizeBound(), '\0');
+        text.resize(static_cast<std::size_t>(describeTo(text.data()) -
+                                             text.data()));
+        return text;
+    }
+
+    auto Array::describeTo(char* out) const -> char* {
+        if (std::find(describing.begin(), describing.end(), data_.get()) !=
+            describing.end()) {
+            constexpr std::string_view CYCLE = "[...]";
+            return std::copy(CYCLE.begin(), CYCLE.end(), out);
+        }
+        describing.push_back(data_.get());
+        *out++ = '[';
+        for (std::size_t i = 0; i < size(); ++i) {
+            if (i != 0) {
+                *out++ = ',';
+                *out++ = ' ';
+            }
+            out = Token::formatTo(out, get(i));
+        }
+        describing.pop_back();
+        *out++ = ']';
+        return out;
+    }
+
+    auto Array::describedSizeBound() const -> std::size_t {
+        if (data_->packed) {
+            return 2 + size() * (MAX_NUMBER_CHARS + 2);
+        }
+        if (std::find(describing.begin(), describing.end(), data_.get()) !=
+            describing.end()) {
+            return 5;
+        }
+        describing.push_back(data_.get());
+        std::size_t bound = 2;
+        for (const auto& value : data_->values) {
+            bound += Token::formattedSizeBound(value) + 2;
+        }
+        describing.pop_back();
+        return bound;
+    }
+
+    auto Array::arith(const Token::Literal& left, const Token::Literal& right,
+                      const Token::Token& op) -> Array {
+        const auto* a    = std::get_if<Array>(&left.value);
+        const auto* b    = std::get_if<Array>(&right.value);
+        auto        size = a != nullptr ? a->size() : b->size();
+        if (a != nullptr && b != nullptr && b->size() != size) {
+            throw Error::RuntimeException(
+                op, "Arrays must be the same length.");
+        }
+        auto binary = *Operators::toBinaryOp(op.type);
+        auto packed = [](const Array* array, const Literal& value) {
+            return array != nullptr ? array->packed() : value.isNumber();
+        };
+        if (!packed(a, left) || !packed(b, right)) {
+            std::vector<Literal> values;
+            values.reserve(size);
+            for (std::size_t i = 0; i < size; ++i) {
+                values.push_back(Operators::apply(
+                    binary, a != nullptr ? a->get(i) : left,
+                    b != nullptr ? b->get(i) : right, op));
+            }
+            return Array{std::move(values)};
+        }
+        std::vector<double> out(size);
+        if (a != nullptr && b != nullptr) {
+            Simd::arithKernel(binary, Dense{a->numbers().data()},
+                              Dense{b->numbers().data()}, out.data(), size);
+        } else if (a != nullptr) {
+            Simd::arithKernel(binary, Dense{a->numbers().data()},
+                              Broadcast{right.asNumber()}, out.data(), size);
+        } else {
+            Simd::arithKernel(binary, Broadcast{left.asNumber()},
+                              Dense{b->numbers().data()}, out.data(), size);
+        }
+        return Array{std::move(out)};
+    }
+
+    auto Builtin::find(std::string_view name) -> const Builtin* {
+        for (const auto& builtin : BUILTINS) {
+            if (builtin.name == name) {
+                return &builtin;
+            }
+        }
+        return nullptr;
+    }
+}  // namespace Runtime
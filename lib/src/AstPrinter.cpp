@@ -2,7 +2,7 @@
 
 namespace AstPrinter {
 
-    auto AstPrinter::print(Expr::Expr expr) const -> void {
+    auto AstPrinter::printTree(const Expr::Expr& expr) const -> void {
         if (expr == nullptr) {
             logger_.error("AstPrinter : Expr type is null");
             return;
@@ -37,6 +37,72 @@ namespace AstPrinter {
                             expr.trueExpr, std::string("or"), expr.falseExpr);
     }
 
+    auto AstPrinter::visit(const Expr::TemplateExpr& expr) const
+        -> std::string {
+        std::string result = " (template";
+        for (std::size_t i = 0; i < expr.holes.size(); ++i) {
+            result += fmt::format(" \"{}\"", expr.segments[i]);
+            result += expr.holes[i]->accept(*this);
+        }
+        result += fmt::format(" \"{}\")", expr.segments.back());
+        return result;
+    }
+
+    auto AstPrinter::visit(const Expr::AssignExpr& expr) const -> std::string {
+        return parenthesize("=", std::string(expr.name.lexeme), expr.value);
+    }
+
+    auto AstPrinter::visit(const Expr::CallExpr& expr) const -> std::string {
+        std::string result = " (call" + expr.callee->accept(*this);
+        for (const auto& argument : expr.arguments) {
+            result += argument->accept(*this);
+        }
+        return result + ")";
+    }
+
+    auto AstPrinter::visit(const Expr::GetExpr& expr) const -> std::string {
+        return parenthesize(".", expr.object, std::string(expr.name.lexeme));
+    }
+
+    auto AstPrinter::visit(const Expr::SetExpr& expr) const -> std::string {
+        auto name = expr.operator_ ? expr.operator_->lexeme + "=" : "=";
+        return parenthesize(name, expr.object, std::string(expr.name.lexeme),
+                            expr.value);
+    }
+
+    auto AstPrinter::visit(const Expr::ObjectExpr& expr) const
+        -> std::string {
+        const auto& names  = expr.shape->names();
+        std::string result = " (object";
+        for (std::size_t i = 0; i < expr.values.size(); ++i) {
+            result += " " + names[expr.slots[i]];
+            result += expr.values[i]->accept(*this);
+        }
+        return result + ")";
+    }
+
+    auto AstPrinter::visit(const Expr::SuperExpr& expr) const -> std::string {
+        return parenthesize("super", std::string(expr.method.lexeme));
+    }
+
+    auto AstPrinter::visit(const Expr::ArrayExpr& expr) const -> std::string {
+        std::string result = " (array";
+        for (const auto& value : expr.values) {
+            result += value->accept(*this);
+        }
+        return result + ")";
+    }
+
+    auto AstPrinter::visit(const Expr::IndexExpr& expr) const -> std::string {
+        return parenthesize("[]", expr.object, expr.index);
+    }
+
+    auto AstPrinter::visit(const Expr::IndexSetExpr& expr) const
+        -> std::string {
+        auto name = expr.operator_ ? expr.operator_->lexeme + "=" : "=";
+        return parenthesize("[]" + name, expr.object, expr.index, expr.value);
+    }
+
     auto AstPrinter::visit(const Expr::LiteralExpr& expr) const -> std::string {
         return parenthesize(expr.literal.stringify());
     }
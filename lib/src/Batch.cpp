@@ -0,0 +1,98 @@
+#include "Thor/Batch.hpp"
+
+#include "Thor/Context.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Lexer.hpp"
+#include "Thor/Parser.hpp"
+#include "Thor/ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <sstream>
+
+namespace Runtime {
+
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        constexpr std::string_view SCRIPT_EXTENSION = ".krp";
+
+        auto secondsSince(Clock::time_point start) -> double {
+            return std::chrono::duration<double>(Clock::now() - start)
+                .count();
+        }
+
+        void runScript(ScriptResult& result) {
+            auto start = Clock::now();
+
+            Context context;
+            try {
+                std::ifstream file(result.path);
+                if (!file.is_open()) {
+                    context.logger().error("Failed to open: {}",
+                                           result.path.string());
+                } else {
+                    std::stringstream source;
+                    source << file.rdbuf();
+                    auto text = source.str();
+
+                    Thor::Lexer              lexer(context);
+                    Parser::Parser           parser(context);
+                    Interpreter::Interpreter interpreter(context);
+                    auto                     tokens = lexer.tokenize(text);
+                    interpreter.interpret(parser.parse(tokens));
+                }
+            } catch (const std::exception& e) {
+                context.logger().error("{}", e.what());
+            }
+
+            result.output      = context.output().takeCaptured();
+            result.diagnostics = context.takeDiagnostics();
+            result.ok          = result.diagnostics.empty();
+            result.seconds     = secondsSince(start);
+        }
+    }  // namespace
+
+    auto BatchReport::failed() const -> std::size_t {
+        return static_cast<std::size_t>(
+            std::count_if(scripts.begin(), scripts.end(),
+                          [](const auto& script) { return !script.ok; }));
+    }
+
+    auto findScripts(const std::filesystem::path& directory)
+        -> std::vector<std::filesystem::path> {
+        std::vector<std::filesystem::path> scripts;
+        for (const auto& entry :
+             std::filesystem::recursive_directory_iterator(directory)) {
+            if (entry.is_regular_file() &&
+                entry.path().extension() == SCRIPT_EXTENSION) {
+                scripts.push_back(entry.path());
+            }
+        }
+        std::sort(scripts.begin(), scripts.end());
+        return scripts;
+    }
+
+    auto runBatch(const std::vector<std::filesystem::path>& scripts,
+                  std::size_t workers) -> BatchReport {
+        BatchReport report;
+        report.scripts.resize(scripts.size());
+        for (std::size_t i = 0; i < scripts.size(); ++i) {
+            report.scripts[i].path = scripts[i];
+        }
+
+        auto start = Clock::now();
+        {
+            ThreadPool pool(workers);
+            report.workers = pool.size();
+            for (auto& result : report.scripts) {
+                pool.submit([&result] { runScript(result); });
+            }
+            pool.wait();
+        }
+        report.seconds = secondsSince(start);
+        return report;
+    }
+}  // namespace Runtime
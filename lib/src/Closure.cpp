@@ -0,0 +1,931 @@
+#include "Thor/Closure.hpp"
+
+#include "Thor/Exceptions.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Operators.hpp"
+
+#include <array>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Closure {
+
+    namespace {
+
+        using Operators::BinaryOp;
+        using Token::Literal;
+
+        // A compiled node, plus its value when it is known up front.
+        struct Compiled {
+            Eval                   eval;
+            std::optional<Literal> constant;
+        };
+
+        auto constant(Literal value) -> Compiled {
+            return {[value](Frame& /*frame*/) { return value; },
+                    std::move(value)};
+        }
+
+        // One closure per operator. Constant operands are captured by value
+        // instead of being called.
+        template <BinaryOp Op>
+        auto binary(Compiled left, Compiled right, const Token::Token& op)
+            -> Eval {
+            if (right.constant) {
+                return [left = std::move(left.eval),
+                        right = std::move(*right.constant),
+                        op = &op](Frame& frame) {
+                    return Operators::apply<Op>(left(frame), right, *op);
+                };
+            }
+            if (left.constant) {
+                return [left = std::move(*left.constant),
+                        right = std::move(right.eval), op = &op](Frame& frame) {
+                    return Operators::apply<Op>(left, right(frame), *op);
+                };
+            }
+            return [left = std::move(left.eval), right = std::move(right.eval),
+                    op = &op](Frame& frame) {
+                auto value = left(frame);
+                return Operators::apply<Op>(value, right(frame), *op);
+            };
+        }
+
+        using Factory = auto (*)(Compiled left, Compiled right,
+                                 const Token::Token& op) -> Eval;
+
+        template <std::size_t... Op>
+        constexpr auto makeFactories(std::index_sequence<Op...> /*unused*/)
+            -> std::array<Factory, Operators::OP_COUNT> {
+            return {{&binary<static_cast<BinaryOp>(Op)>...}};
+        }
+
+        constexpr auto FACTORIES =
+            makeFactories(std::make_index_sequence<Operators::OP_COUNT>{});
+
+        // What a call evaluates to find what it runs: the callee, or for
+        // `obj.name(...)` the object, and for `super.name(...)` the
+        // superclass and `this`.
+        struct Callee {
+            enum class Kind : std::uint8_t { VALUE, METHOD, SUPER };
+
+            Kind                 kind;
+            Eval                 value;
+            Eval                 receiver{};       // SUPER only
+            const Expr::GetExpr* get    = nullptr;  // METHOD only
+            const Token::Token*  method = nullptr;  // SUPER only
+        };
+
+        auto callee(const Expr::Expr& expr, bool jit) -> Callee {
+            if (expr->is<Expr::GetExpr>()) {
+                const auto& get = expr->as<Expr::GetExpr>();
+                return {Callee::Kind::METHOD, compile(get.object, jit), {},
+                        &get};
+            }
+            if (expr->is<Expr::SuperExpr>()) {
+                const auto& super = expr->as<Expr::SuperExpr>();
+                return {Callee::Kind::SUPER, compile(super.superclass, jit),
+                        compile(super.receiver, jit), nullptr, &super.method};
+            }
+            return {Callee::Kind::VALUE, compile(expr, jit)};
+        }
+
+        // A call with its frame open and its arguments in place; or, for
+        // a builtin, already made.
+        struct Prepared {
+            std::optional<Runtime::Function> function;
+            std::size_t                      base;
+            Literal constructed;  // The instance, for a class
+            Literal result;       // The builtin's
+        };
+
+        // Opens the callee's frame and evaluates the arguments into it.
+        auto prepare(Frame& frame, const Callee& callee,
+                     const std::vector<Eval>& arguments,
+                     const Token::Token&      paren) -> Prepared {
+            using Interpreter::Interpreter;
+            Literal             value;
+            Interpreter::Target target;
+            switch (callee.kind) {
+                case Callee::Kind::VALUE:
+                    value  = callee.value(frame);
+                    target = Interpreter::target(value, arguments.size(),
+                                                 paren);
+                    break;
+                case Callee::Kind::METHOD:
+                    target = Interpreter::invoke(
+                        callee.value(frame), callee.get->name,
+                        callee.get->cache, value, arguments.size(), paren);
+                    break;
+                case Callee::Kind::SUPER: {
+                    value              = callee.value(frame);
+                    const auto& method = Interpreter::inherited(
+                        value, *callee.method);
+                    Interpreter::expect(method, arguments.size(), paren);
+                    target = {&method, callee.receiver(frame)};
+                    break;
+                }
+            }
+            if (target.builtin != nullptr) {
+                std::array<Literal, Runtime::Builtin::MAX_ARITY> values;
+                for (std::size_t i = 0; i < arguments.size(); ++i) {
+                    values[i] = arguments[i](frame);
+                }
+                auto result = Interpreter::run(
+                    *target.builtin, target.receiver, values.data(), paren,
+                    [&frame, &paren](const Literal& function,
+                                     const Literal* passed, std::size_t count) {
+                        return apply(frame, function, passed, count, paren);
+                    });
+                return {std::nullopt, 0, {}, std::move(result)};
+            }
+            auto* held     = std::get_if<Runtime::Function>(&value.value);
+            auto  function = held == target.function ? std::move(*held)
+                                                     : *target.function;
+            const auto& definition = function.definition();
+            auto base  = frame.stack.push(definition.locals, paren);
+            auto first = definition.first();
+            if (first != 0) {
+                frame.stack[base] = target.receiver;
+            }
+            for (std::size_t i = 0; i < arguments.size(); ++i) {
+                frame.stack[base + first + i] = arguments[i](frame);
+            }
+            return {std::move(function), base,
+                    target.construct ? std::move(target.receiver) : Literal{},
+                    {}};
+        }
+
+        class Compiler : Expr::Visitor<Compiled> {
+          public:
+
+            explicit Compiler(bool jit) : jit_(jit) {}
+
+            auto compile(const Expr::Expr& expr) const -> Compiled {
+                if (expr == nullptr) {
+                    return {[](Frame& frame) {
+                                frame.logger.error(
+                                    "Interpreter : Expr type is null");
+                                return Literal{};
+                            },
+                            std::nullopt};
+                }
+                auto compiled = expr->accept(*this);
+                if (!jit_ || compiled.constant || !expr->jitSite().compiled()) {
+                    return compiled;
+                }
+                return {[&node = *expr, fallback = std::move(compiled.eval)](
+                            Frame& frame) {
+                            if (auto value = node.jitSite().run(
+                                    node, frame.environment)) {
+                                return std::move(*value);
+                            }
+                            return fallback(frame);
+                        },
+                        std::nullopt};
+            }
+
+          private:
+
+            bool jit_;
+
+            auto visit(const Expr::Variable& expr) const -> Compiled final {
+                if (expr.slot == Expr::Variable::UNRESOLVED) {
+                    return constant(expr.literal);
+                }
+                auto slot = expr.slot;
+                switch (expr.storage) {
+                    case Expr::Storage::GLOBAL:
+                        break;
+                    case Expr::Storage::LOCAL:
+                        return {[slot](Frame& frame) {
+                                    return frame.stack[frame.base + slot];
+                                },
+                                std::nullopt};
+                    case Expr::Storage::CELL:
+                        return {[slot](Frame& frame) {
+                                    return frame.stack[frame.base + slot]
+                                        .as<Runtime::Cell>()
+                                        .get();
+                                },
+                                std::nullopt};
+                    case Expr::Storage::CAPTURE:
+                        return {[slot](Frame& frame) {
+                                    return frame.callee->captures()[slot];
+                                },
+                                std::nullopt};
+                    case Expr::Storage::CAPTURED_CELL:
+                        return {[slot](Frame& frame) {
+                                    return frame.callee->captures()[slot]
+                                        .as<Runtime::Cell>()
+                                        .get();
+                                },
+                                std::nullopt};
+                    case Expr::Storage::SELF:
+                        return {[](Frame& frame) {
+                                    return Literal{*frame.callee};
+                                },
+                                std::nullopt};
+                }
+                return {[slot](Frame& frame) {
+                            return frame.environment.get(slot);
+                        },
+                        std::nullopt};
+            }
+
+            auto visit(const Expr::LiteralExpr& expr) const
+                -> Compiled final {
+                return constant(expr.literal);
+            }
+
+            auto visit(const Expr::GroupExpr& expr) const -> Compiled final {
+                return compile(expr.expr);
+            }
+
+            auto visit(const Expr::InfixExpr& expr) const -> Compiled final {
+                auto left  = compile(expr.left);
+                auto right = compile(expr.right);
+                auto op    = expr.op;
+                if (!op) {
+                    // Both sides still run; the result is nil.
+                    return {[left = std::move(left.eval),
+                             right = std::move(right.eval)](Frame& frame) {
+                                (void)left(frame);
+                                (void)right(frame);
+                                return Literal{};
+                            },
+                            std::nullopt};
+                }
+                if (left.constant && right.constant) {
+                    if (auto value = Operators::fold([&] {
+                            return Operators::apply(*op, *left.constant,
+                                                    *right.constant,
+                                                    expr.operator_);
+                        })) {
+                        return constant(std::move(*value));
+                    }
+                }
+                return {FACTORIES[static_cast<std::size_t>(*op)](
+                            std::move(left), std::move(right), expr.operator_),
+                        std::nullopt};
+            }
+
+            auto visit(const Expr::PrefixExpr& expr) const -> Compiled final {
+                auto right = compile(expr.right);
+                if (right.constant) {
+                    if (auto value = Operators::fold([&] {
+                            return Interpreter::Interpreter::prefix(
+                                expr.operator_, *right.constant);
+                        })) {
+                        return constant(std::move(*value));
+                    }
+                }
+                if (expr.operator_.type == Token::Type::MINUS) {
+                    return {[right = std::move(right.eval),
+                             op = &expr.operator_](Frame& frame) {
+                                auto value = right(frame);
+                                if (value.isNumber()) {
+                                    return Literal{-value.asNumber()};
+                                }
+                                return Interpreter::Interpreter::prefix(
+                                    *op, std::move(value));
+                            },
+                            std::nullopt};
+                }
+                return {[right = std::move(right.eval),
+                         op = &expr.operator_](Frame& frame) {
+                            return Interpreter::Interpreter::prefix(
+                                *op, right(frame));
+                        },
+                        std::nullopt};
+            }
+
+            auto visit(const Expr::PostfixExpr& expr) const
+                -> Compiled final {
+                // The interpreter rejects every postfix use; so does this.
+                auto left = compile(expr.left);
+                return {[left = std::move(left.eval),
+                         op = &expr.operator_](Frame& frame) -> Literal {
+                            auto value = left(frame);
+                            if (!value.isNumber()) {
+                                throw Error::RuntimeException(
+                                    *op, "operator can't work on this type");
+                            }
+                            throw Error::RuntimeException(
+                                *op, "Interpreter: operator is not valid");
+                        },
+                        std::nullopt};
+            }
+
+            auto visit(const Expr::TernaryExpr& expr) const
+                -> Compiled final {
+                auto condition = compile(expr.condition);
+                if (condition.constant) {
+                    return compile(Operators::isTruthy(*condition.constant)
+                                       ? expr.trueExpr
+                                       : expr.falseExpr);
+                }
+                return {[condition = std::move(condition.eval),
+                         whenTrue  = compile(expr.trueExpr).eval,
+                         whenFalse = compile(expr.falseExpr).eval](
+                            Frame& frame) {
+                            return Operators::isTruthy(condition(frame))
+                                       ? whenTrue(frame)
+                                       : whenFalse(frame);
+                        },
+                        std::nullopt};
+            }
+
+            auto visit(const Expr::AssignExpr& expr) const -> Compiled final {
+                switch (expr.storage) {
+                    case Expr::Storage::LOCAL:
+                        return {[value = compile(expr.value).eval,
+                                 slot  = expr.slot](Frame& frame) {
+                                    auto result = value(frame);
+                                    frame.stack[frame.base + slot] = result;
+                                    return result;
+                                },
+                                std::nullopt};
+                    case Expr::Storage::CELL:
+                        return {[value = compile(expr.value).eval,
+                                 slot  = expr.slot](Frame& frame) {
+                                    auto result = value(frame);
+                                    frame.stack[frame.base + slot]
+                                        .as<Runtime::Cell>()
+                                        .get() = result;
+                                    return result;
+                                },
+                                std::nullopt};
+                    case Expr::Storage::CAPTURED_CELL:
+                        return {[value = compile(expr.value).eval,
+                                 slot  = expr.slot](Frame& frame) {
+                                    auto result = value(frame);
+                                    frame.callee->captures()[slot]
+                                        .as<Runtime::Cell>()
+                                        .get() = result;
+                                    return result;
+                                },
+                                std::nullopt};
+                    default:
+                        break;
+                }
+                return {[value = compile(expr.value).eval,
+                         slot  = expr.slot](Frame& frame) {
+                            auto result = value(frame);
+                            frame.environment.define(slot, result);
+                            return result;
+                        },
+                        std::nullopt};
+            }
+
+            auto visit(const Expr::TemplateExpr& expr) const
+                -> Compiled final {
+                constexpr std::size_t INLINE_HOLES = 8;
+
+                std::vector<Eval>    holes;
+                std::vector<Literal> constants;
+                for (const auto& hole : expr.holes) {
+                    auto compiled = compile(hole);
+                    if (compiled.constant) {
+                        constants.push_back(*compiled.constant);
+                    }
+                    holes.push_back(std::move(compiled.eval));
+                }
+                if (constants.size() == holes.size()) {
+                    return constant(Interpreter::Interpreter::render(
+                        expr, constants.data()));
+                }
+                return {[&expr, holes = std::move(holes)](Frame& frame) {
+                    std::array<Literal, INLINE_HOLES> inlineValues;
+                    std::vector<Literal>              heapValues;
+                    Literal*                          values =
+                        inlineValues.data();
+                    if (holes.size() > INLINE_HOLES) {
+                        heapValues.resize(holes.size());
+                        values = heapValues.data();
+                    }
+                    for (std::size_t i = 0; i < holes.size(); ++i) {
+                        values[i] = holes[i](frame);
+                    }
+                    return Interpreter::Interpreter::render(expr, values);
+                },
+                        std::nullopt};
+            }
+
+            auto visit(const Expr::CallExpr& expr) const -> Compiled final {
+                std::vector<Eval> arguments;
+                arguments.reserve(expr.arguments.size());
+                for (const auto& each : expr.arguments) {
+                    arguments.push_back(compile(each).eval);
+                }
+                return {[callee    = Closure::callee(expr.callee, jit_),
+                         arguments = std::move(arguments),
+                         paren     = &expr.paren](Frame& frame) {
+                            frame.stack.guard(*paren);
+                            auto prepared =
+                                prepare(frame, callee, arguments, *paren);
+                            if (!prepared.function) {
+                                return std::move(prepared.result);
+                            }
+                            auto result = call(frame,
+                                               std::move(*prepared.function),
+                                               prepared.base);
+                            return prepared.constructed.isNil()
+                                       ? result
+                                       : prepared.constructed;
+                        },
+                        std::nullopt};
+            }
+
+            auto visit(const Expr::GetExpr& expr) const -> Compiled final {
+                return {[object = compile(expr.object).eval,
+                         &expr](Frame& frame) {
+                            return Interpreter::Interpreter::get(
+                                object(frame), expr.name, expr.cache);
+                        },
+                        std::nullopt};
+            }
+
+            auto visit(const Expr::SetExpr& expr) const -> Compiled final {
+                return {[object = compile(expr.object).eval,
+                         value = compile(expr.value).eval,
+                         &expr](Frame& frame) {
+                            using Interpreter::Interpreter;
+                            auto target = object(frame);
+                            auto result = value(frame);
+                            if (expr.operator_) {
+                                result = Operators::apply(
+                                    *expr.operator_,
+                                    Interpreter::get(target, expr.name,
+                                                     expr.get),
+                                    result);
+                            }
+                            Interpreter::set(target, expr.name, result,
+                                             expr.set);
+                            return result;
+                        },
+                        std::nullopt};
+            }
+
+            auto visit(const Expr::ObjectExpr& expr) const -> Compiled final {
+                std::vector<Eval> values;
+                values.reserve(expr.values.size());
+                for (const auto& each : expr.values) {
+                    values.push_back(compile(each).eval);
+                }
+                return {[values = std::move(values), &expr](Frame& frame) {
+                            Runtime::Object object(expr.shape, nullptr);
+                            for (std::size_t i = 0; i < values.size(); ++i) {
+                                object.fields()[expr.slots[i]] =
+                                    values[i](frame);
+                            }
+                            return Literal{std::move(object)};
+                        },
+                        std::nullopt};
+            }
+
+            auto visit(const Expr::SuperExpr& expr) const -> Compiled final {
+                return {[superclass = compile(expr.superclass).eval,
+                         receiver   = compile(expr.receiver).eval,
+                         method     = &expr.method](Frame& frame) {
+                            auto klass = superclass(frame);
+                            return Literal{Interpreter::Interpreter::inherited(
+                                               klass, *method)
+                                               .bind(receiver(frame))};
+                        },
+                        std::nullopt};
+            }
+
+            auto visit(const Expr::ArrayExpr& expr) const -> Compiled final {
+                std::vector<Eval> values;
+                values.reserve(expr.values.size());
+                for (const auto& each : expr.values) {
+                    values.push_back(compile(each).eval);
+                }
+                return {[values = std::move(values)](Frame& frame) {
+                            std::vector<Literal> made;
+                            made.reserve(values.size());
+                            for (const auto& value : values) {
+                                made.push_back(value(frame));
+                            }
+                            return Literal{Runtime::Array{std::move(made)}};
+                        },
+                        std::nullopt};
+            }
+
+            auto visit(const Expr::IndexExpr& expr) const -> Compiled final {
+                return {[object = compile(expr.object).eval,
+                         index  = compile(expr.index).eval,
+                         &expr](Frame& frame) {
+                            auto array = object(frame);
+                            return Interpreter::Interpreter::element(
+                                array, index(frame), expr.bracket);
+                        },
+                        std::nullopt};
+            }
+
+            auto visit(const Expr::IndexSetExpr& expr) const
+                -> Compiled final {
+                return {[object = compile(expr.object).eval,
+                         index  = compile(expr.index).eval,
+                         value  = compile(expr.value).eval,
+                         &expr](Frame& frame) {
+                            using Interpreter::Interpreter;
+                            auto array  = object(frame);
+                            auto at     = index(frame);
+                            auto result = value(frame);
+                            if (expr.operator_) {
+                                result = Operators::apply(
+                                    *expr.operator_,
+                                    Interpreter::element(array, at,
+                                                         expr.bracket),
+                                    result);
+                            }
+                            Interpreter::setElement(array, at, result,
+                                                    expr.bracket);
+                            return result;
+                        },
+                        std::nullopt};
+            }
+        };
+
+        auto describe(const Literal& value) {
+            return Logger::lazy([&value] { return value.stringify(); });
+        }
+
+        void define(Frame& frame, const Stmt::Variable& variable,
+                    Literal value) {
+            if (variable.storage == Expr::Storage::CELL) {
+                frame.stack[frame.base + variable.slot] =
+                    Literal{Runtime::Cell{std::move(value)}};
+            } else if (variable.storage == Expr::Storage::LOCAL) {
+                frame.stack[frame.base + variable.slot] = std::move(value);
+            } else {
+                frame.environment.define(variable.slot, std::move(value));
+            }
+        }
+    }  // namespace
+
+    auto compile(const Expr::Expr& expr, bool jit) -> Eval {
+        return Compiler(jit).compile(expr).eval;
+    }
+
+    auto compile(const Stmt::Stmt& stmt, bool jit) -> Exec {
+        if (stmt->is<Stmt::Block>()) {
+            std::vector<Exec> statements;
+            for (const auto& each : stmt->as<Stmt::Block>().statements) {
+                statements.push_back(compile(each, jit));
+            }
+            return [statements = std::move(statements)](Frame& frame) {
+                for (const auto& each : statements) {
+                    each(frame);
+                    if (frame.flow != Stmt::Flow::NORMAL) {
+                        return;
+                    }
+                }
+            };
+        }
+        if (stmt->is<Stmt::If>()) {
+            const auto& branch = stmt->as<Stmt::If>();
+            Exec        whenFalse =
+                branch.elseBranch != nullptr
+                           ? compile(branch.elseBranch, jit)
+                           : [](Frame& /*frame*/) {};
+            return [condition = compile(branch.condition, jit),
+                    whenTrue  = compile(branch.thenBranch, jit),
+                    whenFalse = std::move(whenFalse)](Frame& frame) {
+                if (Operators::isTruthy(condition(frame))) {
+                    whenTrue(frame);
+                } else {
+                    whenFalse(frame);
+                }
+            };
+        }
+        if (stmt->is<Stmt::Switch>()) {
+            const auto& choice = stmt->as<Stmt::Switch>();
+            // One body per case, then the `else`.
+            std::vector<Exec> bodies;
+            for (const auto& each : choice.cases) {
+                bodies.push_back(compile(each.body, jit));
+            }
+            bodies.push_back(choice.otherwise != nullptr
+                                 ? compile(choice.otherwise, jit)
+                                 : [](Frame& /*frame*/) {});
+            std::vector<Eval> labels;
+            for (const auto& label : choice.dispatch.dynamic()) {
+                labels.push_back(compile(label.expr, jit));
+            }
+            return [subject  = compile(choice.subject, jit),
+                    dispatch = &choice.dispatch, bodies = std::move(bodies),
+                    labels = std::move(labels)](Frame& frame) {
+                auto chosen = dispatch->select(
+                    subject(frame),
+                    [&](std::size_t label) { return labels[label](frame); });
+                bodies[chosen != Stmt::Dispatch::NONE ? chosen
+                                                      : bodies.size() - 1](
+                    frame);
+            };
+        }
+        if (stmt->is<Stmt::While>()) {
+            return compile(stmt->as<Stmt::While>(), jit);
+        }
+        if (stmt->is<Stmt::Break>()) {
+            return [](Frame& frame) { frame.flow = Stmt::Flow::BREAK; };
+        }
+        if (stmt->is<Stmt::Continue>()) {
+            return [](Frame& frame) { frame.flow = Stmt::Flow::CONTINUE; };
+        }
+        if (stmt->is<Stmt::Function>()) {
+            const auto& declaration = stmt->as<Stmt::Function>();
+            if (declaration.storage == Expr::Storage::GLOBAL) {
+                return [function =
+                            Literal{Runtime::Function{declaration.definition}},
+                        slot = declaration.slot](Frame& frame) {
+                    frame.environment.define(slot, function);
+                };
+            }
+            return [&declaration](Frame& frame) {
+                auto slot = frame.base + declaration.slot;
+                auto cell = declaration.storage == Expr::Storage::CELL;
+                if (cell) {
+                    frame.stack[slot] = Literal{Runtime::Cell{Literal{}}};
+                }
+                Literal function{Runtime::Function::close(
+                    declaration.definition, frame.stack.data() + frame.base,
+                    frame.callee)};
+                if (cell) {
+                    frame.stack[slot].as<Runtime::Cell>().get() =
+                        std::move(function);
+                } else {
+                    frame.stack[slot] = std::move(function);
+                }
+            };
+        }
+        if (stmt->is<Stmt::Class>()) {
+            const auto& declaration = stmt->as<Stmt::Class>();
+            Eval        superclass =
+                declaration.superclass != nullptr
+                           ? compile(declaration.superclass, jit)
+                           : [](Frame& /*frame*/) { return Literal{}; };
+            return [&declaration,
+                    superclass = std::move(superclass)](Frame& frame) {
+                using Interpreter::Interpreter;
+                auto parent = superclass(frame);
+                if (declaration.storage == Expr::Storage::GLOBAL) {
+                    frame.environment.define(
+                        declaration.slot,
+                        Interpreter::declare(declaration, parent, nullptr,
+                                             nullptr));
+                    return;
+                }
+                auto slot = frame.base + declaration.slot;
+                auto cell = declaration.storage == Expr::Storage::CELL;
+                if (cell) {
+                    frame.stack[slot] = Literal{Runtime::Cell{Literal{}}};
+                }
+                auto klass = Interpreter::declare(
+                    declaration, parent, frame.stack.data() + frame.base,
+                    frame.callee);
+                if (cell) {
+                    frame.stack[slot].as<Runtime::Cell>().get() =
+                        std::move(klass);
+                } else {
+                    frame.stack[slot] = std::move(klass);
+                }
+            };
+        }
+        if (stmt->is<Stmt::Return>()) {
+            const auto& ret = stmt->as<Stmt::Return>();
+            if (ret.tail) {
+                // Leaves the callee's frame on top for `call` to slide down.
+                const auto&       tail = ret.value->as<Expr::CallExpr>();
+                std::vector<Eval> arguments;
+                arguments.reserve(tail.arguments.size());
+                for (const auto& each : tail.arguments) {
+                    arguments.push_back(compile(each, jit));
+                }
+                return [callee    = Closure::callee(tail.callee, jit),
+                        arguments = std::move(arguments),
+                        paren     = &tail.paren](Frame& frame) {
+                    auto prepared = prepare(frame, callee, arguments, *paren);
+                    if (!prepared.function) {
+                        frame.result = std::move(prepared.result);
+                        frame.flow   = Stmt::Flow::RETURN;
+                        return;
+                    }
+                    if (!prepared.constructed.isNil()) {
+                        // `init` returns nothing; the call is the instance.
+                        (void)call(frame, std::move(*prepared.function),
+                                   prepared.base);
+                        frame.result = std::move(prepared.constructed);
+                        frame.flow   = Stmt::Flow::RETURN;
+                        return;
+                    }
+                    frame.result = Literal{std::move(*prepared.function)};
+                    frame.flow   = Stmt::Flow::TAIL_CALL;
+                };
+            }
+            Eval value = ret.value != nullptr
+                             ? compile(ret.value, jit)
+                             : [](Frame& /*frame*/) { return Literal{}; };
+            return [value = std::move(value)](Frame& frame) {
+                frame.result = value(frame);
+                frame.flow   = Stmt::Flow::RETURN;
+            };
+        }
+        if (stmt->is<Stmt::Try>()) {
+            // As the tree walker does, with C++ exceptions: the try costs
+            // nothing until something throws.
+            const auto& attempt = stmt->as<Stmt::Try>();
+
+            Exec handler = attempt.handler != nullptr
+                               ? compile(attempt.handler, jit)
+                               : Exec{};
+            Exec cleanup = attempt.cleanup != nullptr
+                               ? compile(attempt.cleanup, jit)
+                               : Exec{};
+            return [body = compile(attempt.body, jit),
+                    handler = std::move(handler), cleanup = std::move(cleanup),
+                    &attempt](Frame& frame) {
+                auto        top    = frame.stack.top();
+                auto        base   = frame.base;
+                const auto* callee = frame.callee;
+                Literal     thrown;
+                auto        guarded = [&](const Exec& each) {
+                    try {
+                        each(frame);
+                    } catch (const Error::RuntimeException& error) {
+                        frame.stack.pop(top);
+                        frame.base   = base;
+                        frame.callee = callee;
+                        frame.flow   = Stmt::Flow::NORMAL;
+                        thrown       = Error::caught(error);
+                        return std::current_exception();
+                    }
+                    return std::exception_ptr{};
+                };
+                auto error = guarded(body);
+                if (error && handler) {
+                    define(frame, attempt.caught->as<Stmt::Variable>(),
+                           std::move(thrown));
+                    error = guarded(handler);
+                }
+                if (cleanup) {
+                    auto flow   = frame.flow;
+                    auto result = std::move(frame.result);
+                    frame.flow  = Stmt::Flow::NORMAL;
+                    cleanup(frame);
+                    if (frame.flow != Stmt::Flow::NORMAL) {
+                        return;
+                    }
+                    frame.flow   = flow;
+                    frame.result = std::move(result);
+                }
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            };
+        }
+        if (stmt->is<Stmt::Throw>()) {
+            const auto& raise = stmt->as<Stmt::Throw>();
+            return [value = compile(raise.value, jit), &raise](Frame& frame) {
+                throw Error::Thrown(raise.keyword, value(frame));
+            };
+        }
+        if (stmt->is<Stmt::Expression>()) {
+            return [eval = compile(stmt->as<Stmt::Expression>().expression,
+                                   jit)](Frame& frame) {
+                auto value = eval(frame);
+                frame.logger.debug("Expression result: {}", describe(value));
+            };
+        }
+        if (stmt->is<Stmt::Print>()) {
+            return [eval = compile(stmt->as<Stmt::Print>().expression, jit)](
+                       Frame& frame) { frame.output.writeLine(eval(frame)); };
+        }
+        const auto& variable = stmt->as<Stmt::Variable>();
+        Eval        initializer =
+            variable.initializer != nullptr
+                       ? compile(variable.initializer, jit)
+                       : [](Frame& /*frame*/) { return Literal{}; };
+        return [initializer = std::move(initializer), &variable](Frame& frame) {
+            auto value = initializer(frame);
+            frame.logger.debug("Variable Declartion:  {},{}: {}", variable.name,
+                               variable.type, describe(value));
+            define(frame, variable, std::move(value));
+        };
+    }
+
+    auto compile(const Stmt::While& loop, bool jit) -> Exec {
+        Eval increment = loop.increment != nullptr
+                             ? compile(loop.increment, jit)
+                             : Eval{};
+        return [condition = compile(loop.condition, jit),
+                body = compile(loop.body, jit), increment = std::move(increment),
+                &loop, level = jit ? Level::JIT : Level::CLOSURE](
+                   Frame& frame) {
+            if (frame.loops != nullptr) {
+                if (const auto* code =
+                        frame.loops->enter(loop, level, frame.environment)) {
+                    (*code)(frame);
+                    return;
+                }
+            }
+            while (Operators::isTruthy(condition(frame))) {
+                body(frame);
+                if (frame.flow == Stmt::Flow::CONTINUE) {
+                    frame.flow = Stmt::Flow::NORMAL;
+                } else if (frame.flow != Stmt::Flow::NORMAL) {
+                    if (frame.flow == Stmt::Flow::BREAK) {
+                        frame.flow = Stmt::Flow::NORMAL;
+                    }
+                    return;
+                }
+                if (increment) {
+                    (void)increment(frame);
+                }
+                if (frame.loops != nullptr) {
+                    if (const auto* code = frame.loops->backEdge(
+                            loop, level, frame.environment)) {
+                        (*code)(frame);
+                        return;
+                    }
+                }
+            }
+        };
+    }
+
+    auto compile(const std::vector<Stmt::Stmt>& statements) -> Program {
+        Program program;
+        program.reserve(statements.size());
+        for (const auto& stmt : statements) {
+            program.push_back(compile(stmt));
+        }
+        return program;
+    }
+
+    auto body(const Stmt::Definition& function) -> const Exec& {
+        std::call_once(function.compiled, [&function] {
+            function.code = [statements = compile(function.body)](
+                                Frame& frame) {
+                for (const auto& each : statements) {
+                    each(frame);
+                    if (frame.flow != Stmt::Flow::NORMAL) {
+                        return;
+                    }
+                }
+            };
+        });
+        return function.code;
+    }
+
+    auto call(Frame& frame, Runtime::Function function, std::size_t base)
+        -> Literal {
+        auto        caller    = frame.base;
+        const auto* enclosing = frame.callee;
+        frame.base            = base;
+        frame.callee          = &function;
+        for (;;) {
+            const auto& definition = function.definition();
+            if (!definition.cells.empty()) {
+                frame.stack.box(base, definition.cells);
+            }
+            body(definition)(frame);
+            if (frame.flow != Stmt::Flow::TAIL_CALL) {
+                break;
+            }
+            frame.flow = Stmt::Flow::NORMAL;
+            function   = std::move(frame.result.as<Runtime::Function>());
+            frame.stack.slide(base, function.definition().locals);
+        }
+        auto result = frame.flow == Stmt::Flow::RETURN ? std::move(frame.result)
+                                                       : Literal{};
+        frame.flow   = Stmt::Flow::NORMAL;
+        frame.base   = caller;
+        frame.callee = enclosing;
+        frame.stack.pop(base);
+        return result;
+    }
+
+    auto apply(Frame& frame, const Literal& callee, const Literal* arguments,
+               std::size_t count, const Token::Token& paren) -> Literal {
+        frame.stack.guard(paren);
+        auto target =
+            Interpreter::Interpreter::target(callee, count, paren);
+        auto        function   = *target.function;
+        const auto& definition = function.definition();
+        auto        base       = frame.stack.push(definition.locals, paren);
+        auto        first      = definition.first();
+        if (first != 0) {
+            frame.stack[base] = target.receiver;
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            frame.stack[base + first + i] = arguments[i];
+        }
+        auto result = call(frame, std::move(function), base);
+        return target.construct ? std::move(target.receiver) : result;
+    }
+}  // namespace Closure
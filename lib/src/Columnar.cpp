@@ -0,0 +1,817 @@
+#include "Thor/Columnar.hpp"
+
+#include "Thor/Lexer.hpp"
+#include "Thor/Operators.hpp"
+#include "Thor/Parser.hpp"
+#include "Thor/Simd.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace Columnar {
+
+    namespace {
+
+        using Operators::BinaryOp;
+        using Simd::at;
+        using Simd::Broadcast;
+        using Simd::Dense;
+        using Token::Literal;
+
+        enum class Compare : std::uint8_t { EQ, NE, LT, LE, GT, GE };
+
+        template <Compare Op>
+        inline auto compare(double left, double right) -> bool {
+            if constexpr (Op == Compare::EQ) {
+                return left == right;
+            } else if constexpr (Op == Compare::NE) {
+                return left != right;
+            } else if constexpr (Op == Compare::LT) {
+                return left < right;
+            } else if constexpr (Op == Compare::LE) {
+                return left <= right;
+            } else if constexpr (Op == Compare::GT) {
+                return left > right;
+            } else {
+                return left >= right;
+            }
+        }
+
+#if defined(__x86_64__)
+        // Ordered predicates, except NE, so NaN behaves as in C++.
+        template <Compare Op>
+        constexpr int PREDICATE = Op == Compare::EQ   ? _CMP_EQ_OQ
+                                  : Op == Compare::NE ? _CMP_NEQ_UQ
+                                  : Op == Compare::LT ? _CMP_LT_OQ
+                                  : Op == Compare::LE ? _CMP_LE_OQ
+                                  : Op == Compare::GT ? _CMP_GT_OQ
+                                                      : _CMP_GE_OQ;
+
+        template <Compare Op, typename L, typename R>
+        THOR_AVX void compareAvx(L left, R right, std::uint64_t* out,
+                                 std::size_t n) {
+            std::size_t row = 0;
+            for (; row + 64 <= n; row += 64) {
+                std::uint64_t bits = 0;
+                for (std::size_t lane = 0; lane < 64; lane += 4) {
+                    auto mask = _mm256_cmp_pd(Simd::load4(left, row + lane),
+                                              Simd::load4(right, row + lane),
+                                              PREDICATE<Op>);
+                    bits |= static_cast<std::uint64_t>(
+                                static_cast<unsigned>(_mm256_movemask_pd(mask)))
+                            << lane;
+                }
+                out[row / 64] = bits;
+            }
+            for (; row < n; ++row) {
+                if (compare<Op>(at(left, row), at(right, row))) {
+                    out[row / 64] |= std::uint64_t{1} << (row % 64);
+                }
+            }
+        }
+#endif
+
+        // `out` must be zeroed.
+        template <Compare Op, typename L, typename R>
+        void compareKernel(L left, R right, std::uint64_t* out,
+                           std::size_t n) {
+#if defined(__x86_64__)
+            if (Simd::HAS_AVX) {
+                compareAvx<Op>(left, right, out, n);
+                return;
+            }
+#endif
+            for (std::size_t row = 0; row < n; ++row) {
+                if (compare<Op>(at(left, row), at(right, row))) {
+                    out[row / 64] |= std::uint64_t{1} << (row % 64);
+                }
+            }
+        }
+
+        auto words(std::size_t rows) -> std::size_t {
+            return (rows + 63) / 64;
+        }
+
+        // Clears the bits past the last row, which inverting sets.
+        void clearTail(Bitmap& bitmap, std::size_t rows) {
+            if (rows % 64 != 0) {
+                bitmap.words.back() &= (std::uint64_t{1} << (rows % 64)) - 1;
+            }
+        }
+
+        auto share(Column column) -> ColumnPtr {
+            return std::make_shared<const Column>(std::move(column));
+        }
+
+        auto scalar(Literal value) -> ColumnPtr {
+            return share(Column{std::move(value)});
+        }
+
+        // A numeric operand, if the column is one.
+        auto isNumeric(const Column& column) -> bool {
+            if (const auto* value = std::get_if<Literal>(&column)) {
+                return value->isNumber();
+            }
+            return std::holds_alternative<Numbers>(column);
+        }
+
+        // Calls `fn` with the column as a Dense or Broadcast operand.
+        template <typename Fn>
+        auto withOperand(const Column& column, Fn&& fn) {
+            if (const auto* numbers = std::get_if<Numbers>(&column)) {
+                return fn(Dense{numbers->data()});
+            }
+            return fn(Broadcast{std::get<Literal>(column).asNumber()});
+        }
+
+        enum class Kind : std::uint8_t { NUMBER, BOOL, STRING, NIL, MIXED };
+
+        auto kindOf(const Column& column) -> Kind {
+            switch (column.index()) {
+                case 0: {
+                    const auto& value = std::get<Literal>(column);
+                    return value.isNumber()   ? Kind::NUMBER
+                           : value.isBool()   ? Kind::BOOL
+                           : value.isString() ? Kind::STRING
+                                              : Kind::NIL;
+                }
+                case 1:
+                    return Kind::NUMBER;
+                case 2:
+                    return Kind::BOOL;
+                case 3:
+                    return Kind::STRING;
+                default:
+                    return Kind::MIXED;
+            }
+        }
+
+        auto compareOp(Token::Type type) -> std::optional<Compare> {
+            switch (type) {
+                case Token::Type::EQUAL_EQUAL:
+                    return Compare::EQ;
+                case Token::Type::BANG_EQUAL:
+                    return Compare::NE;
+                case Token::Type::LESS:
+                    return Compare::LT;
+                case Token::Type::LESS_EQUAL:
+                    return Compare::LE;
+                case Token::Type::GREATER:
+                    return Compare::GT;
+                case Token::Type::GREATER_EQUAL:
+                    return Compare::GE;
+                default:
+                    return std::nullopt;
+            }
+        }
+
+        auto arithOp(Token::Type type) -> std::optional<BinaryOp> {
+            switch (type) {
+                case Token::Type::PLUS:
+                case Token::Type::MINUS:
+                case Token::Type::STAR:
+                case Token::Type::SLASH:
+                    return Operators::toBinaryOp(type);
+                default:
+                    return std::nullopt;
+            }
+        }
+
+        template <typename L, typename R>
+        auto runArith(BinaryOp op, L left, R right, std::size_t rows)
+            -> Numbers {
+            Numbers out(rows);
+            Simd::arithKernel(op, left, right, out.data(), rows);
+            return out;
+        }
+
+        template <typename L, typename R>
+        auto runCompare(Compare op, L left, R right, std::size_t rows)
+            -> Bitmap {
+            Bitmap    out{std::vector<std::uint64_t>(words(rows))};
+            auto*     bits = out.words.data();
+            switch (op) {
+                case Compare::EQ:
+                    compareKernel<Compare::EQ>(left, right, bits, rows);
+                    break;
+                case Compare::NE:
+                    compareKernel<Compare::NE>(left, right, bits, rows);
+                    break;
+                case Compare::LT:
+                    compareKernel<Compare::LT>(left, right, bits, rows);
+                    break;
+                case Compare::LE:
+                    compareKernel<Compare::LE>(left, right, bits, rows);
+                    break;
+                case Compare::GT:
+                    compareKernel<Compare::GT>(left, right, bits, rows);
+                    break;
+                case Compare::GE:
+                    compareKernel<Compare::GE>(left, right, bits, rows);
+                    break;
+            }
+            return out;
+        }
+
+        // Variables of an expression, for binding them row by row.
+        void collectVariables(const Expr::Expr&                    expr,
+                              std::vector<const Expr::Variable*>& out) {
+            if (expr == nullptr) {
+                return;
+            }
+            if (expr->is<Expr::Variable>()) {
+                out.push_back(&expr->as<Expr::Variable>());
+            } else if (expr->is<Expr::InfixExpr>()) {
+                collectVariables(expr->as<Expr::InfixExpr>().left, out);
+                collectVariables(expr->as<Expr::InfixExpr>().right, out);
+            } else if (expr->is<Expr::GroupExpr>()) {
+                collectVariables(expr->as<Expr::GroupExpr>().expr, out);
+            } else if (expr->is<Expr::PrefixExpr>()) {
+                collectVariables(expr->as<Expr::PrefixExpr>().right, out);
+            } else if (expr->is<Expr::PostfixExpr>()) {
+                collectVariables(expr->as<Expr::PostfixExpr>().left, out);
+            } else if (expr->is<Expr::TernaryExpr>()) {
+                const auto& ternary = expr->as<Expr::TernaryExpr>();
+                collectVariables(ternary.condition, out);
+                collectVariables(ternary.trueExpr, out);
+                collectVariables(ternary.falseExpr, out);
+            } else if (expr->is<Expr::TemplateExpr>()) {
+                for (const auto& hole : expr->as<Expr::TemplateExpr>().holes) {
+                    collectVariables(hole, out);
+                }
+            } else if (expr->is<Expr::AssignExpr>()) {
+                collectVariables(expr->as<Expr::AssignExpr>().value, out);
+            } else if (expr->is<Expr::CallExpr>()) {
+                const auto& call = expr->as<Expr::CallExpr>();
+                collectVariables(call.callee, out);
+                for (const auto& argument : call.arguments) {
+                    collectVariables(argument, out);
+                }
+            } else if (expr->is<Expr::GetExpr>()) {
+                collectVariables(expr->as<Expr::GetExpr>().object, out);
+            } else if (expr->is<Expr::SetExpr>()) {
+                collectVariables(expr->as<Expr::SetExpr>().object, out);
+                collectVariables(expr->as<Expr::SetExpr>().value, out);
+            } else if (expr->is<Expr::ObjectExpr>()) {
+                for (const auto& value : expr->as<Expr::ObjectExpr>().values) {
+                    collectVariables(value, out);
+                }
+            } else if (expr->is<Expr::ArrayExpr>()) {
+                for (const auto& value : expr->as<Expr::ArrayExpr>().values) {
+                    collectVariables(value, out);
+                }
+            } else if (expr->is<Expr::IndexExpr>()) {
+                collectVariables(expr->as<Expr::IndexExpr>().object, out);
+                collectVariables(expr->as<Expr::IndexExpr>().index, out);
+            } else if (expr->is<Expr::IndexSetExpr>()) {
+                const auto& store = expr->as<Expr::IndexSetExpr>();
+                collectVariables(store.object, out);
+                collectVariables(store.index, out);
+                collectVariables(store.value, out);
+            }
+        }
+
+        // Resolved variables of `expr` paired with their input columns.
+        auto bindings(const Expr::Expr& expr, const Table& table)
+            -> std::vector<std::pair<std::uint32_t, ColumnPtr>> {
+            std::vector<const Expr::Variable*> variables;
+            collectVariables(expr, variables);
+            std::vector<std::pair<std::uint32_t, ColumnPtr>> out;
+            for (const auto* variable : variables) {
+                auto column = table.find(variable->name.lexeme);
+                if (variable->slot != Expr::Variable::UNRESOLVED && column) {
+                    out.emplace_back(variable->slot, std::move(column));
+                }
+            }
+            return out;
+        }
+    }  // namespace
+
+    auto makeBitmap(const std::vector<bool>& values) -> Bitmap {
+        Bitmap bitmap{std::vector<std::uint64_t>(words(values.size()))};
+        for (std::size_t row = 0; row < values.size(); ++row) {
+            if (values[row]) {
+                bitmap.words[row / 64] |= std::uint64_t{1} << (row % 64);
+            }
+        }
+        return bitmap;
+    }
+
+    auto encodeStrings(const std::vector<std::string>& values) -> Strings {
+        auto dictionary = std::make_shared<std::vector<Runtime::String>>();
+        std::unordered_map<std::string, std::uint32_t> codes;
+        Strings                                         column;
+        column.codes.reserve(values.size());
+        for (const auto& value : values) {
+            auto [found, inserted] = codes.try_emplace(
+                value, static_cast<std::uint32_t>(dictionary->size()));
+            if (inserted) {
+                dictionary->emplace_back(value);
+            }
+            column.codes.push_back(found->second);
+        }
+        column.dictionary = std::move(dictionary);
+        return column;
+    }
+
+    auto valueAt(const Column& column, std::size_t row) -> Token::Literal {
+        switch (column.index()) {
+            case 0:
+                return std::get<Literal>(column);
+            case 1:
+                return Literal{std::get<Numbers>(column)[row]};
+            case 2:
+                return Literal{std::get<Bitmap>(column).test(row)};
+            case 3: {
+                const auto& strings = std::get<Strings>(column);
+                return Literal{(*strings.dictionary)[strings.codes[row]]};
+            }
+            default:
+                return std::get<Boxed>(column)[row];
+        }
+    }
+
+    void Table::add(std::string name, Column column) {
+        columns_[std::move(name)] = share(std::move(column));
+    }
+
+    auto Table::find(std::string_view name) const -> ColumnPtr {
+        auto found = columns_.find(std::string(name));
+        return found == columns_.end() ? nullptr : found->second;
+    }
+
+    auto parseExpression(Runtime::Context& context, std::string source)
+        -> Expr::Expr {
+        source.append(";\n");
+        Thor::Lexer    lexer(context);
+        Parser::Parser parser(context);
+        auto           tokens     = lexer.tokenize(source);
+        auto           statements = parser.parse(tokens);
+        auto           errors     = context.takeDiagnostics();
+        if (!errors.empty() || statements.size() != 1 ||
+            !statements.front()->is<Stmt::Expression>()) {
+            throw std::invalid_argument("Not a single expression: " + errors);
+        }
+        return statements.front()->as<Stmt::Expression>().expression;
+    }
+
+    auto evaluateRows(const Expr::Expr& expr, const Table& table) -> Boxed {
+        Runtime::Context         context;
+        Interpreter::Interpreter interpreter(context);
+        auto                     inputs = bindings(expr, table);
+
+        Boxed out;
+        out.reserve(table.rows());
+        for (std::size_t row = 0; row < table.rows(); ++row) {
+            for (const auto& [slot, column] : inputs) {
+                interpreter.bind(slot, valueAt(*column, row));
+            }
+            out.push_back(interpreter.evaluate(expr));
+        }
+        return out;
+    }
+
+    auto Evaluator::evaluate(const Expr::Expr& expr) -> ColumnPtr {
+        return evaluateUnder(expr, nullptr);
+    }
+
+    auto Evaluator::evaluateUnder(const Expr::Expr&  expr,
+                                  const Selection* selection) const
+        -> ColumnPtr {
+        const auto* outer = selection_;
+        selection_        = selection;
+        auto result       = expr->accept(*this);
+        selection_        = outer;
+        return result;
+    }
+
+    auto Evaluator::visit(const Expr::Variable& expr) const -> ColumnPtr {
+        if (auto column = table_.find(expr.name.lexeme)) {
+            return column;
+        }
+        // As in the row interpreter, an unbound name reads as nil.
+        return scalar(expr.literal);
+    }
+
+    auto Evaluator::visit(const Expr::LiteralExpr& expr) const -> ColumnPtr {
+        return scalar(expr.literal);
+    }
+
+    auto Evaluator::visit(const Expr::GroupExpr& expr) const -> ColumnPtr {
+        return evaluateUnder(expr.expr, selection_);
+    }
+
+    auto Evaluator::visit(const Expr::PostfixExpr& expr) const -> ColumnPtr {
+        return evaluateRowWise(Expr::makeExpr(expr));
+    }
+
+    auto Evaluator::visit(const Expr::TemplateExpr& expr) const -> ColumnPtr {
+        return evaluateRowWise(Expr::makeExpr(expr));
+    }
+
+    auto Evaluator::visit(const Expr::AssignExpr& expr) const -> ColumnPtr {
+        return evaluateRowWise(Expr::makeExpr(expr));
+    }
+
+    auto Evaluator::visit(const Expr::CallExpr& expr) const -> ColumnPtr {
+        return evaluateRowWise(Expr::makeExpr(expr));
+    }
+
+    auto Evaluator::visit(const Expr::GetExpr& expr) const -> ColumnPtr {
+        return evaluateRowWise(Expr::makeExpr(expr));
+    }
+
+    auto Evaluator::visit(const Expr::SetExpr& expr) const -> ColumnPtr {
+        return evaluateRowWise(Expr::makeExpr(expr));
+    }
+
+    auto Evaluator::visit(const Expr::ObjectExpr& expr) const -> ColumnPtr {
+        return evaluateRowWise(Expr::makeExpr(expr));
+    }
+
+    auto Evaluator::visit(const Expr::SuperExpr& expr) const -> ColumnPtr {
+        return evaluateRowWise(Expr::makeExpr(expr));
+    }
+
+    auto Evaluator::visit(const Expr::ArrayExpr& expr) const -> ColumnPtr {
+        return evaluateRowWise(Expr::makeExpr(expr));
+    }
+
+    auto Evaluator::visit(const Expr::IndexExpr& expr) const -> ColumnPtr {
+        return evaluateRowWise(Expr::makeExpr(expr));
+    }
+
+    auto Evaluator::visit(const Expr::IndexSetExpr& expr) const -> ColumnPtr {
+        return evaluateRowWise(Expr::makeExpr(expr));
+    }
+
+    auto Evaluator::visit(const Expr::InfixExpr& expr) const -> ColumnPtr {
+        auto type = expr.operator_.type;
+        if (type == Token::Type::LOGICAL_AND) {
+            return logical(expr, true);
+        }
+        if (type == Token::Type::LOGICAL_OR) {
+            return logical(expr, false);
+        }
+
+        auto        leftPtr  = evaluateUnder(expr.left, selection_);
+        auto        rightPtr = evaluateUnder(expr.right, selection_);
+        const auto& left     = *leftPtr;
+        const auto& right    = *rightPtr;
+
+        if (left.index() == 0 && right.index() == 0) {
+            if (selectedRows() == 0) {
+                return scalar({});
+            }
+            return scalar(Operators::apply(expr.operator_,
+                                           std::get<Literal>(left),
+                                           std::get<Literal>(right)));
+        }
+
+        if (isNumeric(left) && isNumeric(right) && !sparse()) {
+            auto arith   = arithOp(type);
+            auto compare = compareOp(type);
+            if (arith || compare) {
+                return withOperand(left, [&](auto l) {
+                    return withOperand(right, [&](auto r) {
+                        return arith ? share(runArith(*arith, l, r, rows()))
+                                     : share(runCompare(*compare, l, r,
+                                                        rows()));
+                    });
+                });
+            }
+        }
+
+        if (type == Token::Type::EQUAL_EQUAL ||
+            type == Token::Type::BANG_EQUAL) {
+            if (auto result = equality(left, right,
+                                       type == Token::Type::EQUAL_EQUAL)) {
+                return result;
+            }
+        }
+
+        // String concatenation with a constant rewrites the dictionary
+        // instead of every row.
+        if (type == Token::Type::PLUS) {
+            const auto* strings = std::get_if<Strings>(&left);
+            const auto* suffix  = std::get_if<Literal>(&right);
+            if (strings != nullptr && suffix != nullptr &&
+                suffix->isString()) {
+                auto dictionary =
+                    std::make_shared<std::vector<Runtime::String>>();
+                for (const auto& entry : *strings->dictionary) {
+                    dictionary->push_back(entry + suffix->asString());
+                }
+                return share(Strings{strings->codes, std::move(dictionary)});
+            }
+        }
+
+        return applyRowWise(expr.operator_, left, right);
+    }
+
+    auto Evaluator::equality(const Column& left, const Column& right,
+                             bool equal) const -> ColumnPtr {
+        auto leftKind  = kindOf(left);
+        auto rightKind = kindOf(right);
+        if (leftKind == Kind::MIXED || rightKind == Kind::MIXED) {
+            return nullptr;
+        }
+        if (leftKind != rightKind) {
+            return scalar(Literal{!equal});
+        }
+
+        Bitmap out{std::vector<std::uint64_t>(words(rows()))};
+        if (leftKind == Kind::BOOL) {
+            // At least one side is a bitmap, the other a bitmap or constant.
+            const auto& bits  = std::get<Bitmap>(
+                left.index() == 2 ? left : right);
+            const auto& other = left.index() == 2 ? right : left;
+            for (std::size_t word = 0; word < out.words.size(); ++word) {
+                auto otherWord = other.index() == 2
+                                   ? std::get<Bitmap>(other).words[word]
+                               : std::get<Literal>(other).asBool()
+                                   ? ~std::uint64_t{0}
+                                   : 0;
+                auto same      = ~(bits.words[word] ^ otherWord);
+                out.words[word] = equal ? same : ~same;
+            }
+            clearTail(out, rows());
+            return share(std::move(out));
+        }
+
+        if (leftKind == Kind::STRING) {
+            const auto* strings = std::get_if<Strings>(&left);
+            const auto* value   = std::get_if<Literal>(&right);
+            if (strings == nullptr) {
+                strings = std::get_if<Strings>(&right);
+                value   = std::get_if<Literal>(&left);
+            }
+            if (value == nullptr) {
+                return nullptr;  // Two string columns: compared row by row
+            }
+
+            // Compare codes against the constant's code, if it has one.
+            const auto& dictionary = *strings->dictionary;
+            auto        code       = static_cast<std::uint32_t>(
+                dictionary.size());
+            for (std::uint32_t i = 0; i < dictionary.size(); ++i) {
+                if (dictionary[i] == value->asString()) {
+                    code = i;
+                    break;
+                }
+            }
+            const auto* codes = strings->codes.data();
+            for (std::size_t row = 0; row < rows(); ++row) {
+                if ((codes[row] == code) == equal) {
+                    out.words[row / 64] |= std::uint64_t{1} << (row % 64);
+                }
+            }
+            return share(std::move(out));
+        }
+        return nullptr;
+    }
+
+    auto Evaluator::truthy(const Column& column) const -> ColumnPtr {
+        switch (column.index()) {
+            case 0:
+                return scalar(
+                    Literal{Operators::isTruthy(std::get<Literal>(column))});
+            case 1:
+                return share(runCompare(
+                    Compare::NE, Dense{std::get<Numbers>(column).data()},
+                    Broadcast{0.0}, rows()));
+            case 2:
+                return share(Column{std::get<Bitmap>(column)});
+            default:
+                break;
+        }
+
+        Bitmap out{std::vector<std::uint64_t>(words(rows()))};
+        if (const auto* strings = std::get_if<Strings>(&column)) {
+            std::vector<bool> entryTruth;
+            for (const auto& entry : *strings->dictionary) {
+                entryTruth.push_back(!entry.empty());
+            }
+            forEachSelected([&](std::size_t row) {
+                if (entryTruth[strings->codes[row]]) {
+                    out.words[row / 64] |= std::uint64_t{1} << (row % 64);
+                }
+            });
+        } else {
+            const auto& values = std::get<Boxed>(column);
+            forEachSelected([&](std::size_t row) {
+                if (Operators::isTruthy(values[row])) {
+                    out.words[row / 64] |= std::uint64_t{1} << (row % 64);
+                }
+            });
+        }
+        return share(std::move(out));
+    }
+
+    auto Evaluator::narrow(const Bitmap& bits, bool wanted) const
+        -> Selection {
+        Selection out;
+        if (selection_ != nullptr) {
+            for (auto row : *selection_) {
+                if (bits.test(row) == wanted) {
+                    out.push_back(row);
+                }
+            }
+            return out;
+        }
+        for (std::size_t word = 0; word < bits.words.size(); ++word) {
+            auto set = wanted ? bits.words[word] : ~bits.words[word];
+            if (word + 1 == bits.words.size() && rows() % 64 != 0) {
+                set &= (std::uint64_t{1} << (rows() % 64)) - 1;
+            }
+            while (set != 0) {
+                auto bit = static_cast<std::size_t>(__builtin_ctzll(set));
+                out.push_back(static_cast<std::uint32_t>(word * 64 + bit));
+                set &= set - 1;
+            }
+        }
+        return out;
+    }
+
+    auto Evaluator::logical(const Expr::InfixExpr& expr, bool isAnd) const
+        -> ColumnPtr {
+        auto leftTruth = truthy(*evaluateUnder(expr.left, selection_));
+        if (const auto* decided = std::get_if<Literal>(leftTruth.get())) {
+            // The same for every row: either settled, or up to the right.
+            if (decided->asBool() != isAnd) {
+                return leftTruth;
+            }
+            return truthy(*evaluateUnder(expr.right, selection_));
+        }
+
+        // Only rows the left side does not settle reach the right side.
+        const auto& left      = std::get<Bitmap>(*leftTruth);
+        auto        undecided = narrow(left, isAnd);
+        if (undecided.empty()) {
+            return leftTruth;
+        }
+        auto rightTruth = truthy(*evaluateUnder(expr.right, &undecided));
+
+        Bitmap out = left;
+        if (const auto* decided = std::get_if<Literal>(rightTruth.get())) {
+            if (isAnd && !decided->asBool()) {
+                std::fill(out.words.begin(), out.words.end(), 0);
+            } else if (!isAnd && decided->asBool()) {
+                for (auto row : undecided) {
+                    out.words[row / 64] |= std::uint64_t{1} << (row % 64);
+                }
+            }
+            return share(std::move(out));
+        }
+        const auto& right = std::get<Bitmap>(*rightTruth);
+        for (std::size_t word = 0; word < out.words.size(); ++word) {
+            out.words[word] = isAnd ? out.words[word] & right.words[word]
+                                    : out.words[word] | right.words[word];
+        }
+        clearTail(out, rows());
+        return share(std::move(out));
+    }
+
+    auto Evaluator::visit(const Expr::PrefixExpr& expr) const -> ColumnPtr {
+        auto type = expr.operator_.type;
+        if (type == Token::Type::BANG) {
+            auto truth = truthy(*evaluateUnder(expr.right, selection_));
+            if (const auto* value = std::get_if<Literal>(truth.get())) {
+                return scalar(Literal{!value->asBool()});
+            }
+            Bitmap out = std::get<Bitmap>(*truth);
+            for (auto& word : out.words) {
+                word = ~word;
+            }
+            clearTail(out, rows());
+            return share(std::move(out));
+        }
+
+        auto operand = evaluateUnder(expr.right, selection_);
+        if (std::holds_alternative<Numbers>(*operand)) {
+            if (type == Token::Type::MINUS) {
+                return share(runArith(
+                    BinaryOp::STAR, Dense{std::get<Numbers>(*operand).data()},
+                    Broadcast{-1.0}, rows()));
+            }
+            if (type == Token::Type::PLUS) {
+                return operand;
+            }
+        }
+        return evaluateRowWise(Expr::makeExpr(expr));
+    }
+
+    auto Evaluator::visit(const Expr::TernaryExpr& expr) const -> ColumnPtr {
+        auto truth = truthy(*evaluateUnder(expr.condition, selection_));
+        if (const auto* value = std::get_if<Literal>(truth.get())) {
+            return evaluateUnder(value->asBool() ? expr.trueExpr
+                                                 : expr.falseExpr,
+                                 selection_);
+        }
+
+        const auto& bits        = std::get<Bitmap>(*truth);
+        auto        whenTrue    = narrow(bits, true);
+        auto        whenFalse   = narrow(bits, false);
+        auto        trueColumn  = whenTrue.empty()
+                                    ? scalar({})
+                                    : evaluateUnder(expr.trueExpr, &whenTrue);
+        auto        falseColumn = whenFalse.empty()
+                                    ? scalar({})
+                                    : evaluateUnder(expr.falseExpr, &whenFalse);
+
+        if (isNumeric(*trueColumn) && isNumeric(*falseColumn)) {
+            Numbers out(rows());
+            withOperand(*trueColumn, [&](auto t) {
+                withOperand(*falseColumn, [&](auto f) {
+                    for (std::size_t row = 0; row < rows(); ++row) {
+                        out[row] = bits.test(row) ? at(t, row) : at(f, row);
+                    }
+                    return 0;
+                });
+                return 0;
+            });
+            return share(std::move(out));
+        }
+
+        Boxed out(rows());
+        forEachSelected([&](std::size_t row) {
+            out[row] = valueAt(bits.test(row) ? *trueColumn : *falseColumn,
+                               row);
+        });
+        return pack(std::move(out));
+    }
+
+    auto Evaluator::evaluateRowWise(const Expr::Expr& expr) const
+        -> ColumnPtr {
+        auto  inputs = bindings(expr, table_);
+        Boxed out(rows());
+        forEachSelected([&](std::size_t row) {
+            for (const auto& [slot, column] : inputs) {
+                interpreter_.bind(slot, valueAt(*column, row));
+            }
+            out[row] = interpreter_.evaluate(expr);
+        });
+        return pack(std::move(out));
+    }
+
+    auto Evaluator::applyRowWise(const Token::Token& op, const Column& left,
+                                 const Column& right) const -> ColumnPtr {
+        Boxed out(rows());
+        forEachSelected([&](std::size_t row) {
+            out[row] =
+                Operators::apply(op, valueAt(left, row), valueAt(right, row));
+        });
+        return pack(std::move(out));
+    }
+
+    auto Evaluator::pack(Boxed values) const -> ColumnPtr {
+        if (selectedRows() == 0) {
+            return scalar({});
+        }
+        auto first = selection_ != nullptr ? (*selection_)[0] : 0;
+        auto index = values[first].value.index();
+        bool same  = true;
+        forEachSelected([&](std::size_t row) {
+            same = same && values[row].value.index() == index;
+        });
+        if (!same || values[first].isNil()) {
+            return share(std::move(values));
+        }
+
+        if (values[first].isNumber()) {
+            Numbers out(rows());
+            forEachSelected(
+                [&](std::size_t row) { out[row] = values[row].asNumber(); });
+            return share(std::move(out));
+        }
+        if (values[first].isBool()) {
+            Bitmap out{std::vector<std::uint64_t>(words(rows()))};
+            forEachSelected([&](std::size_t row) {
+                if (values[row].asBool()) {
+                    out.words[row / 64] |= std::uint64_t{1} << (row % 64);
+                }
+            });
+            return share(std::move(out));
+        }
+
+        auto dictionary = std::make_shared<std::vector<Runtime::String>>();
+        std::unordered_map<std::string, std::uint32_t> codes;
+        Strings                                        out;
+        out.codes.resize(rows());
+        forEachSelected([&](std::size_t row) {
+            const auto& text = values[row].asString();
+            auto [found, inserted] = codes.try_emplace(
+                std::string(text.view()),
+                static_cast<std::uint32_t>(dictionary->size()));
+            if (inserted) {
+                dictionary->push_back(text);
+            }
+            out.codes[row] = found->second;
+        });
+        if (dictionary->empty()) {
+            dictionary->emplace_back("");
+        }
+        out.dictionary = std::move(dictionary);
+        return share(std::move(out));
+    }
+}  // namespace Columnar
@@ -0,0 +1,33 @@
+#include "Thor/Context.hpp"
+
+#include <utility>
+
+namespace Runtime {
+
+    Context::Context()
+        : ownedLogger_(std::make_unique<Logger::Logger>()),
+          ownedOutput_(std::make_unique<Output::Writer>()),
+          logger_(*ownedLogger_),
+          output_(*ownedOutput_) {
+        // Synchronous, so lines reach `diagnostics_` on the context's own
+        // thread and no backend thread is started.
+        logger_.setMode(Logger::Mode::SYNC);
+        logger_.setLevel(Logger::LogLevel::WARN);
+        logger_.setSink([this](std::string_view lines) {
+            diagnostics_.append(lines);
+        });
+    }
+
+    Context::Context(Logger::Logger& logger, Output::Writer& output)
+        : logger_(logger), output_(output) {}
+
+    auto Context::standard() -> Context& {
+        static Context context(Logger::Logger::instance(),
+                               Output::Writer::standard());
+        return context;
+    }
+
+    auto Context::takeDiagnostics() -> std::string {
+        return std::exchange(diagnostics_, {});
+    }
+}  // namespace Runtime
@@ -0,0 +1,238 @@
+#include "Thor/Dispatch.hpp"
+
+#include "Thor/HashMap.hpp"
+#include "Thor/Operators.hpp"
+#include "Thor/TokenType.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+namespace Stmt {
+
+    namespace {
+
+        // Integers a jump table covers at most, and how much wider than
+        // the labels it may be.
+        constexpr double TABLE_SPAN   = 65536;
+        constexpr double TABLE_SPREAD = 4;
+
+        // Seeds tried for a bucket before the perfect hash's slots double.
+        constexpr std::uint32_t SEEDS = 4096;
+
+        // The value of a number label: a literal, or one negated.
+        auto numberOf(const Expr::Expr& label) -> std::optional<double> {
+            if (label->is<Expr::LiteralExpr>()) {
+                const auto& literal = label->as<Expr::LiteralExpr>().literal;
+                if (literal.is<double>()) {
+                    return literal.as<double>();
+                }
+            }
+            if (label->is<Expr::PrefixExpr>()) {
+                const auto& prefix = label->as<Expr::PrefixExpr>();
+                if (prefix.operator_.type == Token::Type::MINUS) {
+                    if (auto value = numberOf(prefix.right)) {
+                        return -*value;
+                    }
+                }
+            }
+            return std::nullopt;
+        }
+
+        auto powerOfTwo(std::size_t atLeast) -> std::size_t {
+            std::size_t size = 1;
+            while (size < atLeast) {
+                size *= 2;
+            }
+            return size;
+        }
+    }  // namespace
+
+    auto Dispatch::constant(const Token::Literal& subject) const
+        -> std::uint32_t {
+        if (subject.is<double>()) {
+            return number(subject.as<double>());
+        }
+        if (subject.is<Runtime::String>() && !strings_.empty()) {
+            return string(subject.as<Runtime::String>().view());
+        }
+        return NONE;
+    }
+
+    auto Dispatch::equal(const Token::Literal& left,
+                         const Token::Literal& right) -> bool {
+        return Operators::isEqual(left, right);
+    }
+
+    void Dispatch::add(const Expr::Expr& label, std::uint32_t index) {
+        if (auto value = numberOf(label)) {
+            sorted_.emplace_back(*value, index);
+            return;
+        }
+        if (label->is<Expr::LiteralExpr>()) {
+            const auto& literal = label->as<Expr::LiteralExpr>().literal;
+            if (literal.is<Runtime::String>()) {
+                strings_.push_back(
+                    {Runtime::Symbol::intern(
+                         literal.as<Runtime::String>().view()),
+                     label, index});
+                return;
+            }
+        }
+        dynamic_.push_back({label, index});
+    }
+
+    void Dispatch::build(std::uint32_t cases) {
+        std::sort(sorted_.begin(), sorted_.end());
+        sorted_.erase(std::unique(sorted_.begin(), sorted_.end(),
+                                  [](const auto& left, const auto& right) {
+                                      return left.first == right.first;
+                                  }),
+                      sorted_.end());
+        if (!sorted_.empty()) {
+            auto low   = sorted_.front().first;
+            auto span  = sorted_.back().first - low + 1;
+            auto dense = span <= TABLE_SPAN &&
+                         span <= TABLE_SPREAD *
+                                         static_cast<double>(sorted_.size()) +
+                                     8 &&
+                         std::all_of(sorted_.begin(), sorted_.end(),
+                                     [](const auto& entry) {
+                                         return std::floor(entry.first) ==
+                                                entry.first;
+                                     });
+            numbers_ = dense ? Numbers::TABLE : Numbers::SEARCH;
+            if (dense) {
+                low_ = low;
+                table_.assign(static_cast<std::size_t>(span), NONE);
+                for (const auto& [value, index] : sorted_) {
+                    table_[static_cast<std::size_t>(value - low)] = index;
+                }
+                sorted_.clear();
+            }
+        }
+
+        hashStrings();
+
+        before_.assign(cases, 0);
+        for (std::uint32_t index = 0; index < cases; ++index) {
+            before_[index] = static_cast<std::uint32_t>(std::count_if(
+                dynamic_.begin(), dynamic_.end(),
+                [index](const Label& label) { return label.index < index; }));
+        }
+    }
+
+    auto Dispatch::bucket(std::size_t hash) const -> std::size_t {
+        return (Runtime::mix(hash) >> 32) & (seeds_.size() - 1);
+    }
+
+    auto Dispatch::slot(std::size_t hash, std::uint32_t seed) const
+        -> std::size_t {
+        return Runtime::mix(hash ^ (seed * 0x9e3779b97f4a7c15ULL)) &
+               (slots_.size() - 1);
+    }
+
+    // Hash and displace: labels go to buckets by one hash, the fullest
+    // bucket first, and each bucket takes the first seed that puts all
+    // of its labels in slots still free. No seed separates two labels of
+    // the same hash; should that ever happen, the strings are compared in
+    // order instead, as labels that are not constants.
+    void Dispatch::hashStrings() {
+        std::stable_sort(strings_.begin(), strings_.end(),
+                         [](const String& left, const String& right) {
+                             return left.symbol.id() < right.symbol.id();
+                         });
+        strings_.erase(std::unique(strings_.begin(), strings_.end(),
+                                   [](const String& left, const String& right) {
+                                       return left.symbol == right.symbol;
+                                   }),
+                       strings_.end());
+        if (strings_.empty()) {
+            return;
+        }
+
+        seeds_.assign(powerOfTwo((strings_.size() + 1) / 2), 0);
+        std::vector<std::vector<std::uint32_t>> buckets(seeds_.size());
+        for (std::uint32_t i = 0; i < strings_.size(); ++i) {
+            buckets[bucket(strings_[i].symbol.hash())].push_back(i);
+        }
+        std::vector<std::size_t> order(buckets.size());
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&buckets](std::size_t left, std::size_t right) {
+                             return buckets[left].size() >
+                                    buckets[right].size();
+                         });
+
+        for (auto size = powerOfTwo(strings_.size() * 2);; size *= 2) {
+            slots_.assign(size, NONE);
+            auto placed = std::all_of(
+                order.begin(), order.end(), [&](std::size_t which) {
+                    const auto& members = buckets[which];
+                    for (std::uint32_t seed = 0; seed < SEEDS; ++seed) {
+                        std::vector<std::size_t> taken;
+                        for (auto member : members) {
+                            auto at =
+                                slot(strings_[member].symbol.hash(), seed);
+                            if (slots_[at] != NONE ||
+                                std::find(taken.begin(), taken.end(), at) !=
+                                    taken.end()) {
+                                break;
+                            }
+                            taken.push_back(at);
+                        }
+                        if (taken.size() == members.size()) {
+                            for (std::size_t i = 0; i < taken.size(); ++i) {
+                                slots_[taken[i]] = members[i];
+                            }
+                            seeds_[which] = seed;
+                            return true;
+                        }
+                    }
+                    return false;
+                });
+            if (placed) {
+                return;
+            }
+            if (size > strings_.size() * 64) {
+                for (const auto& each : strings_) {
+                    dynamic_.push_back({each.label, each.index});
+                }
+                std::stable_sort(dynamic_.begin(), dynamic_.end(),
+                                 [](const Label& left, const Label& right) {
+                                     return left.index < right.index;
+                                 });
+                strings_.clear();
+                seeds_.clear();
+                slots_.clear();
+                return;
+            }
+        }
+    }
+
+    auto Dispatch::number(double value) const -> std::uint32_t {
+        if (numbers_ == Numbers::TABLE) {
+            auto offset = value - low_;
+            if (!(offset >= 0 && offset < static_cast<double>(table_.size()))) {
+                return NONE;
+            }
+            auto at = static_cast<std::size_t>(offset);
+            return static_cast<double>(at) == offset ? table_[at] : NONE;
+        }
+        auto found = std::lower_bound(
+            sorted_.begin(), sorted_.end(), value,
+            [](const auto& entry, double key) { return entry.first < key; });
+        return found != sorted_.end() && found->first == value ? found->second
+                                                               : NONE;
+    }
+
+    auto Dispatch::string(std::string_view text) const -> std::uint32_t {
+        auto hash  = Runtime::TextHash{}(text);
+        auto found = slots_[slot(hash, seeds_[bucket(hash)])];
+        return found != NONE && strings_[found].symbol.text() == text
+                   ? strings_[found].index
+                   : NONE;
+    }
+}  // namespace Stmt
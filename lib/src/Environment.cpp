@@ -0,0 +1,60 @@
+#include "Thor/Environment.hpp"
+
+#include <memory>
+#include <utility>
+
+namespace Interpreter {
+
+    auto Globals::slotFor(std::string_view name) -> std::uint32_t {
+        auto [found, inserted] = slots_.tryEmplace(
+            std::string(name), static_cast<std::uint32_t>(names_.size()));
+        if (inserted) {
+            names_.emplace_back(name);
+        }
+        return *found;
+    }
+
+    auto Globals::find(std::string_view name) const
+        -> std::optional<std::uint32_t> {
+        const auto* found = slots_.find(name);
+        if (found == nullptr) {
+            return std::nullopt;
+        }
+        return *found;
+    }
+
+    Environment::Environment(Runtime::Arena&       arena,
+                             const Token::Literal* initial, std::size_t count)
+        : size_(count), inArena_(true) {
+        values_ = static_cast<Token::Literal*>(arena.allocate(
+            count * sizeof(Token::Literal), alignof(Token::Literal)));
+        std::uninitialized_copy_n(initial, count, values_);
+    }
+
+    Environment::~Environment() {
+        destroyArenaValues();
+    }
+
+    void Environment::define(std::uint32_t slot, Token::Literal value) {
+        if (slot >= size_) {
+            // Only a heap environment grows; arena slots move over first.
+            heap_.reserve(slot + 1);
+            if (inArena_) {
+                heap_.assign(std::make_move_iterator(values_),
+                             std::make_move_iterator(values_ + size_));
+                destroyArenaValues();
+            }
+            heap_.resize(slot + 1);
+            values_ = heap_.data();
+            size_   = heap_.size();
+        }
+        values_[slot] = std::move(value);
+    }
+
+    void Environment::destroyArenaValues() {
+        if (inArena_) {
+            std::destroy_n(values_, size_);
+            inArena_ = false;
+        }
+    }
+}  // namespace Interpreter
@@ -0,0 +1,92 @@
+#include "Thor/Function.hpp"
+
+#include "Thor/Stmt.hpp"
+
+namespace Runtime {
+
+    Cell::Cell(Token::Literal value)
+        : data_(std::make_shared<Data>(std::move(value))) {}
+
+    Function::Record::Record(
+        std::shared_ptr<const Stmt::Definition> definition,
+        std::vector<Token::Literal> captures, bool bound)
+        : Traced(sizeof(Record), !captures.empty()),
+          definition(std::move(definition)),
+          captures(std::move(captures)),
+          bound(bound) {}
+
+    void Function::Record::trace(Tracer& tracer) const {
+        for (const auto& capture : captures) {
+            tracer.visit(capture);
+        }
+    }
+
+    void Function::Record::clear() {
+        captures = {};
+    }
+
+    auto Function::Record::bytes() const -> std::size_t {
+        return sizeof(Record) + captures.capacity() * sizeof(Token::Literal);
+    }
+
+    Function::Function(std::shared_ptr<const Stmt::Definition> definition)
+        : Function(std::move(definition), {}) {}
+
+    Function::Function(std::shared_ptr<const Stmt::Definition> definition,
+                       std::vector<Token::Literal>             captures)
+        : record_(std::make_shared<Record>(std::move(definition),
+                                           std::move(captures), false)) {}
+
+    auto Function::close(std::shared_ptr<const Stmt::Definition> definition,
+                         const Token::Literal*                   locals,
+                         const Function* enclosing) -> Function {
+        const auto& wanted = definition->captures;
+        if (wanted.empty()) {
+            return Function(std::move(definition));
+        }
+        std::vector<Token::Literal> captures;
+        captures.reserve(wanted.size());
+        for (const auto& capture : wanted) {
+            switch (capture.from) {
+                case Stmt::Capture::From::LOCAL:
+                    captures.push_back(locals[capture.index]);
+                    break;
+                case Stmt::Capture::From::CAPTURE:
+                    captures.push_back(enclosing->captures()[capture.index]);
+                    break;
+                case Stmt::Capture::From::SELF:
+                    captures.emplace_back(*enclosing);
+                    break;
+            }
+        }
+        return {std::move(definition), std::move(captures)};
+    }
+
+    auto operator==(const Function& left, const Function& right) -> bool {
+        return left.record_ == right.record_ ||
+               (left.record_->definition == right.record_->definition &&
+                left.record_->captures.empty() &&
+                right.record_->captures.empty());
+    }
+
+    auto Function::bind(Token::Literal receiver) const -> Function {
+        auto captures = record_->captures;
+        captures.push_back(std::move(receiver));
+        auto method    = *this;
+        method.record_ = std::make_shared<Record>(record_->definition,
+                                                  std::move(captures), true);
+        return method;
+    }
+
+    auto Function::receiver() const -> const Token::Literal& {
+        return record_->captures.back();
+    }
+
+    auto Function::name() const -> std::string_view {
+        return record_->definition->name.lexeme;
+    }
+
+    auto Function::arity() const -> std::size_t {
+        return record_->definition->params.size();
+    }
+}  // namespace Runtime
@@ -0,0 +1,318 @@
+#include "Thor/Heap.hpp"
+
+#include "Thor/Tokens.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace Runtime {
+
+    namespace {
+
+        // The tracked part of `value`, if it has one.
+        auto traced(const Token::Literal& value) -> const Traced* {
+            return std::visit(
+                [](const auto& held) -> const Traced* {
+                    using T = std::decay_t<decltype(held)>;
+                    if constexpr (std::is_same_v<T, Array> ||
+                                  std::is_same_v<T, Object> ||
+                                  std::is_same_v<T, Function> ||
+                                  std::is_same_v<T, Cell>) {
+                        return held.traced();
+                    } else {
+                        return nullptr;
+                    }
+                },
+                value.value);
+        }
+
+        // A tracer that hands `visit` the tracked values it is shown.
+        template <typename Visit>
+        class Visitor final : public Tracer {
+          public:
+
+            explicit Visitor(Visit visit) : visit_(std::move(visit)) {}
+
+            void visit(const Token::Literal& value) override {
+                if (const auto* held = traced(value)) {
+                    visit_(held);
+                }
+            }
+
+          private:
+
+            Visit visit_;
+        };
+
+        template <typename Visit>
+        auto visitor(Visit visit) -> Visitor<Visit> {
+            return Visitor<Visit>(std::move(visit));
+        }
+
+        auto bucket(double seconds) -> std::size_t {
+            std::size_t index = 0;
+            for (double limit = 1e-5;
+                 seconds >= limit && index + 1 < Heap::PAUSE_BUCKETS;
+                 limit *= 10) {
+                ++index;
+            }
+            return index;
+        }
+    }  // namespace
+
+    Traced::Traced(std::size_t size, bool track) {
+        if (track) {
+            Heap::current().track(this, size);
+        }
+    }
+
+    Traced::~Traced() {
+        if (heap_ != nullptr) {
+            heap_->untrack(this);
+        }
+    }
+
+    void Heap::List::add(Traced* value) {
+        value->prev_ = nullptr;
+        value->next_ = head;
+        if (head != nullptr) {
+            head->prev_ = value;
+        }
+        head = value;
+        ++count;
+    }
+
+    void Heap::List::remove(Traced* value) {
+        if (value->prev_ != nullptr) {
+            value->prev_->next_ = value->next_;
+        } else {
+            head = value->next_;
+        }
+        if (value->next_ != nullptr) {
+            value->next_->prev_ = value->prev_;
+        }
+        value->prev_ = nullptr;
+        value->next_ = nullptr;
+        --count;
+    }
+
+    Heap::~Heap() {
+        // Values that outlive the thread are no longer collected.
+        for (auto* list : {&young_, &old_}) {
+            for (auto* value = list->head; value != nullptr;) {
+                auto* next   = value->next_;
+                value->heap_ = nullptr;
+                value->prev_ = nullptr;
+                value->next_ = nullptr;
+                value        = next;
+            }
+        }
+    }
+
+    auto Heap::current() -> Heap& {
+        thread_local Heap heap;
+        return heap;
+    }
+
+    void Heap::track(Traced* value, std::size_t size) {
+        const auto& options = heapOptions();
+        if (options.enabled && !collecting_) {
+            made_ += size;
+            if (made_ >= options.nursery) {
+                auto limit = static_cast<double>(
+                                 std::max(oldAfterFull_, options.nursery)) *
+                             options.growth;
+                collect(static_cast<double>(oldBytes_) > limit);
+            }
+        }
+        value->heap_ = this;
+        young_.add(value);
+    }
+
+    void Heap::untrack(Traced* value) {
+        if (value->old_) {
+            old_.remove(value);
+            oldBytes_ -= value->size_;
+        } else {
+            young_.remove(value);
+        }
+        value->heap_ = nullptr;
+    }
+
+    void Heap::collect(bool full) {
+        if (collecting_) {
+            return;
+        }
+        collecting_ = true;
+        auto start  = std::chrono::steady_clock::now();
+
+        std::vector<Traced*> looked;
+        looked.reserve(young_.count + (full ? old_.count : 0));
+        for (auto* value = young_.head; value != nullptr;
+             value       = value->next_) {
+            looked.push_back(value);
+        }
+        for (auto* value = full ? old_.head : nullptr; value != nullptr;
+             value       = value->next_) {
+            looked.push_back(value);
+        }
+
+        // References to each value, less those from values looked at,
+        // are from outside them. One with none yet is still being made.
+        for (auto* value : looked) {
+            auto owners     = value->weak_from_this().use_count();
+            value->outside_ = owners > 0
+                                  ? owners
+                                  : std::numeric_limits<std::int64_t>::max();
+            value->looked_  = true;
+            value->live_    = false;
+        }
+        auto subtract = visitor([](const Traced* held) {
+            if (held->looked_) {
+                --held->outside_;
+            }
+        });
+        for (const auto* value : looked) {
+            value->trace(subtract);
+        }
+
+        // Live: referenced from outside, or reached from one that is.
+        std::vector<const Traced*> work;
+        for (const auto* value : looked) {
+            if (value->outside_ > 0) {
+                value->live_ = true;
+                work.push_back(value);
+            }
+        }
+        auto reach = visitor([&work](const Traced* held) {
+            if (held->looked_ && !held->live_) {
+                held->live_ = true;
+                work.push_back(held);
+            }
+        });
+        while (!work.empty()) {
+            const auto* value = work.back();
+            work.pop_back();
+            value->trace(reach);
+        }
+
+        // Survivors move to old space; the rest are kept until all are
+        // cleared, so none goes while another still holds it.
+        std::vector<std::shared_ptr<Traced>> garbage;
+        std::uint64_t                        promoted = 0;
+        for (auto* value : looked) {
+            value->looked_ = false;
+            if (!value->live_) {
+                garbage.push_back(value->shared_from_this());
+                continue;
+            }
+            auto size = value->bytes();
+            if (value->old_) {
+                oldBytes_ = oldBytes_ - value->size_ + size;
+            } else {
+                young_.remove(value);
+                old_.add(value);
+                value->old_ = true;
+                oldBytes_ += size;
+                promoted += size;
+            }
+            value->size_ = size;
+        }
+        looked.clear();
+
+        std::uint64_t freedBytes = 0;
+        for (const auto& value : garbage) {
+            freedBytes += value->bytes();
+            value->clear();
+        }
+        stats_.freed += garbage.size();
+        garbage.clear();
+
+        made_ = 0;
+        if (full) {
+            ++stats_.full;
+            oldAfterFull_ = oldBytes_;
+        } else {
+            ++stats_.young;
+        }
+        stats_.promoted += promoted;
+        stats_.freedBytes += freedBytes;
+        auto seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+        stats_.pauseSeconds += seconds;
+        stats_.longestPause = std::max(stats_.longestPause, seconds);
+        ++stats_.pauses[bucket(seconds)];
+        collecting_ = false;
+    }
+
+    auto Heap::stats() const -> Stats {
+        auto stats        = stats_;
+        stats.youngValues = young_.count;
+        stats.oldValues   = old_.count;
+        stats.oldBytes    = oldBytes_;
+        return stats;
+    }
+
+    auto parseHeapOptions(std::string_view text)
+        -> std::optional<Heap::Options> {
+        auto parsed = heapOptions();
+        if (text == "off") {
+            parsed.enabled = false;
+            return parsed;
+        }
+        auto comma = text.find(',');
+        if (comma == std::string_view::npos) {
+            return std::nullopt;
+        }
+        std::size_t kib    = 0;
+        double      growth = 0;
+        auto        size   = text.substr(0, comma);
+        auto        rest   = text.substr(comma + 1);
+        auto [sizeEnd, sizeError] =
+            std::from_chars(size.data(), size.data() + size.size(), kib);
+        auto [restEnd, restError] =
+            std::from_chars(rest.data(), rest.data() + rest.size(), growth);
+        if (sizeError != std::errc() || sizeEnd != size.data() + size.size() ||
+            restError != std::errc() || restEnd != rest.data() + rest.size() ||
+            kib == 0 || !(growth > 1.0)) {
+            return std::nullopt;
+        }
+        parsed.enabled = true;
+        parsed.nursery = kib * 1024;
+        parsed.growth  = growth;
+        return parsed;
+    }
+
+    auto format(const Heap::Stats& stats) -> std::string {
+        auto kib  = [](std::uint64_t bytes) {
+            return static_cast<double>(bytes) / 1024.0;
+        };
+        auto text = fmt::format(
+            "{:>8} {:>8} {:>12} {:>12} {:>14} {:>10} {:>10}\n", "young",
+            "full", "promoted KiB", "freed values", "freed KiB", "pause ms",
+            "longest ms");
+        text += fmt::format(
+            "{:>8} {:>8} {:>12.1f} {:>12} {:>14.1f} {:>10.3f} {:>10.3f}\n",
+            stats.young, stats.full, kib(stats.promoted), stats.freed,
+            kib(stats.freedBytes), stats.pauseSeconds * 1e3,
+            stats.longestPause * 1e3);
+        text += fmt::format("{:>10} {:>10} {:>12}\n", "young now",
+                            "old now", "old KiB");
+        text += fmt::format("{:>10} {:>10} {:>12.1f}\n", stats.youngValues,
+                            stats.oldValues, kib(stats.oldBytes));
+        text += fmt::format("{:>8} {:>8} {:>8} {:>8} {:>8} {:>8}\n", "<10us",
+                            "<100us", "<1ms", "<10ms", "<100ms", "longer");
+        for (auto count : stats.pauses) {
+            text += fmt::format("{:>8} ", count);
+        }
+        text.back() = '\n';
+        return text;
+    }
+}  // namespace Runtime
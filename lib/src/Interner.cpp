@@ -0,0 +1,12 @@
+#include "Thor/Interner.hpp"
+
+namespace Runtime {
+
+    auto Interner::intern(std::string_view text) -> const String& {
+        auto found = strings_.find(text);
+        if (found != strings_.end()) {
+            return found->second;
+        }
+        return strings_.emplace(keys_.copy(text), String(text)).first->second;
+    }
+}  // namespace Runtime
@@ -1,276 +1,268 @@
 #include "Thor/Interpreter.hpp"
 
 #include "Thor/Exceptions.hpp"
+#include "Thor/Jit.hpp"
+#include "Thor/Operators.hpp"
+#include "Thor/Trace.hpp"
 
-namespace Interpreter {
-
-    void Interpreter::interpret(
-        const std::vector<Stmt::Stmt>& statments) const {
-        try {
-            for (const auto& stmt : statments) {
-                execute(stmt);
-            }
-        } catch (Error::RuntimeException& e) {
-            logger_.error(e.what());
-        }
-    }
-
-    void Interpreter::execute(const Stmt::Stmt& stmt) const {
-        stmt->accept(*this);
-    }
-
-    auto Interpreter::evaluate(const Expr::Expr& expr) const -> Token::Literal {
-        if (expr == nullptr) {
-            logger_.error("Interpreter : Expr type is null");
-            return {};
-        }
-        return expr->accept(*this);
-    }
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <exception>
+#include <optional>
 
-    auto Interpreter::isTruthy(Token::Literal literal) -> bool {
-        if (literal.isNil()) {
-            return false;
-        }
-        if (literal.isBool()) {
-            return literal.asBool();
-        }
-        if (literal.isNumber()) {
-            return literal.asNumber() != 0.0;
-        }
-        return !literal.asString().empty();
-    }
-
-    auto Interpreter::isEqual(Token::Literal left, Token::Literal right)
-        -> bool {
-        if (left.isNil() && right.isNil()) {
-            return true;
-        }
-        if (left.isNil() || right.isNil()) {
-            return false;
-        }
-        return left.value == right.value;
-    }
+namespace Interpreter {
 
-    auto Interpreter::visit(const Expr::InfixExpr& expr) const
-        -> Token::Literal {
-        auto left  = evaluate(expr.left);
-        auto right = evaluate(expr.right);
+    namespace {
 
-        switch (expr.operator_.type) {
-            case Token::Type::LOGICAL_OR: {
-                return Token::Literal{isTruthy(left) || isTruthy(right)};
+        // The array `object` is and the slot of element `index` in it.
+        // Throws at `bracket` unless there is one.
+        auto locate(const Token::Literal& object, const Token::Literal& index,
+                    const Token::Token& bracket)
+            -> std::pair<const Runtime::Array*, std::size_t> {
+            const auto* array = std::get_if<Runtime::Array>(&object.value);
+            if (array == nullptr) {
+                throw Error::RuntimeException(
+                    bracket, "Only arrays and objects can be indexed.");
             }
-
-            case Token::Type::LOGICAL_AND: {
-                return Token::Literal{isTruthy(left) && isTruthy(right)};
+            if (!index.isInt()) {
+                throw Error::RuntimeException(bracket,
+                                              "Index must be a whole number.");
             }
-
-            case Token::Type::BIT_OR: {
-                if (!left.isNumber() || !right.isNumber()) {
-                    throw Error::RuntimeException(
-                        expr.operator_, "operator can't work on this type");
-                }
-                int l = left.toInt();
-                int r = right.toInt();
-
-                if (l < 0 || r < 0 || std::floor(l) != l ||
-                    std::floor(r) != r) {
-                    throw Error::RuntimeException(
-                        expr.operator_,
-                        "Operands must be non-negative integers");
-                }
-                return Token::Literal{static_cast<double>(l | r)};
+            auto number = index.asNumber();
+            if (number < 0 || number >= static_cast<double>(array->size())) {
+                throw Error::RuntimeException(bracket, "Index out of range.");
             }
+            return {array, static_cast<std::size_t>(number)};
+        }
 
-            case Token::Type::BIT_XOR: {
-                if (!left.isNumber() || !right.isNumber()) {
-                    throw Error::RuntimeException(
-                        expr.operator_, "operator can't work on this type");
-                }
-                int l = left.toInt();
-                int r = right.toInt();
-
-                if (l < 0 || r < 0 || std::floor(l) != l ||
-                    std::floor(r) != r) {
-                    throw Error::RuntimeException(
-                        expr.operator_,
-                        "Operands must be non-negative integers");
-                }
-                return Token::Literal{static_cast<double>(l ^ r)};
+        // The name `index` is, to look up in an object.
+        auto key(const Token::Literal& index, const Token::Token& bracket)
+            -> std::string_view {
+            if (!index.isString()) {
+                throw Error::RuntimeException(bracket,
+                                              "Object keys must be strings.");
             }
+            return index.asString().view();
+        }
 
-            case Token::Type::BIT_AND: {
-                if (!left.isNumber() || !right.isNumber()) {
-                    throw Error::RuntimeException(
-                        expr.operator_, "operator can't work on this type");
+        // Where `name` is in `instance`, as `Interpreter::property` finds
+        // it; both null if nowhere. Remembered in `cache` unless it is
+        // null, as for a key worked out at run time.
+        auto member(const Runtime::Object& instance, std::string_view name,
+                    const Runtime::InlineCache* cache)
+            -> Interpreter::Property {
+            const auto& shape = instance.shape();
+            if (auto* dictionary = instance.dictionary()) {
+                auto symbol = cache != nullptr
+                                  ? std::optional(cache->key(name))
+                                  : Runtime::Symbol::find(name);
+                if (symbol) {
+                    if (auto* field = dictionary->find(*symbol)) {
+                        return {field, nullptr};
+                    }
                 }
-                int l = left.toInt();
-                int r = right.toInt();
-
-                if (l < 0 || r < 0 || std::floor(l) != l ||
-                    std::floor(r) != r) {
-                    throw Error::RuntimeException(
-                        expr.operator_,
-                        "Operands must be non-negative integers");
+            } else if (auto slot = shape.find(name);
+                       slot != Runtime::Shape::NONE) {
+                if (cache != nullptr) {
+                    cache->add(shape,
+                               {Runtime::InlineCache::Kind::FIELD, slot});
                 }
-                return Token::Literal(static_cast<double>(l & r));
+                return {&instance.fields()[slot], nullptr};
             }
-
-            case Token::Type::EQUAL_EQUAL:
-                return Token::Literal{isEqual(left, right)};
-
-            case Token::Type::BANG_EQUAL:
-                return Token::Literal{!isEqual(left, right)};
-
-            case Token::Type::GREATER: {
-                if (left.isNumber() && right.isNumber()) {
-                    return Token::Literal(left.asNumber() > right.asNumber());
-                }
-
-                if (left.isString() && right.isString()) {
-                    return Token::Literal(left.asString() > right.asString());
+            if (const auto* klass = instance.klass()) {
+                auto index = klass->find(name);
+                if (index != Runtime::Class::NONE) {
+                    // Not for a dictionary: its shape is every one's.
+                    if (cache != nullptr && instance.dictionary() == nullptr) {
+                        cache->add(shape,
+                                   {Runtime::InlineCache::Kind::METHOD, index});
+                    }
+                    return {nullptr, &klass->method(index)};
                 }
-                throw Error::RuntimeException(
-                    expr.operator_, "operator can't work on this type");
             }
+            return {nullptr, nullptr};
+        }
 
-            case Token::Type::GREATER_EQUAL: {
-                if (left.isNumber() && right.isNumber()) {
-                    return Token::Literal(left.asNumber() >= right.asNumber());
-                }
-
-                if (left.isString() && right.isString()) {
-                    return Token::Literal(left.asString() >= right.asString());
-                }
-                throw Error::RuntimeException(
-                    expr.operator_, "operator can't work on this type");
+        // Sets, or adds, the field `name` of `instance`, as `member` finds
+        // it. A field past MAX_FIELDS makes the object a dictionary.
+        void store(const Runtime::Object& instance, std::string_view name,
+                   Token::Literal value, const Runtime::InlineCache* cache) {
+            auto symbol = [&] {
+                return cache != nullptr ? cache->key(name)
+                                        : Runtime::Symbol::intern(name);
+            };
+            if (auto* dictionary = instance.dictionary()) {
+                dictionary->insertOrAssign(symbol(), std::move(value));
+                return;
             }
-            case Token::Type::LESS: {
-                if (left.isNumber() && right.isNumber()) {
-                    return Token::Literal(left.asNumber() < right.asNumber());
+            const auto& shape = instance.shape();
+            const auto* entry = cache != nullptr ? cache->find(shape) : nullptr;
+            if (entry == nullptr) {
+                if (cache != nullptr) {
+                    Runtime::InlineCache::miss();
                 }
-
-                if (left.isString() && right.isString()) {
-                    return Token::Literal(left.asString() < right.asString());
+                auto slot = shape.find(name);
+                if (slot != Runtime::Shape::NONE) {
+                    if (cache != nullptr) {
+                        cache->add(shape,
+                                   {Runtime::InlineCache::Kind::FIELD, slot});
+                    }
+                    instance.fields()[slot] = std::move(value);
+                } else if (shape.size() >= Runtime::Object::MAX_FIELDS) {
+                    instance.makeDictionary();
+                    instance.dictionary()->insertOrAssign(symbol(),
+                                                          std::move(value));
+                } else {
+                    auto next = shape.with(std::string(name));
+                    if (cache != nullptr) {
+                        cache->add(shape,
+                                   {Runtime::InlineCache::Kind::ADD, 0, next});
+                    }
+                    instance.reshape(std::move(next), std::move(value));
                 }
-                throw Error::RuntimeException(
-                    expr.operator_, "operator can't work on this type");
+            } else if (entry->kind == Runtime::InlineCache::Kind::FIELD) {
+                instance.fields()[entry->index] = std::move(value);
+            } else {
+                instance.reshape(entry->next, std::move(value));
             }
-            case Token::Type::LESS_EQUAL: {
-                if (left.isNumber() && right.isNumber()) {
-                    return Token::Literal(left.asNumber() <= right.asNumber());
-                }
+        }
+    }  // namespace
 
-                if (left.isString() && right.isString()) {
-                    return Token::Literal(left.asString() <= right.asString());
-                }
-                throw Error::RuntimeException(
-                    expr.operator_, "operator can't work on this type");
-            }
-            case Token::Type::LEFT_SHIFT: {
-                if (!left.isNumber() || !right.isNumber()) {
-                    throw Error::RuntimeException(
-                        expr.operator_, "operator can't work on this type");
-                }
-                int l = left.toInt();
-                int r = right.toInt();
+    void Interpreter::interpret(
+        const std::vector<Stmt::Stmt>& statments) const {
+        if (engine() != Engine::TREE) {
+            Trace::emit(Trace::Event::ENGINE_COMPILE,
+                        static_cast<std::uint32_t>(statments.size()),
+                        static_cast<std::uint64_t>(engine()));
+        }
+        if (engine() == Engine::CLOSURE) {
+            interpret(Closure::compile(statments));
+            return;
+        }
+        if (engine() == Engine::TIERED) {
+            Tiering::Plan plan(statments);
+            interpret(plan);
+            return;
+        }
+        if (engine() == Engine::VM) {
+            interpret(Vm::Program::compile(statments));
+            return;
+        }
+        walk(statments);
+    }
 
-                if (l < 0 || r < 0 || std::floor(l) != l ||
-                    std::floor(r) != r) {
-                    throw Error::RuntimeException(
-                        expr.operator_,
-                        "Operands must be non-negative integers");
-                }
-                return Token::Literal(static_cast<double>(l << r));
-            }
-            case Token::Type::RIGHT_SHIFT: {
-                if (!left.isNumber() || !right.isNumber()) {
-                    throw Error::RuntimeException(
-                        expr.operator_, "operator can't work on this type");
-                }
-                int l = left.toInt();
-                int r = right.toInt();
+    void Interpreter::walk(const std::vector<Stmt::Stmt>& statements) const {
+        run(static_cast<std::uint32_t>(statements.size()),
+            [&](std::uint32_t index) { execute(statements[index]); });
+    }
 
-                if (l < 0 || r < 0 || std::floor(l) != l ||
-                    std::floor(r) != r) {
-                    throw Error::RuntimeException(
-                        expr.operator_,
-                        "Operands must be non-negative integers");
-                }
-                return Token::Literal(static_cast<double>(l >> r));
-            }
-            case Token::Type::MINUS:
+    void Interpreter::interpret(const Closure::Program& program) const {
+        auto frame = this->frame();
+        run(static_cast<std::uint32_t>(program.size()),
+            [&](std::uint32_t index) { program[index](frame); });
+    }
 
-                if (!left.isNumber() || !right.isNumber()) {
-                    throw Error::RuntimeException(
-                        expr.operator_, "operator can't work on this type");
-                }
-                return Token::Literal(left.asNumber() - right.asNumber());
-            case Token::Type::PLUS:
+    void Interpreter::interpret(Tiering::Plan& plan) const {
+        loops_     = &plan;
+        auto frame = this->frame();
+        run(plan.size(), [&](std::uint32_t index) {
+            auto entry = plan.enter(index, environment_);
+            if (entry.code != nullptr) {
+                (*entry.code)(frame);
+            } else {
+                execute(plan.statement(index));
+            }
+            plan.leave(entry);
+        });
+        loops_ = nullptr;
+    }
 
-                if (left.isNumber() && right.isNumber()) {
-                    return Token::Literal(left.asNumber() + right.asNumber());
-                }
+    void Interpreter::interpret(const Vm::Program& program) const {
+        auto frame = this->frame();
+        frame.base = stack_.push(program.registers(), Token::Token{});
+        run(program.size(),
+            [&](std::uint32_t index) { program.run(index, frame); });
+        stack_.pop(frame.base);
+    }
 
-                if (left.isString() && right.isString()) {
-                    return Token::Literal(left.asString() + right.asString());
-                }
+    template <typename Fn>
+    void Interpreter::run(std::uint32_t count, Fn&& statement) const {
+        Trace::emit(Trace::Event::INTERPRET_BEGIN, count);
+        std::uint32_t index = 0;
+        flow_               = Stmt::Flow::NORMAL;
+        auto top            = stack_.top();
+        auto base           = base_;
+        const auto* callee  = callee_;
+        stack_.anchor();
+        try {
+            for (; index < count; ++index) {
+                Trace::emit(Trace::Event::STATEMENT_BEGIN, index);
+                statement(index);
+                Trace::emit(Trace::Event::STATEMENT_END, index);
+            }
+        } catch (Error::RuntimeException& e) {
+            // The calls the error unwound never dropped their frames.
+            stack_.pop(top);
+            base_   = base;
+            callee_ = callee;
+            flow_   = Stmt::Flow::NORMAL;
+            Trace::emitText(Trace::Event::RUNTIME_ERROR, e.what());
+            Trace::emit(Trace::Event::STATEMENT_END, index);
+            output_.flush();
+            logger_.error("{}", e.what());
+        }
+        Trace::emit(Trace::Event::INTERPRET_END);
+    }
 
-                if (left.isString() || right.isString()) {
-                    return Token::Literal(left.stringify() + right.stringify());
-                }
-                throw Error::RuntimeException(
-                    expr.operator_, "operator can't work on these types");
-            case Token::Type::SLASH:
-                if (!left.isNumber() || !right.isNumber()) {
-                    throw Error::RuntimeException(
-                        expr.operator_, "operator can't work on this type");
-                }
-                return Token::Literal(left.asNumber() / right.asNumber());
-            case Token::Type::STAR:
+    void Interpreter::execute(const Stmt::Stmt& stmt) const {
+        stmt->accept(*this);
+    }
 
-                if (!left.isNumber() || !right.isNumber()) {
-                    throw Error::RuntimeException(
-                        expr.operator_, "operator can't work on this type");
-                }
-                return Token::Literal(left.asNumber() * right.asNumber());
-            case Token::Type::PERCENT:
-                if (!left.isNumber() || !right.isNumber()) {
-                    throw Error::RuntimeException(
-                        expr.operator_, "operator can't work on this type");
-                }
-                return Token::Literal(static_cast<int>(left.asNumber()) %
-                                      static_cast<int>(right.asNumber()));
+    auto Interpreter::evaluate(const Expr::Expr& expr) const -> Token::Literal {
+        if (expr == nullptr) {
+            logger_.error("Interpreter : Expr type is null");
+            return {};
+        }
+        if (Jit::mode() != Jit::Mode::OFF && !expr->jitSite().rejected()) {
+            if (auto value = expr->jitSite().run(*expr, environment_)) {
+                return std::move(*value);
+            }
+        }
+        return expr->accept(*this);
+    }
 
-            case Token::Type::STAR_STAR:
-                if (!left.isNumber() || !right.isNumber()) {
-                    throw Error::RuntimeException(
-                        expr.operator_, "operator can't work on this type");
-                }
-                return Token::Literal{pow(left.asNumber(), right.asNumber())};
-            default:
-                return {};
+    auto Interpreter::visit(const Expr::InfixExpr& expr) const
+        -> Token::Literal {
+        auto left  = evaluate(expr.left);
+        auto right = evaluate(expr.right);
+        if (!expr.op) {
+            return {};
         }
-        return {};
+        return Operators::apply(*expr.op, left, right, expr.operator_);
     }
 
     auto Interpreter::visit(const Expr::PrefixExpr& expr) const
         -> Token::Literal {
-        auto value = evaluate(expr.right);
-        switch (expr.operator_.type) {
+        return prefix(expr.operator_, evaluate(expr.right));
+    }
+
+    auto Interpreter::prefix(const Token::Token& op, Token::Literal value)
+        -> Token::Literal {
+        switch (op.type) {
             case Token::Type::MINUS:
 
                 if (value.isNumber()) {
                     value.setValue(-value.asNumber());
                 } else {
                     throw Error::RuntimeException(
-                        expr.operator_, "operator can't work on this type");
+                        op, "operator can't work on this type");
                 }
                 break;
             case Token::Type::PLUS:
                 if (!value.isNumber()) {
                     throw Error::RuntimeException(
-                        expr.operator_, "operator can't work on this type");
+                        op, "operator can't work on this type");
                 }
                 break;
             case Token::Type::PLUS_PLUS:
@@ -278,20 +270,20 @@ namespace Interpreter {
                     value.setValue(value.asNumber() + 1);
                 } else {
                     throw Error::RuntimeException(
-                        expr.operator_, "operator can't work on this type");
+                        op, "operator can't work on this type");
                 }
             case Token::Type::MINUS_MINUS:
                 if (value.isNumber()) {
                     value.setValue(value.asNumber() - 1);
                 } else {
                     throw Error::RuntimeException(
-                        expr.operator_, "operator can't work on this type");
+                        op, "operator can't work on this type");
                 }
             case Token::Type::BANG:
-                return Token::Literal(!isTruthy(value));
+                return Token::Literal(!Operators::isTruthy(value));
             default:
                 throw Error::RuntimeException(
-                    expr.operator_, "Interpreter: operator is not valid");
+                    op, "Interpreter: operator is not valid");
         }
         return value;
     }
@@ -319,12 +311,54 @@ namespace Interpreter {
     auto Interpreter::visit(const Expr::TernaryExpr& expr) const
         -> Token::Literal {
         auto condition = evaluate(expr.condition);
-        if (isTruthy(condition)) {
+        if (Operators::isTruthy(condition)) {
             return evaluate(expr.trueExpr);
         }
         return evaluate(expr.falseExpr);
     }
 
+    auto Interpreter::visit(const Expr::TemplateExpr& expr) const
+        -> Token::Literal {
+        // Hole values are kept on the stack for the common case so that the
+        // result buffer is the only allocation.
+        constexpr std::size_t INLINE_HOLES = 8;
+
+        std::array<Token::Literal, INLINE_HOLES> inlineValues;
+        std::vector<Token::Literal>              heapValues;
+        Token::Literal*                          values = inlineValues.data();
+        if (expr.holes.size() > INLINE_HOLES) {
+            heapValues.resize(expr.holes.size());
+            values = heapValues.data();
+        }
+
+        for (std::size_t i = 0; i < expr.holes.size(); ++i) {
+            values[i] = evaluate(expr.holes[i]);
+        }
+        return render(expr, values);
+    }
+
+    auto Interpreter::render(const Expr::TemplateExpr& expr,
+                             const Token::Literal*     values)
+        -> Token::Literal {
+        auto capacity = expr.literalSize;
+        for (std::size_t i = 0; i < expr.holes.size(); ++i) {
+            capacity += Token::formattedSizeBound(values[i]);
+        }
+
+        Runtime::String::Builder builder(capacity);
+        char*                    out = builder.data();
+        for (std::size_t i = 0; i < expr.holes.size(); ++i) {
+            const auto& segment = expr.segments[i];
+            std::memcpy(out, segment.data(), segment.size());
+            out = Token::formatTo(out + segment.size(), values[i]);
+        }
+        const auto& last = expr.segments.back();
+        std::memcpy(out, last.data(), last.size());
+        out += last.size();
+
+        return Token::Literal{builder.finish(out - builder.data())};
+    }
+
     auto Interpreter::visit(const Expr::GroupExpr& expr) const
         -> Token::Literal {
         return evaluate(expr.expr);
@@ -337,41 +371,670 @@ namespace Interpreter {
 
     auto Interpreter::visit(const Expr::Variable& expr) const
         -> Token::Literal {
-        return expr.literal;
+        if (expr.slot == Expr::Variable::UNRESOLVED) {
+            return expr.literal;
+        }
+        switch (expr.storage) {
+            case Expr::Storage::GLOBAL:
+                break;
+            case Expr::Storage::LOCAL:
+                return stack_[base_ + expr.slot];
+            case Expr::Storage::CELL:
+                return stack_[base_ + expr.slot].as<Runtime::Cell>().get();
+            case Expr::Storage::CAPTURE:
+                return callee_->captures()[expr.slot];
+            case Expr::Storage::CAPTURED_CELL:
+                return callee_->captures()[expr.slot]
+                    .as<Runtime::Cell>()
+                    .get();
+            case Expr::Storage::SELF:
+                return Token::Literal{*callee_};
+        }
+        return environment_.get(expr.slot);
+    }
+
+    auto Interpreter::visit(const Expr::GetExpr& expr) const -> Token::Literal {
+        return get(evaluate(expr.object), expr.name, expr.cache);
+    }
+
+    auto Interpreter::visit(const Expr::SetExpr& expr) const -> Token::Literal {
+        auto object = evaluate(expr.object);
+        auto value  = evaluate(expr.value);
+        if (expr.operator_) {
+            value = Operators::apply(*expr.operator_,
+                                     get(object, expr.name, expr.get), value);
+        }
+        set(object, expr.name, value, expr.set);
+        return value;
+    }
+
+    auto Interpreter::visit(const Expr::ObjectExpr& expr) const
+        -> Token::Literal {
+        Runtime::Object object(expr.shape, nullptr);
+        for (std::size_t i = 0; i < expr.values.size(); ++i) {
+            object.fields()[expr.slots[i]] = evaluate(expr.values[i]);
+        }
+        return Token::Literal{std::move(object)};
+    }
+
+    auto Interpreter::visit(const Expr::SuperExpr& expr) const
+        -> Token::Literal {
+        auto superclass = evaluate(expr.superclass);
+        return Token::Literal{inherited(superclass, expr.method)
+                                  .bind(evaluate(expr.receiver))};
+    }
+
+    auto Interpreter::visit(const Expr::ArrayExpr& expr) const
+        -> Token::Literal {
+        std::vector<Token::Literal> values;
+        values.reserve(expr.values.size());
+        for (const auto& value : expr.values) {
+            values.push_back(evaluate(value));
+        }
+        return Token::Literal{Runtime::Array{std::move(values)}};
+    }
+
+    auto Interpreter::visit(const Expr::IndexExpr& expr) const
+        -> Token::Literal {
+        auto object = evaluate(expr.object);
+        return element(object, evaluate(expr.index), expr.bracket);
+    }
+
+    auto Interpreter::visit(const Expr::IndexSetExpr& expr) const
+        -> Token::Literal {
+        auto object = evaluate(expr.object);
+        auto index  = evaluate(expr.index);
+        auto value  = evaluate(expr.value);
+        if (expr.operator_) {
+            value = Operators::apply(
+                *expr.operator_, element(object, index, expr.bracket), value);
+        }
+        setElement(object, index, value, expr.bracket);
+        return value;
     }
 
     auto Interpreter::visit(const Stmt::Expression& stmt) const -> void {
         auto value = evaluate(stmt.expression);
-        logger_.debug("Expression result: ", value.stringify());
+        logger_.debug("Expression result: {}",
+                      Logger::lazy([&value] { return value.stringify(); }));
     }
 
     auto Interpreter::visit(const Stmt::Variable& stmt) const -> void {
-        auto value = evaluate(stmt.initializer);
+        auto value = stmt.initializer != nullptr ? evaluate(stmt.initializer)
+                                                 : Token::Literal{};
         logger_.debug("Variable Declartion:  {},{}: {}", stmt.name, stmt.type,
-                      value.stringify());
+                      Logger::lazy([&value] { return value.stringify(); }));
+        define(stmt, std::move(value));
+    }
+
+    void Interpreter::define(const Stmt::Variable& variable,
+                             Token::Literal        value) const {
+        if (variable.storage == Expr::Storage::CELL) {
+            stack_[base_ + variable.slot] =
+                Token::Literal{Runtime::Cell{std::move(value)}};
+        } else if (variable.storage == Expr::Storage::LOCAL) {
+            stack_[base_ + variable.slot] = std::move(value);
+        } else {
+            environment_.define(variable.slot, std::move(value));
+        }
     }
 
     auto Interpreter::visit(const Stmt::Print& stmt) const -> void {
         auto value = evaluate(stmt.expression);
-        fmt::print("{}\n", value.stringify());
+        output_.writeLine(value);
     }
 
-    auto Interpreter::validateAndGetInts(const Token::Literal& left,
-                                         const Token::Literal& right,
-                                         const Token::Token&   op)
-        -> std::pair<int, int> {
-        if (!left.isNumber() || !right.isNumber()) {
-            throw Error::RuntimeException(op, "Operands must be numbers.");
+    auto Interpreter::visit(const Expr::AssignExpr& expr) const
+        -> Token::Literal {
+        auto value = evaluate(expr.value);
+        switch (expr.storage) {
+            case Expr::Storage::LOCAL:
+                stack_[base_ + expr.slot] = value;
+                break;
+            case Expr::Storage::CELL:
+                stack_[base_ + expr.slot].as<Runtime::Cell>().get() = value;
+                break;
+            case Expr::Storage::CAPTURED_CELL:
+                callee_->captures()[expr.slot].as<Runtime::Cell>().get() =
+                    value;
+                break;
+            default:
+                environment_.define(expr.slot, value);
+        }
+        return value;
+    }
+
+    auto Interpreter::visit(const Expr::CallExpr& expr) const
+        -> Token::Literal {
+        stack_.guard(expr.paren);
+        auto prepared = prepare(expr);
+        if (!prepared.function) {
+            return std::move(prepared.result);
+        }
+        auto result = call(std::move(*prepared.function), prepared.base);
+        return prepared.constructed.isNil() ? result : prepared.constructed;
+    }
+
+    void Interpreter::expect(const Runtime::Function& function,
+                             std::size_t arguments, const Token::Token& paren) {
+        if (function.arity() != arguments) {
+            throw Error::RuntimeException(
+                paren, fmt::format("Expected {} arguments but got {}.",
+                                   function.arity(), arguments));
+        }
+    }
+
+    void Interpreter::expect(const Runtime::Builtin& builtin,
+                             std::size_t arguments, const Token::Token& paren) {
+        if (builtin.arity != arguments) {
+            throw Error::RuntimeException(
+                paren, fmt::format("Expected {} arguments but got {}.",
+                                   builtin.arity, arguments));
+        }
+    }
+
+    auto Interpreter::builtin(const Token::Literal& object,
+                              const Token::Token&   name)
+        -> const Runtime::Builtin* {
+        if (!object.is<Runtime::Array>()) {
+            return nullptr;
+        }
+        return Runtime::Builtin::find(name.lexeme);
+    }
+
+    auto Interpreter::run(const Runtime::Builtin& builtin,
+                          const Token::Literal&   receiver,
+                          const Token::Literal*   arguments,
+                          const Token::Token&     paren,
+                          const Runtime::Caller&  call) -> Token::Literal {
+        auto self = receiver.as<Runtime::Array>();
+        std::array<Token::Literal, Runtime::Builtin::MAX_ARITY> copied;
+        std::copy_n(arguments, builtin.arity, copied.begin());
+        return builtin.run(self, copied.data(), paren, call);
+    }
+
+    auto Interpreter::target(const Token::Literal& callee,
+                             std::size_t arguments, const Token::Token& paren)
+        -> Target {
+        if (const auto* function =
+                std::get_if<Runtime::Function>(&callee.value)) {
+            expect(*function, arguments, paren);
+            if (function->bound()) {
+                return {function, function->receiver()};
+            }
+            return {function, {}};
+        }
+        if (const auto* klass = std::get_if<Runtime::Class>(&callee.value)) {
+            const auto& init = klass->initializer();
+            expect(init, arguments, paren);
+            return {&init,
+                    Token::Literal{Runtime::Object{klass->shape(), klass}},
+                    true};
+        }
+        if (const auto* method = std::get_if<Runtime::Method>(&callee.value)) {
+            expect(*method->builtin, arguments, paren);
+            return {nullptr, {}, false, method->builtin};
+        }
+        throw Error::RuntimeException(paren,
+                                      "Can only call functions and classes.");
+    }
+
+    auto Interpreter::invoke(const Token::Literal&       object,
+                             const Token::Token&         name,
+                             const Runtime::InlineCache& cache,
+                             Token::Literal& callee, std::size_t arguments,
+                             const Token::Token& paren) -> Target {
+        if (object.is<Runtime::Array>()) {
+            const auto* found = builtin(object, name);
+            if (found == nullptr) {
+                callee = get(object, name, cache);
+                return target(callee, arguments, paren);
+            }
+            expect(*found, arguments, paren);
+            return {nullptr, object, false, found};
+        }
+        auto [field, method] = property(object, name, cache);
+        if (method == nullptr) {
+            callee = *field;
+            return target(callee, arguments, paren);
+        }
+        expect(*method, arguments, paren);
+        return {method, object};
+    }
+
+    auto Interpreter::property(const Token::Literal&       object,
+                               const Token::Token&         name,
+                               const Runtime::InlineCache& cache)
+        -> Property {
+        const auto* instance = std::get_if<Runtime::Object>(&object.value);
+        if (instance == nullptr) {
+            throw Error::RuntimeException(name,
+                                          "Only instances have properties.");
+        }
+        if (const auto* entry = cache.find(instance->shape())) {
+            if (entry->kind == Runtime::InlineCache::Kind::FIELD) {
+                return {&instance->fields()[entry->index], nullptr};
+            }
+            return {nullptr, &instance->klass()->method(entry->index)};
+        }
+        Runtime::InlineCache::miss();
+        auto found = member(*instance, name.lexeme, &cache);
+        if (found.field != nullptr || found.method != nullptr) {
+            return found;
+        }
+        throw Error::RuntimeException(
+            name, fmt::format("Undefined property '{}'.", name.lexeme));
+    }
+
+    auto Interpreter::get(const Token::Literal&       object,
+                          const Token::Token&         name,
+                          const Runtime::InlineCache& cache) -> Token::Literal {
+        if (const auto* array = std::get_if<Runtime::Array>(&object.value)) {
+            if (name.lexeme == "length") {
+                return Token::Literal{static_cast<double>(array->size())};
+            }
+            if (Runtime::Builtin::find(name.lexeme) != nullptr) {
+                throw Error::RuntimeException(
+                    name, "Can't use an array method without calling it.");
+            }
+            throw Error::RuntimeException(
+                name, fmt::format("Undefined property '{}'.", name.lexeme));
+        }
+        auto [field, method] = property(object, name, cache);
+        if (method != nullptr) {
+            return Token::Literal{method->bind(object)};
+        }
+        return *field;
+    }
+
+    void Interpreter::set(const Token::Literal&       object,
+                          const Token::Token&         name,
+                          Token::Literal              value,
+                          const Runtime::InlineCache& cache) {
+        const auto* instance = std::get_if<Runtime::Object>(&object.value);
+        if (instance == nullptr) {
+            throw Error::RuntimeException(name, "Only instances have fields.");
+        }
+        store(*instance, name.lexeme, std::move(value), &cache);
+    }
+
+    auto Interpreter::element(const Token::Literal& object,
+                              const Token::Literal& index,
+                              const Token::Token&   bracket) -> Token::Literal {
+        if (const auto* instance =
+                std::get_if<Runtime::Object>(&object.value)) {
+            auto name            = key(index, bracket);
+            auto [field, method] = member(*instance, name, nullptr);
+            if (method != nullptr) {
+                return Token::Literal{method->bind(object)};
+            }
+            if (field == nullptr) {
+                throw Error::RuntimeException(
+                    bracket, fmt::format("Undefined property '{}'.", name));
+            }
+            return *field;
+        }
+        auto [array, slot] = locate(object, index, bracket);
+        return array->get(slot);
+    }
+
+    void Interpreter::setElement(const Token::Literal& object,
+                                 const Token::Literal& index,
+                                 Token::Literal        value,
+                                 const Token::Token&   bracket) {
+        if (const auto* instance =
+                std::get_if<Runtime::Object>(&object.value)) {
+            store(*instance, key(index, bracket), std::move(value), nullptr);
+            return;
         }
-        int l = left.toInt();
-        int r = right.toInt();
+        auto [array, slot] = locate(object, index, bracket);
+        array->set(slot, std::move(value));
+    }
 
-        if (l < 0 || r < 0 || std::floor(left.asNumber()) != l ||
-            std::floor(right.asNumber()) != r) {
+    auto Interpreter::inherited(const Token::Literal& superclass,
+                                const Token::Token&   name)
+        -> const Runtime::Function& {
+        const auto& klass = superclass.as<Runtime::Class>();
+        auto        index = klass.find(name.lexeme);
+        if (index == Runtime::Class::NONE) {
             throw Error::RuntimeException(
-                op, "Operands must be non-negative integers.");
+                name, fmt::format("Undefined property '{}'.", name.lexeme));
+        }
+        return klass.method(index);
+    }
+
+    auto Interpreter::declare(const Stmt::Class&       stmt,
+                              const Token::Literal&    superclass,
+                              const Token::Literal*    locals,
+                              const Runtime::Function* enclosing)
+        -> Token::Literal {
+        const Runtime::Class* parent = nullptr;
+        if (stmt.superclass != nullptr) {
+            parent = std::get_if<Runtime::Class>(&superclass.value);
+            if (parent == nullptr) {
+                throw Error::RuntimeException(stmt.name,
+                                              "Superclass must be a class.");
+            }
+        }
+        std::vector<std::pair<std::string, Runtime::Function>> methods;
+        methods.reserve(stmt.methods.size());
+        for (const auto& method : stmt.methods) {
+            methods.emplace_back(
+                method->name.lexeme,
+                Runtime::Function::close(method, locals, enclosing));
+        }
+        return Token::Literal{
+            Runtime::Class{stmt.name.lexeme, parent, std::move(methods)}};
+    }
+
+    auto Interpreter::prepare(const Expr::CallExpr& call) const -> Prepared {
+        const auto& arguments = call.arguments;
+        Token::Literal callee;
+        Target         target;
+        if (call.callee->is<Expr::GetExpr>()) {
+            const auto& get    = call.callee->as<Expr::GetExpr>();
+            auto        object = evaluate(get.object);
+            target = invoke(object, get.name, get.cache, callee,
+                            arguments.size(), call.paren);
+        } else if (call.callee->is<Expr::SuperExpr>()) {
+            const auto& super  = call.callee->as<Expr::SuperExpr>();
+            callee             = evaluate(super.superclass);
+            const auto& method = inherited(callee, super.method);
+            expect(method, arguments.size(), call.paren);
+            target = {&method, evaluate(super.receiver)};
+        } else {
+            callee = evaluate(call.callee);
+            target = this->target(callee, arguments.size(), call.paren);
+        }
+        if (target.builtin != nullptr) {
+            std::array<Token::Literal, Runtime::Builtin::MAX_ARITY> values;
+            for (std::size_t i = 0; i < arguments.size(); ++i) {
+                values[i] = evaluate(arguments[i]);
+            }
+            auto result = run(
+                *target.builtin, target.receiver, values.data(), call.paren,
+                [this, &call](const Token::Literal& callee,
+                              const Token::Literal* passed, std::size_t count) {
+                    return apply(callee, passed, count, call.paren);
+                });
+            return {std::nullopt, 0, {}, std::move(result)};
+        }
+        // A function value is moved out rather than copied.
+        auto* held     = std::get_if<Runtime::Function>(&callee.value);
+        auto  function = held == target.function ? std::move(*held)
+                                                 : *target.function;
+        const auto& definition = function.definition();
+        auto base  = stack_.push(definition.locals, call.paren);
+        auto first = definition.first();
+        if (first != 0) {
+            stack_[base] = target.receiver;
+        }
+        for (std::size_t i = 0; i < arguments.size(); ++i) {
+            // The right side goes first, so growing cannot move the slot.
+            stack_[base + first + i] = evaluate(arguments[i]);
+        }
+        return {std::move(function), base,
+                target.construct ? std::move(target.receiver)
+                                 : Token::Literal{},
+                {}};
+    }
+
+    auto Interpreter::apply(const Token::Literal& callee,
+                            const Token::Literal* arguments,
+                            std::size_t count, const Token::Token& paren) const
+        -> Token::Literal {
+        stack_.guard(paren);
+        auto        target     = this->target(callee, count, paren);
+        auto        function   = *target.function;
+        const auto& definition = function.definition();
+        auto        base       = stack_.push(definition.locals, paren);
+        auto        first      = definition.first();
+        if (first != 0) {
+            stack_[base] = target.receiver;
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            stack_[base + first + i] = arguments[i];
+        }
+        auto result = call(std::move(function), base);
+        return target.construct ? std::move(target.receiver) : result;
+    }
+
+    auto Interpreter::call(Runtime::Function function, std::size_t base) const
+        -> Token::Literal {
+        auto        caller    = base_;
+        const auto* enclosing = callee_;
+        base_                 = base;
+        callee_               = &function;
+        for (;;) {
+            const auto& definition = function.definition();
+            if (!definition.cells.empty()) {
+                stack_.box(base, definition.cells);
+            }
+            const auto* code =
+                loops_ != nullptr ? loops_->call(definition) : nullptr;
+            if (code != nullptr) {
+                auto frame = this->frame();
+                (*code)(frame);
+                flow_   = frame.flow;
+                result_ = std::move(frame.result);
+            } else {
+                for (const auto& each : definition.body) {
+                    execute(each);
+                    if (flow_ != Stmt::Flow::NORMAL) {
+                        break;
+                    }
+                }
+            }
+            if (flow_ != Stmt::Flow::TAIL_CALL) {
+                break;
+            }
+            flow_    = Stmt::Flow::NORMAL;
+            function = std::move(result_.as<Runtime::Function>());
+            stack_.slide(base, function.definition().locals);
+        }
+        auto result = flow_ == Stmt::Flow::RETURN ? std::move(result_)
+                                                  : Token::Literal{};
+        flow_       = Stmt::Flow::NORMAL;
+        base_       = caller;
+        callee_     = enclosing;
+        stack_.pop(base);
+        return result;
+    }
+
+    auto Interpreter::visit(const Stmt::Block& stmt) const -> void {
+        for (const auto& each : stmt.statements) {
+            execute(each);
+            if (flow_ != Stmt::Flow::NORMAL) {
+                return;
+            }
+        }
+    }
+
+    auto Interpreter::visit(const Stmt::If& stmt) const -> void {
+        if (Operators::isTruthy(evaluate(stmt.condition))) {
+            execute(stmt.thenBranch);
+        } else if (stmt.elseBranch != nullptr) {
+            execute(stmt.elseBranch);
+        }
+    }
+
+    auto Interpreter::visit(const Stmt::Switch& stmt) const -> void {
+        const auto& labels = stmt.dispatch.dynamic();
+        auto        chosen = stmt.dispatch.select(
+            evaluate(stmt.subject),
+            [&](std::size_t label) { return evaluate(labels[label].expr); });
+        if (chosen != Stmt::Dispatch::NONE) {
+            execute(stmt.cases[chosen].body);
+        } else if (stmt.otherwise != nullptr) {
+            execute(stmt.otherwise);
+        }
+    }
+
+    auto Interpreter::visit(const Stmt::While& stmt) const -> void {
+        if (loops_ != nullptr) {
+            if (const auto* code =
+                    loops_->enter(stmt, Closure::Level::TREE, environment_)) {
+                resume(*code);
+                return;
+            }
+        }
+        while (Operators::isTruthy(evaluate(stmt.condition))) {
+            execute(stmt.body);
+            if (flow_ == Stmt::Flow::CONTINUE) {
+                flow_ = Stmt::Flow::NORMAL;
+            } else if (flow_ != Stmt::Flow::NORMAL) {
+                // `break`, or a `return` that leaves the function too
+                if (flow_ == Stmt::Flow::BREAK) {
+                    flow_ = Stmt::Flow::NORMAL;
+                }
+                return;
+            }
+            if (stmt.increment != nullptr) {
+                (void)evaluate(stmt.increment);
+            }
+            if (loops_ != nullptr) {
+                if (const auto* code = loops_->backEdge(
+                        stmt, Closure::Level::TREE, environment_)) {
+                    resume(*code);
+                    return;
+                }
+            }
+        }
+    }
+
+    auto Interpreter::visit(const Stmt::Break& /*stmt*/) const -> void {
+        flow_ = Stmt::Flow::BREAK;
+    }
+
+    auto Interpreter::visit(const Stmt::Continue& /*stmt*/) const -> void {
+        flow_ = Stmt::Flow::CONTINUE;
+    }
+
+    auto Interpreter::visit(const Stmt::Function& stmt) const -> void {
+        if (stmt.storage == Expr::Storage::GLOBAL) {
+            environment_.define(
+                stmt.slot, Token::Literal{Runtime::Function{stmt.definition}});
+            return;
+        }
+        if (stmt.storage == Expr::Storage::CELL) {
+            stack_[base_ + stmt.slot] =
+                Token::Literal{Runtime::Cell{Token::Literal{}}};
+        }
+        Token::Literal function{Runtime::Function::close(
+            stmt.definition, stack_.data() + base_, callee_)};
+        auto& slot = stack_[base_ + stmt.slot];
+        if (stmt.storage == Expr::Storage::CELL) {
+            slot.as<Runtime::Cell>().get() = std::move(function);
+        } else {
+            slot = std::move(function);
+        }
+    }
+
+    auto Interpreter::visit(const Stmt::Class& stmt) const -> void {
+        auto superclass = stmt.superclass != nullptr
+                              ? evaluate(stmt.superclass)
+                              : Token::Literal{};
+        if (stmt.storage == Expr::Storage::GLOBAL) {
+            environment_.define(stmt.slot,
+                                declare(stmt, superclass, nullptr, nullptr));
+            return;
+        }
+        if (stmt.storage == Expr::Storage::CELL) {
+            stack_[base_ + stmt.slot] =
+                Token::Literal{Runtime::Cell{Token::Literal{}}};
+        }
+        auto  klass = declare(stmt, superclass, stack_.data() + base_, callee_);
+        auto& slot  = stack_[base_ + stmt.slot];
+        if (stmt.storage == Expr::Storage::CELL) {
+            slot.as<Runtime::Cell>().get() = std::move(klass);
+        } else {
+            slot = std::move(klass);
+        }
+    }
+
+    // Throws are C++ exceptions, whose handlers the compiler puts in tables
+    // beside the code: entering a try costs nothing, and a throw skips the
+    // frames between it and here in one unwind. Those frames are dropped
+    // from the stack here, as `run` does for an error no try catches.
+    auto Interpreter::visit(const Stmt::Try& stmt) const -> void {
+        auto           top    = stack_.top();
+        auto           base   = base_;
+        const auto*    callee = callee_;
+        Token::Literal thrown;
+        auto           guarded = [&](const Stmt::Stmt& each) {
+            try {
+                execute(each);
+            } catch (const Error::RuntimeException& error) {
+                stack_.pop(top);
+                base_   = base;
+                callee_ = callee;
+                flow_   = Stmt::Flow::NORMAL;
+                thrown  = Error::caught(error);
+                return std::current_exception();
+            }
+            return std::exception_ptr{};
+        };
+        auto error = guarded(stmt.body);
+        if (error && stmt.handler != nullptr) {
+            define(stmt.caught->as<Stmt::Variable>(), std::move(thrown));
+            error = guarded(stmt.handler);
+        }
+        if (stmt.cleanup != nullptr) {
+            // A `break`, `continue` or `return` of its own replaces how the
+            // try was being left, a throw included.
+            auto flow   = flow_;
+            auto result = std::move(result_);
+            flow_       = Stmt::Flow::NORMAL;
+            execute(stmt.cleanup);
+            if (flow_ != Stmt::Flow::NORMAL) {
+                return;
+            }
+            flow_   = flow;
+            result_ = std::move(result);
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    auto Interpreter::visit(const Stmt::Throw& stmt) const -> void {
+        throw Error::Thrown(stmt.keyword, evaluate(stmt.value));
+    }
+
+    auto Interpreter::visit(const Stmt::Return& stmt) const -> void {
+        if (stmt.tail) {
+            // The callee's frame goes on top for now; `call` slides it
+            // down over the returning one.
+            auto prepared = prepare(stmt.value->as<Expr::CallExpr>());
+            if (!prepared.function) {
+                result_ = std::move(prepared.result);
+                flow_   = Stmt::Flow::RETURN;
+                return;
+            }
+            if (!prepared.constructed.isNil()) {
+                // `init` returns nothing; the call is the instance.
+                (void)call(std::move(*prepared.function), prepared.base);
+                result_ = std::move(prepared.constructed);
+                flow_   = Stmt::Flow::RETURN;
+                return;
+            }
+            result_ = Token::Literal{std::move(*prepared.function)};
+            flow_   = Stmt::Flow::TAIL_CALL;
+            return;
+        }
+        result_ = stmt.value != nullptr ? evaluate(stmt.value)
+                                        : Token::Literal{};
+        flow_   = Stmt::Flow::RETURN;
+    }
+
+    void Interpreter::resume(const Closure::Exec& code) const {
+        auto frame = this->frame();
+        code(frame);
+        // A `return` inside the loop leaves through here.
+        flow_ = frame.flow;
+        if (flow_ != Stmt::Flow::NORMAL) {
+            result_ = std::move(frame.result);
         }
-        return {l, r};
     }
 
     void Interpreter::assertBothNumber(const Token::Literal& left,
@@ -0,0 +1,954 @@
+#include "Thor/Jit.hpp"
+
+#include "Thor/Environment.hpp"
+#include "Thor/Exceptions.hpp"
+#include "Thor/Expr.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Operators.hpp"
+#include "Thor/Trace.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define THOR_JIT 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <array>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace Jit {
+
+    namespace {
+
+        // Evaluations before a node counts as hot.
+        constexpr std::uint32_t HOT_THRESHOLD = 100;
+
+        // Bailouts after which a function is abandoned.
+        constexpr std::uint32_t MAX_BAILOUTS = 64;
+
+        // Distinct variables one function may read.
+        constexpr std::size_t MAX_INPUTS = 16;
+
+        std::atomic<std::uint64_t> compiledCount{0};
+        std::atomic<std::uint64_t> bailoutCount{0};
+        std::atomic<std::uint64_t> deoptimizedCount{0};
+
+        // Static type of a compiled value. Booleans are 0.0 or 1.0.
+        enum class Kind : std::uint8_t { NONE, NUMBER, BOOL };
+
+        struct CodeChunk;
+
+        // Where one function's code lives.
+        struct CodeBlock {
+            void*       code;
+            std::size_t size;   // Of its own mapping; 0 if in a chunk
+            CodeChunk*  chunk;  // Null if in a mapping of its own
+        };
+
+#if defined(THOR_JIT)
+        struct CodeChunk {
+            std::uint8_t* writable;
+            std::uint8_t* executable;
+            std::size_t   used = 0;
+            std::size_t   live = 0;  // Functions not yet released
+        };
+
+        // Executable memory for every function. Functions are packed into
+        // shared chunks rather than given a page each, so that code which
+        // runs together shares cache lines and TLB entries; a program with
+        // thousands of compiled nodes otherwise spends its time missing.
+        //
+        // A chunk is one memfd mapped twice, writable at one address and
+        // executable at the other, so no address is ever both. It is
+        // unmapped once it is full and every function in it is gone. Where
+        // memfds are unavailable, or for code larger than a chunk, each
+        // function gets pages of its own.
+        class CodeHeap {
+          public:
+
+            static auto instance() -> CodeHeap& {
+                // Never destroyed: functions may outlive static destructors.
+                static auto* heap = new CodeHeap();
+                return *heap;
+            }
+
+            auto allocate(const std::vector<std::uint8_t>& code)
+                -> std::optional<CodeBlock> {
+                auto size = (code.size() + ALIGN - 1) / ALIGN * ALIGN;
+                if (size <= CHUNK_SIZE) {
+                    std::lock_guard lock(mutex_);
+                    if (current_ == nullptr ||
+                        current_->used + size > CHUNK_SIZE) {
+                        retire(current_);
+                        current_ = map();
+                    }
+                    if (current_ != nullptr) {
+                        auto offset = current_->used;
+                        std::memcpy(current_->writable + offset, code.data(),
+                                    code.size());
+                        current_->used += size;
+                        ++current_->live;
+                        return CodeBlock{current_->executable + offset, 0,
+                                         current_};
+                    }
+                }
+                return mapPrivate(code);
+            }
+
+            void release(const CodeBlock& block) {
+                if (block.chunk == nullptr) {
+                    ::munmap(block.code, block.size);
+                    return;
+                }
+                std::lock_guard lock(mutex_);
+                if (--block.chunk->live == 0 && block.chunk != current_) {
+                    unmap(block.chunk);
+                }
+            }
+
+          private:
+
+            static constexpr std::size_t CHUNK_SIZE = std::size_t{1} << 18U;
+            static constexpr std::size_t ALIGN      = 16;
+
+            CodeHeap() = default;
+
+            auto map() -> CodeChunk*;
+            void unmap(CodeChunk* chunk);
+
+            void retire(CodeChunk* chunk) {
+                if (chunk != nullptr && chunk->live == 0) {
+                    unmap(chunk);
+                }
+            }
+
+            static auto mapPrivate(const std::vector<std::uint8_t>& code)
+                -> std::optional<CodeBlock> {
+                auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+                auto size = (code.size() + page - 1) / page * page;
+                void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (memory == MAP_FAILED) {
+                    return std::nullopt;
+                }
+                std::memcpy(memory, code.data(), code.size());
+                // Never writable and executable at the same time.
+                if (::mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+                    ::munmap(memory, size);
+                    return std::nullopt;
+                }
+                return CodeBlock{memory, size, nullptr};
+            }
+
+            std::mutex mutex_;
+            CodeChunk* current_ = nullptr;
+            bool       noMemfd_ = false;
+        };
+
+        auto CodeHeap::map() -> CodeChunk* {
+            if (noMemfd_) {
+                return nullptr;
+            }
+            int fd = ::memfd_create("thor-jit", MFD_CLOEXEC);
+            if (fd < 0 ||
+                ::ftruncate(fd, static_cast<off_t>(CHUNK_SIZE)) != 0) {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+                noMemfd_ = true;
+                return nullptr;
+            }
+            void* writable   = ::mmap(nullptr, CHUNK_SIZE,
+                                      PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                                      0);
+            void* executable = ::mmap(nullptr, CHUNK_SIZE,
+                                      PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (writable == MAP_FAILED || executable == MAP_FAILED) {
+                if (writable != MAP_FAILED) {
+                    ::munmap(writable, CHUNK_SIZE);
+                }
+                if (executable != MAP_FAILED) {
+                    ::munmap(executable, CHUNK_SIZE);
+                }
+                noMemfd_ = true;
+                return nullptr;
+            }
+            return new CodeChunk{static_cast<std::uint8_t*>(writable),
+                                 static_cast<std::uint8_t*>(executable)};
+        }
+
+        void CodeHeap::unmap(CodeChunk* chunk) {
+            ::munmap(chunk->writable, CHUNK_SIZE);
+            ::munmap(chunk->executable, CHUNK_SIZE);
+            delete chunk;
+        }
+#endif
+    }  // namespace
+
+    // Generated code plus the guards of its entry stub.
+    class Function {
+      public:
+
+        // Reads its inputs from `inputs`, writes the value to `result` and
+        // returns 0, or returns 1 to bail out.
+        using Entry = auto (*)(const double* inputs, double* result) -> int;
+
+        Function(CodeBlock code, std::vector<std::uint32_t> slots,
+                 std::vector<Kind> kinds, Kind result)
+            : code_(code),
+              slots_(std::move(slots)),
+              kinds_(std::move(kinds)),
+              result_(result) {}
+
+        Function(const Function&)                    = delete;
+        auto operator=(const Function&) -> Function& = delete;
+
+        ~Function() {
+#if defined(THOR_JIT)
+            CodeHeap::instance().release(code_);
+#endif
+        }
+
+        [[nodiscard]] auto call(const Interpreter::Environment& environment)
+            const -> std::optional<Token::Literal> {
+            std::array<double, MAX_INPUTS> inputs;
+            for (std::size_t i = 0; i < slots_.size(); ++i) {
+                const auto& value = environment.get(slots_[i]);
+                if (kinds_[i] == Kind::NUMBER && value.isNumber()) {
+                    inputs[i] = value.asNumber();
+                } else if (kinds_[i] == Kind::BOOL && value.isBool()) {
+                    inputs[i] = value.asBool() ? 1.0 : 0.0;
+                } else {
+                    return std::nullopt;
+                }
+            }
+            double result = 0;
+            auto   entry  = reinterpret_cast<Entry>(code_.code);
+            if (entry(inputs.data(), &result) != 0) {
+                return std::nullopt;
+            }
+            if (result_ == Kind::BOOL) {
+                return Token::Literal{result != 0.0};
+            }
+            return Token::Literal{result};
+        }
+
+      private:
+
+        CodeBlock                  code_;
+        std::vector<std::uint32_t> slots_;  // Input i is read from slots_[i]
+        std::vector<Kind>          kinds_;
+        Kind                       result_;
+    };
+
+    namespace {
+
+        enum Xmm : std::uint8_t { XMM0, XMM1, XMM2 };
+        enum Reg : std::uint8_t { EAX, ECX, EDX };
+
+        // Second opcode byte of the rel32 form of each jcc.
+        enum class Cond : std::uint8_t {
+            ALWAYS = 0,
+            E      = 0x84,
+            NE     = 0x85,
+            A      = 0x87,
+            S      = 0x88,
+            P      = 0x8A,
+        };
+
+        // cmpsd predicates.
+        enum Predicate : std::uint8_t { EQ = 0, LT = 1, LE = 2, NEQ = 4 };
+
+        auto modrm(std::uint8_t reg, std::uint8_t rm) -> std::uint8_t {
+            return static_cast<std::uint8_t>(0xC0U | (reg << 3U) | rm);
+        }
+
+        // x86-64 machine code for the handful of instructions the templates
+        // need, with forward and backward jumps to labels.
+        class Assembler {
+          public:
+
+            using Label = std::size_t;
+
+            void emit(std::initializer_list<std::uint8_t> bytes) {
+                code_.insert(code_.end(), bytes);
+            }
+
+            template <typename T>
+            void immediate(T value) {
+                std::array<std::uint8_t, sizeof(T)> bytes{};
+                std::memcpy(bytes.data(), &value, sizeof(T));
+                code_.insert(code_.end(), bytes.begin(), bytes.end());
+            }
+
+            auto label() -> Label {
+                labels_.push_back(UNBOUND);
+                return labels_.size() - 1;
+            }
+
+            void bind(Label label) {
+                labels_[label] = code_.size();
+            }
+
+            void jump(Cond cond, Label target) {
+                if (cond == Cond::ALWAYS) {
+                    emit({0xE9});
+                } else {
+                    emit({0x0F, static_cast<std::uint8_t>(cond)});
+                }
+                fixups_.push_back({code_.size(), target});
+                immediate<std::int32_t>(0);
+            }
+
+            // Resolves jumps; empty if a label was never bound.
+            auto finish() -> std::vector<std::uint8_t> {
+                for (const auto& fixup : fixups_) {
+                    auto target = labels_[fixup.label];
+                    if (target == UNBOUND) {
+                        return {};
+                    }
+                    auto rel = static_cast<std::int32_t>(
+                        static_cast<std::ptrdiff_t>(target) -
+                        static_cast<std::ptrdiff_t>(fixup.at + 4));
+                    std::memcpy(&code_[fixup.at], &rel, sizeof(rel));
+                }
+                return std::move(code_);
+            }
+
+            // movsd dst, [rbx + 8 * index]
+            void loadInput(Xmm dst, std::size_t index) {
+                emit({0xF2, 0x0F, 0x10,
+                      static_cast<std::uint8_t>(0x83U | (dst << 3U))});
+                immediate(static_cast<std::int32_t>(index * sizeof(double)));
+            }
+
+            // mov rax, imm64; movq dst, rax
+            void loadConstant(Xmm dst, double value) {
+                emit({0x48, 0xB8});
+                immediate(value);
+                emit({0x66, 0x48, 0x0F, 0x6E, modrm(dst, 0)});
+            }
+
+            // Scalar double op: addsd, mulsd, cmpsd and the like.
+            void sse(std::uint8_t prefix, std::uint8_t opcode, Xmm dst,
+                     Xmm src) {
+                emit({prefix, 0x0F, opcode, modrm(dst, src)});
+            }
+
+            void movapd(Xmm dst, Xmm src) {
+                sse(0x66, 0x28, dst, src);
+            }
+
+            void cmpsd(Xmm dst, Xmm src, Predicate predicate) {
+                sse(0xF2, 0xC2, dst, src);
+                emit({predicate});
+            }
+
+            // sub rsp, 8; movsd [rsp], xmm0
+            void push() {
+                emit({0x48, 0x83, 0xEC, 0x08, 0xF2, 0x0F, 0x11, 0x04, 0x24});
+            }
+
+            // movsd dst, [rsp]; add rsp, 8
+            void pop(Xmm dst) {
+                emit({0xF2, 0x0F, 0x10,
+                      static_cast<std::uint8_t>(0x04U | (dst << 3U)), 0x24,
+                      0x48, 0x83, 0xC4, 0x08});
+            }
+
+            // cvttsd2si dst, src
+            void truncate(Reg dst, Xmm src) {
+                emit({0xF2, 0x0F, 0x2C, modrm(dst, src)});
+            }
+
+            // cvtsi2sd dst, src
+            void convert(Xmm dst, Reg src) {
+                emit({0xF2, 0x0F, 0x2A, modrm(dst, src)});
+            }
+
+          private:
+
+            static constexpr std::size_t UNBOUND = SIZE_MAX;
+
+            struct Fixup {
+                std::size_t at;
+                Label       label;
+            };
+
+            std::vector<std::uint8_t> code_;
+            std::vector<std::size_t>  labels_;
+            std::vector<Fixup>        fixups_;
+        };
+
+        auto fold(const Expr::Expr& expr) -> std::optional<Token::Literal>;
+
+        // Values of operators whose operands read no variables, so that
+        // generated code loads them instead of computing them on every
+        // call. Nullopt as well when computing one throws: the error is
+        // left to surface at run time, as in the closure compiler.
+        auto fold(const Expr::InfixExpr& expr)
+            -> std::optional<Token::Literal> {
+            auto op = expr.op;
+            if (!op) {
+                return std::nullopt;
+            }
+            auto left  = fold(expr.left);
+            auto right = left ? fold(expr.right) : std::nullopt;
+            if (!right) {
+                return std::nullopt;
+            }
+            try {
+                return Operators::apply(*op, *left, *right, expr.operator_);
+            } catch (const Error::RuntimeException& /*error*/) {
+                return std::nullopt;
+            }
+        }
+
+        auto fold(const Expr::PrefixExpr& expr)
+            -> std::optional<Token::Literal> {
+            auto right = fold(expr.right);
+            if (!right) {
+                return std::nullopt;
+            }
+            try {
+                return Interpreter::Interpreter::prefix(expr.operator_,
+                                                        std::move(*right));
+            } catch (const Error::RuntimeException& /*error*/) {
+                return std::nullopt;
+            }
+        }
+
+        auto fold(const Expr::Expr& expr) -> std::optional<Token::Literal> {
+            if (expr->is<Expr::LiteralExpr>()) {
+                return expr->as<Expr::LiteralExpr>().literal;
+            }
+            if (expr->is<Expr::Variable>()) {
+                const auto& variable = expr->as<Expr::Variable>();
+                if (variable.slot == Expr::Variable::UNRESOLVED) {
+                    return variable.literal;
+                }
+                return std::nullopt;
+            }
+            if (expr->is<Expr::GroupExpr>()) {
+                return fold(expr->as<Expr::GroupExpr>().expr);
+            }
+            if (expr->is<Expr::InfixExpr>()) {
+                return fold(expr->as<Expr::InfixExpr>());
+            }
+            if (expr->is<Expr::PrefixExpr>()) {
+                return fold(expr->as<Expr::PrefixExpr>());
+            }
+            return std::nullopt;
+        }
+
+        // Emits one template per node. Every template leaves its value in
+        // xmm0 and may clobber xmm1, xmm2, rax, rcx and rdx; operands that
+        // must survive a nested template are kept on the machine stack.
+        //
+        // The generated function keeps the input array in rbx and the
+        // result pointer in r12, and holds rsp 16-byte aligned at depth 0.
+        class Compiler : Expr::Visitor<Kind> {
+          public:
+
+            explicit Compiler(const Interpreter::Environment& environment)
+                : environment_(environment) {}
+
+            auto compile(const Expr::ExprBase& expr)
+                -> std::unique_ptr<Function> {
+                // A lone leaf is faster to interpret than to call.
+                if (expr.is<Expr::Variable>() || expr.is<Expr::LiteralExpr>()) {
+                    return nullptr;
+                }
+
+                exit_ = assembler_.label();
+                bail_ = assembler_.label();
+                // push rbp; mov rbp, rsp; push rbx; push r12;
+                // mov rbx, rdi; mov r12, rsi
+                assembler_.emit({0x55, 0x48, 0x89, 0xE5, 0x53, 0x41, 0x54,
+                                 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4});
+                auto kind = expr.accept(*this);
+                if (kind == Kind::NONE) {
+                    return nullptr;
+                }
+                // movsd [r12], xmm0; xor eax, eax
+                assembler_.emit({0xF2, 0x41, 0x0F, 0x11, 0x04, 0x24, 0x31,
+                                 0xC0});
+                assembler_.bind(exit_);
+                // lea rsp, [rbp - 16]; pop r12; pop rbx; pop rbp; ret
+                assembler_.emit({0x48, 0x8D, 0x65, 0xF0, 0x41, 0x5C, 0x5B,
+                                 0x5D, 0xC3});
+                assembler_.bind(bail_);
+                assembler_.emit({0xB8, 0x01, 0x00, 0x00, 0x00});  // mov eax, 1
+                assembler_.jump(Cond::ALWAYS, exit_);
+
+                auto code = assembler_.finish();
+                if (code.empty()) {
+                    return nullptr;
+                }
+                return install(code, kind);
+            }
+
+          private:
+
+            auto visit(const Expr::Variable& expr) const -> Kind final {
+                return leaf(expr, XMM0);
+            }
+
+            auto visit(const Expr::LiteralExpr& expr) const -> Kind final {
+                return constant(expr.literal, XMM0);
+            }
+
+            auto visit(const Expr::GroupExpr& expr) const -> Kind final {
+                return expr.expr->accept(*this);
+            }
+
+            auto visit(const Expr::PostfixExpr& /*expr*/) const
+                -> Kind final {
+                return Kind::NONE;
+            }
+
+            auto visit(const Expr::TemplateExpr& /*expr*/) const
+                -> Kind final {
+                return Kind::NONE;
+            }
+
+            // Stores are left to the interpreter.
+            auto visit(const Expr::AssignExpr& /*expr*/) const -> Kind final {
+                return Kind::NONE;
+            }
+
+            // So are calls, and with them the locals they open.
+            auto visit(const Expr::CallExpr& /*expr*/) const -> Kind final {
+                return Kind::NONE;
+            }
+
+            // And objects.
+            auto visit(const Expr::GetExpr& /*expr*/) const -> Kind final {
+                return Kind::NONE;
+            }
+
+            auto visit(const Expr::SetExpr& /*expr*/) const -> Kind final {
+                return Kind::NONE;
+            }
+
+            auto visit(const Expr::ObjectExpr& /*expr*/) const -> Kind final {
+                return Kind::NONE;
+            }
+
+            auto visit(const Expr::SuperExpr& /*expr*/) const -> Kind final {
+                return Kind::NONE;
+            }
+
+            // And arrays.
+            auto visit(const Expr::ArrayExpr& /*expr*/) const -> Kind final {
+                return Kind::NONE;
+            }
+
+            auto visit(const Expr::IndexExpr& /*expr*/) const -> Kind final {
+                return Kind::NONE;
+            }
+
+            auto visit(const Expr::IndexSetExpr& /*expr*/) const
+                -> Kind final {
+                return Kind::NONE;
+            }
+
+            auto visit(const Expr::PrefixExpr& expr) const -> Kind final {
+                if (auto value = fold(expr)) {
+                    return constant(*value, XMM0);
+                }
+                auto kind = expr.right->accept(*this);
+                switch (expr.operator_.type) {
+                    case Token::Type::MINUS:
+                        if (kind != Kind::NUMBER) {
+                            return Kind::NONE;
+                        }
+                        // Flip the sign bit, so -0 stays distinct.
+                        assembler_.loadConstant(XMM1, -0.0);
+                        assembler_.sse(0x66, 0x57, XMM0, XMM1);  // xorpd
+                        return Kind::NUMBER;
+                    case Token::Type::PLUS:
+                        return kind == Kind::NUMBER ? kind : Kind::NONE;
+                    case Token::Type::BANG:
+                        if (kind == Kind::NONE) {
+                            return kind;
+                        }
+                        // NaN is truthy, and compares unequal to zero.
+                        assembler_.sse(0x66, 0x57, XMM2, XMM2);
+                        assembler_.cmpsd(XMM0, XMM2, EQ);
+                        one(XMM0);
+                        return Kind::BOOL;
+                    default:
+                        return Kind::NONE;
+                }
+            }
+
+            auto visit(const Expr::TernaryExpr& expr) const -> Kind final {
+                if (expr.condition->accept(*this) == Kind::NONE) {
+                    return Kind::NONE;
+                }
+                auto whenFalse = assembler_.label();
+                auto done      = assembler_.label();
+                // Truthy unless equal to zero; unordered (NaN) is truthy.
+                auto whenTrue = assembler_.label();
+                assembler_.sse(0x66, 0x57, XMM2, XMM2);  // xorpd
+                assembler_.sse(0x66, 0x2E, XMM0, XMM2);  // ucomisd
+                assembler_.jump(Cond::P, whenTrue);
+                assembler_.jump(Cond::E, whenFalse);
+                assembler_.bind(whenTrue);
+                auto trueKind = expr.trueExpr->accept(*this);
+                assembler_.jump(Cond::ALWAYS, done);
+                assembler_.bind(whenFalse);
+                auto falseKind = expr.falseExpr->accept(*this);
+                assembler_.bind(done);
+                return trueKind == falseKind ? trueKind : Kind::NONE;
+            }
+
+            auto visit(const Expr::InfixExpr& expr) const -> Kind final {
+                if (auto value = fold(expr)) {
+                    return constant(*value, XMM0);
+                }
+                // Left operand into xmm0, right into xmm1.
+                auto left = expr.left->accept(*this);
+                if (left == Kind::NONE) {
+                    return left;
+                }
+                Kind right = Kind::NONE;
+                if (expr.right->is<Expr::Variable>()) {
+                    right = leaf(expr.right->as<Expr::Variable>(), XMM1);
+                } else if (auto value = fold(expr.right)) {
+                    right = constant(*value, XMM1);
+                } else {
+                    assembler_.push();
+                    ++depth_;
+                    right = expr.right->accept(*this);
+                    assembler_.movapd(XMM1, XMM0);
+                    assembler_.pop(XMM0);
+                    --depth_;
+                }
+                if (right == Kind::NONE) {
+                    return right;
+                }
+
+                bool numbers = left == Kind::NUMBER && right == Kind::NUMBER;
+                switch (expr.operator_.type) {
+                    case Token::Type::PLUS:
+                        return numbers ? arithmetic(0x58) : Kind::NONE;
+                    case Token::Type::MINUS:
+                        return numbers ? arithmetic(0x5C) : Kind::NONE;
+                    case Token::Type::STAR:
+                        return numbers ? arithmetic(0x59) : Kind::NONE;
+                    case Token::Type::SLASH:
+                        return numbers ? arithmetic(0x5E) : Kind::NONE;
+                    case Token::Type::STAR_STAR:
+                        return numbers ? power() : Kind::NONE;
+                    case Token::Type::PERCENT:
+                        return numbers ? modulo() : Kind::NONE;
+                    case Token::Type::BIT_AND:
+                    case Token::Type::BIT_OR:
+                    case Token::Type::BIT_XOR:
+                    case Token::Type::LEFT_SHIFT:
+                    case Token::Type::RIGHT_SHIFT:
+                        return numbers ? bitwise(expr.operator_.type)
+                                       : Kind::NONE;
+                    case Token::Type::EQUAL_EQUAL:
+                        return left == right ? compare(XMM0, XMM1, EQ)
+                                             : Kind::NONE;
+                    case Token::Type::BANG_EQUAL:
+                        return left == right ? compare(XMM0, XMM1, NEQ)
+                                             : Kind::NONE;
+                    case Token::Type::LESS:
+                        return numbers ? compare(XMM0, XMM1, LT) : Kind::NONE;
+                    case Token::Type::LESS_EQUAL:
+                        return numbers ? compare(XMM0, XMM1, LE) : Kind::NONE;
+                    case Token::Type::GREATER:
+                        return numbers ? compare(XMM1, XMM0, LT) : Kind::NONE;
+                    case Token::Type::GREATER_EQUAL:
+                        return numbers ? compare(XMM1, XMM0, LE) : Kind::NONE;
+                    case Token::Type::LOGICAL_AND:
+                    case Token::Type::LOGICAL_OR:
+                        // Both sides are evaluated, as in the interpreter.
+                        truthy(XMM0, left);
+                        truthy(XMM1, right);
+                        assembler_.sse(0x66,
+                                       expr.operator_.type ==
+                                               Token::Type::LOGICAL_AND
+                                           ? 0x54   // andpd
+                                           : 0x56,  // orpd
+                                       XMM0, XMM1);
+                        return Kind::BOOL;
+                    default:
+                        return Kind::NONE;
+                }
+            }
+
+            auto leaf(const Expr::Variable& expr, Xmm dst) const -> Kind {
+                if (expr.slot == Expr::Variable::UNRESOLVED) {
+                    return constant(expr.literal, dst);
+                }
+                if (expr.storage != Expr::Storage::GLOBAL) {
+                    return Kind::NONE;
+                }
+                const auto& value = environment_.get(expr.slot);
+                auto        kind  = value.isNumber() ? Kind::NUMBER
+                                    : value.isBool() ? Kind::BOOL
+                                                     : Kind::NONE;
+                if (kind == Kind::NONE) {
+                    return kind;
+                }
+                std::size_t index = 0;
+                while (index < slots_.size() && slots_[index] != expr.slot) {
+                    ++index;
+                }
+                if (index == slots_.size()) {
+                    if (index == MAX_INPUTS) {
+                        return Kind::NONE;
+                    }
+                    slots_.push_back(expr.slot);
+                    kinds_.push_back(kind);
+                }
+                assembler_.loadInput(dst, index);
+                return kind;
+            }
+
+            auto constant(const Token::Literal& value, Xmm dst) const
+                -> Kind {
+                if (value.isNumber()) {
+                    assembler_.loadConstant(dst, value.asNumber());
+                    return Kind::NUMBER;
+                }
+                if (value.isBool()) {
+                    assembler_.loadConstant(dst, value.asBool() ? 1.0 : 0.0);
+                    return Kind::BOOL;
+                }
+                return Kind::NONE;
+            }
+
+            auto arithmetic(std::uint8_t opcode) const -> Kind {
+                assembler_.sse(0xF2, opcode, XMM0, XMM1);
+                return Kind::NUMBER;
+            }
+
+            // `left` is set where cmpsd `predicate` holds; 1.0 or 0.0.
+            auto compare(Xmm left, Xmm right, Predicate predicate) const
+                -> Kind {
+                assembler_.cmpsd(left, right, predicate);
+                if (left != XMM0) {
+                    assembler_.movapd(XMM0, left);
+                }
+                one(XMM0);
+                return Kind::BOOL;
+            }
+
+            // Turns an all-ones mask in `reg` into 1.0.
+            void one(Xmm reg) const {
+                assembler_.loadConstant(XMM2, 1.0);
+                assembler_.sse(0x66, 0x54, reg, XMM2);  // andpd
+            }
+
+            void truthy(Xmm reg, Kind kind) const {
+                if (kind == Kind::BOOL) {
+                    return;
+                }
+                assembler_.sse(0x66, 0x57, XMM2, XMM2);  // xorpd
+                assembler_.cmpsd(reg, XMM2, NEQ);
+                one(reg);
+            }
+
+            auto power() const -> Kind {
+                auto* pow = static_cast<double (*)(double, double)>(&std::pow);
+                bool  pad = depth_ % 2 != 0;
+                if (pad) {
+                    assembler_.emit({0x48, 0x83, 0xEC, 0x08});  // sub rsp, 8
+                }
+                assembler_.emit({0x48, 0xB8});  // mov rax, imm64
+                assembler_.immediate(reinterpret_cast<std::uintptr_t>(pow));
+                assembler_.emit({0xFF, 0xD0});  // call rax
+                if (pad) {
+                    assembler_.emit({0x48, 0x83, 0xC4, 0x08});  // add rsp, 8
+                }
+                return Kind::NUMBER;
+            }
+
+            // `left % right` on ints. Bails out on a zero divisor, so the
+            // interpreter raises the error, and on values that are not ints
+            // or are INT_MIN, which idiv may trap on.
+            auto modulo() const -> Kind {
+                exact(EAX, XMM0);
+                assembler_.emit({0x3D, 0x00, 0x00, 0x00, 0x80});  // cmp eax
+                assembler_.jump(Cond::E, bail_);
+                exact(ECX, XMM1);
+                assembler_.emit({0x85, 0xC9});  // test ecx, ecx
+                assembler_.jump(Cond::E, bail_);
+                assembler_.emit({0x99, 0xF7, 0xF9});  // cdq; idiv ecx
+                assembler_.convert(XMM0, EDX);
+                return Kind::NUMBER;
+            }
+
+            // Bails out unless `src` holds an integer that fits an int.
+            void exact(Reg dst, Xmm src) const {
+                assembler_.truncate(dst, src);
+                assembler_.convert(XMM2, dst);
+                assembler_.sse(0x66, 0x2E, XMM2, src);  // ucomisd
+                assembler_.jump(Cond::P, bail_);
+                assembler_.jump(Cond::NE, bail_);
+            }
+
+            // Bails out unless `src` holds a non-negative integer that fits
+            // an int, as Operators::validateAndGetInts requires.
+            void integer(Reg dst, Xmm src) const {
+                exact(dst, src);
+                assembler_.emit({0x85, modrm(dst, dst)});  // test
+                assembler_.jump(Cond::S, bail_);
+            }
+
+            auto bitwise(Token::Type type) const -> Kind {
+                integer(EAX, XMM0);
+                integer(ECX, XMM1);
+                switch (type) {
+                    case Token::Type::BIT_AND:
+                        assembler_.emit({0x21, 0xC8});  // and eax, ecx
+                        break;
+                    case Token::Type::BIT_OR:
+                        assembler_.emit({0x09, 0xC8});  // or eax, ecx
+                        break;
+                    case Token::Type::BIT_XOR:
+                        assembler_.emit({0x31, 0xC8});  // xor eax, ecx
+                        break;
+                    default:
+                        // Shift counts past 31 are left to the interpreter.
+                        assembler_.emit({0x83, 0xF9, 0x1F});  // cmp ecx, 31
+                        assembler_.jump(Cond::A, bail_);
+                        assembler_.emit(
+                            {0xD3, static_cast<std::uint8_t>(
+                                       type == Token::Type::LEFT_SHIFT
+                                           ? 0xE0     // shl eax, cl
+                                           : 0xF8)});  // sar eax, cl
+                        break;
+                }
+                assembler_.convert(XMM0, EAX);
+                return Kind::NUMBER;
+            }
+
+            auto install(const std::vector<std::uint8_t>& code,
+                         Kind result) const -> std::unique_ptr<Function> {
+#if defined(THOR_JIT)
+                auto block = CodeHeap::instance().allocate(code);
+                if (!block) {
+                    return nullptr;
+                }
+                Trace::emit(Trace::Event::JIT_COMPILE,
+                            static_cast<std::uint32_t>(code.size()),
+                            slots_.size());
+                return std::make_unique<Function>(*block, slots_, kinds_,
+                                                  result);
+#else
+                (void)code;
+                (void)result;
+                return nullptr;
+#endif
+            }
+
+            const Interpreter::Environment& environment_;
+
+            // The visitor interface is const; emitting still has to land.
+            mutable Assembler                  assembler_;
+            mutable std::vector<std::uint32_t> slots_;
+            mutable std::vector<Kind>          kinds_;
+            mutable std::size_t                depth_ = 0;  // Stack temps
+            Assembler::Label                   exit_  = 0;
+            Assembler::Label                   bail_  = 0;
+        };
+    }  // namespace
+
+    auto parseMode(std::string_view text) -> std::optional<Mode> {
+        if (text == "off") {
+            return Mode::OFF;
+        }
+        if (text == "on") {
+            return Mode::ON;
+        }
+        if (text == "always") {
+            return Mode::ALWAYS;
+        }
+        return std::nullopt;
+    }
+
+    auto available() -> bool {
+#if defined(THOR_JIT)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    auto stats() -> Stats {
+        return {compiledCount.load(std::memory_order_relaxed),
+                bailoutCount.load(std::memory_order_relaxed),
+                deoptimizedCount.load(std::memory_order_relaxed)};
+    }
+
+    auto Site::prepare(const Expr::ExprBase&            expr,
+                       const Interpreter::Environment& environment) -> bool {
+        auto state = State::COLD;
+        if (!available() ||
+            !state_.compare_exchange_strong(state, State::COMPILING)) {
+            return state == State::COMPILED;
+        }
+
+        auto function = Compiler(environment).compile(expr);
+        if (function == nullptr) {
+            state_.store(State::REJECTED, std::memory_order_release);
+            return false;
+        }
+        compiledCount.fetch_add(1, std::memory_order_relaxed);
+        function_.store(function.release(), std::memory_order_release);
+        state_.store(State::COMPILED, std::memory_order_release);
+        return true;
+    }
+
+    Site::~Site() {
+        delete function_.load(std::memory_order_relaxed);
+    }
+
+    auto Site::run(const Expr::ExprBase&            expr,
+                   const Interpreter::Environment& environment)
+        -> std::optional<Token::Literal> {
+        auto state = state_.load(std::memory_order_acquire);
+        if (state == State::COLD) {
+            // Racy on purpose: a lost increment only delays compilation.
+            auto hits = hits_.load(std::memory_order_relaxed) + 1;
+            hits_.store(hits, std::memory_order_relaxed);
+            auto threshold = mode() == Mode::ALWAYS ? 1U : HOT_THRESHOLD;
+            if (hits < threshold || !prepare(expr, environment)) {
+                return std::nullopt;
+            }
+        } else if (state != State::COMPILED) {
+            return std::nullopt;
+        }
+
+        const auto* function = function_.load(std::memory_order_acquire);
+        auto        result   = function->call(environment);
+        if (!result) {
+            bailoutCount.fetch_add(1, std::memory_order_relaxed);
+            auto bailouts =
+                bailouts_.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (bailouts == MAX_BAILOUTS) {
+                // The code stays mapped until the node goes away, since
+                // another thread may still be running it.
+                state_.store(State::REJECTED, std::memory_order_relaxed);
+                deoptimizedCount.fetch_add(1, std::memory_order_relaxed);
+                Trace::emit(Trace::Event::JIT_DEOPT, bailouts);
+            }
+        }
+        return result;
+    }
+}  // namespace Jit
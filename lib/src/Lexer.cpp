@@ -1,17 +1,22 @@
 #include "Thor/Lexer.hpp"
 
+#include "Thor/Trace.hpp"
+
 #include <bit>
 #include <utility>
 
 namespace Thor {
 
-    Lexer::Lexer()
+    Lexer::Lexer() : Lexer(Runtime::Context::standard()) {}
+
+    Lexer::Lexer(Runtime::Context& context)
         : start_(0),
           current_(0),
           line_(1),
           column_(0),
           lineStart_(0),
-          logger_(Logger::getLogger()) {}
+          context_(context),
+          logger_(context.logger()) {}
 
     Lexer::~Lexer() {
         tokens_.clear();
@@ -27,16 +32,22 @@ namespace Thor {
 
         // Estimate: One token per ~4 characters is a common heuristic
         auto estCapacity = source_.size() / 4;
-        estCapacity      = 1U << (std::__bit_width(estCapacity) - 1);
+        if (estCapacity > 0) {
+            estCapacity = 1U << (std::__bit_width(estCapacity) - 1);
+        }
 
         if (tokens_.capacity() < estCapacity) {
             tokens_.reserve(estCapacity);
         }
         tokens_.clear();
+        Trace::emit(Trace::Event::LEX_BEGIN,
+                    static_cast<std::uint32_t>(source_.size()));
         while (!isAtEnd()) {
             auto token = scanToken();
             addToken(token);
         }
+        Trace::emit(Trace::Event::LEX_END,
+                    static_cast<std::uint32_t>(tokens_.size()));
         return tokens_;
     }
 
@@ -77,7 +88,14 @@ namespace Thor {
         auto token = Token::Token{
             type, text, literal, start_ - lineStart_, current_ - lineStart_,
             line_};
-        logger_.debug("Created: {}", token);
+        // Field by field rather than `{}` with the token, so an asynchronous
+        // logger copies the pieces instead of formatting on this thread.
+        logger_.debug(
+            "Created: Token({}, `{}`, {}, [line {}({}:{})])", type, text,
+            Logger::lazy([&token] { return token.literal.stringify(); }),
+            token.line, token.start, token.end);
+        Trace::emit(Trace::Event::TOKEN, static_cast<std::uint32_t>(type),
+                    (std::uint64_t{token.line} << 32U) | token.start);
         return token;
     }
 
@@ -85,7 +103,8 @@ namespace Thor {
     auto Lexer::errorToken(fmt::format_string<Args...> fmt,
                            Args&&... args) const -> Token::Token {
         auto message = fmt::format(fmt, std::forward<Args>(args)...);
-        logger_.error(message);
+        logger_.error("{}", message);
+        Trace::emitText(Trace::Event::LEX_ERROR, message);
         return makeToken(Token::Type::ERROR, message);
     }
 
@@ -125,7 +144,8 @@ namespace Thor {
         for (auto it = newLines.rbegin(); it != newLines.rend(); ++it) {
             value.erase(*it - 1, 1);
         }
-        return makeToken(Token::Type::STRING, value);
+        return makeToken(Token::Type::STRING,
+                         context_.interner().intern(value));
     }
 
     auto Lexer::getNumberLiteral() -> Token::Token {
@@ -142,7 +162,7 @@ namespace Thor {
             }
         }
         double number =
-            std::stod(std::string(source_.substr(start_, current_)));
+            std::stod(std::string(source_.substr(start_, current_ - start_)));
         return makeToken(Token::Type::NUMBER, number);
     }
 
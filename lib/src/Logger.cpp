@@ -0,0 +1,347 @@
+#include "Thor/Logger.hpp"
+
+#include <time.h>
+
+#include <algorithm>
+#include <array>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Logger {
+
+    namespace {
+        std::atomic<std::uint64_t> nextLoggerId{1};
+
+        // Loggers with a running backend, drained by the crash handler. A
+        // fixed table of atomics so the handler never takes a lock.
+        constexpr std::size_t                         MAX_LOGGERS = 64;
+        std::array<std::atomic<Logger*>, MAX_LOGGERS> liveLoggers{};
+
+        constexpr std::array CRASH_SIGNALS = {SIGSEGV, SIGABRT, SIGFPE,
+                                              SIGBUS, SIGILL};
+
+        // How long a crash waits for the backends to drain, in 1 ms naps.
+        constexpr int CRASH_WAIT_MS = 200;
+
+        // The rings this thread logs into, by logger id. They are retired
+        // when it exits, so their loggers free them once drained; a logger
+        // destroyed first has freed them already.
+        struct ThreadRings {
+            std::vector<std::pair<std::uint64_t, std::weak_ptr<detail::Ring>>>
+                rings;
+
+            ~ThreadRings();
+        };
+
+        // Trivially destructible, so still usable while the thread exits.
+        thread_local std::uint64_t cachedOwner = 0;
+        thread_local detail::Ring* cachedRing  = nullptr;
+        thread_local bool          exited      = false;
+
+        ThreadRings::~ThreadRings() {
+            exited      = true;
+            cachedOwner = 0;
+            for (auto& [owner, ring] : rings) {
+                if (auto live = ring.lock()) {
+                    live->retire();
+                }
+            }
+        }
+
+        auto threadRings() -> ThreadRings& {
+            thread_local ThreadRings rings;
+            return rings;
+        }
+
+        void registerLogger(Logger* logger) {
+            for (auto& slot : liveLoggers) {
+                Logger* empty = nullptr;
+                if (slot.compare_exchange_strong(empty, logger)) {
+                    return;
+                }
+            }
+        }
+
+        void unregisterLogger(Logger* logger) {
+            for (auto& slot : liveLoggers) {
+                Logger* expected = logger;
+                slot.compare_exchange_strong(expected, nullptr);
+            }
+        }
+    }  // namespace
+
+    Logger::Logger() : id_(nextLoggerId.fetch_add(1)) {}
+
+    Logger::~Logger() {
+        if (started_.load()) {
+            {
+                std::lock_guard lock(backendMutex_);
+                stopping_ = true;
+            }
+            backendWake_.notify_one();
+            backend_.join();
+            unregisterLogger(this);
+        }
+    }
+
+    void Logger::setLogFile(const std::string& filename) {
+        flush();
+        std::lock_guard lock(fileMutex_);
+        if (logFile_.is_open()) {
+            logFile_.close();
+        }
+        logFile_.open(filename, std::ios::app);
+    }
+
+    void Logger::setSink(Sink sink) {
+        flush();
+        std::lock_guard lock(fileMutex_);
+        sink_ = std::move(sink);
+    }
+
+    void Logger::setMode(Mode mode) {
+        if (mode_ == Mode::ASYNC && mode == Mode::SYNC) {
+            flush();
+        }
+        mode_ = mode;
+    }
+
+    void Logger::setRingCapacity(std::size_t bytes) {
+        std::size_t capacity = 256;
+        while (capacity < bytes) {
+            capacity <<= 1U;
+        }
+        ringCapacity_ = capacity;
+    }
+
+    void Logger::flush() {
+        if (!started_.load()) {
+            std::lock_guard lock(fileMutex_);
+            std::fflush(stdout);
+            logFile_.flush();
+            return;
+        }
+        if (std::this_thread::get_id() == backend_.get_id()) {
+            return;
+        }
+        std::unique_lock lock(backendMutex_);
+        if (stopping_) {
+            return;
+        }
+        auto ticket = ++flushRequested_;
+        backendWake_.notify_one();
+        flushed_.wait(lock, [&] { return flushCompleted_ >= ticket; });
+    }
+
+    auto Logger::ringCount() -> std::size_t {
+        std::lock_guard lock(ringsMutex_);
+        return rings_.size();
+    }
+
+    auto Logger::threadRing() -> detail::Ring* {
+        // Cached per thread; keyed by id rather than address so a logger
+        // created where a destroyed one lived never sees its stale ring.
+        if (cachedOwner == id_) {
+            return cachedRing;
+        }
+        if (exited) {
+            return nullptr;
+        }
+        if (!started_.load(std::memory_order_acquire)) {
+            startBackend();
+        }
+
+        auto& owned = threadRings().rings;
+        owned.erase(std::remove_if(owned.begin(), owned.end(),
+                                   [](const auto& entry) {
+                                       return entry.second.expired();
+                                   }),
+                    owned.end());
+        std::shared_ptr<detail::Ring> ring;
+        for (const auto& [owner, weak] : owned) {
+            if (owner == id_) {
+                ring = weak.lock();
+            }
+        }
+        if (!ring) {
+            ring = std::make_shared<detail::Ring>(ringCapacity_);
+            owned.emplace_back(id_, ring);
+            std::lock_guard lock(ringsMutex_);
+            rings_.push_back(ring);
+        }
+        cachedOwner = id_;
+        cachedRing  = ring.get();
+        return cachedRing;
+    }
+
+    void Logger::startBackend() {
+        std::lock_guard lock(backendMutex_);
+        if (started_.load()) {
+            return;
+        }
+        static std::once_flag handlersInstalled;
+        std::call_once(handlersInstalled, [] {
+            for (auto signal : CRASH_SIGNALS) {
+                std::signal(signal, &Logger::flushOnCrash);
+            }
+        });
+        backend_ = std::thread([this] { backendLoop(); });
+        registerLogger(this);
+        started_.store(true, std::memory_order_release);
+    }
+
+    // Runs on the crashing thread, which may hold any of the loggers'
+    // locks or be halfway through a record, so it takes no lock and
+    // allocates nothing: the backends wake on their own every few
+    // milliseconds, and it waits a bounded time for each to finish a pass
+    // begun after the crash before dying of the signal.
+    void Logger::flushOnCrash(int signal) {
+        std::array<std::uint64_t, MAX_LOGGERS> passes{};
+        for (std::size_t i = 0; i < MAX_LOGGERS; ++i) {
+            if (auto* live = liveLoggers[i].load()) {
+                passes[i] = live->drains_.load() + 2;
+            }
+        }
+        for (int waited = 0; waited < CRASH_WAIT_MS; ++waited) {
+            auto drained = true;
+            for (std::size_t i = 0; i < MAX_LOGGERS; ++i) {
+                auto* live = liveLoggers[i].load();
+                drained &= live == nullptr || live->drains_.load() >= passes[i];
+            }
+            if (drained) {
+                break;
+            }
+            timespec nap{0, 1'000'000};
+            nanosleep(&nap, nullptr);
+        }
+        std::signal(signal, SIG_DFL);
+        std::raise(signal);
+    }
+
+    void Logger::wakeBackend() {
+        backendWake_.notify_one();
+    }
+
+    void Logger::backendLoop() {
+        std::unique_lock lock(backendMutex_);
+        while (true) {
+            auto ticket   = flushRequested_;
+            auto stopping = stopping_;
+            lock.unlock();
+
+            // Keep draining until the rings stay empty, so a flush covers
+            // everything committed before it was requested.
+            auto wrote = false;
+            while (drain()) {
+                wrote = true;
+            }
+
+            lock.lock();
+            flushCompleted_ = ticket;
+            flushed_.notify_all();
+            if (stopping) {
+                return;
+            }
+            if (!wrote && flushRequested_ == ticket && !stopping_) {
+                backendWake_.wait_for(lock, std::chrono::milliseconds(5));
+            }
+        }
+    }
+
+    auto Logger::drain() -> bool {
+        // Rings retired before they are consumed are empty after it.
+        std::vector<std::pair<std::shared_ptr<detail::Ring>, bool>> rings;
+        {
+            std::lock_guard lock(ringsMutex_);
+            rings.reserve(rings_.size());
+            for (const auto& ring : rings_) {
+                rings.emplace_back(ring, ring->retired());
+            }
+        }
+
+        fmt::memory_buffer console;
+        fmt::memory_buffer file;
+        fmt::memory_buffer message;
+        auto               any = false;
+        auto retired = false;
+        for (const auto& [ring, done] : rings) {
+            retired |= done;
+            any |= ring->consume([&](const detail::RecordHeader& header,
+                                     const std::byte*            args) {
+                message.clear();
+                header.decode(args, {header.format, header.formatSize},
+                              message);
+                appendLine(header.level, header.timestamp,
+                           {message.data(), message.size()}, console, file);
+            });
+        }
+
+        auto dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != droppedReported_) {
+            auto text = fmt::format("{} log messages dropped",
+                                    dropped - droppedReported_);
+            droppedReported_ = dropped;
+            appendLine(LogLevel::WARN,
+                       std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count(),
+                       text, console, file);
+        }
+
+        if (console.size() > 0) {
+            writeLines(console, file);
+        }
+        if (retired) {
+            std::lock_guard lock(ringsMutex_);
+            for (const auto& [ring, done] : rings) {
+                if (done) {
+                    rings_.erase(
+                        std::find(rings_.begin(), rings_.end(), ring));
+                }
+            }
+        }
+        drains_.fetch_add(1);
+        return any;
+    }
+
+    void Logger::writeNow(LogLevel level, std::int64_t timestamp,
+                          std::string_view message) {
+        fmt::memory_buffer console;
+        fmt::memory_buffer file;
+        appendLine(level, timestamp, message, console, file);
+        writeLines(console, file);
+    }
+
+    void Logger::writeLines(const fmt::memory_buffer& console,
+                            const fmt::memory_buffer& file) {
+        std::lock_guard lock(fileMutex_);
+        if (sink_) {
+            sink_({file.data(), file.size()});
+        } else {
+            std::fwrite(console.data(), 1, console.size(), stdout);
+            std::fflush(stdout);
+        }
+        if (logFile_.is_open()) {
+            logFile_.write(file.data(),
+                           static_cast<std::streamsize>(file.size()));
+            logFile_.flush();
+        }
+    }
+
+    void Logger::appendLine(LogLevel level, std::int64_t timestamp,
+                            std::string_view    message,
+                            fmt::memory_buffer& console,
+                            fmt::memory_buffer& file) {
+        auto seconds = static_cast<std::time_t>(timestamp / 1'000'000'000);
+        auto start   = file.size();
+        fmt::format_to(std::back_inserter(file), "[{}] [{}] {}\n",
+                       getLevelString(level), seconds, message);
+        fmt::format_to(std::back_inserter(console), fg(getLevelColor(level)),
+                       "{}", std::string_view(file.data() + start,
+                                              file.size() - start - 1));
+        console.push_back('\n');
+    }
+}  // namespace Logger
@@ -0,0 +1,171 @@
+#include "Thor/Object.hpp"
+
+#include "Thor/Tokens.hpp"
+
+#include <mutex>
+#include <utility>
+
+namespace Runtime {
+
+    namespace {
+        std::mutex                 transitions;
+        std::atomic<std::uint64_t> missed{0};
+    }  // namespace
+
+    auto Shape::empty() -> const std::shared_ptr<const Shape>& {
+        static const std::shared_ptr<const Shape> shape = root();
+        return shape;
+    }
+
+    auto Shape::dictionary() -> const std::shared_ptr<const Shape>& {
+        static const std::shared_ptr<const Shape> shape = root();
+        return shape;
+    }
+
+    auto Shape::root() -> std::shared_ptr<const Shape> {
+        return std::make_shared<Shape>();
+    }
+
+    auto Shape::find(std::string_view name) const -> std::uint32_t {
+        if (names_.size() > LINEAR) {
+            const auto* found = index_.find(name);
+            return found != nullptr ? *found : NONE;
+        }
+        for (std::uint32_t slot = 0; slot < names_.size(); ++slot) {
+            if (names_[slot] == name) {
+                return slot;
+            }
+        }
+        return NONE;
+    }
+
+    auto Shape::with(const std::string& name) const
+        -> std::shared_ptr<const Shape> {
+        std::lock_guard lock(transitions);
+        auto& known = transitions_[name];
+        if (auto child = known.lock()) {
+            return child;
+        }
+        auto child    = std::make_shared<Shape>();
+        child->names_ = names_;
+        child->names_.push_back(name);
+        if (child->names_.size() > LINEAR) {
+            for (std::uint32_t slot = 0; slot < child->names_.size(); ++slot) {
+                child->index_.tryEmplace(child->names_[slot], slot);
+            }
+        }
+        known = child;
+        return child;
+    }
+
+    Class::Class(std::string name, const Class* superclass,
+                 std::vector<std::pair<std::string, Function>> methods) {
+        auto data   = std::make_shared<Data>();
+        data->name  = std::move(name);
+        data->shape = Shape::root();
+        if (superclass != nullptr) {
+            data->methods = superclass->data_->methods;
+            data->index   = superclass->data_->index;
+        }
+        for (auto& [method, function] : methods) {
+            auto [found, added] = data->index.tryEmplace(
+                std::move(method),
+                static_cast<std::uint32_t>(data->methods.size()));
+            if (added) {
+                data->methods.push_back(std::move(function));
+            } else {
+                data->methods[*found] = std::move(function);
+            }
+        }
+        data->initializer = *data->index.find(std::string_view("init"));
+        data_             = std::move(data);
+    }
+
+    auto Class::find(std::string_view name) const -> std::uint32_t {
+        const auto* found = data_->index.find(name);
+        return found != nullptr ? *found : NONE;
+    }
+
+    void Class::widen(std::uint32_t fields) const {
+        auto width = data_->width.load(std::memory_order_relaxed);
+        while (width < fields &&
+               !data_->width.compare_exchange_weak(
+                   width, fields, std::memory_order_relaxed)) {
+        }
+    }
+
+    void Object::Data::trace(Tracer& tracer) const {
+        for (const auto& field : fields) {
+            tracer.visit(field);
+        }
+        if (dictionary != nullptr) {
+            for (const auto& entry : *dictionary) {
+                tracer.visit(entry.value);
+            }
+        }
+    }
+
+    void Object::Data::clear() {
+        fields = {};
+        dictionary.reset();
+    }
+
+    auto Object::Data::bytes() const -> std::size_t {
+        auto size = sizeof(Data) + fields.capacity() * sizeof(Token::Literal);
+        if (dictionary != nullptr) {
+            size += dictionary->size() * sizeof(Dictionary::Entry);
+        }
+        return size;
+    }
+
+    Object::Object(std::shared_ptr<const Shape> shape, const Class* klass)
+        : data_(std::make_shared<Data>()) {
+        data_->fields.resize(shape->size());
+        data_->shape = std::move(shape);
+        if (klass != nullptr) {
+            data_->klass = *klass;
+            data_->fields.reserve(klass->width());
+        }
+    }
+
+    void Object::reshape(std::shared_ptr<const Shape> shape,
+                         Token::Literal              value) const {
+        data_->fields.push_back(std::move(value));
+        data_->shape = std::move(shape);
+        if (data_->klass.data_ != nullptr) {
+            data_->klass.widen(data_->shape->size());
+        }
+    }
+
+    void Object::makeDictionary() const {
+        auto        dictionary = std::make_unique<Dictionary>();
+        const auto& names      = data_->shape->names();
+        dictionary->reserve(names.size() + 1);
+        for (std::size_t slot = 0; slot < names.size(); ++slot) {
+            dictionary->tryEmplace(Symbol::intern(names[slot]),
+                                   std::move(data_->fields[slot]));
+        }
+        data_->fields.clear();
+        data_->shape      = Shape::dictionary();
+        data_->dictionary = std::move(dictionary);
+    }
+
+    void InlineCache::add(const Shape& shape, Entry entry) const {
+        auto way = used_.fetch_add(1, std::memory_order_relaxed);
+        if (way >= WAYS) {
+            used_.store(WAYS, std::memory_order_relaxed);
+            return;
+        }
+        ways_[way].entry = std::move(entry);
+        ways_[way].keep  = shape.shared_from_this();
+        ways_[way].key.store(&shape, std::memory_order_release);
+    }
+
+    auto InlineCache::misses() -> std::uint64_t {
+        return missed.load(std::memory_order_relaxed);
+    }
+
+    void InlineCache::miss() {
+        missed.fetch_add(1, std::memory_order_relaxed);
+    }
+}  // namespace Runtime
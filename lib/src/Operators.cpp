@@ -0,0 +1,244 @@
+#include "Thor/Operators.hpp"
+
+#include "Thor/Exceptions.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace Operators {
+
+    namespace {
+
+        using Token::Literal;
+        using LiteralVal = Literal::LiteralVal;
+
+        template <typename T>
+        constexpr bool IS_NUMBER = std::is_same_v<T, double>;
+
+        template <typename T>
+        constexpr bool IS_STRING = std::is_same_v<T, Runtime::String>;
+
+        template <typename T>
+        constexpr bool IS_ARRAY = std::is_same_v<T, Runtime::Array>;
+
+        // `+ - * /` element by element: an array with an array or a number.
+        template <typename L, typename R>
+        constexpr bool ELEMENTWISE = (IS_ARRAY<L> && (IS_ARRAY<R> ||
+                                                      IS_NUMBER<R>)) ||
+                                     (IS_NUMBER<L> && IS_ARRAY<R>);
+
+        // Unchecked access: the table only routes matching types here.
+        template <typename T>
+        auto get(const Literal& literal) -> const T& {
+            return *std::get_if<T>(&literal.value);
+        }
+
+        template <typename T>
+        auto truthy(const T& val) -> bool {
+            if constexpr (std::is_same_v<T, std::nullptr_t>) {
+                return false;
+            } else if constexpr (std::is_same_v<T, bool>) {
+                return val;
+            } else if constexpr (IS_NUMBER<T>) {
+                return val != 0.0;
+            } else if constexpr (std::is_same_v<T, Runtime::Function> ||
+                                 std::is_same_v<T, Runtime::Cell> ||
+                                 std::is_same_v<T, Runtime::Object> ||
+                                 std::is_same_v<T, Runtime::Class> ||
+                                 std::is_same_v<T, Runtime::Array> ||
+                                 std::is_same_v<T, Runtime::Method>) {
+                return true;
+            } else {
+                return !val.empty();
+            }
+        }
+
+        // Whether `Op` has a kernel for the (L, R) operand types. Every
+        // other combination is routed to `typeError`.
+        template <BinaryOp Op, typename L, typename R>
+        constexpr auto supports() -> bool {
+            switch (Op) {
+                case BinaryOp::LOGICAL_OR:
+                case BinaryOp::LOGICAL_AND:
+                case BinaryOp::EQUAL_EQUAL:
+                case BinaryOp::BANG_EQUAL:
+                    return true;
+                case BinaryOp::GREATER:
+                case BinaryOp::GREATER_EQUAL:
+                case BinaryOp::LESS:
+                case BinaryOp::LESS_EQUAL:
+                    return (IS_NUMBER<L> && IS_NUMBER<R>) ||
+                           (IS_STRING<L> && IS_STRING<R>);
+                case BinaryOp::PLUS:
+                    return (IS_NUMBER<L> && IS_NUMBER<R>) || IS_STRING<L> ||
+                           IS_STRING<R> || ELEMENTWISE<L, R>;
+                case BinaryOp::MINUS:
+                case BinaryOp::STAR:
+                case BinaryOp::SLASH:
+                    return (IS_NUMBER<L> && IS_NUMBER<R>) || ELEMENTWISE<L, R>;
+                default:
+                    return IS_NUMBER<L> && IS_NUMBER<R>;
+            }
+        }
+
+        template <BinaryOp Op, typename L, typename R>
+        auto binaryKernel(const Literal& left, const Literal& right,
+                          const Token::Token& op) -> Literal {
+            if constexpr (Op == BinaryOp::LOGICAL_OR) {
+                return Literal{truthy(get<L>(left)) || truthy(get<R>(right))};
+            } else if constexpr (Op == BinaryOp::LOGICAL_AND) {
+                return Literal{truthy(get<L>(left)) && truthy(get<R>(right))};
+            } else if constexpr (Op == BinaryOp::EQUAL_EQUAL ||
+                                 Op == BinaryOp::BANG_EQUAL) {
+                bool equal = false;
+                if constexpr (std::is_same_v<L, R>) {
+                    equal = get<L>(left) == get<R>(right);
+                }
+                return Literal{Op == BinaryOp::EQUAL_EQUAL ? equal : !equal};
+            } else if constexpr (Op == BinaryOp::GREATER) {
+                return Literal{get<L>(left) > get<R>(right)};
+            } else if constexpr (Op == BinaryOp::GREATER_EQUAL) {
+                return Literal{get<L>(left) >= get<R>(right)};
+            } else if constexpr (Op == BinaryOp::LESS) {
+                return Literal{get<L>(left) < get<R>(right)};
+            } else if constexpr (Op == BinaryOp::LESS_EQUAL) {
+                return Literal{get<L>(left) <= get<R>(right)};
+            } else if constexpr (ELEMENTWISE<L, R> &&
+                                 (Op == BinaryOp::PLUS ||
+                                  Op == BinaryOp::MINUS ||
+                                  Op == BinaryOp::STAR ||
+                                  Op == BinaryOp::SLASH)) {
+                return Literal{Runtime::Array::arith(left, right, op)};
+            } else if constexpr (Op == BinaryOp::PLUS) {
+                if constexpr (IS_NUMBER<L> && IS_NUMBER<R>) {
+                    return Literal{get<L>(left) + get<R>(right)};
+                } else if constexpr (IS_STRING<L> && IS_STRING<R>) {
+                    return Literal{get<L>(left) + get<R>(right)};
+                } else if constexpr (IS_STRING<L>) {
+                    return Literal{get<L>(left) +
+                                   Runtime::String(right.stringify())};
+                } else {
+                    return Literal{Runtime::String(left.stringify()) +
+                                   get<R>(right)};
+                }
+            } else if constexpr (Op == BinaryOp::MINUS) {
+                return Literal{get<L>(left) - get<R>(right)};
+            } else if constexpr (Op == BinaryOp::STAR) {
+                return Literal{get<L>(left) * get<R>(right)};
+            } else if constexpr (Op == BinaryOp::SLASH) {
+                return Literal{get<L>(left) / get<R>(right)};
+            } else if constexpr (Op == BinaryOp::STAR_STAR) {
+                return Literal{std::pow(get<L>(left), get<R>(right))};
+            } else if constexpr (Op == BinaryOp::PERCENT) {
+                // Takes the sign of the dividend, as `%` on integers does,
+                // though a zero is never negative.
+                if (get<R>(right) == 0) {
+                    throw Error::RuntimeException(op, "Division by zero");
+                }
+                auto rest = std::fmod(get<L>(left), get<R>(right));
+                return Literal{rest == 0 ? 0.0 : rest};
+            } else {
+                auto [l, r] =
+                    validateAndGetInts(get<L>(left), get<R>(right), op);
+                if constexpr (Op == BinaryOp::BIT_OR) {
+                    return Literal{static_cast<double>(l | r)};
+                } else if constexpr (Op == BinaryOp::BIT_XOR) {
+                    return Literal{static_cast<double>(l ^ r)};
+                } else if constexpr (Op == BinaryOp::BIT_AND) {
+                    return Literal{static_cast<double>(l & r)};
+                } else {
+                    if (r > 31) {
+                        throw Error::RuntimeException(
+                            op, "Shift count must be less than 32");
+                    }
+                    // 32 bits wide, wrapping as the JIT's shifts do.
+                    if constexpr (Op == BinaryOp::LEFT_SHIFT) {
+                        return Literal{static_cast<double>(
+                            static_cast<std::int32_t>(
+                                static_cast<std::uint32_t>(l) << r))};
+                    } else {
+                        static_assert(Op == BinaryOp::RIGHT_SHIFT);
+                        return Literal{static_cast<double>(l >> r)};
+                    }
+                }
+            }
+        }
+
+        // Shared kernel for every invalid operator/type combination.
+        auto typeError(const Literal& /*left*/, const Literal& /*right*/,
+                       const Token::Token& op) -> Literal {
+            throw Error::RuntimeException(
+                op, op.type == Token::Type::PLUS
+                        ? "operator can't work on these types"
+                        : "operator can't work on this type");
+        }
+
+        template <BinaryOp Op, std::size_t L, std::size_t R>
+        constexpr auto selectKernel() -> Kernel {
+            using LeftT  = std::variant_alternative_t<L, LiteralVal>;
+            using RightT = std::variant_alternative_t<R, LiteralVal>;
+            if constexpr (supports<Op, LeftT, RightT>()) {
+                return &binaryKernel<Op, LeftT, RightT>;
+            } else {
+                return &typeError;
+            }
+        }
+
+        template <BinaryOp Op, std::size_t L, std::size_t... R>
+        constexpr auto makeRow(std::index_sequence<R...> /*unused*/)
+            -> std::array<Kernel, TYPE_COUNT> {
+            return {{selectKernel<Op, L, R>()...}};
+        }
+
+        template <BinaryOp Op, std::size_t... L>
+        constexpr auto makePlane(std::index_sequence<L...> /*unused*/)
+            -> std::array<std::array<Kernel, TYPE_COUNT>, TYPE_COUNT> {
+            return {
+                {makeRow<Op, L>(std::make_index_sequence<TYPE_COUNT>{})...}};
+        }
+
+        template <std::size_t... Op>
+        constexpr auto makeTable(std::index_sequence<Op...> /*unused*/)
+            -> KernelTable {
+            return {{makePlane<static_cast<BinaryOp>(Op)>(
+                std::make_index_sequence<TYPE_COUNT>{})...}};
+        }
+
+        constexpr KernelTable TABLE =
+            makeTable(std::make_index_sequence<OP_COUNT>{});
+    }  // namespace
+
+    const KernelTable KERNELS = TABLE;
+
+    auto isTruthy(const Token::Literal& literal) -> bool {
+        return std::visit([](const auto& val) { return truthy(val); },
+                          literal.value);
+    }
+
+    auto isEqual(const Token::Literal& left, const Token::Literal& right)
+        -> bool {
+        if (left.isNil() && right.isNil()) {
+            return true;
+        }
+        if (left.isNil() || right.isNil()) {
+            return false;
+        }
+        return left.value == right.value;
+    }
+
+    auto validateAndGetInts(double left, double right, const Token::Token& op)
+        -> std::pair<int, int> {
+        // Checked before the casts, which are undefined outside int.
+        auto fits = [](double value) {
+            return value >= 0 && value <= std::numeric_limits<int>::max() &&
+                   std::floor(value) == value;
+        };
+        if (!fits(left) || !fits(right)) {
+            throw Error::RuntimeException(
+                op, "Operands must be non-negative integers");
+        }
+        return {static_cast<int>(left), static_cast<int>(right)};
+    }
+}  // namespace Operators
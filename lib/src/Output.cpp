@@ -0,0 +1,128 @@
+#include "Thor/Output.hpp"
+
+#include "Thor/Logger.hpp"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+namespace Output {
+
+    Writer::Writer() : Writer(-1) {}
+
+    Writer::Writer(int fd)
+        : fd_(fd),
+          terminal_(fd >= 0 && isatty(fd) != 0),
+          buffer_(std::make_unique<char[]>(BUFFER_SIZE)) {}
+
+    Writer::~Writer() {
+        flush();
+    }
+
+    auto Writer::standard() -> Writer& {
+        static Writer writer(STDOUT_FILENO);
+        return writer;
+    }
+
+    void Writer::setUnbuffered(bool unbuffered) {
+        flush();
+        unbuffered_ = unbuffered;
+    }
+
+    void Writer::write(std::string_view text) {
+        if (unbuffered_ && fd_ >= 0) {
+            fmt::print("{}", text);
+            return;
+        }
+        auto* out = reserve(text.size());
+        if (out == nullptr) {
+            writeOut(text.data(), text.size());
+            return;
+        }
+        std::memcpy(out, text.data(), text.size());
+        size_ += text.size();
+    }
+
+    void Writer::write(const Token::Literal& value) {
+        if ((unbuffered_ && fd_ >= 0) || value.isString()) {
+            write(value.isString() ? value.asString().view()
+                                   : std::string_view(value.stringify()));
+            return;
+        }
+        auto* out = reserve(Token::formattedSizeBound(value));
+        if (out == nullptr) {
+            auto text = value.stringify();
+            writeOut(text.data(), text.size());
+            return;
+        }
+        size_ = Token::formatTo(out, value) - buffer_.get();
+    }
+
+    void Writer::writeLine(const Token::Literal& value) {
+        if (unbuffered_ && fd_ >= 0) {
+            fmt::print("{}\n", value.stringify());
+            return;
+        }
+        write(value);
+        *reserve(1) = '\n';
+        size_ += 1;
+        if (terminal_) {
+            flush();
+        }
+    }
+
+    void Writer::flush() {
+        if (size_ == 0) {
+            return;
+        }
+        writeOut(buffer_.get(), size_);
+        size_ = 0;
+    }
+
+    auto Writer::captured() -> const std::string& {
+        flush();
+        return captured_;
+    }
+
+    auto Writer::takeCaptured() -> std::string {
+        flush();
+        return std::exchange(captured_, {});
+    }
+
+    auto Writer::reserve(std::size_t size) -> char* {
+        if (size_ + size > BUFFER_SIZE) {
+            flush();
+        }
+        if (size > BUFFER_SIZE) {
+            return nullptr;
+        }
+        return buffer_.get() + size_;
+    }
+
+    void Writer::writeOut(const char* data, std::size_t size) {
+        if (fd_ < 0) {
+            captured_.append(data, size);
+            return;
+        }
+        // Keep log lines that are still queued (in the logger's rings or in
+        // stdio) in front of the script's output.
+        if (fd_ == STDOUT_FILENO) {
+            Logger::getLogger().flush();
+            std::fflush(stdout);
+        }
+        while (size > 0) {
+            auto written = ::write(fd_, data, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+    }
+}  // namespace Output
@@ -1,20 +1,73 @@
 #include "Thor/Parser.hpp"
 
+#include "Thor/Operators.hpp"
 #include "Thor/TokenType.hpp"
+#include "Thor/Trace.hpp"
 
+#include <optional>
 #include <utility>
 
 namespace Parser {
 
+    namespace {
+        // Most parameters a function, and arguments a call, may have.
+        constexpr std::size_t MAX_ARGUMENTS = 255;
+
+        // Evaluates `expr` if it only depends on literals. Returns nothing for
+        // anything that has to wait for run time, including operations that
+        // would raise an error, so the error is still reported when reached.
+        auto foldConstant(const Expr::Expr& expr)
+            -> std::optional<Token::Literal> {
+            if (expr->is<Expr::LiteralExpr>()) {
+                return expr->as<Expr::LiteralExpr>().literal;
+            }
+            if (expr->is<Expr::GroupExpr>()) {
+                return foldConstant(expr->as<Expr::GroupExpr>().expr);
+            }
+            if (expr->is<Expr::InfixExpr>()) {
+                const auto& infix = expr->as<Expr::InfixExpr>();
+                auto        left  = foldConstant(infix.left);
+                auto        right = foldConstant(infix.right);
+                if (!left || !right) {
+                    return std::nullopt;
+                }
+                try {
+                    return Operators::apply(infix.operator_, *left, *right);
+                } catch (Error::RuntimeException&) {
+                    return std::nullopt;
+                }
+            }
+            return std::nullopt;
+        }
+    }  // namespace
+
+    template <typename Node, typename Made, typename... Args>
+    auto Parser::make(const Resolved& resolved, Args&&... args)
+        -> std::shared_ptr<Made> {
+        auto node = std::make_shared<Made>(Node{
+            std::forward<Args>(args)..., resolved.slot, resolved.storage});
+        if (resolved.owner != Resolved::NONE) {
+            functions_[resolved.owner].locals[resolved.local].uses.push_back(
+                {node, &node->template as<Node>().storage});
+        }
+        return node;
+    }
+
     auto Parser::parse(std::vector<Token::Token>& tokens)
         -> std::vector<Stmt::Stmt> {
         tokens_  = tokens;
         current_ = 0;
         std::vector<Stmt::Stmt> statments;
 
+        Trace::emit(Trace::Event::PARSE_BEGIN,
+                    static_cast<std::uint32_t>(tokens_.size()));
         while (!isAtEnd()) {
-            statments.push_back(declartion());
+            if (auto stmt = declartion()) {
+                statments.push_back(std::move(stmt));
+            }
         }
+        Trace::emit(Trace::Event::PARSE_END,
+                    static_cast<std::uint32_t>(statments.size()));
         return statments;
     }
 
@@ -23,10 +76,17 @@ namespace Parser {
             if (match({Token::Type::VAR, Token::Type::VAL})) {
                 return varDeclartion(previous());
             }
+            if (match({Token::Type::FUNCTION})) {
+                return functionDeclaration();
+            }
+            if (match({Token::Type::CLASS})) {
+                return classDeclaration();
+            }
             return statement();
         } catch (Error::ParseException& e) {
             synchronize();
-            Logger::getLogger().error(e.what());
+            context_.logger().error("{}", e.what());
+            Trace::emitText(Trace::Event::PARSE_ERROR, e.what());
         }
         return {};
     }
@@ -39,16 +99,465 @@ namespace Parser {
             initializer = expression();
         }
         consume(Token::Type::SEMICOLON, "Expect ';' after variable declartion");
-        return Stmt::makeStmt(Stmt::Variable{name, initializer, type});
+        return make<Stmt::Variable, Stmt::StmtBase>(declare(name), name,
+                                                    initializer, type);
+    }
+
+    auto Parser::functionDeclaration() -> Stmt::Stmt {
+        auto name = consume(Token::Type::IDENTIFIER, "Expect function name.");
+        // Before the body, so that the body can call it.
+        auto declared = declare(name);
+        consume(Token::Type::LEFT_PAREN, "Expect '(' after function name.");
+        return make<Stmt::Function, Stmt::StmtBase>(
+            declared, definition(std::move(name), false));
+    }
+
+    auto Parser::definition(Token::Token name, bool method)
+        -> std::shared_ptr<const Stmt::Definition> {
+        functions_.emplace_back();
+        if (method) {
+            // Slot 0. Methods have no name to call themselves by.
+            (void)declare(Token::Token(Token::Type::THIS, "this", nullptr,
+                                       name.start, name.end, name.line));
+            functions_.back().initializer = name.type == Token::Type::INIT;
+        } else {
+            functions_.back().name = name.lexeme;
+        }
+        auto outerLoops = loopDepth_;
+        auto outerTries = tryDepth_;
+        loopDepth_      = 0;
+        tryDepth_       = 0;
+        try {
+            std::vector<Token::Token> params;
+            if (!checkType(Token::Type::RIGHT_PAREN)) {
+                do {
+                    if (params.size() == MAX_ARGUMENTS) {
+                        throw error(peek(),
+                                    "Can't have more than 255 parameters.");
+                    }
+                    auto param = consume(Token::Type::IDENTIFIER,
+                                         "Expect parameter name.");
+                    if (functions_.back().slots.count(param.lexeme) != 0) {
+                        throw error(param,
+                                    "Already a parameter with this name.");
+                    }
+                    (void)declare(param);
+                    params.push_back(std::move(param));
+                } while (match({Token::Type::COMMA}));
+            }
+            consume(Token::Type::RIGHT_PAREN, "Expect ')' after parameters.");
+            consume(Token::Type::LEFT_BRACE,
+                    "Expect '{' before function body.");
+            auto body  = block();
+            auto scope = std::move(functions_.back());
+            functions_.pop_back();
+            loopDepth_ = outerLoops;
+            tryDepth_  = outerTries;
+
+            // Its locals are all known now, and so is which need a cell.
+            std::vector<std::uint32_t> cells;
+            for (std::uint32_t slot = 0; slot < scope.locals.size(); ++slot) {
+                const auto& local = scope.locals[slot];
+                if (!local.captured || !local.assigned) {
+                    continue;
+                }
+                cells.push_back(slot);
+                for (const auto& use : local.uses) {
+                    *use.storage = *use.storage == Expr::Storage::CAPTURE
+                                       ? Expr::Storage::CAPTURED_CELL
+                                       : Expr::Storage::CELL;
+                }
+            }
+            return std::make_shared<const Stmt::Definition>(
+                std::move(name), std::move(params), std::move(body),
+                static_cast<std::uint32_t>(scope.slots.size()), definitions_++,
+                std::move(scope.captures), std::move(cells), method);
+        } catch (...) {
+            functions_.pop_back();
+            loopDepth_ = outerLoops;
+            tryDepth_  = outerTries;
+            throw;
+        }
+    }
+
+    // `class Name : Super { methods }`. With a superclass, the class goes
+    // in a block after the variable `super Name` that holds it, which no
+    // program can name.
+    auto Parser::classDeclaration() -> Stmt::Stmt {
+        auto name     = consume(Token::Type::IDENTIFIER, "Expect class name.");
+        auto declared = declare(name);
+        // Its methods close over the name before the class is stored in
+        // it, as if it were assigned.
+        if (declared.owner != Resolved::NONE) {
+            functions_[declared.owner].locals[declared.local].assigned = true;
+        }
+
+        Stmt::Stmt hidden;
+        Expr::Expr superclass;
+        if (match({Token::Type::COLON})) {
+            auto parent =
+                consume(Token::Type::IDENTIFIER, "Expect superclass name.");
+            if (parent.lexeme == name.lexeme) {
+                throw error(parent, "A class can't inherit from itself.");
+            }
+            auto variable   = parent;
+            variable.lexeme = "super " + name.lexeme;
+            auto read = make<Expr::Variable, Expr::ExprBase>(resolve(parent),
+                                                             parent);
+            hidden    = make<Stmt::Variable, Stmt::StmtBase>(
+                declare(variable), variable, std::move(read),
+                Token::Token(Token::Type::VAL, "val", nullptr, parent.start,
+                             parent.end, parent.line));
+            superclass = make<Expr::Variable, Expr::ExprBase>(
+                resolve(variable), variable);
+        }
+        consume(Token::Type::LEFT_BRACE, "Expect '{' before class body.");
+
+        std::vector<std::shared_ptr<const Stmt::Definition>> methods;
+        classes_.push_back({name.lexeme, superclass != nullptr});
+        try {
+            auto initializer = false;
+            while (!checkType(Token::Type::RIGHT_BRACE) && !isAtEnd()) {
+                (void)match({Token::Type::FUNCTION});
+                if (!match({Token::Type::IDENTIFIER, Token::Type::INIT})) {
+                    throw error(peek(), "Expect method name.");
+                }
+                auto method = previous();
+                consume(Token::Type::LEFT_PAREN,
+                        "Expect '(' after method name.");
+                initializer = initializer || method.type == Token::Type::INIT;
+                methods.push_back(definition(std::move(method), true));
+            }
+            consume(Token::Type::RIGHT_BRACE, "Expect '}' after class body.");
+            classes_.pop_back();
+            if (!initializer && superclass == nullptr) {
+                methods.push_back(std::make_shared<const Stmt::Definition>(
+                    Token::Token(Token::Type::INIT, "init", nullptr,
+                                 name.start, name.end, name.line),
+                    std::vector<Token::Token>{}, std::vector<Stmt::Stmt>{}, 1,
+                    definitions_++, std::vector<Stmt::Capture>{},
+                    std::vector<std::uint32_t>{}, true));
+            }
+        } catch (...) {
+            classes_.pop_back();
+            throw;
+        }
+
+        auto klass = make<Stmt::Class, Stmt::StmtBase>(
+            declared, std::move(name), std::move(superclass),
+            std::move(methods));
+        if (hidden == nullptr) {
+            return klass;
+        }
+        return Stmt::makeStmt(
+            Stmt::Block{{std::move(hidden), std::move(klass)}});
+    }
+
+    auto Parser::declare(const Token::Token& name) -> Resolved {
+        if (functions_.empty()) {
+            return {globals_->slotFor(name.lexeme), Expr::Storage::GLOBAL};
+        }
+        auto& scope            = functions_.back();
+        auto [found, inserted] = scope.slots.try_emplace(
+            name.lexeme, static_cast<std::uint32_t>(scope.slots.size()));
+        if (inserted) {
+            scope.locals.emplace_back();
+        }
+        return {found->second, Expr::Storage::LOCAL, functions_.size() - 1,
+                found->second};
+    }
+
+    auto Parser::resolve(const Token::Token& name, bool assign) -> Resolved {
+        // The innermost function that declares `name`, or whose own name
+        // it is; the outermost function's name is a global.
+        auto depth = functions_.size();
+        auto self  = false;
+        while (depth-- > 0) {
+            const auto& scope = functions_[depth];
+            if (scope.slots.count(name.lexeme) != 0) {
+                break;
+            }
+            if (!assign && depth > 0 && scope.name == name.lexeme) {
+                self = true;
+                break;
+            }
+        }
+        if (depth == Resolved::NONE) {
+            return {globals_->slotFor(name.lexeme), Expr::Storage::GLOBAL};
+        }
+
+        Resolved resolved{0, Expr::Storage::SELF};
+        Stmt::Capture from{Stmt::Capture::From::SELF, 0};
+        if (!self) {
+            auto  slot     = functions_[depth].slots.at(name.lexeme);
+            auto& local    = functions_[depth].locals[slot];
+            local.assigned = local.assigned || assign;
+            local.captured = local.captured || depth + 1 < functions_.size();
+            resolved       = {slot, Expr::Storage::LOCAL, depth, slot};
+            from           = {Stmt::Capture::From::LOCAL, slot};
+        }
+        // Each function in between passes it on from its own captures.
+        for (auto inner = depth + 1; inner < functions_.size(); ++inner) {
+            resolved.slot    = capture(functions_[inner], name.lexeme, from);
+            resolved.storage = Expr::Storage::CAPTURE;
+            from = {Stmt::Capture::From::CAPTURE, resolved.slot};
+        }
+        return resolved;
+    }
+
+    auto Parser::capture(Scope& scope, const std::string& name,
+                         Stmt::Capture from) -> std::uint32_t {
+        auto [found, inserted] = scope.captured.try_emplace(
+            name, static_cast<std::uint32_t>(scope.captures.size()));
+        if (inserted) {
+            scope.captures.push_back(from);
+        }
+        return found->second;
     }
 
     auto Parser::statement() -> Stmt::Stmt {
         if (match({Token::Type::PRINT})) {
             return printStatement();
         }
+        if (match({Token::Type::LEFT_BRACE})) {
+            return Stmt::makeStmt(Stmt::Block{block()});
+        }
+        if (match({Token::Type::IF})) {
+            return ifStatement();
+        }
+        if (match({Token::Type::SWITCH})) {
+            return switchStatement();
+        }
+        if (match({Token::Type::WHILE})) {
+            return whileStatement();
+        }
+        if (match({Token::Type::FOR})) {
+            return forStatement();
+        }
+        if (match({Token::Type::RETURN})) {
+            return returnStatement();
+        }
+        if (match({Token::Type::TRY})) {
+            return tryStatement();
+        }
+        if (match({Token::Type::THROW})) {
+            auto keyword = previous();
+            auto value   = expression();
+            consume(Token::Type::SEMICOLON, "Expect ';' after thrown value.");
+            return Stmt::makeStmt(Stmt::Throw{keyword, std::move(value)});
+        }
+        if (match({Token::Type::BREAK, Token::Type::CONTINUE})) {
+            auto keyword = previous();
+            if (loopDepth_ == 0) {
+                throw error(keyword, "Can't be used outside of a loop.");
+            }
+            consume(Token::Type::SEMICOLON,
+                    "Expect ';' after '" + keyword.lexeme + "'.");
+            if (keyword.type == Token::Type::BREAK) {
+                return Stmt::makeStmt(Stmt::Break{keyword});
+            }
+            return Stmt::makeStmt(Stmt::Continue{keyword});
+        }
         return expressionStatement();
     }
 
+    auto Parser::block() -> std::vector<Stmt::Stmt> {
+        std::vector<Stmt::Stmt> statements;
+        while (!checkType(Token::Type::RIGHT_BRACE) && !isAtEnd()) {
+            if (auto stmt = declartion()) {
+                statements.push_back(std::move(stmt));
+            }
+        }
+        consume(Token::Type::RIGHT_BRACE, "Expect '}' after block.");
+        return statements;
+    }
+
+    auto Parser::ifStatement() -> Stmt::Stmt {
+        consume(Token::Type::LEFT_PAREN, "Expect '(' after 'if'.");
+        auto condition = expression();
+        consume(Token::Type::RIGHT_PAREN, "Expect ')' after if condition.");
+        auto       thenBranch = statement();
+        Stmt::Stmt elseBranch;
+        if (match({Token::Type::ELSE})) {
+            elseBranch = statement();
+        }
+        return Stmt::makeStmt(Stmt::If{std::move(condition),
+                                       std::move(thenBranch),
+                                       std::move(elseBranch)});
+    }
+
+    // Labels that fold to a number or a string are replaced by it, for the
+    // switch to look up rather than compare.
+    auto Parser::switchStatement() -> Stmt::Stmt {
+        auto keyword = previous();
+        consume(Token::Type::LEFT_PAREN, "Expect '(' after 'switch'.");
+        auto subject = expression();
+        consume(Token::Type::RIGHT_PAREN, "Expect ')' after switch subject.");
+        consume(Token::Type::LEFT_BRACE, "Expect '{' before switch cases.");
+        std::vector<Stmt::Switch::Case> cases;
+        Stmt::Stmt                      otherwise;
+        while (!checkType(Token::Type::RIGHT_BRACE) && !isAtEnd()) {
+            if (otherwise != nullptr) {
+                throw error(peek(), "Expect '}' after the 'else' case.");
+            }
+            if (match({Token::Type::ELSE})) {
+                consume(Token::Type::COLON, "Expect ':' after 'else'.");
+                otherwise = caseBody();
+                continue;
+            }
+            consume(Token::Type::CASE, "Expect 'case' or 'else' in switch.");
+            std::vector<Expr::Expr> labels;
+            do {
+                auto label    = expression();
+                auto constant = foldConstant(label);
+                if (constant && (constant->is<double>() ||
+                                 constant->is<Runtime::String>())) {
+                    label = Expr::makeExpr(Expr::LiteralExpr(*constant));
+                }
+                labels.push_back(std::move(label));
+            } while (match({Token::Type::COMMA}));
+            consume(Token::Type::COLON, "Expect ':' after case labels.");
+            cases.push_back({std::move(labels), caseBody()});
+        }
+        consume(Token::Type::RIGHT_BRACE, "Expect '}' after switch cases.");
+        return Stmt::makeStmt(Stmt::Switch{std::move(keyword),
+                                           std::move(subject),
+                                           std::move(cases),
+                                           std::move(otherwise)});
+    }
+
+    // The statements of a case, up to the next case, `else` or the end of
+    // the switch. No statement starts with `else`: an `if` takes its own.
+    auto Parser::caseBody() -> Stmt::Stmt {
+        std::vector<Stmt::Stmt> statements;
+        while (!checkType(Token::Type::CASE) &&
+               !checkType(Token::Type::ELSE) &&
+               !checkType(Token::Type::RIGHT_BRACE) && !isAtEnd()) {
+            if (auto stmt = declartion()) {
+                statements.push_back(std::move(stmt));
+            }
+        }
+        return Stmt::makeStmt(Stmt::Block{std::move(statements)});
+    }
+
+    auto Parser::whileStatement() -> Stmt::Stmt {
+        consume(Token::Type::LEFT_PAREN, "Expect '(' after 'while'.");
+        auto condition = expression();
+        consume(Token::Type::RIGHT_PAREN, "Expect ')' after condition.");
+        auto id = loops_++;
+        return Stmt::makeStmt(
+            Stmt::While{std::move(condition), loopBody(), nullptr, id});
+    }
+
+    // `for (init; condition; increment) body` becomes the initializer
+    // followed by a While, in a block.
+    auto Parser::forStatement() -> Stmt::Stmt {
+        consume(Token::Type::LEFT_PAREN, "Expect '(' after 'for'.");
+        Stmt::Stmt initializer;
+        if (match({Token::Type::VAR, Token::Type::VAL})) {
+            initializer = varDeclartion(previous());
+        } else if (!match({Token::Type::SEMICOLON})) {
+            initializer = expressionStatement();
+        }
+
+        Expr::Expr condition = checkType(Token::Type::SEMICOLON)
+                                   ? Expr::makeExpr(Expr::LiteralExpr(true))
+                                   : expression();
+        consume(Token::Type::SEMICOLON, "Expect ';' after loop condition.");
+
+        Expr::Expr increment;
+        if (!checkType(Token::Type::RIGHT_PAREN)) {
+            increment = expression();
+        }
+        consume(Token::Type::RIGHT_PAREN, "Expect ')' after for clauses.");
+
+        auto id   = loops_++;
+        auto loop = Stmt::makeStmt(Stmt::While{
+            std::move(condition), loopBody(), std::move(increment), id});
+        std::vector<Stmt::Stmt> statements;
+        if (initializer) {
+            statements.push_back(std::move(initializer));
+        }
+        statements.push_back(std::move(loop));
+        return Stmt::makeStmt(Stmt::Block{std::move(statements)});
+    }
+
+    auto Parser::loopBody() -> Stmt::Stmt {
+        ++loopDepth_;
+        try {
+            auto body = statement();
+            --loopDepth_;
+            return body;
+        } catch (...) {
+            --loopDepth_;
+            throw;
+        }
+    }
+
+    // `try { ... }`, then `catch (name) { ... }`, `finally { ... }` or
+    // both. The name is a variable of the enclosing function, as any other
+    // declared in a block.
+    auto Parser::tryStatement() -> Stmt::Stmt {
+        auto keyword = previous();
+        ++tryDepth_;
+        try {
+            consume(Token::Type::LEFT_BRACE, "Expect '{' after 'try'.");
+            auto       body = Stmt::makeStmt(Stmt::Block{block()});
+            Stmt::Stmt caught;
+            Stmt::Stmt handler;
+            Stmt::Stmt cleanup;
+            if (match({Token::Type::CATCH})) {
+                consume(Token::Type::LEFT_PAREN, "Expect '(' after 'catch'.");
+                auto name = consume(Token::Type::IDENTIFIER,
+                                    "Expect name of the caught value.");
+                consume(Token::Type::RIGHT_PAREN,
+                        "Expect ')' after caught value.");
+                caught = make<Stmt::Variable, Stmt::StmtBase>(
+                    declare(name), name, nullptr,
+                    Token::Token(Token::Type::VAR, "var", nullptr, name.start,
+                                 name.end, name.line));
+                consume(Token::Type::LEFT_BRACE, "Expect '{' after catch.");
+                handler = Stmt::makeStmt(Stmt::Block{block()});
+            }
+            if (match({Token::Type::FINALLY})) {
+                consume(Token::Type::LEFT_BRACE, "Expect '{' after 'finally'.");
+                cleanup = Stmt::makeStmt(Stmt::Block{block()});
+            }
+            if (handler == nullptr && cleanup == nullptr) {
+                throw error(peek(), "Expect 'catch' or 'finally' after try.");
+            }
+            --tryDepth_;
+            return Stmt::makeStmt(Stmt::Try{keyword, std::move(body),
+                                            std::move(caught),
+                                            std::move(handler),
+                                            std::move(cleanup)});
+        } catch (...) {
+            --tryDepth_;
+            throw;
+        }
+    }
+
+    // A call returned as it is, `return f(x);`, is a tail call, unless a
+    // try is around it: the call has to run before the try is left.
+    auto Parser::returnStatement() -> Stmt::Stmt {
+        auto keyword = previous();
+        if (functions_.empty()) {
+            throw error(keyword, "Can't return from top-level code.");
+        }
+        Expr::Expr value;
+        if (!checkType(Token::Type::SEMICOLON)) {
+            if (functions_.back().initializer) {
+                throw error(keyword,
+                            "Can't return a value from an initializer.");
+            }
+            value = expression();
+        }
+        consume(Token::Type::SEMICOLON, "Expect ';' after return value.");
+        auto tail = value != nullptr && value->is<Expr::CallExpr>() &&
+                    tryDepth_ == 0;
+        return Stmt::makeStmt(Stmt::Return{keyword, std::move(value), tail});
+    }
+
     auto Parser::printStatement() -> Stmt::Stmt {
         auto value = expression();
         consume(Token::Type::SEMICOLON, "Expect ';' after value");
@@ -62,7 +571,68 @@ namespace Parser {
     }
 
     auto Parser::expression() -> Expr::Expr {
-        return ternaryOperator();
+        return assignment();
+    }
+
+    // Right-associative, below every operator: `a = b = c + 1`.
+    auto Parser::assignment() -> Expr::Expr {
+        auto target = ternaryOperator();
+        if (!match({Token::Type::EQUAL, Token::Type::PLUS_EQUAL,
+                    Token::Type::MINUS_EQUAL, Token::Type::STAR_EQUAL,
+                    Token::Type::SLASH_EQUAL})) {
+            return target;
+        }
+        auto equals = previous();
+        auto value  = assignment();
+
+        // `a += b` is `a = a + b`, with the operator at the `+=`.
+        std::optional<Token::Token> op;
+        switch (equals.type) {
+            case Token::Type::PLUS_EQUAL:
+                op = equals;
+                op->type = Token::Type::PLUS;
+                break;
+            case Token::Type::MINUS_EQUAL:
+                op = equals;
+                op->type = Token::Type::MINUS;
+                break;
+            case Token::Type::STAR_EQUAL:
+                op = equals;
+                op->type = Token::Type::STAR;
+                break;
+            case Token::Type::SLASH_EQUAL:
+                op = equals;
+                op->type = Token::Type::SLASH;
+                break;
+            default:
+                break;
+        }
+        if (op) {
+            op->lexeme = equals.lexeme.substr(0, 1);
+        }
+
+        if (target->is<Expr::GetExpr>()) {
+            const auto& get = target->as<Expr::GetExpr>();
+            return Expr::makeExpr(Expr::SetExpr(get.object, get.name,
+                                                std::move(value), op));
+        }
+        if (target->is<Expr::IndexExpr>()) {
+            const auto& index = target->as<Expr::IndexExpr>();
+            return Expr::makeExpr(Expr::IndexSetExpr(
+                index.object, index.bracket, index.index, std::move(value),
+                op));
+        }
+        if (!target->is<Expr::Variable>() ||
+            target->as<Expr::Variable>().name.type == Token::Type::THIS) {
+            throw error(equals, "Invalid assignment target.");
+        }
+        const auto& variable = target->as<Expr::Variable>();
+        if (op) {
+            value = Expr::makeExpr(
+                Expr::InfixExpr(target, std::move(*op), std::move(value)));
+        }
+        return make<Expr::AssignExpr, Expr::ExprBase>(
+            resolve(variable.name, true), variable.name, std::move(value));
     }
 
     auto Parser::parsePrecedence(uint8_t minPrec) -> Expr::Expr {
@@ -150,6 +720,9 @@ namespace Parser {
             case Token::Type::IDENTIFIER:
                 return parseVariable();
 
+            case Token::Type::DOLLAR:
+                return templateString();
+
             case Token::Type::LEFT_PAREN: {
                 Expr::Expr expr = parsePrecedence(0);  // or lowest
 
@@ -265,6 +838,25 @@ namespace Parser {
 
     auto Parser::postfix() -> Expr::Expr {
         auto expr = primary();
+        for (;;) {
+            if (match({Token::Type::LEFT_PAREN})) {
+                expr = call(std::move(expr));
+            } else if (match({Token::Type::DOT})) {
+                if (!match({Token::Type::IDENTIFIER, Token::Type::INIT})) {
+                    throw error(peek(), "Expect property name after '.'.");
+                }
+                expr = Expr::makeExpr(
+                    Expr::GetExpr(std::move(expr), previous()));
+            } else if (match({Token::Type::LEFT_BRACKET})) {
+                auto index   = expression();
+                auto bracket = consume(Token::Type::RIGHT_BRACKET,
+                                       "Expect ']' after index.");
+                expr         = Expr::makeExpr(Expr::IndexExpr(
+                    std::move(expr), std::move(bracket), std::move(index)));
+            } else {
+                break;
+            }
+        }
 
         if (match({Token::Type::PLUS_PLUS, Token::Type::MINUS_MINUS})) {
             auto operator_ = previous();
@@ -292,9 +884,209 @@ namespace Parser {
         if (match({Token::Type::IDENTIFIER})) {
             return parseVariable();
         }
+        if (match({Token::Type::DOLLAR})) {
+            return templateString();
+        }
+        if (match({Token::Type::THIS})) {
+            return self();
+        }
+        if (match({Token::Type::SUPER})) {
+            return super();
+        }
+        if (match({Token::Type::LEFT_BRACE})) {
+            return object();
+        }
+        if (match({Token::Type::LEFT_BRACKET})) {
+            return array();
+        }
         return group();
     }
 
+    // `{name: value, "name": value}`, with an optional trailing comma.
+    auto Parser::object() -> Expr::Expr {
+        auto                       brace = previous();
+        auto                       shape = Runtime::Shape::empty();
+        std::vector<Expr::Expr>    values;
+        std::vector<std::uint32_t> slots;
+        while (!checkType(Token::Type::RIGHT_BRACE)) {
+            if (!match({Token::Type::IDENTIFIER, Token::Type::STRING})) {
+                throw error(peek(), "Expect property name.");
+            }
+            auto key  = previous();
+            auto name = key.type == Token::Type::STRING
+                            ? key.literal.asString().str()
+                            : key.lexeme;
+            consume(Token::Type::COLON, "Expect ':' after property name.");
+            auto slot = shape->find(name);
+            if (slot == Runtime::Shape::NONE) {
+                slot  = shape->size();
+                shape = shape->with(name);
+            }
+            values.push_back(expression());
+            slots.push_back(slot);
+            if (!match({Token::Type::COMMA})) {
+                break;
+            }
+        }
+        consume(Token::Type::RIGHT_BRACE, "Expect '}' after object literal.");
+        return Expr::makeExpr(Expr::ObjectExpr(
+            std::move(brace), std::move(values), std::move(slots),
+            std::move(shape)));
+    }
+
+    // `[value, ...]`, with an optional trailing comma.
+    auto Parser::array() -> Expr::Expr {
+        auto                    bracket = previous();
+        std::vector<Expr::Expr> values;
+        while (!checkType(Token::Type::RIGHT_BRACKET)) {
+            values.push_back(expression());
+            if (!match({Token::Type::COMMA})) {
+                break;
+            }
+        }
+        consume(Token::Type::RIGHT_BRACKET, "Expect ']' after array elements.");
+        return Expr::makeExpr(
+            Expr::ArrayExpr(std::move(bracket), std::move(values)));
+    }
+
+    // `this` is the first local of the method it is in; functions nested
+    // in one capture it like any other local.
+    auto Parser::self() -> Expr::Expr {
+        auto keyword = previous();
+        auto inside  = std::any_of(
+            functions_.begin(), functions_.end(),
+            [](const Scope& scope) { return scope.slots.count("this") != 0; });
+        if (!inside) {
+            throw error(keyword, "Can't use 'this' outside of a class.");
+        }
+        return make<Expr::Variable, Expr::ExprBase>(resolve(keyword), keyword);
+    }
+
+    auto Parser::super() -> Expr::Expr {
+        auto keyword = previous();
+        if (classes_.empty()) {
+            throw error(keyword, "Can't use 'super' outside of a class.");
+        }
+        if (!classes_.back().inherits) {
+            throw error(keyword,
+                        "Can't use 'super' in a class with no superclass.");
+        }
+        consume(Token::Type::DOT, "Expect '.' after 'super'.");
+        if (!match({Token::Type::IDENTIFIER, Token::Type::INIT})) {
+            throw error(peek(), "Expect superclass method name.");
+        }
+        auto method = previous();
+
+        auto variable   = keyword;
+        variable.type   = Token::Type::IDENTIFIER;
+        variable.lexeme = "super " + classes_.back().name;
+        auto self       = keyword;
+        self.type       = Token::Type::THIS;
+        self.lexeme     = "this";
+        auto superclass =
+            make<Expr::Variable, Expr::ExprBase>(resolve(variable), variable);
+        auto receiver =
+            make<Expr::Variable, Expr::ExprBase>(resolve(self), self);
+        return Expr::makeExpr(Expr::SuperExpr(
+            std::move(keyword), std::move(method), std::move(superclass),
+            std::move(receiver)));
+    }
+
+    auto Parser::call(Expr::Expr callee) -> Expr::Expr {
+        std::vector<Expr::Expr> arguments;
+        if (!checkType(Token::Type::RIGHT_PAREN)) {
+            do {
+                if (arguments.size() == MAX_ARGUMENTS) {
+                    throw error(peek(), "Can't have more than 255 arguments.");
+                }
+                arguments.push_back(expression());
+            } while (match({Token::Type::COMMA}));
+        }
+        auto paren =
+            consume(Token::Type::RIGHT_PAREN, "Expect ')' after arguments.");
+        return Expr::makeExpr(Expr::CallExpr(
+            std::move(callee), std::move(paren), std::move(arguments)));
+    }
+
+    auto Parser::templateString() -> Expr::Expr {
+        auto token =
+            consume(Token::Type::STRING, "Expect string after '$'.");
+        auto text = token.literal.asString().str();
+
+        std::vector<std::string> segments(1);
+        std::vector<Expr::Expr>  holes;
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            char ch = text[i];
+            if ((ch == '{' || ch == '}') && i + 1 < text.size() &&
+                text[i + 1] == ch) {
+                segments.back() += ch;  // `{{` and `}}` are escapes
+                ++i;
+                continue;
+            }
+            if (ch == '}') {
+                throw error(token, "Unmatched '}' in template string.");
+            }
+            if (ch != '{') {
+                segments.back() += ch;
+                continue;
+            }
+
+            auto close = i + 1;
+            for (int depth = 1; close < text.size(); ++close) {
+                depth += text[close] == '{' ? 1 : 0;
+                depth -= text[close] == '}' ? 1 : 0;
+                if (depth == 0) {
+                    break;
+                }
+            }
+            if (close >= text.size()) {
+                throw error(token, "Unterminated '{' in template string.");
+            }
+            auto hole = templateHole(text.substr(i + 1, close - i - 1), token);
+            i         = close;
+
+            // Constant holes are formatted now and merged into the text.
+            if (auto constant = foldConstant(hole)) {
+                segments.back() += constant->stringify();
+                continue;
+            }
+            holes.push_back(std::move(hole));
+            segments.emplace_back();
+        }
+
+        if (holes.empty()) {
+            return Expr::makeExpr(Expr::LiteralExpr(
+                Token::Literal{std::move(segments.front())}));
+        }
+        return Expr::makeExpr(Expr::TemplateExpr(
+            std::move(token), std::move(segments), std::move(holes)));
+    }
+
+    auto Parser::templateHole(std::string source, const Token::Token& token)
+        -> Expr::Expr {
+        source.append("\n");
+        Thor::Lexer lexer(context_);
+        auto        tokens = lexer.tokenize(source);
+        for (auto& holeToken : tokens) {
+            holeToken.line = token.line;
+        }
+
+        Parser inner(context_, std::move(tokens));
+        inner.globals_   = globals_;
+        inner.functions_ = functions_;
+        inner.classes_   = classes_;
+        if (inner.isAtEnd()) {
+            throw error(token, "Expect expression inside '{}' of template.");
+        }
+        auto expr = inner.expression();
+        if (!inner.isAtEnd()) {
+            throw error(inner.peek(), "Expect '}' after template expression.");
+        }
+        // With what the hole captured and assigned.
+        functions_ = std::move(inner.functions_);
+        return expr;
+    }
+
     auto Parser::group() -> Expr::Expr {
         if (match({Token::Type::LEFT_PAREN})) {
             auto expr = expression();
@@ -305,7 +1097,9 @@ namespace Parser {
     }
 
     auto Parser::parseVariable() -> Expr::Expr {
-        return Expr::makeExpr(Expr::Variable(previous()));
+        auto name          = previous();
+        auto resolved = resolve(name);
+        return make<Expr::Variable, Expr::ExprBase>(resolved, std::move(name));
     }
 
     auto Parser::getRule(Token::Type type) -> ParseRule {
@@ -316,6 +1110,7 @@ namespace Parser {
             case Token::Type::TRUE:
             case Token::Type::FALSE:
             case Token::Type::NIL:
+            case Token::Type::DOLLAR:
             case Token::Type::LEFT_PAREN:
                 return {1, [this] { return parsePrimary(); }, nullptr};
             case Token::Type::PLUS_PLUS:
@@ -435,7 +1230,7 @@ namespace Parser {
                 case Token::Type::RETURN:
                     return;
                 default:
-                    continue;
+                    break;
             }
             advance();
         }
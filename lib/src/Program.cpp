@@ -0,0 +1,137 @@
+#include "Thor/Program.hpp"
+
+#include "Thor/Interpreter.hpp"
+#include "Thor/Lexer.hpp"
+#include "Thor/Parser.hpp"
+#include "Thor/Trace.hpp"
+
+#include <utility>
+
+namespace Thor {
+
+    namespace {
+        auto threadContext() -> Runtime::Context& {
+            thread_local Runtime::Context context;
+            return context;
+        }
+    }  // namespace
+
+    Inputs::Inputs(std::shared_ptr<const Interpreter::Globals> globals)
+        : globals_(std::move(globals)), values_(globals_->size()) {}
+
+    auto Inputs::set(std::string_view name, Token::Literal value) -> Inputs& {
+        if (auto slot = globals_->find(name)) {
+            values_[*slot] = std::move(value);
+        }
+        return *this;
+    }
+
+    auto Program::compile(std::string_view source, Engine engine)
+        -> Program {
+        return compile(threadContext(), source, engine);
+    }
+
+    auto Program::compile(Runtime::Context& context, std::string_view source,
+                          Engine engine) -> Program {
+        auto compiled    = std::make_shared<Compiled>();
+        compiled->engine = engine;
+        compiled->source = std::string(source);
+
+        Lexer          lexer(context);
+        Parser::Parser parser(context);
+        auto           tokens = lexer.tokenize(compiled->source);
+        compiled->statements  = parser.parse(tokens);
+        if (engine != Engine::TREE) {
+            Trace::emit(Trace::Event::ENGINE_COMPILE,
+                        static_cast<std::uint32_t>(compiled->statements.size()),
+                        static_cast<std::uint64_t>(engine));
+        }
+        switch (engine) {
+            case Engine::TREE:
+                break;
+            case Engine::CLOSURE:
+                compiled->closures = Closure::compile(compiled->statements);
+                break;
+            case Engine::TIERED:
+                compiled->plan =
+                    std::make_unique<Tiering::Plan>(compiled->statements);
+                break;
+            case Engine::VM:
+                compiled->registers =
+                    Vm::Program::compile(compiled->statements);
+                break;
+        }
+        compiled->globals     = parser.globals();
+        compiled->diagnostics = context.takeDiagnostics();
+        return Program(std::move(compiled));
+    }
+
+    auto Program::engine() const -> Engine {
+        return compiled_->engine;
+    }
+
+    auto Program::diagnostics() const -> const std::string& {
+        return compiled_->diagnostics;
+    }
+
+    auto Program::source() const -> const std::string& {
+        return compiled_->source;
+    }
+
+    auto Program::slot(std::string_view name) const
+        -> std::optional<std::size_t> {
+        return compiled_->globals->find(name);
+    }
+
+    auto Program::inputs() const -> Inputs {
+        return Inputs(compiled_->globals);
+    }
+
+    auto Program::tiers() const -> std::vector<Tiering::RegionReport> {
+        if (!compiled_->plan) {
+            return {};
+        }
+        return compiled_->plan->report();
+    }
+
+    auto Program::run(const Inputs& inputs) const -> Outputs {
+        return run(threadContext(), inputs);
+    }
+
+    auto Program::run(Runtime::Context& context, const Inputs& inputs) const
+        -> Outputs {
+        Outputs outputs;
+        auto&   arena = context.arena();
+        auto    mark  = arena.mark();
+        {
+            const auto&              values = inputs.values();
+            Interpreter::Interpreter interpreter(context, values.data(),
+                                                 values.size());
+            switch (compiled_->engine) {
+                case Engine::TREE:
+                    interpreter.walk(compiled_->statements);
+                    break;
+                case Engine::CLOSURE:
+                    interpreter.interpret(compiled_->closures);
+                    break;
+                case Engine::TIERED:
+                    interpreter.interpret(*compiled_->plan);
+                    break;
+                case Engine::VM:
+                    interpreter.interpret(compiled_->registers);
+                    break;
+            }
+
+            const auto& environment = interpreter.environment();
+            outputs.globals.reserve(environment.size());
+            for (std::uint32_t slot = 0; slot < environment.size(); ++slot) {
+                outputs.globals.push_back(environment.get(slot));
+            }
+        }
+        arena.rewind(mark);
+
+        outputs.output      = context.output().takeCaptured();
+        outputs.diagnostics = context.takeDiagnostics();
+        return outputs;
+    }
+}  // namespace Thor
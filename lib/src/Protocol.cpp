@@ -0,0 +1,241 @@
+#include "Thor/Protocol.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace Protocol {
+
+    namespace {
+        enum class Tag : std::uint8_t { NUMBER, STRING, BOOL, NIL };
+
+        void putU8(std::string& out, std::uint8_t value) {
+            out.push_back(static_cast<char>(value));
+        }
+
+        void putU32(std::string& out, std::uint32_t value) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                out.push_back(static_cast<char>((value >> shift) & 0xFFU));
+            }
+        }
+
+        void putString(std::string& out, std::string_view text) {
+            putU32(out, static_cast<std::uint32_t>(text.size()));
+            out.append(text);
+        }
+
+        void putLiteral(std::string& out, const Token::Literal& value) {
+            if (value.isNumber()) {
+                putU8(out, static_cast<std::uint8_t>(Tag::NUMBER));
+                auto number = value.asNumber();
+                char bytes[sizeof(double)];
+                std::memcpy(bytes, &number, sizeof(double));
+                out.append(bytes, sizeof(double));
+            } else if (value.isString()) {
+                putU8(out, static_cast<std::uint8_t>(Tag::STRING));
+                putString(out, value.asString().view());
+            } else if (value.isBool()) {
+                putU8(out, static_cast<std::uint8_t>(Tag::BOOL));
+                putU8(out, value.asBool() ? 1 : 0);
+            } else {
+                putU8(out, static_cast<std::uint8_t>(Tag::NIL));
+            }
+        }
+
+        // Reads fields off the front of a payload; any overrun sets
+        // `failed` and yields zero values from then on.
+        struct Reader {
+            std::string_view rest;
+            bool             failed = false;
+
+            auto take(std::size_t size) -> std::string_view {
+                if (failed || rest.size() < size) {
+                    failed = true;
+                    return {};
+                }
+                auto taken = rest.substr(0, size);
+                rest.remove_prefix(size);
+                return taken;
+            }
+
+            auto u8() -> std::uint8_t {
+                auto bytes = take(1);
+                return bytes.empty() ? 0 : static_cast<std::uint8_t>(bytes[0]);
+            }
+
+            auto u32() -> std::uint32_t {
+                auto          bytes = take(4);
+                std::uint32_t value = 0;
+                for (std::size_t i = 0; i < bytes.size(); ++i) {
+                    value |= static_cast<std::uint32_t>(
+                                 static_cast<unsigned char>(bytes[i]))
+                             << (8 * i);
+                }
+                return value;
+            }
+
+            auto string() -> std::string {
+                return std::string(take(u32()));
+            }
+
+            auto literal() -> Token::Literal {
+                switch (static_cast<Tag>(u8())) {
+                    case Tag::NUMBER: {
+                        auto   bytes  = take(sizeof(double));
+                        double number = 0;
+                        if (!bytes.empty()) {
+                            std::memcpy(&number, bytes.data(), sizeof(double));
+                        }
+                        return Token::Literal{number};
+                    }
+                    case Tag::STRING:
+                        return Token::Literal{string()};
+                    case Tag::BOOL:
+                        return Token::Literal{u8() != 0};
+                    case Tag::NIL:
+                        return Token::Literal{};
+                }
+                failed = true;
+                return {};
+            }
+
+            [[nodiscard]] auto complete() const -> bool {
+                return !failed && rest.empty();
+            }
+        };
+
+        auto writeAll(int fd, const char* data, std::size_t size) -> bool {
+            while (size > 0) {
+                auto written = ::send(fd, data, size, MSG_NOSIGNAL);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data += written;
+                size -= static_cast<std::size_t>(written);
+            }
+            return true;
+        }
+
+        auto readAll(int fd, char* data, std::size_t size) -> bool {
+            while (size > 0) {
+                auto got = ::read(fd, data, size);
+                if (got < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (got <= 0) {
+                    return false;
+                }
+                data += got;
+                size -= static_cast<std::size_t>(got);
+            }
+            return true;
+        }
+    }  // namespace
+
+    auto encode(const Request& request) -> std::string {
+        std::string out;
+        putU8(out, static_cast<std::uint8_t>(request.kind));
+        putString(out, request.text);
+        putU32(out, static_cast<std::uint32_t>(request.params.size()));
+        for (const auto& [name, value] : request.params) {
+            putString(out, name);
+            putLiteral(out, value);
+        }
+        return out;
+    }
+
+    auto encode(const Response& response) -> std::string {
+        std::string out;
+        putU8(out, response.ok ? 0 : 1);
+        putString(out, response.output);
+        putString(out, response.diagnostics);
+        return out;
+    }
+
+    auto decodeRequest(std::string_view payload) -> std::optional<Request> {
+        Reader  reader{payload};
+        Request request;
+        auto    kind = reader.u8();
+        if (kind > static_cast<std::uint8_t>(RequestKind::PATH)) {
+            return std::nullopt;
+        }
+        request.kind = static_cast<RequestKind>(kind);
+        request.text = reader.string();
+        auto count   = reader.u32();
+        for (std::uint32_t i = 0; i < count && !reader.failed; ++i) {
+            auto name = reader.string();
+            request.params.emplace_back(std::move(name), reader.literal());
+        }
+        if (!reader.complete()) {
+            return std::nullopt;
+        }
+        return request;
+    }
+
+    auto decodeResponse(std::string_view payload) -> std::optional<Response> {
+        Reader   reader{payload};
+        Response response;
+        response.ok          = reader.u8() == 0;
+        response.output      = reader.string();
+        response.diagnostics = reader.string();
+        if (!reader.complete()) {
+            return std::nullopt;
+        }
+        return response;
+    }
+
+    auto writeFrame(int fd, std::string_view payload) -> bool {
+        std::string frame;
+        frame.reserve(4 + payload.size());
+        putU32(frame, static_cast<std::uint32_t>(payload.size()));
+        frame.append(payload);
+        return writeAll(fd, frame.data(), frame.size());
+    }
+
+    auto readFrame(int fd, std::string& payload) -> bool {
+        char header[4];
+        if (!readAll(fd, header, sizeof(header))) {
+            return false;
+        }
+        auto size = Reader{std::string_view(header, sizeof(header))}.u32();
+        if (size > MAX_FRAME) {
+            return false;
+        }
+        payload.resize(size);
+        return readAll(fd, payload.data(), size);
+    }
+
+    auto connectTo(const std::string& path) -> int {
+        sockaddr_un address{};
+        if (path.size() >= sizeof(address.sun_path)) {
+            return -1;
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address),
+                      sizeof(address)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    auto call(int fd, const Request& request) -> std::optional<Response> {
+        std::string payload;
+        if (!writeFrame(fd, encode(request)) || !readFrame(fd, payload)) {
+            return std::nullopt;
+        }
+        return decodeResponse(payload);
+    }
+}  // namespace Protocol
@@ -0,0 +1,239 @@
+#include "Thor/Server.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace Runtime {
+
+    auto ProgramCache::hash(std::string_view source) -> std::uint64_t {
+        // FNV-1a
+        std::uint64_t hash = 14695981039346656037ULL;
+        for (char ch : source) {
+            hash ^= static_cast<unsigned char>(ch);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    auto ProgramCache::find(std::string_view source)
+        -> std::optional<Thor::Program> {
+        auto            key = hash(source);
+        std::lock_guard lock(mutex_);
+        auto            found = slots_.find(key);
+        // Comparing the source rules out hash collisions.
+        if (found == slots_.end() ||
+            found->second.program.source() != source) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+        ages_.splice(ages_.begin(), ages_, found->second.age);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return found->second.program;
+    }
+
+    void ProgramCache::insert(const Thor::Program& program) {
+        auto            key = hash(program.source());
+        std::lock_guard lock(mutex_);
+        auto            found = slots_.find(key);
+        if (found != slots_.end()) {
+            found->second.program = program;
+            ages_.splice(ages_.begin(), ages_, found->second.age);
+            return;
+        }
+        if (slots_.size() >= capacity_ && !ages_.empty()) {
+            slots_.erase(ages_.back());
+            ages_.pop_back();
+        }
+        ages_.push_front(key);
+        slots_.emplace(key, Slot{program, ages_.begin()});
+    }
+
+    Server::Server(Options options)
+        : options_(std::move(options)), cache_(options_.cacheCapacity) {
+        // A root that does not resolve stays empty and refuses every path.
+        if (!options_.scriptRoot.empty()) {
+            std::error_code error;
+            root_ = std::filesystem::canonical(options_.scriptRoot, error);
+        }
+        auto workers = std::max<std::size_t>(options_.workers, 1);
+        for (std::size_t i = 0; i < workers; ++i) {
+            contexts_.push_back(std::make_unique<Context>());
+            idle_.push_back(contexts_.back().get());
+        }
+    }
+
+    Server::~Server() {
+        stop();
+        reapConnections(true);
+        if (listenFd_ >= 0) {
+            ::close(listenFd_);
+            ::unlink(options_.socketPath.c_str());
+        }
+    }
+
+    auto Server::listen() -> bool {
+        sockaddr_un address{};
+        const auto& path = options_.socketPath;
+        if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+            return false;
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listenFd_ < 0) {
+            return false;
+        }
+        ::unlink(path.c_str());
+        return ::bind(listenFd_, reinterpret_cast<sockaddr*>(&address),
+                      sizeof(address)) == 0 &&
+               ::listen(listenFd_, SOMAXCONN) == 0;
+    }
+
+    void Server::serve() {
+        while (!stopping_.load()) {
+            int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;  // Shut down by stop(), or the socket failed
+            }
+            reapConnections(false);
+
+            std::lock_guard lock(connectionsMutex_);
+            auto& connection = *connections_.emplace_back(
+                std::make_unique<Connection>());
+            connection.fd     = fd;
+            connection.thread = std::thread(
+                [this, &connection] { serveConnection(connection); });
+        }
+        reapConnections(true);
+    }
+
+    void Server::stop() {
+        stopping_.store(true);
+        if (listenFd_ >= 0) {
+            ::shutdown(listenFd_, SHUT_RDWR);
+        }
+    }
+
+    void Server::serveConnection(Connection& connection) {
+        std::string payload;
+        while (Protocol::readFrame(connection.fd, payload)) {
+            Protocol::Response response;
+            if (auto request = Protocol::decodeRequest(payload)) {
+                response = handle(*request);
+            } else {
+                response.diagnostics = "Malformed request\n";
+            }
+            if (!Protocol::writeFrame(connection.fd,
+                                      Protocol::encode(response))) {
+                break;
+            }
+        }
+        connection.done.store(true);
+    }
+
+    void Server::reapConnections(bool all) {
+        std::lock_guard lock(connectionsMutex_);
+        for (auto it = connections_.begin(); it != connections_.end();) {
+            auto& connection = **it;
+            if (!all && !connection.done.load()) {
+                ++it;
+                continue;
+            }
+            // Unblocks a read still waiting on the client.
+            ::shutdown(connection.fd, SHUT_RDWR);
+            connection.thread.join();
+            ::close(connection.fd);
+            it = connections_.erase(it);
+        }
+    }
+
+    auto Server::acquireContext() -> Context& {
+        std::unique_lock lock(idleMutex_);
+        contextFreed_.wait(lock, [this] { return !idle_.empty(); });
+        auto* context = idle_.back();
+        idle_.pop_back();
+        return *context;
+    }
+
+    void Server::releaseContext(Context& context) {
+        {
+            std::lock_guard lock(idleMutex_);
+            idle_.push_back(&context);
+        }
+        contextFreed_.notify_one();
+    }
+
+    auto Server::readScript(const std::string& path) const -> std::string {
+        if (root_.empty()) {
+            throw std::runtime_error("Path requests are disabled: " + path);
+        }
+        // Relative paths are taken from the root; an absolute one replaces
+        // it, and must still resolve to somewhere under it.
+        std::error_code error;
+        auto            resolved =
+            std::filesystem::canonical(root_ / path, error);
+        if (error) {
+            throw std::runtime_error("Failed to open: " + path);
+        }
+        auto inside = std::mismatch(root_.begin(), root_.end(),
+                                    resolved.begin(), resolved.end())
+                          .first == root_.end();
+        if (!inside) {
+            throw std::runtime_error("Outside the script root: " + path);
+        }
+
+        std::ifstream file(resolved);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open: " + path);
+        }
+        std::stringstream text;
+        text << file.rdbuf();
+        return text.str();
+    }
+
+    auto Server::handle(const Protocol::Request& request)
+        -> Protocol::Response {
+        Protocol::Response response;
+
+        auto& context = acquireContext();
+        try {
+            auto source = request.kind == Protocol::RequestKind::PATH
+                              ? readScript(request.text)
+                              : request.text;
+
+            auto program = cache_.find(source);
+            if (!program) {
+                program =
+                    Thor::Program::compile(context, source, options_.engine);
+                cache_.insert(*program);
+            }
+
+            auto inputs = program->inputs();
+            for (const auto& [name, value] : request.params) {
+                inputs.set(name, value);
+            }
+            auto outputs         = program->run(context, inputs);
+            response.output      = std::move(outputs.output);
+            response.diagnostics = program->diagnostics() + outputs.diagnostics;
+        } catch (const std::exception& e) {
+            context.logger().error("{}", e.what());
+            context.output().takeCaptured();
+        }
+        response.diagnostics += context.takeDiagnostics();
+        response.ok = response.diagnostics.empty();
+        releaseContext(context);
+        return response;
+    }
+}  // namespace Runtime
@@ -0,0 +1,37 @@
+#include "Thor/Stack.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace Interpreter {
+
+    namespace {
+        constexpr std::size_t INITIAL_SLOTS = 256;
+    }  // namespace
+
+    void Stack::slide(std::size_t base, std::size_t size) {
+        auto from = top_ - size;
+        if (from != base) {
+            std::move(values_.begin() + static_cast<std::ptrdiff_t>(from),
+                      values_.begin() + static_cast<std::ptrdiff_t>(top_),
+                      values_.begin() + static_cast<std::ptrdiff_t>(base));
+        }
+        top_ = base + size;
+    }
+
+    void Stack::box(std::size_t                       base,
+                    const std::vector<std::uint32_t>& slots) {
+        for (auto slot : slots) {
+            auto& value = values_[base + slot];
+            value       = Token::Literal{Runtime::Cell{std::move(value)}};
+        }
+    }
+
+    void Stack::grow(std::size_t end, const Token::Token& call) {
+        if (end > limits_.slots) {
+            throw Error::RuntimeException(call, "Stack overflow.");
+        }
+        auto size = std::max(values_.size() * 2, INITIAL_SLOTS);
+        values_.resize(std::min(std::max(size, end), limits_.slots));
+    }
+}  // namespace Interpreter
@@ -0,0 +1,254 @@
+#include "Thor/String.hpp"
+
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace Runtime {
+
+    namespace {
+        // Concatenations up to this length are copied into a flat buffer;
+        // ropes only pay off once copying gets expensive.
+        constexpr std::size_t FLAT_LIMIT = 128;
+
+        // When appending to a rope whose right leaf is short, the leaf is
+        // merged with the new text instead of growing the rope by one node.
+        constexpr std::size_t LEAF_LIMIT = 512;
+    }  // namespace
+
+    struct String::Node {
+        std::atomic<std::uint32_t> refs{1};
+        bool                       rope;
+        std::size_t                size;
+
+        Node(bool rope, std::size_t size) : rope(rope), size(size) {}
+    };
+
+    struct String::FlatNode : Node {
+        explicit FlatNode(std::size_t size) : Node(false, size) {}
+
+        auto data() -> char* {
+            return reinterpret_cast<char*>(this + 1);
+        }
+    };
+
+    struct String::RopeNode : Node {
+        String            left;
+        String            right;
+        mutable FlatNode* flat = nullptr;
+
+        RopeNode(const String& left, const String& right)
+            : Node(true, left.size() + right.size()),
+              left(left),
+              right(right) {}
+    };
+
+    auto formatNumber(char* out, double number) -> char* {
+        return fmt::format_to_n(out, MAX_NUMBER_CHARS, "{}", number).out;
+    }
+
+    String::String(std::string_view text) : String() {
+        if (text.size() <= INLINE_CAPACITY) {
+            std::memcpy(small_, text.data(), text.size());
+            smallSize_ = static_cast<std::uint8_t>(text.size());
+            return;
+        }
+        auto* flat = makeFlat(text.size());
+        std::memcpy(flat->data(), text.data(), text.size());
+        node_      = flat;
+        smallSize_ = HEAP;
+    }
+
+    String::String(const String& other) noexcept
+        : small_{}, smallSize_(other.smallSize_) {
+        if (other.isInline()) {
+            std::memcpy(small_, other.small_, INLINE_CAPACITY);
+        } else {
+            node_ = other.node_;
+            retain(node_);
+        }
+    }
+
+    String::String(String&& other) noexcept
+        : small_{}, smallSize_(other.smallSize_) {
+        std::memcpy(small_, other.small_, INLINE_CAPACITY);
+        other.smallSize_ = 0;
+    }
+
+    auto String::operator=(const String& other) noexcept -> String& {
+        if (this != &other) {
+            String copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    auto String::operator=(String&& other) noexcept -> String& {
+        if (this != &other) {
+            release(detach());
+            std::memcpy(small_, other.small_, INLINE_CAPACITY);
+            smallSize_       = other.smallSize_;
+            other.smallSize_ = 0;
+        }
+        return *this;
+    }
+
+    String::~String() {
+        release(detach());
+    }
+
+    auto String::size() const noexcept -> std::size_t {
+        return isInline() ? smallSize_ : node_->size;
+    }
+
+    auto String::isRope() const noexcept -> bool {
+        return !isInline() && node_->rope;
+    }
+
+    auto String::view() const -> std::string_view {
+        if (isInline()) {
+            return {small_, smallSize_};
+        }
+        if (!node_->rope) {
+            auto* flat = static_cast<FlatNode*>(node_);
+            return {flat->data(), flat->size};
+        }
+        const auto& rope = *static_cast<RopeNode*>(node_);
+        if (rope.flat == nullptr) {
+            rope.flat = flatten(rope);
+        }
+        return {rope.flat->data(), rope.flat->size};
+    }
+
+    auto String::concat(const String& left, const String& right) -> String {
+        if (left.empty()) {
+            return right;
+        }
+        if (right.empty()) {
+            return left;
+        }
+
+        auto size = left.size() + right.size();
+        if (size <= FLAT_LIMIT) {
+            auto    lhs = left.view();
+            auto    rhs = right.view();
+            Builder joined(size);
+            std::memcpy(joined.data(), lhs.data(), lhs.size());
+            std::memcpy(joined.data() + lhs.size(), rhs.data(), rhs.size());
+            return joined.finish(size);
+        }
+
+        // Repeated `s = s + piece` keeps extending the rightmost leaf, so the
+        // rope grows by one node per LEAF_LIMIT characters, not per append.
+        if (left.isRope() && right.size() < LEAF_LIMIT) {
+            const auto& rope = *static_cast<RopeNode*>(left.node_);
+            if (rope.flat == nullptr &&
+                rope.right.size() + right.size() <= LEAF_LIMIT) {
+                auto* leaf = makeFlat(rope.right.size() + right.size());
+                auto  tail = rope.right.view();
+                auto  text = right.view();
+                std::memcpy(leaf->data(), tail.data(), tail.size());
+                std::memcpy(leaf->data() + tail.size(), text.data(),
+                            text.size());
+                String merged(leaf);
+                return String(new RopeNode(rope.left, merged));
+            }
+        }
+        return String(new RopeNode(left, right));
+    }
+
+    String::Builder::Builder(std::size_t capacity) : data_(result_.small_) {
+        if (capacity > INLINE_CAPACITY) {
+            auto* flat = makeFlat(capacity);
+            result_    = String(flat);
+            data_      = flat->data();
+        }
+    }
+
+    auto String::Builder::finish(std::size_t size) -> String {
+        if (result_.isInline()) {
+            result_.smallSize_ = static_cast<std::uint8_t>(size);
+        } else {
+            result_.node_->size = size;
+        }
+        return std::move(result_);
+    }
+
+    void String::retain(Node* node) noexcept {
+        node->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void String::release(Node* node) noexcept {
+        // Ropes can be arbitrarily deep, so nodes are freed from an explicit
+        // work list rather than by recursing through child destructors.
+        std::vector<Node*> pending;
+        while (node != nullptr) {
+            if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (node->rope) {
+                    auto* rope = static_cast<RopeNode*>(node);
+                    for (auto* child :
+                         {rope->left.detach(), rope->right.detach(),
+                          static_cast<Node*>(rope->flat)}) {
+                        if (child != nullptr) {
+                            pending.push_back(child);
+                        }
+                    }
+                    delete rope;
+                } else {
+                    auto* flat = static_cast<FlatNode*>(node);
+                    flat->~FlatNode();
+                    ::operator delete(flat);
+                }
+            }
+            if (pending.empty()) {
+                break;
+            }
+            node = pending.back();
+            pending.pop_back();
+        }
+    }
+
+    auto String::makeFlat(std::size_t size) -> FlatNode* {
+        void* memory = ::operator new(sizeof(FlatNode) + size);
+        return new (memory) FlatNode(size);
+    }
+
+    auto String::flatten(const RopeNode& rope) -> FlatNode* {
+        auto* flat = makeFlat(rope.size);
+        char* out  = flat->data();
+
+        std::vector<const String*> stack{&rope.right, &rope.left};
+        while (!stack.empty()) {
+            const auto* part = stack.back();
+            stack.pop_back();
+            if (part->isRope()) {
+                const auto& child = *static_cast<RopeNode*>(part->node_);
+                if (child.flat == nullptr) {
+                    stack.push_back(&child.right);
+                    stack.push_back(&child.left);
+                    continue;
+                }
+            }
+            auto text = part->view();
+            std::memcpy(out, text.data(), text.size());
+            out += text.size();
+        }
+
+        // The flat copy replaces the children; dropping them here frees the
+        // rope's leaves unless another string still shares them.
+        auto& owner = const_cast<RopeNode&>(rope);
+        release(owner.left.detach());
+        release(owner.right.detach());
+        return flat;
+    }
+
+    auto String::detach() noexcept -> Node* {
+        if (isInline()) {
+            smallSize_ = 0;
+            return nullptr;
+        }
+        auto* node = node_;
+        smallSize_ = 0;
+        return node;
+    }
+}  // namespace Runtime
@@ -0,0 +1,56 @@
+#include "Thor/Symbol.hpp"
+
+#include "Thor/Arena.hpp"
+#include "Thor/HashMap.hpp"
+
+#include <mutex>
+#include <new>
+
+namespace Runtime {
+
+    namespace {
+
+        // Texts and records live in an arena that is never rewound, so a
+        // symbol's pointer and text stay valid for good.
+        template <typename Record>
+        struct Table {
+            using Map =
+                HashMap<std::string_view, const Record*, TextHash, TextEqual>;
+
+            std::mutex lock;
+            Arena      arena;
+            Map        map;
+        };
+
+        // Never destroyed, as symbols may be used by other statics' ends.
+        template <typename Record>
+        auto table() -> Table<Record>& {
+            static auto* const instance = new Table<Record>();
+            return *instance;
+        }
+    }  // namespace
+
+    auto Symbol::intern(std::string_view text) -> Symbol {
+        auto&           symbols = table<Record>();
+        std::lock_guard guard(symbols.lock);
+        if (const auto* found = symbols.map.find(text)) {
+            return Symbol(*found);
+        }
+        auto  copy   = symbols.arena.copy(text);
+        auto* record = new (symbols.arena.allocate(sizeof(Record),
+                                                   alignof(Record)))
+            Record{copy, TextHash{}(copy),
+                   static_cast<std::uint32_t>(symbols.map.size())};
+        symbols.map.tryEmplace(copy, record);
+        return Symbol(record);
+    }
+
+    auto Symbol::find(std::string_view text) -> std::optional<Symbol> {
+        auto&           symbols = table<Record>();
+        std::lock_guard guard(symbols.lock);
+        if (const auto* found = symbols.map.find(text)) {
+            return Symbol(*found);
+        }
+        return std::nullopt;
+    }
+}  // namespace Runtime
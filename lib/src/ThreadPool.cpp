@@ -0,0 +1,104 @@
+#include "Thor/ThreadPool.hpp"
+
+#include <algorithm>
+
+namespace Runtime {
+
+    namespace {
+        // Lets `submit` called from inside a task find the worker's deque.
+        thread_local const ThreadPool* currentPool  = nullptr;
+        thread_local std::size_t       currentIndex = 0;
+    }  // namespace
+
+    ThreadPool::ThreadPool(std::size_t workers) {
+        workers = std::max<std::size_t>(workers, 1);
+        queues_.reserve(workers);
+        for (std::size_t i = 0; i < workers; ++i) {
+            queues_.push_back(std::make_unique<Queue>());
+        }
+        workers_.reserve(workers);
+        for (std::size_t i = 0; i < workers; ++i) {
+            workers_.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock(idleMutex_);
+            stopping_ = true;
+        }
+        workAvailable_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::submit(Task task) {
+        auto index = currentPool == this
+                       ? currentIndex
+                       : nextQueue_.fetch_add(1) % queues_.size();
+
+        // Counted before the task is visible, so neither counter can dip
+        // below the number of tasks actually outstanding. A worker woken
+        // in between simply finds nothing and looks again.
+        {
+            std::lock_guard lock(idleMutex_);
+            pending_.fetch_add(1);
+            queued_.fetch_add(1);
+        }
+        {
+            std::lock_guard lock(queues_[index]->mutex);
+            queues_[index]->tasks.push_back(std::move(task));
+        }
+        workAvailable_.notify_one();
+    }
+
+    void ThreadPool::wait() {
+        std::unique_lock lock(idleMutex_);
+        allDone_.wait(lock, [this] { return pending_.load() == 0; });
+    }
+
+    void ThreadPool::workerLoop(std::size_t index) {
+        currentPool  = this;
+        currentIndex = index;
+        while (true) {
+            if (auto task = take(index)) {
+                task();
+                if (pending_.fetch_sub(1) == 1) {
+                    std::lock_guard lock(idleMutex_);
+                    allDone_.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock lock(idleMutex_);
+            workAvailable_.wait(
+                lock, [this] { return stopping_ || queued_.load() > 0; });
+            if (stopping_ && queued_.load() == 0) {
+                return;
+            }
+        }
+    }
+
+    auto ThreadPool::take(std::size_t index) -> Task {
+        // Newest of our own first, then the oldest of everyone else's.
+        for (std::size_t i = 0; i < queues_.size(); ++i) {
+            auto&           queue = *queues_[(index + i) % queues_.size()];
+            std::lock_guard lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            Task task;
+            if (i == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            queued_.fetch_sub(1);
+            return task;
+        }
+        return {};
+    }
+}  // namespace Runtime
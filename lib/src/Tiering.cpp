@@ -0,0 +1,723 @@
+#include "Thor/Tiering.hpp"
+
+#include "Thor/Jit.hpp"
+#include "Thor/Trace.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <charconv>
+
+namespace Tiering {
+
+    namespace {
+
+        using Sites = std::vector<const Expr::ExprBase*>;
+
+        constexpr std::int64_t NEVER = -1;
+
+        // Entries into a JIT region between looks for abandoned code.
+        constexpr std::uint64_t DEOPTIMIZE_CHECK = 16;
+
+        // Below about this many operators, entering compiled code costs as
+        // much as the closures it would stand in for save.
+        constexpr std::size_t MIN_JIT_OPERATORS = 12;
+
+        auto operators(const Expr::Expr& expr) -> std::size_t {
+            if (expr == nullptr) {
+                return 0;
+            }
+            if (expr->is<Expr::InfixExpr>()) {
+                const auto& infix = expr->as<Expr::InfixExpr>();
+                return 1 + operators(infix.left) + operators(infix.right);
+            }
+            if (expr->is<Expr::GroupExpr>()) {
+                return operators(expr->as<Expr::GroupExpr>().expr);
+            }
+            if (expr->is<Expr::PrefixExpr>()) {
+                return 1 + operators(expr->as<Expr::PrefixExpr>().right);
+            }
+            if (expr->is<Expr::PostfixExpr>()) {
+                return 1 + operators(expr->as<Expr::PostfixExpr>().left);
+            }
+            if (expr->is<Expr::TernaryExpr>()) {
+                const auto& ternary = expr->as<Expr::TernaryExpr>();
+                return 1 + operators(ternary.condition) +
+                       operators(ternary.trueExpr) +
+                       operators(ternary.falseExpr);
+            }
+            if (expr->is<Expr::AssignExpr>()) {
+                return operators(expr->as<Expr::AssignExpr>().value);
+            }
+            std::size_t count = 0;
+            if (expr->is<Expr::TemplateExpr>()) {
+                for (const auto& hole : expr->as<Expr::TemplateExpr>().holes) {
+                    count += operators(hole);
+                }
+            }
+            return count;
+        }
+
+        // Compiles the largest subtrees of `expr` the JIT accepts and that
+        // are worth it, collecting their nodes.
+        void prepare(const Expr::Expr&               expr,
+                     const Interpreter::Environment& environment,
+                     Sites&                          sites) {
+            if (operators(expr) < MIN_JIT_OPERATORS) {
+                return;
+            }
+            if (expr->jitSite().prepare(*expr, environment)) {
+                sites.push_back(expr.get());
+                return;
+            }
+            if (expr->is<Expr::InfixExpr>()) {
+                prepare(expr->as<Expr::InfixExpr>().left, environment, sites);
+                prepare(expr->as<Expr::InfixExpr>().right, environment, sites);
+            } else if (expr->is<Expr::GroupExpr>()) {
+                prepare(expr->as<Expr::GroupExpr>().expr, environment, sites);
+            } else if (expr->is<Expr::PrefixExpr>()) {
+                prepare(expr->as<Expr::PrefixExpr>().right, environment, sites);
+            } else if (expr->is<Expr::PostfixExpr>()) {
+                prepare(expr->as<Expr::PostfixExpr>().left, environment, sites);
+            } else if (expr->is<Expr::TernaryExpr>()) {
+                const auto& ternary = expr->as<Expr::TernaryExpr>();
+                prepare(ternary.condition, environment, sites);
+                prepare(ternary.trueExpr, environment, sites);
+                prepare(ternary.falseExpr, environment, sites);
+            } else if (expr->is<Expr::TemplateExpr>()) {
+                for (const auto& hole : expr->as<Expr::TemplateExpr>().holes) {
+                    prepare(hole, environment, sites);
+                }
+            } else if (expr->is<Expr::AssignExpr>()) {
+                prepare(expr->as<Expr::AssignExpr>().value, environment,
+                        sites);
+            }
+        }
+
+        template <typename Fn>
+        void forEachExpression(const Stmt::Stmt& stmt, Fn&& fn);
+
+        template <typename Fn>
+        void forEachExpression(const Stmt::While& loop, Fn&& fn) {
+            fn(loop.condition);
+            forEachExpression(loop.body, fn);
+            if (loop.increment != nullptr) {
+                fn(loop.increment);
+            }
+        }
+
+        // Calls `fn` with each expression of `stmt`, nested statements
+        // included. A declaration without initializer passes null.
+        template <typename Fn>
+        void forEachExpression(const Stmt::Stmt& stmt, Fn&& fn) {
+            if (stmt->is<Stmt::Expression>()) {
+                fn(stmt->as<Stmt::Expression>().expression);
+            } else if (stmt->is<Stmt::Print>()) {
+                fn(stmt->as<Stmt::Print>().expression);
+            } else if (stmt->is<Stmt::Variable>()) {
+                fn(stmt->as<Stmt::Variable>().initializer);
+            } else if (stmt->is<Stmt::Class>()) {
+                fn(stmt->as<Stmt::Class>().superclass);
+            } else if (stmt->is<Stmt::Block>()) {
+                for (const auto& each : stmt->as<Stmt::Block>().statements) {
+                    forEachExpression(each, fn);
+                }
+            } else if (stmt->is<Stmt::If>()) {
+                const auto& branch = stmt->as<Stmt::If>();
+                fn(branch.condition);
+                forEachExpression(branch.thenBranch, fn);
+                if (branch.elseBranch != nullptr) {
+                    forEachExpression(branch.elseBranch, fn);
+                }
+            } else if (stmt->is<Stmt::Switch>()) {
+                const auto& choice = stmt->as<Stmt::Switch>();
+                fn(choice.subject);
+                for (const auto& each : choice.cases) {
+                    for (const auto& label : each.labels) {
+                        fn(label);
+                    }
+                    forEachExpression(each.body, fn);
+                }
+                if (choice.otherwise != nullptr) {
+                    forEachExpression(choice.otherwise, fn);
+                }
+            } else if (stmt->is<Stmt::While>()) {
+                forEachExpression(stmt->as<Stmt::While>(), fn);
+            } else if (stmt->is<Stmt::Return>()) {
+                fn(stmt->as<Stmt::Return>().value);
+            } else if (stmt->is<Stmt::Throw>()) {
+                fn(stmt->as<Stmt::Throw>().value);
+            } else if (stmt->is<Stmt::Try>()) {
+                const auto& attempt = stmt->as<Stmt::Try>();
+                for (const auto* each : {&attempt.body, &attempt.caught,
+                                         &attempt.handler, &attempt.cleanup}) {
+                    if (*each != nullptr) {
+                        forEachExpression(*each, fn);
+                    }
+                }
+            }
+        }
+
+        // Calls `onLoop` with each loop in `stmt` and `onFunction` with each
+        // function it declares, outer ones first, function bodies included.
+        template <typename OnLoop, typename OnFunction>
+        void forEachRegion(const Stmt::Stmt& stmt, OnLoop&& onLoop,
+                           OnFunction&& onFunction) {
+            if (stmt->is<Stmt::Block>()) {
+                for (const auto& each : stmt->as<Stmt::Block>().statements) {
+                    forEachRegion(each, onLoop, onFunction);
+                }
+            } else if (stmt->is<Stmt::If>()) {
+                const auto& branch = stmt->as<Stmt::If>();
+                forEachRegion(branch.thenBranch, onLoop, onFunction);
+                if (branch.elseBranch != nullptr) {
+                    forEachRegion(branch.elseBranch, onLoop, onFunction);
+                }
+            } else if (stmt->is<Stmt::Switch>()) {
+                const auto& choice = stmt->as<Stmt::Switch>();
+                for (const auto& each : choice.cases) {
+                    forEachRegion(each.body, onLoop, onFunction);
+                }
+                if (choice.otherwise != nullptr) {
+                    forEachRegion(choice.otherwise, onLoop, onFunction);
+                }
+            } else if (stmt->is<Stmt::Try>()) {
+                const auto& attempt = stmt->as<Stmt::Try>();
+                for (const auto* each :
+                     {&attempt.body, &attempt.handler, &attempt.cleanup}) {
+                    if (*each != nullptr) {
+                        forEachRegion(*each, onLoop, onFunction);
+                    }
+                }
+            } else if (stmt->is<Stmt::While>()) {
+                onLoop(stmt->as<Stmt::While>());
+                forEachRegion(stmt->as<Stmt::While>().body, onLoop,
+                              onFunction);
+            } else if (stmt->is<Stmt::Function>()) {
+                const auto& definition = *stmt->as<Stmt::Function>().definition;
+                onFunction(definition);
+                for (const auto& each : definition.body) {
+                    forEachRegion(each, onLoop, onFunction);
+                }
+            } else if (stmt->is<Stmt::Class>()) {
+                for (const auto& method : stmt->as<Stmt::Class>().methods) {
+                    onFunction(*method);
+                    for (const auto& each : method->body) {
+                        forEachRegion(each, onLoop, onFunction);
+                    }
+                }
+            }
+        }
+
+        // An array indexed by id from the lowest one, with `T::stmt` set
+        // for each id in `nodes`.
+        template <typename T, typename Node>
+        auto byId(const std::vector<const Node*>& nodes, std::uint32_t& first,
+                  std::uint32_t& count) -> std::unique_ptr<T[]> {
+            if (nodes.empty()) {
+                return nullptr;
+            }
+            auto [lowest, highest] = std::minmax_element(
+                nodes.begin(), nodes.end(),
+                [](const auto* a, const auto* b) { return a->id < b->id; });
+            first       = (*lowest)->id;
+            count       = (*highest)->id - first + 1;
+            auto result = std::make_unique<T[]>(count);
+            for (const auto* node : nodes) {
+                result[node->id - first].stmt = node;
+            }
+            return result;
+        }
+
+        auto label(const Stmt::Stmt& stmt) -> std::string {
+            if (stmt->is<Stmt::Expression>()) {
+                return "expression";
+            }
+            if (stmt->is<Stmt::Print>()) {
+                return "print";
+            }
+            if (stmt->is<Stmt::Variable>()) {
+                return "var " + stmt->as<Stmt::Variable>().name.lexeme;
+            }
+            if (stmt->is<Stmt::Block>()) {
+                return "block";
+            }
+            if (stmt->is<Stmt::If>()) {
+                return "if";
+            }
+            if (stmt->is<Stmt::Switch>()) {
+                return "switch";
+            }
+            if (stmt->is<Stmt::While>()) {
+                return "while";
+            }
+            if (stmt->is<Stmt::Function>()) {
+                return "func " +
+                       stmt->as<Stmt::Function>().definition->name.lexeme;
+            }
+            if (stmt->is<Stmt::Class>()) {
+                return "class " + stmt->as<Stmt::Class>().name.lexeme;
+            }
+            if (stmt->is<Stmt::Return>()) {
+                return "return";
+            }
+            if (stmt->is<Stmt::Try>()) {
+                return "try";
+            }
+            if (stmt->is<Stmt::Throw>()) {
+                return "throw";
+            }
+            return stmt->is<Stmt::Break>() ? "break" : "continue";
+        }
+
+        auto seconds(std::int64_t nanos) -> std::optional<double> {
+            if (nanos == NEVER) {
+                return std::nullopt;
+            }
+            return static_cast<double>(nanos) * 1e-9;
+        }
+
+        auto milliseconds(const std::optional<double>& seconds)
+            -> std::string {
+            return seconds ? fmt::format("{:.3f}", *seconds * 1e3) : "-";
+        }
+    }  // namespace
+
+    // What every entry reads, kept small so that the regions of a long
+    // script stay in cache.
+    struct Plan::Region {
+        std::atomic<const Closure::Exec*> code{nullptr};  // Null for TREE
+        std::atomic<std::uint64_t>        entries{0};
+        std::atomic<Tier>                 tier{Tier::TREE};
+        std::atomic<bool>                 promoting{false};
+        std::atomic<bool>                 settled{false};  // Stays put
+    };
+
+    // The rest, for promotion, deoptimization and reports.
+    struct Plan::Profile {
+        // Written before `Region::tier` is raised past them, then never
+        // again.
+        std::unique_ptr<Closure::Exec> closure;
+        std::unique_ptr<Closure::Exec> jitted;
+        Sites                          sites;
+
+        // Nanoseconds from the plan being made.
+        std::array<std::atomic<std::int64_t>, TIER_COUNT> promotedAt;
+        std::atomic<std::int64_t>                         deoptimizedAt{NEVER};
+
+        std::array<std::atomic<std::int64_t>, TIER_COUNT> nanos;
+
+        Profile() {
+            for (std::size_t tier = 0; tier < TIER_COUNT; ++tier) {
+                promotedAt[tier].store(tier == 0 ? 0 : NEVER);
+                nanos[tier].store(0);
+            }
+        }
+    };
+
+    // A loop's counters and code; promoted as a region is, see `Region`
+    // and `Profile`.
+    struct Plan::Loop {
+        const Stmt::While*                stmt = nullptr;
+        std::atomic<const Closure::Exec*> code{nullptr};  // Null for TREE
+        std::atomic<std::uint64_t>        iterations{0};
+        std::atomic<Tier>                 tier{Tier::TREE};
+        std::atomic<bool>                 promoting{false};
+        std::atomic<bool>                 settled{false};
+
+        std::unique_ptr<Closure::Exec>                    closure;
+        std::unique_ptr<Closure::Exec>                    jitted;
+        Sites                                             sites;
+        std::array<std::atomic<std::int64_t>, TIER_COUNT> promotedAt;
+
+        Loop() {
+            for (std::size_t tier = 0; tier < TIER_COUNT; ++tier) {
+                promotedAt[tier].store(tier == 0 ? 0 : NEVER);
+            }
+        }
+    };
+
+    // A function's calls, and its body once hot. The body is compiled
+    // into the definition itself, see Closure::body.
+    struct Plan::Function {
+        const Stmt::Definition*           stmt = nullptr;
+        std::atomic<const Closure::Exec*> code{nullptr};  // Null for TREE
+        std::atomic<std::uint64_t>        calls{0};
+        std::atomic<std::int64_t>         promotedAt{NEVER};
+    };
+
+    auto name(Tier tier) -> std::string_view {
+        switch (tier) {
+            case Tier::TREE:
+                return "tree";
+            case Tier::CLOSURE:
+                return "closure";
+            case Tier::JIT:
+                return "jit";
+        }
+        return "?";
+    }
+
+    auto parseThresholds(std::string_view text) -> std::optional<Options> {
+        auto comma = text.find(',');
+        if (comma == std::string_view::npos) {
+            return std::nullopt;
+        }
+        auto parse = [](std::string_view part) -> std::optional<std::uint32_t> {
+            std::uint32_t value = 0;
+            const auto* end     = part.data() + part.size();
+            auto [ptr, error]   = std::from_chars(part.data(), end, value);
+            if (error != std::errc() || ptr != end) {
+                return std::nullopt;
+            }
+            return value;
+        };
+        auto closureAfter = parse(text.substr(0, comma));
+        auto jitAfter     = parse(text.substr(comma + 1));
+        if (!closureAfter || !jitAfter) {
+            return std::nullopt;
+        }
+        auto parsed         = options();
+        parsed.closureAfter = *closureAfter;
+        parsed.jitAfter     = *jitAfter;
+        return parsed;
+    }
+
+    auto format(const std::vector<RegionReport>& report) -> std::string {
+        auto text = fmt::format(
+            "{:>6}  {:<16} {:<8} {:>9}  {:>10} {:>10} {:>10}  {:>10} {:>10} "
+            "{:>10}\n",
+            "region", "statement", "tier", "entries", "closure@ms", "jit@ms",
+            "deopt@ms", "tree ms", "closure ms", "jit ms");
+        for (std::size_t i = 0; i < report.size(); ++i) {
+            const auto& region = report[i];
+            text += fmt::format(
+                "{:>6}  {:<16} {:<8} {:>9}  {:>10} {:>10} {:>10}  {:>10.3f} "
+                "{:>10.3f} {:>10.3f}\n",
+                i, region.label, name(region.tier), region.entries,
+                milliseconds(region.promotedAt[1]),
+                milliseconds(region.promotedAt[2]),
+                milliseconds(region.deoptimizedAt), region.seconds[0] * 1e3,
+                region.seconds[1] * 1e3, region.seconds[2] * 1e3);
+        }
+        return text;
+    }
+
+    Plan::Plan(std::vector<Stmt::Stmt> statements, Options options)
+        : statements_(std::move(statements)),
+          options_(options),
+          created_(std::chrono::steady_clock::now()),
+          regions_(std::make_unique<Region[]>(statements_.size())),
+          profiles_(std::make_unique<Profile[]>(statements_.size())) {
+        std::vector<const Stmt::While*>      loops;
+        std::vector<const Stmt::Definition*> functions;
+        for (const auto& stmt : statements_) {
+            forEachRegion(
+                stmt, [&](const Stmt::While& loop) { loops.push_back(&loop); },
+                [&](const Stmt::Definition& function) {
+                    functions.push_back(&function);
+                });
+        }
+        loops_     = byId<Loop>(loops, firstLoop_, loopCount_);
+        functions_ = byId<Function>(functions, firstFunction_, functionCount_);
+    }
+
+    Plan::~Plan() = default;
+
+    auto Plan::enter(std::uint32_t                   index,
+                     const Interpreter::Environment& environment) -> Entry {
+        auto& region = regions_[index];
+        // Racy on purpose, as in the JIT: a lost entry only delays things.
+        auto entries = region.entries.load(std::memory_order_relaxed) + 1;
+        region.entries.store(entries, std::memory_order_relaxed);
+
+        auto tier = region.tier.load(std::memory_order_acquire);
+        if (tier == Tier::JIT) {
+            // A node the JIT gave up on already runs its closure; dropping
+            // the region only saves asking it, so there is no hurry.
+            const auto& sites = profiles_[index].sites;
+            if (entries % DEOPTIMIZE_CHECK == 0 &&
+                std::any_of(sites.begin(), sites.end(),
+                            [](const Expr::ExprBase* node) {
+                                return node->jitSite().rejected();
+                            })) {
+                tier = deoptimize(index);
+            }
+        } else if (!region.settled.load(std::memory_order_relaxed)) {
+            if (tier == Tier::TREE && entries >= options_.closureAfter) {
+                tier = promote(Tier::CLOSURE, index, environment);
+            }
+            if (tier == Tier::CLOSURE && entries >= options_.jitAfter) {
+                tier = promote(Tier::JIT, index, environment);
+            }
+        }
+
+        Entry entry{index, tier, region.code.load(std::memory_order_acquire),
+                    {}};
+        if (options_.timing) {
+            entry.start = std::chrono::steady_clock::now();
+        }
+        return entry;
+    }
+
+    auto Plan::enter(const Stmt::While& stmt, Tier level,
+                     const Interpreter::Environment& /*environment*/)
+        -> const Closure::Exec* {
+        auto* found = find(stmt);
+        if (found == nullptr) {
+            return nullptr;
+        }
+        auto& loop = *found;
+        if (loop.tier.load(std::memory_order_acquire) <= level) {
+            return nullptr;
+        }
+        return loop.code.load(std::memory_order_acquire);
+    }
+
+    auto Plan::backEdge(const Stmt::While&              stmt, Tier level,
+                        const Interpreter::Environment& environment)
+        -> const Closure::Exec* {
+        auto* found = find(stmt);
+        if (found == nullptr) {
+            return nullptr;
+        }
+        auto& loop = *found;
+        // Racy, as for regions.
+        auto iterations = loop.iterations.load(std::memory_order_relaxed) + 1;
+        loop.iterations.store(iterations, std::memory_order_relaxed);
+
+        auto tier = loop.tier.load(std::memory_order_acquire);
+        if (tier != Tier::JIT && !loop.settled.load(std::memory_order_relaxed)) {
+            if (tier == Tier::TREE && iterations >= options_.closureAfter) {
+                tier = promote(Tier::CLOSURE, loop, environment);
+            }
+            if (tier == Tier::CLOSURE && iterations >= options_.jitAfter) {
+                tier = promote(Tier::JIT, loop, environment);
+            }
+        }
+        if (tier <= level) {
+            return nullptr;
+        }
+        return loop.code.load(std::memory_order_acquire);
+    }
+
+    auto Plan::call(const Stmt::Definition& definition)
+        -> const Closure::Exec* {
+        auto index = definition.id - firstFunction_;
+        if (definition.id < firstFunction_ || index >= functionCount_ ||
+            functions_[index].stmt != &definition) {
+            return nullptr;  // Declared by another plan, as in the REPL
+        }
+        auto& function = functions_[index];
+        // Racy, as for regions.
+        auto calls = function.calls.load(std::memory_order_relaxed) + 1;
+        function.calls.store(calls, std::memory_order_relaxed);
+        if (const auto* code = function.code.load(std::memory_order_acquire)) {
+            return code;
+        }
+        if (calls < options_.closureAfter) {
+            return nullptr;
+        }
+        // Compiling once is up to Closure::body; whoever gets here first
+        // publishes it.
+        const auto* code     = &Closure::body(definition);
+        const auto* expected = static_cast<const Closure::Exec*>(nullptr);
+        if (function.code.compare_exchange_strong(expected, code,
+                                                  std::memory_order_acq_rel)) {
+            function.promotedAt.store(elapsed(), std::memory_order_relaxed);
+            Trace::emit(Trace::Event::TIER_UP,
+                        size() + loopCount_ + index,
+                        static_cast<std::uint64_t>(Tier::CLOSURE));
+        }
+        return code;
+    }
+
+    auto Plan::find(const Stmt::While& stmt) const -> Loop* {
+        auto index = stmt.id - firstLoop_;
+        if (stmt.id < firstLoop_ || index >= loopCount_ ||
+            loops_[index].stmt != &stmt) {
+            return nullptr;
+        }
+        return &loops_[index];
+    }
+
+    auto Plan::promote(Tier tier, Loop& loop,
+                       const Interpreter::Environment& environment) -> Tier {
+        auto idle = false;
+        if (!loop.promoting.compare_exchange_strong(idle, true)) {
+            return loop.tier.load(std::memory_order_acquire);
+        }
+        auto current = loop.tier.load(std::memory_order_acquire);
+        if (current >= tier || loop.settled.load()) {
+            loop.promoting.store(false);
+            return current;
+        }
+
+        const Closure::Exec* code = nullptr;
+        if (tier == Tier::CLOSURE) {
+            loop.closure = std::make_unique<Closure::Exec>(
+                Closure::compile(*loop.stmt));
+            code = loop.closure.get();
+        } else {
+            // The variables have kept their types for `jitAfter`
+            // iterations; that is what the JIT specialises on.
+            if (Jit::available()) {
+                forEachExpression(*loop.stmt, [&](const Expr::Expr& expr) {
+                    prepare(expr, environment, loop.sites);
+                });
+            }
+            if (loop.sites.empty()) {
+                loop.settled.store(true);
+                loop.promoting.store(false);
+                return current;
+            }
+            loop.jitted = std::make_unique<Closure::Exec>(
+                Closure::compile(*loop.stmt, true));
+            code = loop.jitted.get();
+        }
+
+        auto slot = static_cast<std::size_t>(tier);
+        loop.promotedAt[slot].store(elapsed(), std::memory_order_relaxed);
+        loop.code.store(code, std::memory_order_release);
+        loop.tier.store(tier, std::memory_order_release);
+        loop.promoting.store(false);
+        Trace::emit(Trace::Event::TIER_UP,
+                    size() + (loop.stmt->id - firstLoop_), slot);
+        return tier;
+    }
+
+    void Plan::leave(const Entry& entry) {
+        if (!options_.timing) {
+            return;
+        }
+        auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - entry.start)
+                         .count();
+        profiles_[entry.index]
+            .nanos[static_cast<std::size_t>(entry.tier)]
+            .fetch_add(nanos, std::memory_order_relaxed);
+    }
+
+    auto Plan::promote(Tier tier, std::uint32_t index,
+                       const Interpreter::Environment& environment) -> Tier {
+        auto& region  = regions_[index];
+        auto& profile = profiles_[index];
+        // One thread compiles; the rest carry on in the current tier.
+        auto idle = false;
+        if (!region.promoting.compare_exchange_strong(idle, true)) {
+            return region.tier.load(std::memory_order_acquire);
+        }
+        auto current = region.tier.load(std::memory_order_acquire);
+        if (current >= tier || region.settled.load()) {
+            region.promoting.store(false);
+            return current;
+        }
+
+        const auto&          stmt = statements_[index];
+        const Closure::Exec* code = nullptr;
+        if (tier == Tier::CLOSURE) {
+            profile.closure =
+                std::make_unique<Closure::Exec>(Closure::compile(stmt));
+            code = profile.closure.get();
+        } else {
+            if (Jit::available()) {
+                forEachExpression(stmt, [&](const Expr::Expr& expr) {
+                    prepare(expr, environment, profile.sites);
+                });
+            }
+            if (profile.sites.empty()) {
+                // Nothing here worth compiling; closures it is.
+                region.settled.store(true);
+                region.promoting.store(false);
+                return current;
+            }
+            profile.jitted =
+                std::make_unique<Closure::Exec>(Closure::compile(stmt, true));
+            code = profile.jitted.get();
+        }
+
+        auto slot = static_cast<std::size_t>(tier);
+        profile.promotedAt[slot].store(elapsed(), std::memory_order_relaxed);
+        region.code.store(code, std::memory_order_release);
+        region.tier.store(tier, std::memory_order_release);
+        region.promoting.store(false);
+        Trace::emit(Trace::Event::TIER_UP, index, slot);
+        return tier;
+    }
+
+    auto Plan::deoptimize(std::uint32_t index) -> Tier {
+        auto& region   = regions_[index];
+        auto  expected = Tier::JIT;
+        if (region.tier.compare_exchange_strong(expected, Tier::CLOSURE,
+                                                std::memory_order_acq_rel)) {
+            auto& profile = profiles_[index];
+            region.settled.store(true);
+            region.code.store(profile.closure.get(),
+                              std::memory_order_release);
+            profile.deoptimizedAt.store(elapsed(), std::memory_order_relaxed);
+            Trace::emit(Trace::Event::TIER_DOWN, index,
+                        static_cast<std::uint64_t>(Tier::CLOSURE));
+        }
+        return Tier::CLOSURE;
+    }
+
+    auto Plan::elapsed() const -> std::int64_t {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - created_)
+            .count();
+    }
+
+    auto Plan::report() const -> std::vector<RegionReport> {
+        std::vector<RegionReport> report;
+        report.reserve(statements_.size());
+        for (std::size_t i = 0; i < statements_.size(); ++i) {
+            const auto&  region  = regions_[i];
+            const auto&  profile = profiles_[i];
+            RegionReport entry{label(statements_[i]),
+                               region.tier.load(std::memory_order_acquire),
+                               region.entries.load(std::memory_order_relaxed),
+                               {},
+                               seconds(profile.deoptimizedAt.load()),
+                               {}};
+            for (std::size_t tier = 0; tier < TIER_COUNT; ++tier) {
+                const auto& promoted = profile.promotedAt[tier];
+                entry.promotedAt[tier] = seconds(promoted.load());
+                entry.seconds[tier] =
+                    static_cast<double>(profile.nanos[tier].load()) * 1e-9;
+            }
+            report.push_back(std::move(entry));
+        }
+        for (std::uint32_t i = 0; i < loopCount_; ++i) {
+            const auto& loop = loops_[i];
+            if (loop.stmt == nullptr) {
+                continue;  // An id from a statement outside the plan
+            }
+            RegionReport entry{fmt::format("loop {}", loop.stmt->id),
+                               loop.tier.load(std::memory_order_acquire),
+                               loop.iterations.load(std::memory_order_relaxed),
+                               {},
+                               std::nullopt,
+                               {}};
+            for (std::size_t tier = 0; tier < TIER_COUNT; ++tier) {
+                entry.promotedAt[tier] = seconds(loop.promotedAt[tier].load());
+            }
+            report.push_back(std::move(entry));
+        }
+        for (std::uint32_t i = 0; i < functionCount_; ++i) {
+            const auto& function = functions_[i];
+            if (function.stmt == nullptr) {
+                continue;
+            }
+            auto         promoted = function.promotedAt.load();
+            RegionReport entry{
+                fmt::format("func {}", function.stmt->name.lexeme),
+                promoted == NEVER ? Tier::TREE : Tier::CLOSURE,
+                function.calls.load(std::memory_order_relaxed),
+                {seconds(0), seconds(promoted), std::nullopt},
+                std::nullopt,
+                {}};
+            report.push_back(std::move(entry));
+        }
+        return report;
+    }
+}  // namespace Tiering
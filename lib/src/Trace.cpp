@@ -0,0 +1,237 @@
+#include "Thor/Trace.hpp"
+
+#include "Thor/Logger.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+namespace Trace {
+
+    namespace {
+        constexpr std::size_t PAGE             = 4096;
+        constexpr std::size_t STRINGS_CAPACITY = std::size_t{1} << 20U;
+
+        std::atomic<std::uint64_t> nextTracerId{1};
+        std::atomic<std::uint16_t> nextThread{0};
+        std::unique_ptr<Tracer>    current;
+
+        constexpr std::array<EventInfo, static_cast<std::size_t>(Event::COUNT_)>
+            EVENTS = {{
+                {"none", 'i', nullptr, nullptr, false},
+                {"lex", 'B', "bytes", nullptr, false},
+                {"lex", 'E', "tokens", nullptr, false},
+                {"token", 'i', "type", "position", false},
+                {"lex error", 'i', nullptr, nullptr, true},
+                {"parse", 'B', "tokens", nullptr, false},
+                {"parse", 'E', "statements", nullptr, false},
+                {"parse error", 'i', nullptr, nullptr, true},
+                {"interpret", 'B', "statements", nullptr, false},
+                {"interpret", 'E', nullptr, nullptr, false},
+                {"statement", 'B', "index", nullptr, false},
+                {"statement", 'E', "index", nullptr, false},
+                {"runtime error", 'i', nullptr, nullptr, true},
+                {"mark", 'i', "a", "b", true},
+                {"jit compile", 'i', "bytes", "inputs", false},
+                {"jit deopt", 'i', "bailouts", nullptr, false},
+                {"tier up", 'i', "statement", "tier", false},
+                {"tier down", 'i', "statement", "tier", false},
+                {"engine compile", 'i', "statements", "engine", false},
+            }};
+
+        auto wallNanos() -> std::int64_t {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                .count();
+        }
+
+        auto steadyNanos() -> std::int64_t {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        // Tick rate measured against the steady clock over a short spin;
+        // replaced by a measurement over the whole run when the trace is
+        // closed normally.
+        auto calibrate(std::uint64_t& ticks, std::int64_t& nanos) -> double {
+            ticks      = readTicks();
+            nanos      = steadyNanos();
+            auto until = nanos + 2'000'000;
+            while (steadyNanos() < until) {
+            }
+            auto elapsedTicks = readTicks() - ticks;
+            auto elapsedNanos = steadyNanos() - nanos;
+            return static_cast<double>(elapsedTicks) /
+                   static_cast<double>(elapsedNanos);
+        }
+    }  // namespace
+
+    auto eventInfo(Event event) -> const EventInfo& {
+        auto index = static_cast<std::size_t>(event);
+        return EVENTS.at(index < EVENTS.size() ? index : 0);
+    }
+
+    auto Tracer::open(const std::string& path, std::size_t capacity)
+        -> std::unique_ptr<Tracer> {
+        std::size_t records = Tracer::BLOCK;
+        while (records < capacity) {
+            records <<= 1U;
+        }
+        auto recordsBytes = records * sizeof(Record);
+        auto size         = PAGE + recordsBytes + STRINGS_CAPACITY;
+
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            Logger::getLogger().error("Cannot create trace file {}: {}", path,
+                                      std::strerror(errno));
+            return nullptr;
+        }
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            Logger::getLogger().error("Cannot size trace file {}: {}", path,
+                                      std::strerror(errno));
+            ::close(fd);
+            return nullptr;
+        }
+        void* mapping =
+            ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            Logger::getLogger().error("Cannot map trace file {}: {}", path,
+                                      std::strerror(errno));
+            ::close(fd);
+            return nullptr;
+        }
+        return std::unique_ptr<Tracer>(new Tracer(
+            fd, static_cast<std::byte*>(mapping), size, records));
+    }
+
+    Tracer::Tracer(int fd, std::byte* mapping, std::size_t size,
+                   std::size_t capacity)
+        : fd_(fd),
+          mapping_(mapping),
+          size_(size),
+          header_(reinterpret_cast<FileHeader*>(mapping)),
+          records_(reinterpret_cast<Record*>(mapping + PAGE)),
+          mask_(capacity - 1),
+          id_(nextTracerId.fetch_add(1)),
+          openedNanos_(0) {
+        auto& header = *header_;
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version         = VERSION;
+        header.recordSize      = sizeof(Record);
+        header.capacity        = capacity;
+        header.recordsOffset   = PAGE;
+        header.stringsOffset   = PAGE + capacity * sizeof(Record);
+        header.stringsCapacity = STRINGS_CAPACITY;
+        header.stringsUsed     = 0;
+        header.ticksPerNano    = calibrate(header.startTicks, openedNanos_);
+        header.startNanos      = wallNanos();
+    }
+
+    Tracer::~Tracer() {
+        auto elapsedTicks = readTicks() - header_->startTicks;
+        auto elapsedNanos = steadyNanos() - openedNanos_;
+        if (elapsedNanos > 0) {
+            header_->ticksPerNano = static_cast<double>(elapsedTicks) /
+                                    static_cast<double>(elapsedNanos);
+        }
+        ::msync(mapping_, size_, MS_SYNC);
+        ::munmap(mapping_, size_);
+        ::close(fd_);
+    }
+
+    void Tracer::claim(detail::Cursor& cursor) {
+        if (cursor.owner != id_) {
+            cursor.owner  = id_;
+            cursor.thread = nextThread.fetch_add(1, std::memory_order_relaxed);
+        }
+        cursor.next = head_.fetch_add(BLOCK, std::memory_order_relaxed);
+        cursor.end  = cursor.next + BLOCK;
+    }
+
+    auto Tracer::intern(std::string_view text) -> std::uint32_t {
+        std::lock_guard lock(stringsMutex_);
+        auto            found = strings_.find(std::string(text));
+        if (found != strings_.end()) {
+            return found->second;
+        }
+        auto& header = *header_;
+        auto  needed = 2 * sizeof(std::uint32_t) + text.size();
+        if (header.stringsUsed + needed > header.stringsCapacity) {
+            return 0;
+        }
+        auto  id    = static_cast<std::uint32_t>(strings_.size() + 1);
+        auto  size  = static_cast<std::uint32_t>(text.size());
+        auto* entry = mapping_ + header.stringsOffset + header.stringsUsed;
+        std::memcpy(entry, &id, sizeof(id));
+        std::memcpy(entry + sizeof(id), &size, sizeof(size));
+        std::memcpy(entry + 2 * sizeof(id), text.data(), text.size());
+        header.stringsUsed += needed;
+        strings_.emplace(text, id);
+        return id;
+    }
+
+    auto readFile(const std::string& path) -> TraceFile {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        TraceFile file{};
+        in.read(reinterpret_cast<char*>(&file.header), sizeof(FileHeader));
+        const auto& header = file.header;
+        if (!in || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::runtime_error(path + " is not a Thor trace file");
+        }
+        if (header.version != VERSION || header.recordSize != sizeof(Record)) {
+            throw std::runtime_error(path + ": unsupported trace version");
+        }
+
+        std::vector<Record> slots(header.capacity);
+        in.seekg(static_cast<std::streamoff>(header.recordsOffset));
+        in.read(reinterpret_cast<char*>(slots.data()),
+                static_cast<std::streamsize>(slots.size() * sizeof(Record)));
+        std::copy_if(slots.begin(), slots.end(),
+                     std::back_inserter(file.records),
+                     [](const Record& record) { return record.sequence != 0; });
+        std::sort(file.records.begin(), file.records.end(),
+                  [](const Record& left, const Record& right) {
+                      return left.ticks < right.ticks;
+                  });
+
+        std::string table(header.stringsUsed, '\0');
+        in.seekg(static_cast<std::streamoff>(header.stringsOffset));
+        in.read(table.data(), static_cast<std::streamsize>(table.size()));
+        std::size_t offset = 0;
+        while (offset + 2 * sizeof(std::uint32_t) <= table.size()) {
+            std::uint32_t id   = 0;
+            std::uint32_t size = 0;
+            std::memcpy(&id, table.data() + offset, sizeof(id));
+            std::memcpy(&size, table.data() + offset + sizeof(id),
+                        sizeof(size));
+            offset += 2 * sizeof(std::uint32_t);
+            file.strings.emplace(id, table.substr(offset, size));
+            offset += size;
+        }
+        return file;
+    }
+
+    auto start(const std::string& path, std::size_t capacity) -> bool {
+        stop();
+        current = Tracer::open(path, capacity);
+        detail::active.store(current.get(), std::memory_order_release);
+        return current != nullptr;
+    }
+
+    void stop() {
+        detail::active.store(nullptr, std::memory_order_release);
+        current.reset();
+    }
+}  // namespace Trace
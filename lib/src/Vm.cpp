@@ -0,0 +1,2040 @@
+#include "Thor/Vm.hpp"
+
+#include "Thor/Exceptions.hpp"
+#include "Thor/Interpreter.hpp"
+#include "Thor/Operators.hpp"
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <utility>
+
+namespace Vm {
+
+    namespace {
+
+        using Operators::BinaryOp;
+        using Token::Literal;
+
+        using Binary = auto (*)(const Literal& left, const Literal& right,
+                                const Token::Token& op) -> Literal;
+
+        template <std::size_t... Op>
+        constexpr auto makeBinaries(std::index_sequence<Op...> /*unused*/)
+            -> std::array<Binary, Operators::OP_COUNT> {
+            return {{&Operators::apply<static_cast<BinaryOp>(Op)>...}};
+        }
+
+        // One entry per operator, with the number fast path built in.
+        constexpr auto BINARIES =
+            makeBinaries(std::make_index_sequence<Operators::OP_COUNT>{});
+
+        const Literal NIL{};
+
+        // Overwrites `out` in place when it already holds a `T`; registers
+        // mostly keep the type they held last time round.
+        template <typename T>
+        void assign(Literal& out, T value) {
+            if (auto* same = std::get_if<T>(&out.value)) {
+                *same = value;
+            } else {
+                out.value = value;
+            }
+        }
+
+        // Writes `left <op> right` to `out` for the operators numbers have
+        // inline; false for the rest.
+        auto numbers(BinaryOp op, double left, double right, Literal& out)
+            -> bool {
+            switch (op) {
+                case BinaryOp::PLUS:
+                    assign(out, left + right);
+                    return true;
+                case BinaryOp::MINUS:
+                    assign(out, left - right);
+                    return true;
+                case BinaryOp::STAR:
+                    assign(out, left * right);
+                    return true;
+                case BinaryOp::SLASH:
+                    assign(out, left / right);
+                    return true;
+                case BinaryOp::GREATER:
+                    assign(out, left > right);
+                    return true;
+                case BinaryOp::GREATER_EQUAL:
+                    assign(out, left >= right);
+                    return true;
+                case BinaryOp::LESS:
+                    assign(out, left < right);
+                    return true;
+                case BinaryOp::LESS_EQUAL:
+                    assign(out, left <= right);
+                    return true;
+                case BinaryOp::EQUAL_EQUAL:
+                    assign(out, left == right);
+                    return true;
+                case BinaryOp::BANG_EQUAL:
+                    assign(out, left != right);
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        auto compares(BinaryOp op) -> bool {
+            switch (op) {
+                case BinaryOp::GREATER:
+                case BinaryOp::GREATER_EQUAL:
+                case BinaryOp::LESS:
+                case BinaryOp::LESS_EQUAL:
+                case BinaryOp::EQUAL_EQUAL:
+                case BinaryOp::BANG_EQUAL:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // `left <op> right` for a comparison of two numbers.
+        auto compare(BinaryOp op, double left, double right) -> bool {
+            switch (op) {
+                case BinaryOp::GREATER:
+                    return left > right;
+                case BinaryOp::GREATER_EQUAL:
+                    return left >= right;
+                case BinaryOp::LESS:
+                    return left < right;
+                case BinaryOp::LESS_EQUAL:
+                    return left <= right;
+                case BinaryOp::EQUAL_EQUAL:
+                    return left == right;
+                default:
+                    return left != right;
+            }
+        }
+
+        // Comparisons leave a bool, so branches check for one first.
+        auto truthy(const Literal& value) -> bool {
+            const auto* flag = std::get_if<bool>(&value.value);
+            return flag != nullptr ? *flag : Operators::isTruthy(value);
+        }
+
+        auto describe(const Literal& value) {
+            return Logger::lazy([&value] { return value.stringify(); });
+        }
+
+        // A lowered expression: its value when known up front, otherwise
+        // the operand that holds it.
+        struct Lowered {
+            Operand                operand;
+            std::optional<Literal> constant;
+        };
+
+        auto known(Literal value) -> Lowered {
+            return {{}, std::move(value)};
+        }
+
+        // A lowered condition: the jump to patch, or the constant it
+        // folded to, in which case there is no jump.
+        struct Branch {
+            std::uint32_t          jump = 0;
+            std::optional<Literal> constant;
+        };
+
+        // Keys for the variables loops write and hoisted subtrees read: a
+        // global slot, or a local one with LOCAL set. A loop that calls a
+        // function or stores an array element also writes CALLS, and has
+        // nothing hoisted: a callee may write any global, and either may
+        // change the elements of an array any variable holds. Cells and
+        // captures are never hoisted; writing one counts as writing a
+        // local.
+        constexpr std::uint32_t LOCAL = 1U << 31;
+        constexpr std::uint32_t CALLS =
+            std::numeric_limits<std::uint32_t>::max();
+
+        auto key(std::uint32_t slot, bool local) -> std::uint32_t {
+            return local ? slot | LOCAL : slot;
+        }
+
+        // Calls `fn` with `expr` and each expression under it, null ones
+        // included.
+        template <typename Fn>
+        void walk(const Expr::Expr& expr, Fn&& fn) {
+            fn(expr);
+            if (expr == nullptr) {
+                return;
+            }
+            if (expr->is<Expr::GroupExpr>()) {
+                walk(expr->as<Expr::GroupExpr>().expr, fn);
+            } else if (expr->is<Expr::InfixExpr>()) {
+                walk(expr->as<Expr::InfixExpr>().left, fn);
+                walk(expr->as<Expr::InfixExpr>().right, fn);
+            } else if (expr->is<Expr::PrefixExpr>()) {
+                walk(expr->as<Expr::PrefixExpr>().right, fn);
+            } else if (expr->is<Expr::PostfixExpr>()) {
+                walk(expr->as<Expr::PostfixExpr>().left, fn);
+            } else if (expr->is<Expr::TernaryExpr>()) {
+                const auto& ternary = expr->as<Expr::TernaryExpr>();
+                walk(ternary.condition, fn);
+                walk(ternary.trueExpr, fn);
+                walk(ternary.falseExpr, fn);
+            } else if (expr->is<Expr::TemplateExpr>()) {
+                for (const auto& hole : expr->as<Expr::TemplateExpr>().holes) {
+                    walk(hole, fn);
+                }
+            } else if (expr->is<Expr::AssignExpr>()) {
+                walk(expr->as<Expr::AssignExpr>().value, fn);
+            } else if (expr->is<Expr::CallExpr>()) {
+                const auto& call = expr->as<Expr::CallExpr>();
+                walk(call.callee, fn);
+                for (const auto& argument : call.arguments) {
+                    walk(argument, fn);
+                }
+            } else if (expr->is<Expr::GetExpr>()) {
+                walk(expr->as<Expr::GetExpr>().object, fn);
+            } else if (expr->is<Expr::SetExpr>()) {
+                walk(expr->as<Expr::SetExpr>().object, fn);
+                walk(expr->as<Expr::SetExpr>().value, fn);
+            } else if (expr->is<Expr::ObjectExpr>()) {
+                for (const auto& value : expr->as<Expr::ObjectExpr>().values) {
+                    walk(value, fn);
+                }
+            } else if (expr->is<Expr::SuperExpr>()) {
+                walk(expr->as<Expr::SuperExpr>().superclass, fn);
+                walk(expr->as<Expr::SuperExpr>().receiver, fn);
+            } else if (expr->is<Expr::ArrayExpr>()) {
+                for (const auto& value : expr->as<Expr::ArrayExpr>().values) {
+                    walk(value, fn);
+                }
+            } else if (expr->is<Expr::IndexExpr>()) {
+                walk(expr->as<Expr::IndexExpr>().object, fn);
+                walk(expr->as<Expr::IndexExpr>().index, fn);
+            } else if (expr->is<Expr::IndexSetExpr>()) {
+                const auto& store = expr->as<Expr::IndexSetExpr>();
+                walk(store.object, fn);
+                walk(store.index, fn);
+                walk(store.value, fn);
+            }
+        }
+
+        // Whether running `expr` may write a variable: an assignment, or a
+        // call, which may write any global.
+        auto assigns(const Expr::Expr& expr) -> bool {
+            bool found = false;
+            walk(expr, [&](const Expr::Expr& each) {
+                found = found ||
+                        (each != nullptr && (each->is<Expr::AssignExpr>() ||
+                                             each->is<Expr::CallExpr>()));
+            });
+            return found;
+        }
+
+        // Adds the keys of the variables `expr` may write to `slots`.
+        void writes(const Expr::Expr& expr, std::vector<std::uint32_t>& slots) {
+            walk(expr, [&](const Expr::Expr& each) {
+                if (each == nullptr) {
+                    return;
+                }
+                if (each->is<Expr::AssignExpr>()) {
+                    const auto& assign = each->as<Expr::AssignExpr>();
+                    slots.push_back(key(
+                        assign.slot, assign.storage != Expr::Storage::GLOBAL));
+                } else if (each->is<Expr::CallExpr>() ||
+                           each->is<Expr::IndexSetExpr>()) {
+                    slots.push_back(CALLS);
+                }
+            });
+        }
+
+        // Adds the keys of the variables `stmt` may write to `slots`:
+        // assignments and declarations.
+        void writes(const Stmt::Stmt& stmt, std::vector<std::uint32_t>& slots) {
+            if (stmt->is<Stmt::Expression>()) {
+                writes(stmt->as<Stmt::Expression>().expression, slots);
+            } else if (stmt->is<Stmt::Print>()) {
+                writes(stmt->as<Stmt::Print>().expression, slots);
+            } else if (stmt->is<Stmt::Variable>()) {
+                const auto& variable = stmt->as<Stmt::Variable>();
+                slots.push_back(key(variable.slot,
+                                    variable.storage != Expr::Storage::GLOBAL));
+                writes(variable.initializer, slots);
+            } else if (stmt->is<Stmt::Function>()) {
+                const auto& function = stmt->as<Stmt::Function>();
+                slots.push_back(key(function.slot,
+                                    function.storage != Expr::Storage::GLOBAL));
+            } else if (stmt->is<Stmt::Class>()) {
+                const auto& klass = stmt->as<Stmt::Class>();
+                slots.push_back(
+                    key(klass.slot, klass.storage != Expr::Storage::GLOBAL));
+                writes(klass.superclass, slots);
+            } else if (stmt->is<Stmt::Return>()) {
+                writes(stmt->as<Stmt::Return>().value, slots);
+            } else if (stmt->is<Stmt::Block>()) {
+                for (const auto& each : stmt->as<Stmt::Block>().statements) {
+                    writes(each, slots);
+                }
+            } else if (stmt->is<Stmt::If>()) {
+                const auto& branch = stmt->as<Stmt::If>();
+                writes(branch.condition, slots);
+                writes(branch.thenBranch, slots);
+                if (branch.elseBranch != nullptr) {
+                    writes(branch.elseBranch, slots);
+                }
+            } else if (stmt->is<Stmt::Switch>()) {
+                const auto& choice = stmt->as<Stmt::Switch>();
+                writes(choice.subject, slots);
+                for (const auto& each : choice.cases) {
+                    for (const auto& label : each.labels) {
+                        writes(label, slots);
+                    }
+                    writes(each.body, slots);
+                }
+                if (choice.otherwise != nullptr) {
+                    writes(choice.otherwise, slots);
+                }
+            } else if (stmt->is<Stmt::While>()) {
+                const auto& loop = stmt->as<Stmt::While>();
+                writes(loop.condition, slots);
+                writes(loop.body, slots);
+                writes(loop.increment, slots);
+            } else if (stmt->is<Stmt::Try>()) {
+                const auto& attempt = stmt->as<Stmt::Try>();
+                for (const auto* each : {&attempt.body, &attempt.caught,
+                                         &attempt.handler, &attempt.cleanup}) {
+                    if (*each != nullptr) {
+                        writes(*each, slots);
+                    }
+                }
+            } else if (stmt->is<Stmt::Throw>()) {
+                writes(stmt->as<Stmt::Throw>().value, slots);
+            }
+        }
+
+        // The keys of the variables a subtree worth hoisting out of a loop
+        // reads, or nullopt if it is not one: an operator over operators
+        // that reads a global or a plain local, and has no side effect,
+        // call, jump, property, element or error to log in it. Objects
+        // and arrays change under a property or an element, and a new one
+        // is a new value each time.
+        // Smaller subtrees cost no more than the check skipping them.
+        auto hoistable(const Expr::Expr& expr)
+            -> std::optional<std::vector<std::uint32_t>> {
+            if (!expr->is<Expr::InfixExpr>() && !expr->is<Expr::PrefixExpr>() &&
+                !expr->is<Expr::TemplateExpr>()) {
+                return std::nullopt;
+            }
+            std::vector<std::uint32_t> reads;
+            std::size_t                operators = 0;
+            bool                       pure      = true;
+            walk(expr, [&](const Expr::Expr& each) {
+                if (each == nullptr || each->is<Expr::PostfixExpr>() ||
+                    each->is<Expr::TernaryExpr>() ||
+                    each->is<Expr::AssignExpr>() ||
+                    each->is<Expr::CallExpr>() || each->is<Expr::GetExpr>() ||
+                    each->is<Expr::SetExpr>() ||
+                    each->is<Expr::ObjectExpr>() ||
+                    each->is<Expr::SuperExpr>() ||
+                    each->is<Expr::ArrayExpr>() ||
+                    each->is<Expr::IndexExpr>() ||
+                    each->is<Expr::IndexSetExpr>()) {
+                    pure = false;
+                } else if (each->is<Expr::InfixExpr>()) {
+                    pure = pure && each->as<Expr::InfixExpr>().op.has_value();
+                    ++operators;
+                } else if (each->is<Expr::PrefixExpr>() ||
+                           each->is<Expr::TemplateExpr>()) {
+                    ++operators;
+                } else if (each->is<Expr::Variable>()) {
+                    const auto& variable = each->as<Expr::Variable>();
+                    auto        storage  = variable.storage;
+                    if (variable.slot == Expr::Variable::UNRESOLVED) {
+                        return;
+                    }
+                    if (storage != Expr::Storage::GLOBAL &&
+                        storage != Expr::Storage::LOCAL) {
+                        pure = false;
+                    }
+                    reads.push_back(
+                        key(variable.slot, storage == Expr::Storage::LOCAL));
+                }
+            });
+            if (!pure || operators < 2 || reads.empty()) {
+                return std::nullopt;
+            }
+            return reads;
+        }
+    }  // namespace
+
+    // Lowers one statement or function body at a time into `program`:
+    // first into virtual registers, one per value, then packed by linear
+    // scan. A function's locals are its first registers and are not
+    // packed; the argument slots of its calls come after the packed ones.
+    class Lowering : Expr::Visitor<Lowered> {
+      public:
+
+        explicit Lowering(Program& program) : program_(program) {}
+
+        void statement(const Stmt::Stmt& stmt) {
+            begin(0);
+            nested(stmt);
+            emit({Opcode::HALT});
+            program_.registers_ = std::max(program_.registers_, allocate());
+            program_.starts_.push_back(here());
+        }
+
+        // Lowers the bodies of the functions the statements declared, and
+        // of those they declare in turn, after them.
+        void functions() {
+            std::vector<Program::Function> lowered;
+            while (!pending_.empty()) {
+                const auto* definition = pending_.back();
+                pending_.pop_back();
+                begin(definition->locals);
+                // Shared locals start in cells, parameters included.
+                for (auto slot : definition->cells) {
+                    Operand local{Operand::Kind::REGISTER, slot};
+                    emit({Opcode::CELL, 0, local, local});
+                }
+                for (const auto& each : definition->body) {
+                    nested(each);
+                }
+                // Falling off the end returns nil.
+                emit({Opcode::RETURN, 0, {}, operand(known(Literal{}))});
+                lowered.push_back({definition, start_, 0, closes_});
+                lowered.back().window = allocate();
+            }
+            if (lowered.empty()) {
+                return;
+            }
+            auto [lowest, highest] = std::minmax_element(
+                lowered.begin(), lowered.end(),
+                [](const auto& a, const auto& b) {
+                    return a.definition->id < b.definition->id;
+                });
+            program_.firstFunction_ = lowest->definition->id;
+            program_.functions_.resize(highest->definition->id -
+                                       program_.firstFunction_ + 1);
+            for (const auto& function : lowered) {
+                program_.functions_[function.definition->id -
+                                    program_.firstFunction_] = function;
+            }
+        }
+
+      private:
+
+        static constexpr auto UNUSED = std::numeric_limits<std::uint32_t>::max();
+
+        // Registers from here on are the argument slots of calls, counted
+        // from the first one above the packed registers.
+        static constexpr std::uint32_t OUTGOING = 1U << 29;
+
+        // A loop being lowered.
+        struct Loop {
+            std::vector<std::uint32_t> writes;  // Sorted keys
+            std::vector<std::uint32_t> breaks;  // Jumps to the exit
+            std::vector<std::uint32_t> continues;
+            std::vector<Operand>       hoisted;  // Cleared on entry
+        };
+
+        // A try being lowered, and the ranges of code it guards so far:
+        // leaving it by `break`, `continue` or `return` ends one, and the
+        // code after the jump starts another. A try with both `catch` and
+        // `finally` is two, the guard for the `catch` inside.
+        struct Guard {
+            const Stmt::Try*                                     stmt;
+            bool                                                 finally;
+            std::size_t                                          loops;
+            std::vector<std::pair<std::uint32_t, std::uint32_t>> ranges;
+            std::uint32_t                                        open;
+        };
+
+        Program& program_;
+
+        // Per statement. The visitors are const; lowering still has to
+        // count here.
+        mutable std::uint32_t      start_     = 0;
+        mutable std::uint32_t      fixed_     = 0;  // Locals, not packed
+        mutable std::uint32_t      virtuals_  = 0;
+        mutable std::uint32_t      outgoing_  = 0;  // Argument slots in use
+        mutable std::uint32_t      arguments_ = 0;  // The most of them
+        mutable std::vector<Loop>  loops_;          // Innermost last
+        mutable std::vector<Guard> guards_;        // Innermost last
+        mutable bool               hoisting_ = false;
+        mutable bool               closes_   = false;  // See Program
+
+        // Declared functions whose bodies are still to lower.
+        mutable std::vector<const Stmt::Definition*> pending_;
+
+        void begin(std::uint32_t locals) const {
+            start_     = here();
+            fixed_     = locals;
+            virtuals_  = locals;
+            outgoing_  = 0;
+            arguments_ = 0;
+            closes_    = false;
+        }
+
+        void nested(const Stmt::Stmt& stmt) const {
+            if (stmt->is<Stmt::Expression>()) {
+                auto value =
+                    operand(lower(stmt->as<Stmt::Expression>().expression));
+                auto* last =
+                    here() > start_ ? &program_.code_.back() : nullptr;
+                if (last != nullptr && last->opcode == Opcode::STORE &&
+                    value == Operand{Operand::Kind::GLOBAL, last->aux}) {
+                    last->op = 1;  // An assignment: log it as it stores
+                } else {
+                    emit({Opcode::DISCARD, 0, {}, value});
+                }
+            } else if (stmt->is<Stmt::Print>()) {
+                auto value = operand(lower(stmt->as<Stmt::Print>().expression));
+                emit({Opcode::PRINT, 0, {}, value});
+            } else if (stmt->is<Stmt::Variable>()) {
+                const auto& variable = stmt->as<Stmt::Variable>();
+                auto        value    = variable.initializer != nullptr
+                                           ? operand(lower(variable.initializer))
+                                           : operand(known(Literal{}));
+                auto index =
+                    static_cast<std::uint32_t>(program_.variables_.size());
+                program_.variables_.push_back(&variable);
+                emit({Opcode::DEFINE, 0, {}, value, {}, index});
+            } else if (stmt->is<Stmt::Function>()) {
+                declare(stmt->as<Stmt::Function>());
+            } else if (stmt->is<Stmt::Class>()) {
+                declare(stmt->as<Stmt::Class>());
+            } else if (stmt->is<Stmt::Return>()) {
+                const auto& ret = stmt->as<Stmt::Return>();
+                if (ret.tail) {
+                    const auto& call = ret.value->as<Expr::CallExpr>();
+                    auto [callee, first] = arguments(call);
+                    emit({Opcode::TAIL_CALL,
+                          static_cast<std::uint8_t>(call.arguments.size()), {},
+                          callee, first, 0, &call.paren});
+                } else {
+                    auto value = ret.value != nullptr
+                                     ? operand(lower(ret.value))
+                                     : operand(known(Literal{}));
+                    auto finally = std::any_of(
+                        guards_.begin(), guards_.end(),
+                        [](const Guard& guard) { return guard.finally; });
+                    if (finally && value.kind() != Operand::Kind::CONSTANT) {
+                        // A `finally` runs in between, and may assign it.
+                        auto kept = temporary();
+                        emit({Opcode::MOVE, 0, kept, value});
+                        value = kept;
+                    }
+                    leave(guards_.size(), [&] {
+                        emit({Opcode::RETURN, 0, {}, value});
+                    });
+                }
+            } else if (stmt->is<Stmt::Block>()) {
+                for (const auto& each : stmt->as<Stmt::Block>().statements) {
+                    nested(each);
+                }
+            } else if (stmt->is<Stmt::If>()) {
+                branch(stmt->as<Stmt::If>());
+            } else if (stmt->is<Stmt::Switch>()) {
+                choose(stmt->as<Stmt::Switch>());
+            } else if (stmt->is<Stmt::While>()) {
+                loop(stmt->as<Stmt::While>());
+            } else if (stmt->is<Stmt::Try>()) {
+                attempt(stmt->as<Stmt::Try>());
+            } else if (stmt->is<Stmt::Throw>()) {
+                const auto& raise = stmt->as<Stmt::Throw>();
+                emit({Opcode::THROW, 0, {}, operand(lower(raise.value)), {}, 0,
+                      &raise.keyword});
+            } else {
+                auto& jumps = stmt->is<Stmt::Break>()
+                                  ? loops_.back().breaks
+                                  : loops_.back().continues;
+                leave(inLoop(), [&] { jumps.push_back(emit({Opcode::JUMP})); });
+            }
+        }
+
+        // `try { body } catch (error) { handler } finally { cleanup }`:
+        //
+        //          body
+        //          JUMP done            (the end of the `catch` guard)
+        //   catch: CATCH error
+        //          handler
+        //   done:  cleanup              (the end of the `finally` guard)
+        //          JUMP out
+        //          CAUGHT saved
+        //          cleanup
+        //          RETHROW saved
+        //   out:
+        void attempt(const Stmt::Try& stmt) const {
+            auto finally = stmt.cleanup != nullptr;
+            if (finally) {
+                guards_.push_back({&stmt, true, loops_.size(), {}, here()});
+            }
+            if (stmt.handler != nullptr) {
+                guards_.push_back({&stmt, false, loops_.size(), {}, here()});
+                nested(stmt.body);
+                auto guard = close();
+                auto done  = emit({Opcode::JUMP});
+                auto at    = here();
+                auto index =
+                    static_cast<std::uint32_t>(program_.variables_.size());
+                program_.variables_.push_back(
+                    &stmt.caught->as<Stmt::Variable>());
+                emit({Opcode::CATCH, 0, {}, {}, {}, index});
+                nested(stmt.handler);
+                patch(done, here());
+                handle(guard, at);
+            } else {
+                nested(stmt.body);
+            }
+            if (finally) {
+                auto guard = close();
+                nested(stmt.cleanup);
+                auto out   = emit({Opcode::JUMP});
+                auto at    = here();
+                auto saved = temporary();
+                emit({Opcode::CAUGHT, 0, saved});
+                nested(stmt.cleanup);
+                emit({Opcode::RETHROW, 0, {}, saved});
+                patch(out, here());
+                handle(guard, at);
+            }
+        }
+
+        // The innermost guard, taken off with its last range ended here.
+        auto close() const -> Guard {
+            auto guard = std::move(guards_.back());
+            guards_.pop_back();
+            if (guard.open < here()) {
+                guard.ranges.emplace_back(guard.open, here());
+            }
+            return guard;
+        }
+
+        void handle(const Guard& guard, std::uint32_t at) const {
+            for (const auto& [from, to] : guard.ranges) {
+                program_.handlers_.push_back({from, to, at});
+            }
+        }
+
+        // Guards a `break` or `continue` leaves: those inside the loop.
+        [[nodiscard]] auto inLoop() const -> std::size_t {
+            return static_cast<std::size_t>(std::count_if(
+                guards_.begin(), guards_.end(), [this](const Guard& guard) {
+                    return guard.loops == loops_.size();
+                }));
+        }
+
+        // Leaves the innermost `count` guards by what `jump` emits: each
+        // guard's range ends before it, with the `finally` of each run on
+        // the way out, innermost first, guarded by those still around it.
+        template <typename Jump>
+        void leave(std::size_t count, Jump&& jump) const {
+            std::vector<Guard> left;
+            for (std::size_t i = 0; i < count; ++i) {
+                left.push_back(close());
+                if (left.back().finally) {
+                    nested(left.back().stmt->cleanup);
+                }
+            }
+            jump();
+            for (auto guard = left.rbegin(); guard != left.rend(); ++guard) {
+                guard->open = here();
+                guards_.push_back(std::move(*guard));
+            }
+        }
+
+        void branch(const Stmt::If& stmt) const {
+            auto condition = jumpWhen(stmt.condition, false);
+            if (condition.constant) {
+                if (Operators::isTruthy(*condition.constant)) {
+                    nested(stmt.thenBranch);
+                } else if (stmt.elseBranch != nullptr) {
+                    nested(stmt.elseBranch);
+                }
+                return;
+            }
+            auto toElse = condition.jump;
+            nested(stmt.thenBranch);
+            if (stmt.elseBranch == nullptr) {
+                patch(toElse, here());
+                return;
+            }
+            auto toEnd = emit({Opcode::JUMP});
+            patch(toElse, here());
+            nested(stmt.elseBranch);
+            patch(toEnd, here());
+        }
+
+        // The subject is looked up once, by a SWITCH, then each label that
+        // is not a constant is compared in order, with another SWITCH after
+        // it in case a constant of a later case matched. The last SWITCH
+        // always jumps.
+        //
+        //         SWITCH  subject, 0 checked
+        //         JUMP_IF subject == label 0, its case
+        //         SWITCH  subject, 1 checked
+        //         ...
+        //   case: body
+        //         JUMP    end
+        //         ...
+        //   else: body
+        //   end:
+        void choose(const Stmt::Switch& stmt) const {
+            const auto& dynamic = stmt.dispatch.dynamic();
+            auto        lowered = lower(stmt.subject);
+            for (const auto& label : dynamic) {
+                lowered = pin(std::move(lowered), label.expr);
+            }
+            auto subject = operand(std::move(lowered));
+            auto cases   = static_cast<std::uint32_t>(stmt.cases.size());
+            auto targets = static_cast<std::uint32_t>(program_.targets_.size());
+            program_.targets_.resize(targets + cases + 1);
+            auto lookup = [&](std::uint32_t checked) {
+                auto index =
+                    static_cast<std::uint32_t>(program_.switches_.size());
+                program_.switches_.push_back(
+                    {&stmt.dispatch, targets, cases, checked});
+                emit({Opcode::SWITCH, 0, {}, subject, {}, index,
+                      &stmt.keyword});
+            };
+
+            lookup(0);
+            constexpr auto EQUAL =
+                static_cast<std::uint8_t>(Operators::BinaryOp::EQUAL_EQUAL);
+            std::vector<std::uint32_t> compared;  // JUMP_IFs, by label
+            for (std::uint32_t i = 0; i < dynamic.size(); ++i) {
+                auto label = operand(lower(dynamic[i].expr));
+                compared.push_back(emit({Opcode::JUMP_IF, EQUAL, {}, subject,
+                                         label, 0, &stmt.keyword}));
+                lookup(i + 1);
+            }
+
+            std::vector<std::uint32_t> ends;
+            for (std::uint32_t index = 0; index < cases; ++index) {
+                program_.targets_[targets + index] = here() - start_;
+                nested(stmt.cases[index].body);
+                if (index + 1 < cases || stmt.otherwise != nullptr) {
+                    ends.push_back(emit({Opcode::JUMP}));
+                }
+            }
+            program_.targets_[targets + cases] = here() - start_;
+            if (stmt.otherwise != nullptr) {
+                nested(stmt.otherwise);
+            }
+            for (auto jump : ends) {
+                patch(jump, here());
+            }
+            for (std::uint32_t i = 0; i < dynamic.size(); ++i) {
+                program_.code_[compared[i]].aux =
+                    program_.targets_[targets + dynamic[i].index];
+            }
+        }
+
+        // Rotated: the condition sits after the body, so an iteration
+        // costs one backward JUMP_TRUE.
+        //
+        //         CLEAR    hoisted values
+        //         JUMP     condition
+        //   top:  body
+        //         increment
+        //         condition
+        //         JUMP_TRUE top
+        void loop(const Stmt::While& stmt) const {
+            auto list = static_cast<std::uint32_t>(program_.lists_.size());
+            program_.lists_.push_back({0, 0});
+            emit({Opcode::CLEAR, 0, {}, {}, {}, list});
+
+            Loop state;
+            writes(stmt.condition, state.writes);
+            writes(stmt.body, state.writes);
+            writes(stmt.increment, state.writes);
+            std::sort(state.writes.begin(), state.writes.end());
+            loops_.push_back(std::move(state));
+
+            auto toCondition = emit({Opcode::JUMP});
+            auto top         = here();
+            nested(stmt.body);
+            auto next = here();
+            if (stmt.increment != nullptr) {
+                (void)lower(stmt.increment);
+            }
+            patch(toCondition, here());
+            auto condition = jumpWhen(stmt.condition, true);
+            if (!condition.constant) {
+                patch(condition.jump, top);
+            } else if (Operators::isTruthy(*condition.constant)) {
+                emit({Opcode::JUMP, 0, {}, {}, {}, top - start_});
+            }
+
+            auto done = std::move(loops_.back());
+            loops_.pop_back();
+            for (auto jump : done.breaks) {
+                patch(jump, here());
+            }
+            for (auto jump : done.continues) {
+                patch(jump, next);
+            }
+            program_.lists_[list] = {
+                static_cast<std::uint32_t>(program_.holes_.size()),
+                static_cast<std::uint32_t>(done.hoisted.size())};
+            program_.holes_.insert(program_.holes_.end(), done.hoisted.begin(),
+                                   done.hoisted.end());
+        }
+
+        // Lowers `condition` into a jump taken when its truth is `when`. A
+        // comparison jumps on its operands, without a bool in between.
+        [[nodiscard]] auto jumpWhen(const Expr::Expr& condition,
+                                    bool              when) const -> Branch {
+            const auto* root = &condition;
+            while (*root != nullptr && (*root)->is<Expr::GroupExpr>()) {
+                root = &(*root)->as<Expr::GroupExpr>().expr;
+            }
+            if (*root != nullptr && (*root)->is<Expr::InfixExpr>()) {
+                const auto& infix = (*root)->as<Expr::InfixExpr>();
+                auto        op    = infix.op;
+                if (op && compares(*op)) {
+                    auto left  = pin(lower(infix.left), infix.right);
+                    auto right = lower(infix.right);
+                    if (left.constant && right.constant) {
+                        if (auto value = Operators::fold([&] {
+                                return Operators::apply(*op, *left.constant,
+                                                        *right.constant,
+                                                        infix.operator_);
+                            })) {
+                            return {0, std::move(value)};
+                        }
+                    }
+                    auto opcode = when ? Opcode::JUMP_IF : Opcode::JUMP_UNLESS;
+                    return {emit({opcode, static_cast<std::uint8_t>(*op), {},
+                                  operand(std::move(left)),
+                                  operand(std::move(right)), 0,
+                                  &infix.operator_}),
+                            std::nullopt};
+                }
+            }
+            auto value = lower(condition);
+            if (value.constant) {
+                return {0, std::move(value.constant)};
+            }
+            auto opcode = when ? Opcode::JUMP_TRUE : Opcode::JUMP_FALSE;
+            return {emit({opcode, 0, {}, operand(std::move(value))}),
+                    std::nullopt};
+        }
+
+        void patch(std::uint32_t jump, std::uint32_t to) const {
+            program_.code_[jump].aux = to - start_;
+        }
+
+        // The outermost enclosing loop that writes none of `expr`'s
+        // variables, if it is worth hoisting at all.
+        [[nodiscard]] auto invariantIn(const Expr::Expr& expr) const
+            -> Loop* {
+            if (hoisting_ || loops_.empty()) {
+                return nullptr;
+            }
+            auto reads = hoistable(expr);
+            if (!reads) {
+                return nullptr;
+            }
+            // Inner loops write a subset of what outer ones do.
+            for (auto& loop : loops_) {
+                auto calls =
+                    !loop.writes.empty() && loop.writes.back() == CALLS;
+                auto written =
+                    calls ||
+                    std::any_of(reads->begin(), reads->end(),
+                                [&](std::uint32_t slot) {
+                                    return std::binary_search(
+                                        loop.writes.begin(), loop.writes.end(),
+                                        slot);
+                                });
+                if (!written) {
+                    return &loop;
+                }
+            }
+            return nullptr;
+        }
+
+        // Computes `expr` into a register of `loop` the first time round
+        // and skips it from then on; the loop clears it on entry. Kernels
+        // never return nil, so nil means not computed yet.
+        auto hoist(const Expr::Expr& expr, Loop& loop) const -> Lowered {
+            auto kept = temporary();
+            auto skip = emit({Opcode::JUMP_SET, 0, {}, kept});
+            hoisting_ = true;
+            auto value = expr->accept(*this);
+            hoisting_ = false;
+            // Not constant, as it reads a variable: its root came last.
+            program_.code_.back().target = kept;
+            patch(skip, here());
+            loop.hoisted.push_back(kept);
+            return {kept, std::nullopt};
+        }
+
+        // A variable's operand is read when its instruction runs, so one
+        // that a later operand may assign is copied out first.
+        [[nodiscard]] auto pin(Lowered value, const Expr::Expr& later) const
+            -> Lowered {
+            auto variable =
+                value.operand.kind() == Operand::Kind::GLOBAL ||
+                (value.operand.kind() == Operand::Kind::REGISTER &&
+                 value.operand.index() < fixed_);
+            if (value.constant || !variable || !assigns(later)) {
+                return value;
+            }
+            auto target = temporary();
+            move(target, std::move(value));
+            return {target, std::nullopt};
+        }
+
+        [[nodiscard]] auto here() const -> std::uint32_t {
+            return static_cast<std::uint32_t>(program_.code_.size());
+        }
+
+        auto emit(Instruction instruction) const -> std::uint32_t {
+            program_.code_.push_back(instruction);
+            return here() - 1;
+        }
+
+        [[nodiscard]] auto temporary() const -> Operand {
+            return {Operand::Kind::REGISTER, virtuals_++};
+        }
+
+        // Known values become constants only once an instruction uses
+        // them, so folded subtrees leave nothing behind.
+        [[nodiscard]] auto operand(Lowered value) const -> Operand {
+            if (!value.constant) {
+                return value.operand;
+            }
+            program_.constants_.push_back(std::move(*value.constant));
+            return {Operand::Kind::CONSTANT,
+                    static_cast<std::uint32_t>(program_.constants_.size() - 1)};
+        }
+
+        [[nodiscard]] auto lower(const Expr::Expr& expr) const -> Lowered {
+            if (expr == nullptr) {
+                emit({Opcode::NULL_EXPR});
+                return known(Literal{});
+            }
+            if (auto* loop = invariantIn(expr)) {
+                return hoist(expr, *loop);
+            }
+            return expr->accept(*this);
+        }
+
+        void move(Operand target, Lowered value) const {
+            emit({Opcode::MOVE, 0, target, operand(std::move(value))});
+        }
+
+        // A function that captures nothing is the same value each time,
+        // so it is a constant; one that does is made by CLOSE. A new cell
+        // goes in first for one stored in a cell, as it may capture it.
+        void declare(const Stmt::Function& function) const {
+            pending_.push_back(function.definition.get());
+            const auto& definition = *function.definition;
+            if (function.storage == Expr::Storage::GLOBAL) {
+                auto value = operand(
+                    known(Literal{Runtime::Function{function.definition}}));
+                emit({Opcode::STORE, 0, {}, value, {}, function.slot});
+                return;
+            }
+            Operand local{Operand::Kind::REGISTER, function.slot};
+            auto    cell = function.storage == Expr::Storage::CELL;
+            if (cell) {
+                emit({Opcode::CELL, 0, local, operand(known(Literal{}))});
+            }
+            Lowered value;
+            if (definition.captures.empty()) {
+                value = known(Literal{Runtime::Function{function.definition}});
+            } else {
+                auto index =
+                    static_cast<std::uint32_t>(program_.closures_.size());
+                program_.closures_.push_back(function.definition);
+                value   = {cell ? temporary() : local, std::nullopt};
+                closes_ = true;
+                emit({Opcode::CLOSE, 0, value.operand, {}, {}, index});
+            }
+            if (cell) {
+                emit({Opcode::SET, 0, {}, local, operand(std::move(value))});
+            } else {
+                move(local, std::move(value));
+            }
+        }
+
+        // As a function, but always made by CLASS: its methods are closed
+        // over the frame, and the superclass is checked, when it runs.
+        void declare(const Stmt::Class& klass) const {
+            auto superclass = klass.superclass != nullptr
+                                  ? operand(lower(klass.superclass))
+                                  : operand(known(Literal{}));
+            auto index = static_cast<std::uint32_t>(program_.classes_.size());
+            program_.classes_.push_back(&klass);
+            for (const auto& method : klass.methods) {
+                pending_.push_back(method.get());
+                closes_ = closes_ || !method->captures.empty();
+            }
+            Operand local{Operand::Kind::REGISTER, klass.slot};
+            Operand value = klass.storage == Expr::Storage::LOCAL
+                                ? local
+                                : temporary();
+            if (klass.storage == Expr::Storage::CELL) {
+                emit({Opcode::CELL, 0, local, operand(known(Literal{}))});
+            }
+            emit({Opcode::CLASS, 0, value, superclass, {}, index,
+                  &klass.name});
+            if (klass.storage == Expr::Storage::GLOBAL) {
+                emit({Opcode::STORE, 0, {}, value, {}, klass.slot});
+            } else if (klass.storage == Expr::Storage::CELL) {
+                emit({Opcode::SET, 0, {}, local, value});
+            }
+        }
+
+        auto site(const Token::Token&         name,
+                  const Runtime::InlineCache& cache) const -> std::uint32_t {
+            program_.sites_.push_back({&name, &cache});
+            return static_cast<std::uint32_t>(program_.sites_.size() - 1);
+        }
+
+        auto visit(const Expr::Variable& expr) const -> Lowered final {
+            if (expr.slot == Expr::Variable::UNRESOLVED) {
+                return known(expr.literal);
+            }
+            Operand local{Operand::Kind::REGISTER, expr.slot};
+            switch (expr.storage) {
+                case Expr::Storage::GLOBAL:
+                    break;
+                case Expr::Storage::LOCAL:
+                    return {local, std::nullopt};
+                case Expr::Storage::CELL: {
+                    auto target = temporary();
+                    emit({Opcode::UNBOX, 0, target, local});
+                    return {target, std::nullopt};
+                }
+                case Expr::Storage::CAPTURE:
+                case Expr::Storage::CAPTURED_CELL: {
+                    auto target = temporary();
+                    auto cell   = expr.storage == Expr::Storage::CAPTURED_CELL;
+                    closes_     = true;
+                    emit({Opcode::CAPTURE, static_cast<std::uint8_t>(cell),
+                          target, {}, {}, expr.slot});
+                    return {target, std::nullopt};
+                }
+                case Expr::Storage::SELF: {
+                    auto target = temporary();
+                    closes_     = true;
+                    emit({Opcode::SELF, 0, target});
+                    return {target, std::nullopt};
+                }
+            }
+            return {{Operand::Kind::GLOBAL, expr.slot}, std::nullopt};
+        }
+
+        auto visit(const Expr::LiteralExpr& expr) const -> Lowered final {
+            return known(expr.literal);
+        }
+
+        auto visit(const Expr::GroupExpr& expr) const -> Lowered final {
+            return lower(expr.expr);
+        }
+
+        auto visit(const Expr::InfixExpr& expr) const -> Lowered final {
+            auto left  = pin(lower(expr.left), expr.right);
+            auto right = lower(expr.right);
+            auto op    = expr.op;
+            if (!op) {
+                // Both sides still ran; the result is nil.
+                return known(Literal{});
+            }
+            if (left.constant && right.constant) {
+                if (auto value = Operators::fold([&] {
+                        return Operators::apply(*op, *left.constant,
+                                                *right.constant,
+                                                expr.operator_);
+                    })) {
+                    return known(std::move(*value));
+                }
+            }
+            auto target = temporary();
+            emit({Opcode::BINARY, static_cast<std::uint8_t>(*op), target,
+                  operand(std::move(left)), operand(std::move(right)), 0,
+                  &expr.operator_});
+            return {target, std::nullopt};
+        }
+
+        auto visit(const Expr::PrefixExpr& expr) const -> Lowered final {
+            auto right = lower(expr.right);
+            if (right.constant) {
+                if (auto value = Operators::fold([&] {
+                        return Interpreter::Interpreter::prefix(
+                            expr.operator_, *right.constant);
+                    })) {
+                    return known(std::move(*value));
+                }
+            }
+            auto target = temporary();
+            auto opcode = expr.operator_.type == Token::Type::MINUS
+                              ? Opcode::NEGATE
+                              : Opcode::PREFIX;
+            emit({opcode, 0, target, operand(std::move(right)), {}, 0,
+                  &expr.operator_});
+            return {target, std::nullopt};
+        }
+
+        auto visit(const Expr::PostfixExpr& expr) const -> Lowered final {
+            // The interpreter rejects every postfix use; so does this.
+            auto left = operand(lower(expr.left));
+            emit({Opcode::POSTFIX, 0, {}, left, {}, 0, &expr.operator_});
+            return known(Literal{});
+        }
+
+        auto visit(const Expr::TernaryExpr& expr) const -> Lowered final {
+            auto condition = lower(expr.condition);
+            if (condition.constant) {
+                return lower(Operators::isTruthy(*condition.constant)
+                                 ? expr.trueExpr
+                                 : expr.falseExpr);
+            }
+            auto target = temporary();
+            auto toFalse =
+                emit({Opcode::JUMP_FALSE, 0, {}, operand(std::move(condition))});
+            move(target, lower(expr.trueExpr));
+            auto toEnd = emit({Opcode::JUMP});
+            program_.code_[toFalse].aux = here() - start_;
+            move(target, lower(expr.falseExpr));
+            program_.code_[toEnd].aux = here() - start_;
+            return {target, std::nullopt};
+        }
+
+        auto visit(const Expr::TemplateExpr& expr) const -> Lowered final {
+            std::vector<Lowered> holes;
+            holes.reserve(expr.holes.size());
+            bool constant = true;
+            for (std::size_t i = 0; i < expr.holes.size(); ++i) {
+                auto hole = lower(expr.holes[i]);
+                for (auto later = i + 1; later < expr.holes.size(); ++later) {
+                    hole = pin(std::move(hole), expr.holes[later]);
+                }
+                constant = constant && hole.constant.has_value();
+                holes.push_back(std::move(hole));
+            }
+            if (constant) {
+                std::vector<Literal> values;
+                values.reserve(holes.size());
+                for (auto& hole : holes) {
+                    values.push_back(std::move(*hole.constant));
+                }
+                return known(
+                    Interpreter::Interpreter::render(expr, values.data()));
+            }
+
+            // Nested templates add their own holes while lowering, so this
+            // one's are appended together once they are all known.
+            auto first = static_cast<std::uint32_t>(program_.holes_.size());
+            for (auto& hole : holes) {
+                program_.holes_.push_back(operand(std::move(hole)));
+            }
+            auto index = static_cast<std::uint32_t>(program_.templates_.size());
+            program_.templates_.push_back({&expr, first});
+
+            auto target = temporary();
+            emit({Opcode::RENDER, 0, target, {}, {}, index, &expr.token});
+            return {target, std::nullopt};
+        }
+
+        auto visit(const Expr::AssignExpr& expr) const -> Lowered final {
+            Operand local{Operand::Kind::REGISTER, expr.slot};
+            if (expr.storage == Expr::Storage::LOCAL) {
+                move(local, lower(expr.value));
+                return {local, std::nullopt};
+            }
+            auto value = operand(lower(expr.value));
+            if (expr.storage == Expr::Storage::CELL) {
+                emit({Opcode::SET, 0, {}, local, value});
+                return {value, std::nullopt};
+            }
+            if (expr.storage == Expr::Storage::CAPTURED_CELL) {
+                auto cell = temporary();
+                closes_   = true;
+                emit({Opcode::CAPTURE, 0, cell, {}, {}, expr.slot});
+                emit({Opcode::SET, 0, {}, cell, value});
+                return {value, std::nullopt};
+            }
+            emit({Opcode::STORE, 0, {}, value, {}, expr.slot});
+            return {{Operand::Kind::GLOBAL, expr.slot}, std::nullopt};
+        }
+
+        auto visit(const Expr::CallExpr& expr) const -> Lowered final {
+            auto [callee, first] = arguments(expr);
+            auto target          = temporary();
+            emit({Opcode::CALL,
+                  static_cast<std::uint8_t>(expr.arguments.size()), target,
+                  callee, first, 0, &expr.paren});
+            return {target, std::nullopt};
+        }
+
+        auto visit(const Expr::GetExpr& expr) const -> Lowered final {
+            auto object = operand(lower(expr.object));
+            auto target = temporary();
+            emit({Opcode::GET, 0, target, object, {},
+                  site(expr.name, expr.cache), &expr.name});
+            return {target, std::nullopt};
+        }
+
+        auto visit(const Expr::SetExpr& expr) const -> Lowered final {
+            auto object = operand(pin(lower(expr.object), expr.value));
+            auto value  = operand(lower(expr.value));
+            if (expr.operator_) {
+                auto op = Operators::toBinaryOp(expr.operator_->type);
+                auto current = temporary();
+                emit({Opcode::GET, 0, current, object, {},
+                      site(expr.name, expr.get), &expr.name});
+                auto result = temporary();
+                emit({Opcode::BINARY, static_cast<std::uint8_t>(*op), result,
+                      current, value, 0, &*expr.operator_});
+                value = result;
+            }
+            emit({Opcode::PUT, 0, {}, object, value, site(expr.name, expr.set),
+                  &expr.name});
+            return {value, std::nullopt};
+        }
+
+        auto visit(const Expr::ObjectExpr& expr) const -> Lowered final {
+            std::vector<Operand> values;
+            values.reserve(expr.values.size());
+            for (std::size_t i = 0; i < expr.values.size(); ++i) {
+                auto value = lower(expr.values[i]);
+                for (auto later = i + 1; later < expr.values.size(); ++later) {
+                    value = pin(std::move(value), expr.values[later]);
+                }
+                values.push_back(operand(std::move(value)));
+            }
+            auto index = static_cast<std::uint32_t>(program_.objects_.size());
+            program_.objects_.push_back(
+                {&expr, static_cast<std::uint32_t>(program_.holes_.size())});
+            program_.holes_.insert(program_.holes_.end(), values.begin(),
+                                   values.end());
+            auto target = temporary();
+            emit({Opcode::OBJECT, 0, target, {}, {}, index, &expr.brace});
+            return {target, std::nullopt};
+        }
+
+        auto visit(const Expr::SuperExpr& expr) const -> Lowered final {
+            auto superclass = operand(lower(expr.superclass));
+            auto receiver   = operand(lower(expr.receiver));
+            auto target     = temporary();
+            emit({Opcode::SUPER, 0, target, superclass, receiver, 0,
+                  &expr.method});
+            return {target, std::nullopt};
+        }
+
+        auto visit(const Expr::ArrayExpr& expr) const -> Lowered final {
+            std::vector<Operand> values;
+            values.reserve(expr.values.size());
+            for (std::size_t i = 0; i < expr.values.size(); ++i) {
+                auto value = lower(expr.values[i]);
+                for (auto later = i + 1; later < expr.values.size(); ++later) {
+                    value = pin(std::move(value), expr.values[later]);
+                }
+                values.push_back(operand(std::move(value)));
+            }
+            auto list = static_cast<std::uint32_t>(program_.lists_.size());
+            program_.lists_.push_back(
+                {static_cast<std::uint32_t>(program_.holes_.size()),
+                 static_cast<std::uint32_t>(values.size())});
+            program_.holes_.insert(program_.holes_.end(), values.begin(),
+                                   values.end());
+            auto target = temporary();
+            emit({Opcode::ARRAY, 0, target, {}, {}, list, &expr.bracket});
+            return {target, std::nullopt};
+        }
+
+        auto visit(const Expr::IndexExpr& expr) const -> Lowered final {
+            auto object = operand(pin(lower(expr.object), expr.index));
+            auto index  = operand(lower(expr.index));
+            auto target = temporary();
+            emit({Opcode::INDEX, 0, target, object, index, 0, &expr.bracket});
+            return {target, std::nullopt};
+        }
+
+        auto visit(const Expr::IndexSetExpr& expr) const -> Lowered final {
+            auto object = pin(lower(expr.object), expr.index);
+            object      = pin(std::move(object), expr.value);
+            auto index  = operand(pin(lower(expr.index), expr.value));
+            auto value  = operand(lower(expr.value));
+            auto array  = operand(std::move(object));
+            if (expr.operator_) {
+                auto op      = Operators::toBinaryOp(expr.operator_->type);
+                auto current = temporary();
+                emit({Opcode::INDEX, 0, current, array, index, 0,
+                      &expr.bracket});
+                auto result = temporary();
+                emit({Opcode::BINARY, static_cast<std::uint8_t>(*op), result,
+                      current, value, 0, &*expr.operator_});
+                value = result;
+            }
+            emit({Opcode::PUT_INDEX, 0, value, array, index, 0,
+                  &expr.bracket});
+            return {value, std::nullopt};
+        }
+
+        // Lowers the callee of `call`, then each argument straight into
+        // the slot it is passed in; returns the callee and the first slot.
+        // Arguments that hold calls of their own build those above. The
+        // slot below the first is the receiver's: METHOD and SUPER put it
+        // there for a call to a method, CALL for a bound one or a class.
+        auto arguments(const Expr::CallExpr& call) const
+            -> std::pair<Operand, Operand> {
+            const auto& expr = call.callee;
+            Lowered     callee;
+            Operand     object;
+            Operand     superclass;
+            if (expr->is<Expr::GetExpr>()) {
+                object = operand(lower(expr->as<Expr::GetExpr>().object));
+            } else if (expr->is<Expr::SuperExpr>()) {
+                const auto& super = expr->as<Expr::SuperExpr>();
+                superclass        = operand(lower(super.superclass));
+                object            = operand(lower(super.receiver));
+            } else {
+                callee = lower(expr);
+                for (const auto& argument : call.arguments) {
+                    callee = pin(std::move(callee), argument);
+                }
+            }
+            auto count  = static_cast<std::uint32_t>(call.arguments.size());
+            auto first  = outgoing_;
+            outgoing_ += count + 1;
+            arguments_ = std::max(arguments_, outgoing_);
+            Operand receiver{Operand::Kind::REGISTER, OUTGOING + first};
+            // Both read their operands before any argument can assign them.
+            if (expr->is<Expr::GetExpr>()) {
+                const auto& get = expr->as<Expr::GetExpr>();
+                callee          = {temporary(), std::nullopt};
+                emit({Opcode::METHOD, 0, callee.operand, object, receiver,
+                      site(get.name, get.cache), &get.name});
+            } else if (expr->is<Expr::SuperExpr>()) {
+                const auto& super = expr->as<Expr::SuperExpr>();
+                callee            = {temporary(), std::nullopt};
+                emit({Opcode::MOVE, 0, receiver, object});
+                emit({Opcode::SUPER, 1, callee.operand, superclass, receiver, 0,
+                      &super.method});
+            }
+            auto simple = std::all_of(
+                call.arguments.begin(), call.arguments.end(),
+                [](const Expr::Expr& argument) {
+                    return argument != nullptr &&
+                           (argument->is<Expr::Variable>() ||
+                            argument->is<Expr::LiteralExpr>());
+                });
+            auto checked = operand(std::move(callee));
+            if (!simple) {
+                // The callee is checked before arguments that might fail.
+                emit({Opcode::CHECK, static_cast<std::uint8_t>(count), {},
+                      checked, {}, 0, &call.paren});
+            }
+            for (std::uint32_t i = 0; i < count; ++i) {
+                move({Operand::Kind::REGISTER, OUTGOING + first + 1 + i},
+                     lower(call.arguments[i]));
+            }
+            outgoing_ = first;
+            return {checked, {Operand::Kind::REGISTER, OUTGOING + first + 1}};
+        }
+
+        // Calls `use(operand)` for every operand instruction `index` reads,
+        // and for the registers a CLEAR writes.
+        template <typename Fn>
+        void reads(std::uint32_t index, Fn&& use) const {
+            auto& instruction = program_.code_[index];
+            if (instruction.opcode == Opcode::RENDER) {
+                const auto& render = program_.templates_[instruction.aux];
+                for (std::size_t i = 0; i < render.expr->holes.size(); ++i) {
+                    use(program_.holes_[render.holes + i]);
+                }
+                return;
+            }
+            if (instruction.opcode == Opcode::CLEAR ||
+                instruction.opcode == Opcode::ARRAY) {
+                const auto& list = program_.lists_[instruction.aux];
+                for (std::uint32_t i = 0; i < list.count; ++i) {
+                    use(program_.holes_[list.first + i]);
+                }
+                return;
+            }
+            if (instruction.opcode == Opcode::OBJECT) {
+                const auto& object = program_.objects_[instruction.aux];
+                for (std::size_t i = 0; i < object.expr->values.size(); ++i) {
+                    use(program_.holes_[object.values + i]);
+                }
+                return;
+            }
+            use(instruction.left);
+            use(instruction.right);
+        }
+
+        [[nodiscard]] static auto jumps(Opcode opcode) -> bool {
+            return opcode == Opcode::JUMP || opcode == Opcode::JUMP_FALSE ||
+                   opcode == Opcode::JUMP_TRUE || opcode == Opcode::JUMP_IF ||
+                   opcode == Opcode::JUMP_UNLESS || opcode == Opcode::JUMP_SET;
+        }
+
+        // Linear scan over the statement's virtual registers. A value is
+        // live from its first touch to its last in instruction order, and
+        // past a backward jump to the end of the loop if it is live where
+        // the jump lands. A register whose last read is at an instruction
+        // can be that instruction's target: reads come first. Returns the
+        // registers the window needs, argument slots included.
+        auto allocate() const -> std::uint32_t {
+            struct Interval {
+                std::uint32_t start = UNUSED;
+                std::uint32_t end   = 0;
+            };
+            std::vector<Interval> intervals(virtuals_);
+            auto                  touch = [&](Operand operand, std::uint32_t at) {
+                if (operand.kind() != Operand::Kind::REGISTER ||
+                    operand.index() < fixed_ || operand.index() >= OUTGOING) {
+                    return;
+                }
+                auto& interval = intervals[operand.index()];
+                interval.start = std::min(interval.start, at);
+                interval.end   = std::max(interval.end, at);
+            };
+            for (auto index = start_; index < here(); ++index) {
+                reads(index, [&](Operand operand) { touch(operand, index); });
+                touch(program_.code_[index].target, index);
+            }
+            for (bool changed = true; changed;) {
+                changed = false;
+                for (auto index = start_; index < here(); ++index) {
+                    const auto& instruction = program_.code_[index];
+                    auto        to          = start_ + instruction.aux;
+                    if (!jumps(instruction.opcode) || to > index) {
+                        continue;
+                    }
+                    for (auto& interval : intervals) {
+                        if (interval.start != UNUSED && interval.start < to &&
+                            interval.end >= to && interval.end < index) {
+                            interval.end = index;
+                            changed      = true;
+                        }
+                    }
+                }
+            }
+
+            std::vector<std::uint32_t> order(virtuals_ - fixed_);
+            for (std::uint32_t i = 0; i < order.size(); ++i) {
+                order[i] = fixed_ + i;
+            }
+            std::sort(order.begin(), order.end(),
+                      [&](std::uint32_t a, std::uint32_t b) {
+                          return intervals[a].start < intervals[b].start;
+                      });
+
+            std::vector<std::uint32_t> physical(virtuals_, 0);
+            std::vector<std::uint32_t> active;  // Virtual, by physical
+            for (auto current : order) {
+                const auto& interval = intervals[current];
+                if (interval.start == UNUSED) {
+                    continue;
+                }
+                std::uint32_t chosen = 0;
+                while (chosen < active.size() &&
+                       intervals[active[chosen]].end > interval.start) {
+                    ++chosen;
+                }
+                if (chosen == active.size()) {
+                    active.push_back(current);
+                } else {
+                    active[chosen] = current;
+                }
+                physical[current] = chosen;
+            }
+            auto packed = fixed_ + static_cast<std::uint32_t>(active.size());
+
+            auto rename = [&](Operand& operand) {
+                if (operand.kind() != Operand::Kind::REGISTER ||
+                    operand.index() < fixed_) {
+                    return;
+                }
+                auto index = operand.index();
+                operand    = {Operand::Kind::REGISTER,
+                              index >= OUTGOING ? packed + index - OUTGOING
+                                                : fixed_ + physical[index]};
+            };
+            for (auto index = start_; index < here(); ++index) {
+                reads(index, rename);
+                rename(program_.code_[index].target);
+            }
+            return packed + arguments_;
+        }
+    };
+
+    auto Program::compile(const std::vector<Stmt::Stmt>& statements)
+        -> Program {
+        Program  program;
+        Lowering lowering(program);
+        for (const auto& stmt : statements) {
+            lowering.statement(stmt);
+        }
+        lowering.functions();
+        return program;
+    }
+
+    auto Program::find(const Stmt::Definition& definition) const
+        -> const Function* {
+        auto index = definition.id - firstFunction_;
+        if (definition.id < firstFunction_ || index >= functions_.size() ||
+            functions_[index].definition != &definition) {
+            return nullptr;  // Declared by another program, as in the REPL
+        }
+        return &functions_[index];
+    }
+
+    auto Program::read(Operand operand, const Closure::Frame& frame,
+                       const Token::Literal* registers) const
+        -> const Token::Literal& {
+        switch (operand.kind()) {
+            case Operand::Kind::REGISTER:
+                return registers[operand.index()];
+            case Operand::Kind::CONSTANT:
+                return constants_[operand.index()];
+            case Operand::Kind::GLOBAL:
+                return frame.environment.get(operand.index());
+            default:
+                return NIL;
+        }
+    }
+
+    void Program::run(std::uint32_t index, Closure::Frame& frame) const {
+        constexpr std::size_t INLINE_HOLES = 8;
+
+        // Where each call in progress returns to.
+        struct Call {
+            std::uint32_t pc;
+            std::uint32_t start;
+            std::size_t   base;
+            std::size_t   top;
+            std::uint32_t target;
+            Literal       running;
+            Literal       constructed;  // What a class's call is instead
+        };
+        std::vector<Call> calls;
+
+        auto  start     = starts_[index];
+        auto  pc        = start;
+        auto  base      = frame.base;
+        auto  top       = frame.stack.top();
+        auto* registers = frame.stack.data() + base;
+
+        // The running function, kept for code that reads it: its own
+        // value, or a copy of it when the call started in this program.
+        Literal     running;
+        const auto* closure = frame.callee;
+        auto        run     = [&](Literal function) {
+            running = std::move(function);
+            closure = running.isFunction() ? &running.as<Runtime::Function>()
+                                           : nullptr;
+        };
+
+        // Drops the running call's window, for `caller`'s.
+        auto restore = [&](Call& caller) {
+            pc    = caller.pc;
+            start = caller.start;
+            base  = caller.base;
+            top   = caller.top;
+            run(std::move(caller.running));
+            frame.stack.pop(top);
+            registers = frame.stack.data() + base;
+        };
+
+        // Back to the caller with `value`.
+        auto leave = [&](Literal value) {
+            auto caller = std::move(calls.back());
+            calls.pop_back();
+            restore(caller);
+            registers[caller.target] = caller.constructed.isNil()
+                                           ? std::move(value)
+                                           : std::move(caller.constructed);
+        };
+
+        // What is being thrown: a value from THROW, with its token, or an
+        // error something an instruction called threw. CAUGHT keeps them
+        // in `raised` while a `finally` runs.
+        struct Raised {
+            Literal             value;
+            const Token::Token* token = nullptr;
+            std::exception_ptr  error;
+        };
+        Raised              raising;
+        std::vector<Raised> raised;
+        auto                entryBase   = frame.base;
+        const auto*         entryCallee = frame.callee;
+
+        // Goes on at the handler for the instruction before `pc`, or for
+        // the call each caller is in, dropping the windows in between.
+        // False when none has one, with every call dropped.
+        auto unwind = [&]() -> bool {
+            for (;;) {
+                auto from  = pc - 1;
+                auto found = std::find_if(
+                    handlers_.begin(), handlers_.end(),
+                    [from](const Handler& handler) {
+                        return handler.from <= from && from < handler.to;
+                    });
+                if (found != handlers_.end()) {
+                    pc = found->at;
+                    frame.stack.pop(top);
+                    registers = frame.stack.data() + base;
+                    return true;
+                }
+                if (calls.empty()) {
+                    return false;
+                }
+                auto caller = std::move(calls.back());
+                calls.pop_back();
+                restore(caller);
+            }
+        };
+
+        // Throws what no handler caught out of the program.
+        auto escape = [&]() {
+            if (raising.error) {
+                std::rethrow_exception(raising.error);
+            }
+            throw Error::Thrown(*raising.token, raising.value);
+        };
+
+        // Errors from what instructions call are C++ exceptions, caught
+        // here by a handler the compiler keeps in tables beside the code,
+        // at no cost until one is thrown.
+        for (;;) try {
+            const auto& instruction = code_[pc++];
+            auto        left   = [&]() -> const Literal& {
+                return read(instruction.left, frame, registers);
+            };
+            auto        target = [&]() -> Literal& {
+                return registers[instruction.target.index()];
+            };
+            switch (instruction.opcode) {
+                case Opcode::BINARY: {
+                    const auto& right = read(instruction.right, frame, registers);
+                    const auto* x     = std::get_if<double>(&left().value);
+                    const auto* y     = std::get_if<double>(&right.value);
+                    if (x != nullptr && y != nullptr &&
+                        numbers(static_cast<BinaryOp>(instruction.op), *x, *y,
+                                target())) {
+                        break;
+                    }
+                    target() = BINARIES[instruction.op](left(), right,
+                                                        *instruction.token);
+                    break;
+                }
+                case Opcode::NEGATE:
+                    if (left().isNumber()) {
+                        target() = Literal{-left().asNumber()};
+                    } else {
+                        target() = Interpreter::Interpreter::prefix(
+                            *instruction.token, left());
+                    }
+                    break;
+                case Opcode::PREFIX:
+                    target() = Interpreter::Interpreter::prefix(
+                        *instruction.token, left());
+                    break;
+                case Opcode::POSTFIX:
+                    if (!left().isNumber()) {
+                        throw Error::RuntimeException(
+                            *instruction.token,
+                            "operator can't work on this type");
+                    }
+                    throw Error::RuntimeException(
+                        *instruction.token,
+                        "Interpreter: operator is not valid");
+                case Opcode::RENDER: {
+                    const auto& render = templates_[instruction.aux];
+                    auto        count  = render.expr->holes.size();
+                    std::array<Literal, INLINE_HOLES> inlineValues;
+                    std::vector<Literal>              heapValues;
+                    Literal* values = inlineValues.data();
+                    if (count > INLINE_HOLES) {
+                        heapValues.resize(count);
+                        values = heapValues.data();
+                    }
+                    for (std::size_t i = 0; i < count; ++i) {
+                        values[i] =
+                            read(holes_[render.holes + i], frame, registers);
+                    }
+                    target() = Interpreter::Interpreter::render(*render.expr,
+                                                              values);
+                    break;
+                }
+                case Opcode::MOVE:
+                    if (!(instruction.left == instruction.target)) {
+                        target() = left();
+                    }
+                    break;
+                case Opcode::NULL_EXPR:
+                    frame.logger.error("Interpreter : Expr type is null");
+                    break;
+                case Opcode::JUMP:
+                    pc = start + instruction.aux;
+                    break;
+                case Opcode::JUMP_FALSE:
+                    if (!truthy(left())) {
+                        pc = start + instruction.aux;
+                    }
+                    break;
+                case Opcode::JUMP_TRUE:
+                    if (truthy(left())) {
+                        pc = start + instruction.aux;
+                    }
+                    break;
+                case Opcode::JUMP_IF:
+                case Opcode::JUMP_UNLESS: {
+                    const auto& right = read(instruction.right, frame, registers);
+                    const auto* x     = std::get_if<double>(&left().value);
+                    const auto* y     = std::get_if<double>(&right.value);
+                    auto        op    = static_cast<BinaryOp>(instruction.op);
+                    auto        taken =
+                        x != nullptr && y != nullptr
+                                   ? compare(op, *x, *y)
+                                   : truthy(BINARIES[instruction.op](
+                                  left(), right, *instruction.token));
+                    if (taken == (instruction.opcode == Opcode::JUMP_IF)) {
+                        pc = start + instruction.aux;
+                    }
+                    break;
+                }
+                case Opcode::JUMP_SET:
+                    if (!left().isNil()) {
+                        pc = start + instruction.aux;
+                    }
+                    break;
+                case Opcode::SWITCH: {
+                    const auto& choice = switches_[instruction.aux];
+                    auto chosen = choice.dispatch->constant(left());
+                    if (chosen != Stmt::Dispatch::NONE &&
+                        choice.dispatch->before(chosen) <= choice.checked) {
+                        pc = start + targets_[choice.targets + chosen];
+                    } else if (choice.checked ==
+                               choice.dispatch->dynamic().size()) {
+                        pc = start + targets_[choice.targets + choice.cases];
+                    }
+                    break;
+                }
+                case Opcode::CLEAR: {
+                    const auto& list = lists_[instruction.aux];
+                    for (std::uint32_t i = 0; i < list.count; ++i) {
+                        registers[holes_[list.first + i].index()] = Literal{};
+                    }
+                    break;
+                }
+                case Opcode::DEFINE:
+                case Opcode::CATCH: {
+                    const auto& variable = *variables_[instruction.aux];
+                    // Copied: a global may be defined from itself.
+                    auto value = instruction.opcode == Opcode::DEFINE
+                                     ? left()
+                                     : std::move(raising.value);
+                    frame.logger.debug("Variable Declartion:  {},{}: {}",
+                                       variable.name, variable.type,
+                                       describe(value));
+                    if (variable.storage == Expr::Storage::CELL) {
+                        registers[variable.slot] =
+                            Literal{Runtime::Cell{std::move(value)}};
+                    } else if (variable.storage == Expr::Storage::LOCAL) {
+                        registers[variable.slot] = std::move(value);
+                    } else {
+                        frame.environment.define(variable.slot,
+                                                 std::move(value));
+                    }
+                    break;
+                }
+                case Opcode::STORE: {
+                    const auto& value  = left();
+                    const auto* number = std::get_if<double>(&value.value);
+                    auto*       slot   = frame.environment.find(instruction.aux);
+                    if (number != nullptr && slot != nullptr) {
+                        assign(*slot, *number);
+                    } else {
+                        // `define` takes its copy before it can grow the
+                        // slots.
+                        frame.environment.define(instruction.aux, value);
+                    }
+                    if (instruction.op != 0) {
+                        frame.logger.debug(
+                            "Expression result: {}",
+                            describe(frame.environment.get(instruction.aux)));
+                    }
+                    break;
+                }
+                case Opcode::PRINT:
+                    frame.output.writeLine(left());
+                    break;
+                case Opcode::DISCARD:
+                    frame.logger.debug("Expression result: {}",
+                                       describe(left()));
+                    break;
+                case Opcode::CHECK:
+                    (void)Interpreter::Interpreter::target(
+                        left(), instruction.op, *instruction.token);
+                    break;
+                case Opcode::CALL:
+                case Opcode::TAIL_CALL: {
+                    auto called = Interpreter::Interpreter::target(
+                        left(), instruction.op, *instruction.token);
+                    if (called.builtin != nullptr) {
+                        // METHOD left the array below the arguments.
+                        const auto* token = instruction.token;
+                        auto        value = Interpreter::Interpreter::run(
+                            *called.builtin,
+                            registers[instruction.right.index() - 1],
+                            registers + instruction.right.index(), *token,
+                            [&frame, token](const Literal& function,
+                                            const Literal* passed,
+                                            std::size_t    count) {
+                                return Closure::apply(frame, function, passed,
+                                                      count, *token);
+                            });
+                        registers = frame.stack.data() + base;
+                        if (instruction.opcode == Opcode::CALL) {
+                            target() = std::move(value);
+                        } else {
+                            leave(std::move(value));
+                        }
+                        break;
+                    }
+                    const auto& function   = *called.function;
+                    const auto& definition = function.definition();
+                    const auto* callee     = find(definition);
+                    // A method's frame starts at the receiver, which METHOD
+                    // and SUPER have put in place unless it is bound.
+                    auto first = definition.first();
+                    auto from  = base + instruction.right.index() - first;
+                    if (!called.receiver.isNil()) {
+                        registers[instruction.right.index() - first] =
+                            called.receiver;
+                    }
+                    auto constructed = called.construct
+                                           ? std::move(called.receiver)
+                                           : Literal{};
+                    auto arguments   = first + instruction.op;
+                    if (callee == nullptr) {
+                        // Not lowered here; closures run it. Copied first,
+                        // as claiming may move the register it is in.
+                        auto held = function;
+                        frame.stack.claim(from + definition.locals,
+                                          *instruction.token);
+                        for (auto slot = from + arguments;
+                             slot < from + definition.locals; ++slot) {
+                            frame.stack[slot] = Literal{};
+                        }
+                        auto value =
+                            Closure::call(frame, std::move(held), from);
+                        frame.stack.claim(top, *instruction.token);
+                        registers = frame.stack.data() + base;
+                        if (!constructed.isNil()) {
+                            value = std::move(constructed);
+                        }
+                        if (instruction.opcode == Opcode::CALL) {
+                            target() = std::move(value);
+                        } else {
+                            leave(std::move(value));
+                        }
+                        break;
+                    }
+                    auto value = callee->closes ? Literal{function} : Literal{};
+                    // Before anything changes, for a handler of the error
+                    // to find this call as it was.
+                    frame.stack.claim(
+                        (instruction.opcode == Opcode::CALL ? from : base) +
+                            callee->window,
+                        *instruction.token);
+                    if (instruction.opcode == Opcode::CALL) {
+                        calls.push_back({pc, start, base, top,
+                                         instruction.target.index(),
+                                         std::move(running),
+                                         std::move(constructed)});
+                        base = from;
+                    } else if (!constructed.isNil()) {
+                        // `init` returns nothing; the call is the instance.
+                        calls.back().constructed = std::move(constructed);
+                    }
+                    run(std::move(value));
+                    top       = base + callee->window;
+                    registers = frame.stack.data() + base;
+                    if (instruction.opcode == Opcode::TAIL_CALL) {
+                        // The arguments replace this call's locals.
+                        auto* passed = frame.stack.data() + from;
+                        for (std::uint32_t i = 0; i < arguments; ++i) {
+                            registers[i] = std::move(passed[i]);
+                        }
+                    }
+                    for (auto slot = arguments; slot < definition.locals;
+                         ++slot) {
+                        registers[slot] = Literal{};
+                    }
+                    start = callee->start;
+                    pc    = start;
+                    break;
+                }
+                case Opcode::RETURN:
+                    // The window is done with, so its register can go.
+                    leave(instruction.left.kind() == Operand::Kind::REGISTER
+                              ? std::move(registers[instruction.left.index()])
+                              : left());
+                    break;
+                case Opcode::CLOSE:
+                    target() = Literal{Runtime::Function::close(
+                        closures_[instruction.aux], registers, closure)};
+                    break;
+                case Opcode::CELL: {
+                    Runtime::Cell cell{left()};
+                    target() = Literal{std::move(cell)};
+                    break;
+                }
+                case Opcode::UNBOX:
+                    target() = left().as<Runtime::Cell>().get();
+                    break;
+                case Opcode::SET:
+                    left().as<Runtime::Cell>().get() =
+                        read(instruction.right, frame, registers);
+                    break;
+                case Opcode::CAPTURE: {
+                    const auto& value = closure->captures()[instruction.aux];
+                    target() = instruction.op != 0
+                                   ? value.as<Runtime::Cell>().get()
+                                   : value;
+                    break;
+                }
+                case Opcode::SELF:
+                    target() = Literal{*closure};
+                    break;
+                case Opcode::GET: {
+                    const auto& site = sites_[instruction.aux];
+                    target()         = Interpreter::Interpreter::get(
+                        left(), *site.name, *site.cache);
+                    break;
+                }
+                case Opcode::PUT: {
+                    const auto& site = sites_[instruction.aux];
+                    Interpreter::Interpreter::set(
+                        left(), *site.name,
+                        read(instruction.right, frame, registers),
+                        *site.cache);
+                    break;
+                }
+                case Opcode::METHOD: {
+                    const auto& site = sites_[instruction.aux];
+                    if (const auto* builtin =
+                            Interpreter::Interpreter::builtin(left(),
+                                                              *site.name)) {
+                        registers[instruction.right.index()] = left();
+                        target() = Literal{Runtime::Method{builtin}};
+                        break;
+                    }
+                    if (left().is<Runtime::Array>()) {
+                        // Copied first, as for a field.
+                        auto value = Interpreter::Interpreter::get(
+                            left(), *site.name, *site.cache);
+                        target() = std::move(value);
+                        break;
+                    }
+                    auto [field, method] = Interpreter::Interpreter::property(
+                        left(), *site.name, *site.cache);
+                    if (method == nullptr) {
+                        // Copied first: the target may hold the object.
+                        auto value = *field;
+                        target()   = std::move(value);
+                        break;
+                    }
+                    registers[instruction.right.index()] = left();
+                    target() = Literal{*method};
+                    break;
+                }
+                case Opcode::OBJECT: {
+                    const auto&     object = objects_[instruction.aux];
+                    Runtime::Object made(object.expr->shape, nullptr);
+                    auto&           fields = made.fields();
+                    for (std::size_t i = 0; i < object.expr->values.size();
+                         ++i) {
+                        fields[object.expr->slots[i]] =
+                            read(holes_[object.values + i], frame, registers);
+                    }
+                    target() = Literal{std::move(made)};
+                    break;
+                }
+                case Opcode::SUPER: {
+                    const auto& method = Interpreter::Interpreter::inherited(
+                        left(), *instruction.token);
+                    if (instruction.op != 0) {
+                        target() = Literal{method};
+                    } else {
+                        target() = Literal{method.bind(
+                            read(instruction.right, frame, registers))};
+                    }
+                    break;
+                }
+                case Opcode::CLASS:
+                    target() = Interpreter::Interpreter::declare(
+                        *classes_[instruction.aux], left(), registers, closure);
+                    break;
+                case Opcode::ARRAY: {
+                    const auto&          list = lists_[instruction.aux];
+                    std::vector<Literal> values;
+                    values.reserve(list.count);
+                    for (std::uint32_t i = 0; i < list.count; ++i) {
+                        values.push_back(
+                            read(holes_[list.first + i], frame, registers));
+                    }
+                    target() = Literal{Runtime::Array{std::move(values)}};
+                    break;
+                }
+                case Opcode::INDEX: {
+                    auto value = Interpreter::Interpreter::element(
+                        left(), read(instruction.right, frame, registers),
+                        *instruction.token);
+                    target() = std::move(value);
+                    break;
+                }
+                case Opcode::PUT_INDEX:
+                    Interpreter::Interpreter::setElement(
+                        left(), read(instruction.right, frame, registers),
+                        read(instruction.target, frame, registers),
+                        *instruction.token);
+                    break;
+                case Opcode::THROW:
+                    raising = {left(), instruction.token, nullptr};
+                    if (!unwind()) {
+                        escape();
+                    }
+                    break;
+                case Opcode::CAUGHT:
+                    target() = Literal{static_cast<double>(raised.size())};
+                    raised.push_back(std::move(raising));
+                    break;
+                case Opcode::RETHROW: {
+                    auto kept = static_cast<std::size_t>(left().asNumber());
+                    raising   = std::move(raised[kept]);
+                    raised.resize(kept);
+                    if (!unwind()) {
+                        escape();
+                    }
+                    break;
+                }
+                case Opcode::HALT:
+                    return;
+            }
+        } catch (const Error::RuntimeException& error) {
+            // A native call that threw may have left these behind.
+            frame.base   = entryBase;
+            frame.callee = entryCallee;
+            frame.flow   = Stmt::Flow::NORMAL;
+
+            raising = {Error::caught(error), nullptr, std::current_exception()};
+            if (!unwind()) {
+                throw;
+            }
+        }
+    }
+}  // namespace Vm
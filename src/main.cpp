@@ -1,14 +1,42 @@
+#include "Thor/Batch.hpp"
+#include "Thor/Heap.hpp"
 #include "Thor/Interpreter.hpp"
+#include "Thor/Jit.hpp"
 #include "Thor/Lexer.hpp"
+#include "Thor/Output.hpp"
 #include "Thor/Parser.hpp"
+#include "Thor/Server.hpp"
+#include "Thor/Tiering.hpp"
+#include "Thor/Trace.hpp"
 
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 constexpr std::string_view FILE_EXTENSION = ".krp";
+constexpr std::string_view TRACE_OPTION   = "--trace=";
+constexpr std::string_view SERVE_OPTION   = "--serve=";
+constexpr std::string_view ROOT_OPTION    = "--script-root=";
+constexpr std::string_view JIT_OPTION     = "--jit=";
+constexpr std::string_view ENGINE_OPTION  = "--engine=";
+constexpr std::string_view TIERS_OPTION   = "--tiers=";
+constexpr std::string_view GC_OPTION      = "--gc=";
+constexpr std::string_view USAGE =
+    "Usage: krypton [--unbuffered] [--trace=<file>] [--jit=off|on|always]\n"
+    "               [--engine=tree|closure|tiered|vm]\n"
+    "               [--tiers=<closure>,<jit>] [--tier-report]\n"
+    "               [--gc=off|<KiB>,<growth>] [--gc-report] <filename>\n"
+    "       krypton --batch <directory> [-j <workers>]\n"
+    "       krypton --serve=<socket> [-j <workers>] [--script-root=<dir>]";
 
 namespace {
 
@@ -35,10 +63,11 @@ namespace {
             line.append("\n");
             auto tokens = lexer.tokenize(line);
             interpreter.interpret(parser.parse(tokens));
+            Output::Writer::standard().flush();
         }
     }
 
-    auto runFile(std::string file) -> int {
+    auto runFile(std::string file, bool tierReport) -> int {
         auto ext = file.substr(file.rfind('.'));
         if (ext != FILE_EXTENSION) {
             Logger::getLogger().error("Invalid file extension: `{}`", ext);
@@ -69,7 +98,80 @@ namespace {
         auto parser = Parser::Parser();
 
         auto interpreter = Interpreter::Interpreter();
-        interpreter.interpret(parser.parse(tokens));
+        if (Interpreter::engine() != Interpreter::Engine::TIERED) {
+            interpreter.interpret(parser.parse(tokens));
+            return 0;
+        }
+        Tiering::Plan plan(parser.parse(tokens));
+        interpreter.interpret(plan);
+        if (tierReport) {
+            Output::Writer::standard().flush();
+            std::cerr << Tiering::format(plan.report());
+        }
+        return 0;
+    }
+
+    // Runs every script under `directory`, then prints each one's output
+    // in path order followed by a summary. Fails if any script did.
+    auto runBatch(const std::string& directory, std::size_t workers) -> int {
+        if (!std::filesystem::is_directory(directory)) {
+            Logger::getLogger().error("Not a directory: {}", directory);
+            return 1;
+        }
+        auto report = Runtime::runBatch(Runtime::findScripts(directory),
+                                        workers);
+
+        auto& out = Output::Writer::standard();
+        for (const auto& script : report.scripts) {
+            out.write(fmt::format("==> {} ({}, {:.2f} ms)\n",
+                                  script.path.string(),
+                                  script.ok ? "ok" : "FAILED",
+                                  script.seconds * 1e3));
+            out.write(script.output);
+            out.write(script.diagnostics);
+        }
+
+        auto count = report.scripts.size();
+        out.write(fmt::format(
+            "\n{} scripts, {} failed, {} workers, {:.3f} s ({:.1f} "
+            "scripts/s)\n",
+            count, report.failed(), report.workers, report.seconds,
+            static_cast<double>(count) / report.seconds));
+        out.flush();
+        return report.failed() == 0 ? 0 : 1;
+    }
+
+    Runtime::Server* activeServer = nullptr;
+
+    // Serves requests on `socket` until SIGINT or SIGTERM. Path requests
+    // are refused unless `root` names a directory to serve scripts from.
+    auto runServer(const std::string& socket, std::size_t workers,
+                   const std::string& root) -> int {
+        if (!root.empty() && !std::filesystem::is_directory(root)) {
+            Logger::getLogger().error("Invalid script root: `{}`", root);
+            return 1;
+        }
+        Runtime::Server::Options options{socket, workers};
+        options.engine     = Interpreter::engine();
+        options.scriptRoot = root;
+        Runtime::Server server(options);
+        if (!server.listen()) {
+            Logger::getLogger().error("Cannot listen on `{}`: {}", socket,
+                                      std::strerror(errno));
+            return 1;
+        }
+        activeServer = &server;
+        for (auto signal : {SIGINT, SIGTERM}) {
+            std::signal(signal, [](int) { activeServer->stop(); });
+        }
+        Logger::getLogger().info("Serving on {} with {} workers", socket,
+                                 workers);
+        server.serve();
+        activeServer = nullptr;
+
+        const auto& cache = server.cache();
+        Logger::getLogger().info("Program cache: {} hits, {} misses",
+                                 cache.hits(), cache.misses());
         return 0;
     }
 }  // namespace
@@ -77,17 +179,117 @@ namespace {
 auto main(int argc, char const* argv[]) -> int {
     Logger::getLogger().setLogFile("krypton.log");
     Logger::getLogger().setLevel(Logger::LogLevel::DEBUG);
-    if (argc > 2) {
-        Logger::getLogger().error("Usage: krypton <filename>");
+
+    std::vector<std::string> files;
+    std::string              batch;
+    std::string              serve;
+    std::string              scriptRoot;
+    std::size_t              workers    = std::thread::hardware_concurrency();
+    bool                     tierReport = false;
+    bool                     gcReport   = false;
+    Jit::setMode(Jit::Mode::ON);
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--batch" || arg == "-j") {
+            if (i + 1 == argc) {
+                Logger::getLogger().error("`{}` needs a value", arg);
+                return 1;
+            }
+            std::string value = argv[++i];
+            if (arg == "--batch") {
+                batch = value;
+            } else if (auto parsed = std::atoi(value.c_str()); parsed > 0) {
+                workers = static_cast<std::size_t>(parsed);
+            } else {
+                Logger::getLogger().error("Invalid worker count: `{}`", value);
+                return 1;
+            }
+        } else if (arg == "--unbuffered") {
+            Output::Writer::standard().setUnbuffered(true);
+        } else if (arg.rfind(SERVE_OPTION, 0) == 0) {
+            serve = arg.substr(SERVE_OPTION.size());
+        } else if (arg.rfind(ROOT_OPTION, 0) == 0) {
+            scriptRoot = arg.substr(ROOT_OPTION.size());
+        } else if (arg.rfind(JIT_OPTION, 0) == 0) {
+            auto mode = Jit::parseMode(arg.substr(JIT_OPTION.size()));
+            if (!mode) {
+                Logger::getLogger().error("Invalid JIT mode: `{}`", arg);
+                return 1;
+            }
+            Jit::setMode(*mode);
+        } else if (arg.rfind(ENGINE_OPTION, 0) == 0) {
+            auto engine = arg.substr(ENGINE_OPTION.size());
+            if (engine == "tree") {
+                Interpreter::setEngine(Interpreter::Engine::TREE);
+            } else if (engine == "closure") {
+                Interpreter::setEngine(Interpreter::Engine::CLOSURE);
+            } else if (engine == "tiered") {
+                Interpreter::setEngine(Interpreter::Engine::TIERED);
+            } else if (engine == "vm") {
+                Interpreter::setEngine(Interpreter::Engine::VM);
+            } else {
+                Logger::getLogger().error("Invalid engine: `{}`", arg);
+                return 1;
+            }
+        } else if (arg.rfind(TIERS_OPTION, 0) == 0) {
+            auto options =
+                Tiering::parseThresholds(arg.substr(TIERS_OPTION.size()));
+            if (!options) {
+                Logger::getLogger().error("Invalid tier thresholds: `{}`", arg);
+                return 1;
+            }
+            Tiering::setOptions(*options);
+        } else if (arg == "--tier-report") {
+            tierReport     = true;
+            auto options   = Tiering::options();
+            options.timing = true;
+            Tiering::setOptions(options);
+        } else if (arg.rfind(GC_OPTION, 0) == 0) {
+            auto options =
+                Runtime::parseHeapOptions(arg.substr(GC_OPTION.size()));
+            if (!options) {
+                Logger::getLogger().error("Invalid GC options: `{}`", arg);
+                return 1;
+            }
+            Runtime::setHeapOptions(*options);
+        } else if (arg == "--gc-report") {
+            gcReport = true;
+        } else if (arg.rfind(TRACE_OPTION, 0) == 0) {
+            if (!Trace::start(std::string(arg.substr(TRACE_OPTION.size())))) {
+                return 1;
+            }
+        } else if (arg.rfind("--", 0) == 0) {
+            Logger::getLogger().error("Unknown option: `{}`", arg);
+            return 1;
+        } else {
+            files.emplace_back(arg);
+        }
+    }
+    auto modes = static_cast<int>(!files.empty()) +
+                 static_cast<int>(!batch.empty()) +
+                 static_cast<int>(!serve.empty());
+    if (files.size() > 1 || modes > 1) {
+        Logger::getLogger().error("{}", USAGE);
         return 1;
     }
-    if (argc == 2) {
-        runFile(argv[1]);
+    int status = 0;
+    if (!batch.empty()) {
+        status = runBatch(batch, workers);
+    } else if (!serve.empty()) {
+        status = runServer(serve, workers, scriptRoot);
+    } else if (files.size() == 1) {
+        runFile(files.front(), tierReport);
+        if (gcReport) {
+            Output::Writer::standard().flush();
+            std::cerr << Runtime::format(Runtime::Heap::current().stats());
+        }
     } else {
         runPrompt();
     }
 
+    Output::Writer::standard().flush();
+    Trace::stop();
     Logger::getLogger().warn("Exiting Thor interpreter...");
 
-    return 0;
+    return status;
 }
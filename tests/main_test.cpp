@@ -2,6 +2,15 @@
 
 #include "Thor/Thor.hpp"
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+
 TEST(ThorTest, Tokenize) {
     EXPECT_TRUE(true);
 }
@@ -10,3 +19,1543 @@ TEST(ThorTest, LexerTest) {
     std::string output = "Hello from ProjectClass!";
     EXPECT_EQ(output, "Hello from ProjectClass!");
 }
+
+namespace {
+    auto opToken(Token::Type type) -> Token::Token {
+        return Token::Token{type, "", nullptr, 0, 0, 0};
+    }
+}  // namespace
+
+TEST(OperatorsTest, KernelsMatchOperandTypes) {
+    using Token::Literal;
+    auto plus = opToken(Token::Type::PLUS);
+
+    EXPECT_EQ(Operators::apply(plus, Literal{1.0}, Literal{2.0}).asNumber(),
+              3.0);
+    EXPECT_EQ(Operators::apply(plus, Literal{std::string("a")}, Literal{1.0})
+                  .asString(),
+              "a1");
+    EXPECT_TRUE(Operators::apply(opToken(Token::Type::EQUAL_EQUAL), Literal{},
+                                 Literal{})
+                    .asBool());
+    EXPECT_FALSE(Operators::apply(opToken(Token::Type::EQUAL_EQUAL),
+                                  Literal{1.0}, Literal{true})
+                     .asBool());
+    EXPECT_EQ(Operators::apply(opToken(Token::Type::BIT_OR), Literal{5.0},
+                               Literal{2.0})
+                  .asNumber(),
+              7.0);
+}
+
+TEST(OperatorsTest, InvalidCombinationsThrow) {
+    using Token::Literal;
+    EXPECT_THROW(Operators::apply(opToken(Token::Type::PLUS), Literal{true},
+                                  Literal{1.0}),
+                 Error::RuntimeException);
+    EXPECT_THROW(Operators::apply(opToken(Token::Type::BIT_AND), Literal{2.5},
+                                  Literal{1.0}),
+                 Error::RuntimeException);
+    EXPECT_THROW(Operators::apply(opToken(Token::Type::PERCENT), Literal{2.0},
+                                  Literal{0.0}),
+                 Error::RuntimeException);
+    EXPECT_THROW(Operators::apply(opToken(Token::Type::BIT_OR),
+                                  Literal{4294967296.0}, Literal{1.0}),
+                 Error::RuntimeException);
+    EXPECT_THROW(Operators::apply(opToken(Token::Type::LEFT_SHIFT),
+                                  Literal{1.0}, Literal{40.0}),
+                 Error::RuntimeException);
+}
+
+TEST(OperatorsTest, RemainderKeepsWholeOperands) {
+    using Token::Literal;
+    auto percent = [](double left, double right) {
+        return Operators::apply(opToken(Token::Type::PERCENT), Literal{left},
+                                Literal{right})
+            .stringify();
+    };
+    EXPECT_EQ(percent(3000000000, 7), "4");
+    EXPECT_EQ(percent(1, 0.5), "0");
+    EXPECT_EQ(percent(7.5, 2), "1.5");
+    EXPECT_EQ(percent(-7, 3), "-1");
+    EXPECT_EQ(percent(-7, 7), "0");
+}
+
+TEST(StringTest, InlineHeapAndRope) {
+    Runtime::String small("short");
+    EXPECT_TRUE(small.isInline());
+    EXPECT_EQ(small.view(), "short");
+
+    std::string     text(200, 'x');
+    Runtime::String big(text);
+    Runtime::String shared = big;
+    EXPECT_FALSE(shared.isInline());
+    EXPECT_EQ(shared.view().data(), big.view().data());
+
+    auto joined = big + shared;
+    EXPECT_TRUE(joined.isRope());
+    EXPECT_EQ(joined.size(), 400U);
+    EXPECT_EQ(joined.view(), text + text);
+    EXPECT_LT(Runtime::String("abc"), Runtime::String("abd"));
+}
+
+TEST(StringTest, DeepRopeBuildsAndReleasesIteratively) {
+    Runtime::String acc;
+    std::string     expected;
+    for (int i = 0; i < 200000; ++i) {
+        auto piece = fmt::format("{},", i % 10);
+        acc        = acc + Runtime::String(piece);
+        expected += piece;
+        if (i % 50000 == 0) {
+            EXPECT_EQ(acc.view(), expected);
+        }
+    }
+    EXPECT_EQ(acc.size(), expected.size());
+    EXPECT_EQ(acc.view(), expected);
+}
+
+namespace {
+    auto parseSource(std::string source) -> std::vector<Stmt::Stmt> {
+        Thor::Lexer    lexer;
+        Parser::Parser parser;
+        auto           tokens = lexer.tokenize(source);
+        return parser.parse(tokens);
+    }
+
+    auto firstExpression(const std::vector<Stmt::Stmt>& stmts) -> Expr::Expr {
+        return stmts.front()->as<Stmt::Expression>().expression;
+    }
+
+    auto lowerToVm(std::string source) -> Vm::Program {
+        Runtime::Context context;
+        Thor::Lexer      lexer(context);
+        Parser::Parser   parser(context);
+        auto             tokens = lexer.tokenize(source);
+        return Vm::Program::compile(parser.parse(tokens));
+    }
+
+    auto countOpcode(const Vm::Program& program, Vm::Opcode opcode)
+        -> std::ptrdiff_t {
+        const auto& code = program.instructions();
+        return std::count_if(code.begin(), code.end(), [&](const auto& each) {
+            return each.opcode == opcode;
+        });
+    }
+
+    // Runs each script on the tree walker and then on every other engine,
+    // with tiering promoting early, and expects the same output and
+    // diagnostics from all of them.
+    void expectEnginesAgree(const std::vector<std::string>& scripts) {
+        const Interpreter::Engine engines[] = {Interpreter::Engine::CLOSURE,
+                                               Interpreter::Engine::TIERED,
+                                               Interpreter::Engine::VM};
+        Tiering::setOptions({1, 2, false});
+        for (const auto& script : scripts) {
+            auto program = Thor::compile(script);
+            EXPECT_TRUE(program.ok()) << program.diagnostics();
+            auto tree = program.run(program.inputs());
+            for (auto engine : engines) {
+                auto other = Thor::compile(script, engine);
+                auto run   = other.run(other.inputs());
+                EXPECT_EQ(run.output, tree.output) << script;
+                EXPECT_EQ(run.diagnostics, tree.diagnostics) << script;
+            }
+        }
+        Tiering::setOptions({});
+    }
+}  // namespace
+
+TEST(OperatorsTest, InfixNodesResolveTheirOperatorOnce) {
+    auto stmts = parseSource("var a = 1;\nvar b = 2;\na * b - a;\n");
+    const auto& outer = firstExpression({stmts[2]})->as<Expr::InfixExpr>();
+    const auto& inner = outer.left->as<Expr::InfixExpr>();
+    EXPECT_EQ(outer.op, Operators::BinaryOp::MINUS);
+    EXPECT_EQ(inner.op, Operators::BinaryOp::STAR);
+}
+
+TEST(TemplateTest, ConstantHolesAreFolded) {
+    auto expr = firstExpression(parseSource("$\"a{1 + 2}b{{c}}\";\n"));
+    ASSERT_TRUE(expr->is<Expr::LiteralExpr>());
+    EXPECT_EQ(expr->as<Expr::LiteralExpr>().literal.asString().view(),
+              "a3b{c}");
+}
+
+TEST(TemplateTest, HolesAreEvaluatedAtRunTime) {
+    auto expr = firstExpression(parseSource("$\"x={x}, y={2 * 3}\";\n"));
+    ASSERT_TRUE(expr->is<Expr::TemplateExpr>());
+    const auto& tmpl = expr->as<Expr::TemplateExpr>();
+    EXPECT_EQ(tmpl.holes.size(), 1U);
+    EXPECT_EQ(tmpl.segments.back(), ", y=6");
+
+    Interpreter::Interpreter interpreter;
+    EXPECT_EQ(interpreter.evaluate(expr).asString().view(), "x=nil, y=6");
+}
+
+TEST(OutputTest, WriterFormatsValuesIntoItsBuffer) {
+    std::FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    {
+        Output::Writer writer(fileno(file));
+        writer.writeLine(Token::Literal{2.5});
+        writer.writeLine(Token::Literal{std::string("text")});
+        writer.writeLine(Token::Literal{true});
+        writer.writeLine(Token::Literal{});
+    }
+    std::rewind(file);
+    char buffer[64] = {};
+    auto read       = std::fread(buffer, 1, sizeof(buffer) - 1, file);
+    std::fclose(file);
+    EXPECT_EQ(std::string(buffer, read), "2.5\ntext\ntrue\nnil\n");
+}
+
+TEST(OutputTest, FormatToWritesWhatStringifyReturns) {
+    auto program = Thor::compile(
+        "class P {}\nval p = P();\n"
+        "val a = [1.5, \"x\", true, nil, p, P, [2, 3], {}];\na.push(a);\n");
+    auto outputs = program.run(program.inputs());
+    ASSERT_TRUE(outputs.ok()) << outputs.diagnostics;
+    auto values = outputs.globals;
+    values.emplace_back(Runtime::Method{Runtime::Builtin::find("push")});
+    for (const auto& value : values) {
+        std::string buffer(Token::formattedSizeBound(value), '\0');
+        auto*       end = Token::formatTo(buffer.data(), value);
+        EXPECT_EQ(std::string(buffer.data(), end), value.stringify());
+    }
+    EXPECT_EQ(outputs.globals[*program.slot("a")].stringify(),
+              "[1.5, x, true, nil, <P instance>, <class P>, [2, 3], "
+              "<object>, [...]]");
+    EXPECT_EQ(values.back().stringify(), "<builtin push>");
+}
+
+TEST(OutputTest, NumbersPrintAsFmtFormatsThem) {
+    const std::pair<double, const char*> cases[] = {
+        {100000, "100000"},     {1000000, "1000000"},
+        {0.1, "0.1"},           {1e15, "1000000000000000"},
+        {1e16, "1e+16"},        {-2.5, "-2.5"},
+        {0.0001, "0.0001"},     {0.00001, "1e-05"},
+    };
+    for (const auto& [number, text] : cases) {
+        char buffer[Runtime::MAX_NUMBER_CHARS];
+        auto end = Runtime::formatNumber(buffer, number);
+        EXPECT_EQ(std::string(buffer, end), text);
+        EXPECT_EQ(Token::Literal{number}.stringify(), text);
+    }
+    auto program = Thor::compile("print 100000;\nprint 1000000;\nprint 0.1;\n");
+    EXPECT_EQ(program.run(program.inputs()).output, "100000\n1000000\n0.1\n");
+}
+
+TEST(OutputTest, ValuesLargerThanTheBufferAreWrittenWhole) {
+    std::vector<double> numbers(20000);
+    for (std::size_t i = 0; i < numbers.size(); ++i) {
+        numbers[i] = static_cast<double>(i);
+    }
+    Token::Literal array{Runtime::Array(std::move(numbers))};
+    auto           text = array.stringify();
+    ASSERT_GT(text.size(), Output::Writer::BUFFER_SIZE);
+    EXPECT_GE(Token::formattedSizeBound(array), text.size());
+
+    Output::Writer writer;
+    writer.writeLine(Token::Literal{1.0});
+    writer.writeLine(array);
+    EXPECT_EQ(writer.captured(), "1\n" + text + "\n");
+}
+
+TEST(LoggerTest, AsyncRecordsAreWrittenByFlush) {
+    auto  path   = testing::TempDir() + "thor_logger_test.log";
+    auto& logger = Logger::getLogger();
+    std::remove(path.c_str());
+    logger.setLogFile(path);
+    logger.setLevel(Logger::LogLevel::INFO);
+    logger.setMode(Logger::Mode::ASYNC);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&logger, t] {
+            for (int i = 0; i < 1000; ++i) {
+                logger.info("thread {} message {} {}", t, i,
+                            std::string("payload"));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    logger.debug("filtered out {}", 1);
+    logger.flush();
+    logger.setLogFile("/dev/null");
+
+    std::ifstream file(path);
+    std::string   line;
+    int           lines = 0;
+    while (std::getline(file, line)) {
+        EXPECT_NE(line.find("message"), std::string::npos) << line;
+        EXPECT_NE(line.find("payload"), std::string::npos) << line;
+        ++lines;
+    }
+    EXPECT_EQ(lines, 4000);
+    EXPECT_EQ(logger.droppedCount(), 0U);
+}
+
+TEST(LoggerTest, RingsOfExitedThreadsAreFreedOnceDrained) {
+    Logger::Logger logger;
+    std::string    written;
+    logger.setSink([&written](std::string_view lines) { written += lines; });
+    logger.setRingCapacity(4096);
+    for (int t = 0; t < 16; ++t) {
+        std::thread([&logger, t] { logger.warn("thread {}", t); }).join();
+    }
+    logger.flush();
+    EXPECT_EQ(logger.ringCount(), 0U);
+    EXPECT_EQ(std::count(written.begin(), written.end(), '\n'), 16);
+
+    logger.warn("still logging");
+    logger.flush();
+    EXPECT_EQ(logger.ringCount(), 1U);
+}
+
+TEST(LoggerTest, LazyArgumentsOnlyRunWhenEmitted) {
+    auto& logger = Logger::getLogger();
+    int   calls  = 0;
+    auto  value  = Logger::lazy([&calls] {
+        ++calls;
+        return std::string("computed");
+    });
+
+    logger.setLevel(Logger::LogLevel::WARN);
+    EXPECT_FALSE(logger.isEnabled(Logger::LogLevel::INFO));
+    logger.info("skipped {}", value);
+    EXPECT_EQ(calls, 0);
+
+    logger.setLevel(Logger::LogLevel::INFO);
+    logger.info("emitted {}", value);
+    logger.flush();
+    EXPECT_EQ(calls, Logger::MIN_LEVEL <= Logger::LogLevel::INFO ? 1 : 0);
+}
+
+TEST(TraceTest, RecordsRoundTripThroughTheFile) {
+    auto path = testing::TempDir() + "thor_trace_test.trace";
+    ASSERT_TRUE(Trace::start(path, 256));
+    Trace::emit(Trace::Event::MARK, 7, 42);
+    Trace::emitText(Trace::Event::RUNTIME_ERROR, "boom");
+    parseSource("print 1 + 2;\n");
+    Trace::stop();
+    Trace::emit(Trace::Event::MARK, 0, 99);  // Not recorded once stopped
+
+    auto file = Trace::readFile(path);
+    ASSERT_GE(file.records.size(), 4U);
+    EXPECT_EQ(file.records[0].event, Trace::Event::MARK);
+    EXPECT_EQ(file.records[0].a, 7U);
+    EXPECT_EQ(file.records[0].b, 42U);
+    EXPECT_EQ(file.records[1].event, Trace::Event::RUNTIME_ERROR);
+    EXPECT_EQ(file.strings.at(file.records[1].text), "boom");
+    EXPECT_EQ(file.records.back().event, Trace::Event::PARSE_END);
+    EXPECT_EQ(file.records.back().a, 1U);
+    for (const auto& record : file.records) {
+        EXPECT_NE(record.b, 99U);
+    }
+}
+
+TEST(ContextTest, IndependentInterpretersRunConcurrently) {
+    constexpr int            THREADS = 64;
+    std::vector<std::string> outputs(THREADS);
+    std::vector<std::string> diagnostics(THREADS);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < THREADS; ++i) {
+        threads.emplace_back([i, &outputs, &diagnostics] {
+            Runtime::Context         context;
+            Thor::Lexer              lexer(context);
+            Parser::Parser           parser(context);
+            Interpreter::Interpreter interpreter(context);
+            for (int round = 0; round < 20; ++round) {
+                auto source = fmt::format(
+                    "print \"thread\" + \" {0}\";\nprint {0} * 2;\n"
+                    "print $\"{{{0} + 1}}\";\nprint -\"oops\";\n",
+                    i);
+                auto tokens = lexer.tokenize(source);
+                interpreter.interpret(parser.parse(tokens));
+            }
+            outputs[i]     = context.output().takeCaptured();
+            diagnostics[i] = context.takeDiagnostics();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (int i = 0; i < THREADS; ++i) {
+        std::string expected;
+        for (int round = 0; round < 20; ++round) {
+            expected += fmt::format("thread {}\n{}\n{}\n", i, i * 2, i + 1);
+        }
+        EXPECT_EQ(outputs[i], expected);
+        const auto& lines = diagnostics[i];
+        EXPECT_EQ(std::count(lines.begin(), lines.end(), '\n'), 20);
+    }
+}
+
+TEST(ThreadPoolTest, NestedTasksAllRunBeforeWaitReturns) {
+    std::atomic<int> ran{0};
+    {
+        Runtime::ThreadPool pool(4);
+        for (int i = 0; i < 100; ++i) {
+            pool.submit([&pool, &ran] {
+                pool.submit([&ran] { ++ran; });
+                ++ran;
+            });
+        }
+        pool.wait();
+        EXPECT_EQ(ran.load(), 200);
+    }
+}
+
+TEST(BatchTest, ScriptsRunInIsolatedContexts) {
+    auto directory = std::filesystem::path(testing::TempDir()) / "thor_batch";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "nested");
+    for (int i = 0; i < 10; ++i) {
+        std::ofstream(directory / fmt::format("s{}.krp", i))
+            << fmt::format("print {} * 2;\n", i);
+    }
+    std::ofstream(directory / "nested" / "bad.krp") << "print -\"x\";\n";
+    std::ofstream(directory / "notes.txt") << "not a script\n";
+
+    auto scripts = Runtime::findScripts(directory);
+    ASSERT_EQ(scripts.size(), 11U);
+    auto report = Runtime::runBatch(scripts, 3);
+    EXPECT_EQ(report.workers, 3U);
+    EXPECT_EQ(report.failed(), 1U);
+    EXPECT_FALSE(report.scripts[0].ok);  // nested/bad.krp sorts first
+    EXPECT_NE(report.scripts[0].diagnostics.find("can't work"),
+              std::string::npos);
+    for (std::size_t i = 1; i < report.scripts.size(); ++i) {
+        const auto& script = report.scripts[i];
+        EXPECT_TRUE(script.ok);
+        EXPECT_EQ(script.output, fmt::format("{}\n", (i - 1) * 2));
+    }
+    std::filesystem::remove_all(directory);
+}
+
+TEST(ServerTest, RepeatedScriptsHitTheProgramCache) {
+    auto            socket = testing::TempDir() + "thor_server_test.sock";
+    Runtime::Server server({socket, 2});
+    ASSERT_TRUE(server.listen());
+    std::thread serving([&server] { server.serve(); });
+
+    int fd = Protocol::connectTo(socket);
+    ASSERT_GE(fd, 0);
+    Protocol::Request request;
+    request.text = "print $\"{name}: {n * 2}\";\n";
+    for (int n = 1; n <= 3; ++n) {
+        request.params = {{"name", Token::Literal{std::string("run")}},
+                          {"n", Token::Literal{n}}};
+        auto response  = Protocol::call(fd, request);
+        ASSERT_TRUE(response.has_value());
+        EXPECT_TRUE(response->ok);
+        EXPECT_EQ(response->output, fmt::format("run: {}\n", n * 2));
+    }
+    EXPECT_EQ(server.cache().misses(), 1U);
+    EXPECT_EQ(server.cache().hits(), 2U);
+
+    // Without a script root, paths are refused.
+    request.kind  = Protocol::RequestKind::PATH;
+    request.text  = "/nonexistent/script.krp";
+    auto response = Protocol::call(fd, request);
+    ASSERT_TRUE(response.has_value());
+    EXPECT_FALSE(response->ok);
+    EXPECT_NE(response->diagnostics.find("disabled"), std::string::npos);
+
+    close(fd);
+    server.stop();
+    serving.join();
+}
+
+TEST(ServerTest, PathRequestsStayUnderTheScriptRoot) {
+    auto base = std::filesystem::path(testing::TempDir()) / "thor_server_root";
+    std::filesystem::remove_all(base);
+    std::filesystem::create_directories(base / "scripts");
+    std::ofstream(base / "scripts" / "ok.krp") << "print 1 + 1;\n";
+    std::ofstream(base / "secret.krp") << "print \"secret\";\n";
+    std::filesystem::create_symlink(base / "secret.krp",
+                                    base / "scripts" / "link.krp");
+
+    Runtime::Server::Options options;
+    options.scriptRoot = (base / "scripts").string();
+    Runtime::Server server(options);
+    auto            call = [&](std::string path) {
+        Protocol::Request request;
+        request.kind = Protocol::RequestKind::PATH;
+        request.text = std::move(path);
+        return server.handle(request);
+    };
+
+    EXPECT_EQ(call("ok.krp").output, "2\n");
+    EXPECT_EQ(call((base / "scripts" / "ok.krp").string()).output, "2\n");
+    EXPECT_EQ(call("../scripts/ok.krp").output, "2\n");
+    for (const auto& path :
+         {std::string("../secret.krp"), (base / "secret.krp").string(),
+          std::string("link.krp"), std::string("/etc/passwd")}) {
+        auto response = call(path);
+        EXPECT_FALSE(response.ok) << path;
+        EXPECT_EQ(response.output, "") << path;
+        EXPECT_NE(response.diagnostics.find("Outside the script root"),
+                  std::string::npos)
+            << path;
+    }
+    auto missing = call("missing.krp");
+    EXPECT_FALSE(missing.ok);
+    EXPECT_NE(missing.diagnostics.find("Failed to open"), std::string::npos);
+    std::filesystem::remove_all(base);
+}
+
+TEST(ProgramTest, CompiledOnceRunsWithFreshInputs) {
+    auto program = Thor::compile(
+        "print seen;\nvar seen = true;\n"
+        "val total = price * qty;\n"
+        "print total > 100 ? \"big\" : \"small\";\n");
+    ASSERT_TRUE(program.ok());
+    ASSERT_TRUE(program.slot("total").has_value());
+
+    Runtime::Context context;
+    for (double qty : {1.0, 50.0}) {
+        auto inputs = program.inputs();
+        inputs.set("price", Token::Literal{4.0})
+            .set("qty", Token::Literal{qty});
+        auto outputs = program.run(context, inputs);
+        EXPECT_TRUE(outputs.ok());
+        EXPECT_EQ(outputs.output, qty > 25 ? "nil\nbig\n" : "nil\nsmall\n");
+        EXPECT_EQ(outputs.globals[*program.slot("total")].asNumber(),
+                  4.0 * qty);
+        EXPECT_EQ(context.arena().bytesUsed(), 0U);
+    }
+
+    // One program shared by several threads, each in its own context.
+    std::vector<std::thread> threads;
+    std::atomic<int>         correct{0};
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&program, &correct, i] {
+            auto inputs = program.inputs();
+            inputs.set("price", Token::Literal{i})
+                .set("qty", Token::Literal{30});
+            for (int run = 0; run < 100; ++run) {
+                auto outputs = program.run(inputs);
+                correct += outputs.output ==
+                           (i * 30 > 100 ? "nil\nbig\n" : "nil\nsmall\n");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(correct.load(), 400);
+}
+
+TEST(ProgramTest, KeepsTheEngineItWasCompiledFor) {
+    const std::string script = "var s = 0;\nfor (var i = 0; i < 3; i += 1) "
+                               "s += i;\nprint s;\n";
+    auto tree = Thor::compile(script);
+    EXPECT_EQ(tree.engine(), Interpreter::Engine::TREE);
+
+    auto path = testing::TempDir() + "thor_program_engine.trace";
+    ASSERT_TRUE(Trace::start(path, 4096));
+    for (auto engine : {Interpreter::Engine::CLOSURE,
+                        Interpreter::Engine::TIERED, Interpreter::Engine::VM}) {
+        Interpreter::setEngine(engine);
+        EXPECT_EQ(tree.run(tree.inputs()).output, "3\n");
+    }
+    Interpreter::setEngine(Interpreter::Engine::TREE);
+    auto vm = Thor::compile(script, Interpreter::Engine::VM);
+    EXPECT_EQ(vm.run(vm.inputs()).output, "3\n");
+    Trace::stop();
+
+    // Only the VM program was compiled beyond its statements.
+    std::vector<Trace::Record> compiles;
+    for (const auto& record : Trace::readFile(path).records) {
+        if (record.event == Trace::Event::ENGINE_COMPILE) {
+            compiles.push_back(record);
+        }
+    }
+    ASSERT_EQ(compiles.size(), 1U);
+    EXPECT_EQ(compiles[0].b,
+              static_cast<std::uint64_t>(Interpreter::Engine::VM));
+}
+
+TEST(ProgramTest, FoldedStringsAreFlatConstants) {
+    const std::string half(100, 'a');
+    auto folded = Operators::fold([&] {
+        return Operators::apply(opToken(Token::Type::PLUS),
+                                Token::Literal{half}, Token::Literal{half});
+    });
+    ASSERT_TRUE(folded.has_value());
+    EXPECT_FALSE(folded->as<Runtime::String>().isRope());
+    EXPECT_EQ(folded->as<Runtime::String>().size(), 200U);
+
+    // Runs share the constant; reading it must not write to it.
+    const auto script = fmt::format("print \"{0}\" + \"{0}\";\n", half);
+    for (auto engine :
+         {Interpreter::Engine::CLOSURE, Interpreter::Engine::VM}) {
+        auto                     program = Thor::compile(script, engine);
+        std::vector<std::thread> threads;
+        std::atomic<int>         correct{0};
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([&program, &correct, &half] {
+                for (int run = 0; run < 50; ++run) {
+                    correct += program.run(program.inputs()).output ==
+                               half + half + "\n";
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(correct.load(), 200);
+    }
+}
+
+TEST(ColumnarTest, ColumnsAgreeWithRowsAndShortCircuit) {
+    constexpr std::size_t ROWS = 200;
+    std::vector<double>      price(ROWS);
+    std::vector<double>      qty(ROWS);
+    std::vector<bool>        rush(ROWS);
+    std::vector<std::string> region(ROWS);
+    for (std::size_t i = 0; i < ROWS; ++i) {
+        price[i]  = static_cast<double>(i % 37) * 1.5;
+        qty[i]    = static_cast<double>(i % 5);
+        rush[i]   = i % 3 == 0;
+        region[i] = i % 4 == 0 ? "EU" : "US";
+    }
+    Columnar::Table table(ROWS);
+    table.add("price", price);
+    table.add("qty", qty);
+    table.add("rush", Columnar::makeBitmap(rush));
+    table.add("region", Columnar::encodeStrings(region));
+
+    Runtime::Context context;
+    for (const auto* source :
+         {"price * qty > 100 && region == \"EU\"",
+          "rush || -price < -20 ? price / 2 : qty + 1",
+          "!rush && region != \"US\" ? region + \"!\" : \"none\"",
+          "$\"{region}:{qty}\"", "qty == 0 || price % (qty + 1) == 1"}) {
+        auto expr    = Columnar::parseExpression(context, source);
+        auto rows    = Columnar::evaluateRows(expr, table);
+        auto columns = Columnar::Evaluator(table).evaluate(expr);
+        for (std::size_t i = 0; i < ROWS; ++i) {
+            EXPECT_EQ(Columnar::valueAt(*columns, i).stringify(),
+                      rows[i].stringify())
+                << source << " at row " << i;
+        }
+    }
+
+    // The right-hand side only sees rows where `qty > 0`, so `%` never
+    // divides by zero; row at a time, both sides run.
+    auto guarded =
+        Columnar::parseExpression(context, "qty > 0 && 10 % qty == 0");
+    EXPECT_THROW(Columnar::evaluateRows(guarded, table),
+                 Error::RuntimeException);
+    auto result = Columnar::Evaluator(table).evaluate(guarded);
+    ASSERT_TRUE(std::holds_alternative<Columnar::Bitmap>(*result));
+    for (std::size_t i = 0; i < ROWS; ++i) {
+        EXPECT_EQ(std::get<Columnar::Bitmap>(*result).test(i),
+                  qty[i] == 1 || qty[i] == 2);
+    }
+}
+
+TEST(JitTest, CompiledCodeMatchesInterpreterAndBailsOut) {
+    struct Case {
+        const char* source;
+        double      a;
+        double      b;
+    };
+    const std::vector<Case> cases = {
+        {"a * b + a / (b - 1) - -a", 3, 4},
+        {"a ** 2 + b ** 0.5", 3, 16},
+        {"(a + b) * (a - b) > 10 ? a * 2 : b * 3", 7, 2},
+        {"(a + b) * (a - b) > 10 ? a * 2 : b * 3", 2, 7},
+        {"a >= b || !(a != b) && a <= 2", 2, 2},
+        {"a == b", 0.0 / 0.0, 0.0 / 0.0},
+        {"((a & 255) | (b << 3)) ^ 5", 1000, 3},
+        {"a % b + (a >> 1)", 17, 5},
+        {"a % b", 7.5, 2},
+        {"a % b", -7, 7},
+        {"(a << b) + 1", 1, 31},
+        {"(a > b) == (b < a) ? -0 * a : 1", 1, 2},
+    };
+
+    Runtime::Context context;
+    auto             evaluate = [&](Jit::Mode mode, const Case& each) {
+        Jit::setMode(mode);
+        auto expr = Columnar::parseExpression(context, each.source);
+        Interpreter::Interpreter interpreter(context);
+        interpreter.bind(0, Token::Literal{each.a});
+        interpreter.bind(1, Token::Literal{each.b});
+        return interpreter.evaluate(expr).stringify();
+    };
+    auto compiled = Jit::stats().compiled;
+    for (const auto& each : cases) {
+        EXPECT_EQ(evaluate(Jit::Mode::ALWAYS, each),
+                  evaluate(Jit::Mode::OFF, each))
+            << each.source;
+    }
+    if (Jit::available()) {
+        EXPECT_EQ(Jit::stats().compiled, compiled + cases.size());
+    }
+
+    // Compiled for numbers, then run with a string and a zero divisor:
+    // both go back to the interpreter, which concatenates or throws.
+    Jit::setMode(Jit::Mode::ALWAYS);
+    auto expr = Columnar::parseExpression(context, "a + 10 % b");
+    Interpreter::Interpreter interpreter(context);
+    interpreter.bind(0, Token::Literal{1.0});
+    interpreter.bind(1, Token::Literal{4.0});
+    EXPECT_EQ(interpreter.evaluate(expr).asNumber(), 3.0);
+    auto bailouts = Jit::stats().bailouts;
+    interpreter.bind(0, Token::Literal{std::string("x")});
+    EXPECT_EQ(interpreter.evaluate(expr).stringify(), "x2");
+    interpreter.bind(0, Token::Literal{1.0});
+    interpreter.bind(1, Token::Literal{0.0});
+    EXPECT_THROW((void)interpreter.evaluate(expr), Error::RuntimeException);
+    if (Jit::available()) {
+        // The root bails twice; after the first, the interpreter compiles
+        // `10 % b` on its own, which bails on the zero divisor as well.
+        EXPECT_EQ(Jit::stats().bailouts, bailouts + 3);
+    }
+    Jit::setMode(Jit::Mode::OFF);
+}
+
+TEST(ClosureTest, MatchesTreeWalker) {
+    const std::vector<std::string> scripts = {
+        "val a = (5 + 3 * 2 ** 2 - -1) >> 1 & 7 | 15 ^ 10;\n"
+        "print a;\nprint !a;\nprint ++a;\nprint -a * 2 + a / 4;\n"
+        "print a > 3 && a != 7 ? \"big\" : \"small\";\n",
+        "var name = \"thor\";\nvar n = 3;\n"
+        "print $\"{name}:{n * 2}:{true}\";\nprint $\"{1 + 1}\";\n"
+        "print name + n + nil;\nprint \"abc\" < \"abd\";\n",
+        "print 1;\nprint 10 % 0;\nprint 2;\n",
+        "var x = 4;\nprint x % 3;\nprint \"a\" - x;\nprint 3;\n",
+        "print unknown;\nprint 1 == true;\nprint nil == nil;\n",
+    };
+    for (const auto& script : scripts) {
+        auto program  = Thor::compile(script);
+        auto closures = Thor::compile(script, Interpreter::Engine::CLOSURE);
+        auto tree     = program.run(program.inputs());
+        auto closure  = closures.run(closures.inputs());
+        EXPECT_EQ(closure.output, tree.output) << script;
+        EXPECT_EQ(closure.diagnostics, tree.diagnostics) << script;
+        EXPECT_EQ(closure.globals.size(), tree.globals.size());
+    }
+}
+
+TEST(TieringTest, PromotesHotStatementsAndDeoptimizes) {
+    using Tiering::Tier;
+    Tiering::setOptions({2, 4, true});
+    // Only expressions of a dozen operators or more are worth the JIT.
+    auto program = Thor::compile(
+        "val total = price + (qty * 2 - qty / 4 + qty * qty - 1 + qty * 3 -"
+        " qty % 7 + qty / 2 - 8 * qty + 1);\n"
+        "print qty * 2 + qty / 3 - qty % 4 * 2 + qty * qty / 10 - 1 + qty >"
+        " 50 ? \"big\" : \"small\";\n"
+        "print total;\n",
+        Interpreter::Engine::TIERED);
+    Tiering::setOptions({});
+    auto run = [&](Token::Literal price) {
+        auto inputs = program.inputs();
+        inputs.set("price", std::move(price))
+            .set("qty", Token::Literal{30.0});
+        return program.run(inputs).output;
+    };
+    auto tier = [&](std::size_t region) {
+        return program.tiers()[region].tier;
+    };
+
+    EXPECT_EQ(run(Token::Literal{4.0}), "big\n819.5\n");
+    EXPECT_EQ(tier(0), Tier::TREE);
+    EXPECT_EQ(run(Token::Literal{4.0}), "big\n819.5\n");
+    EXPECT_EQ(tier(0), Tier::CLOSURE);
+    for (int i = 0; i < 2; ++i) {
+        EXPECT_EQ(run(Token::Literal{4.0}), "big\n819.5\n");
+    }
+    // The last statement has nothing for the JIT and stays a closure.
+    auto hot = Jit::available() ? Tier::JIT : Tier::CLOSURE;
+    EXPECT_EQ(tier(0), hot);
+    EXPECT_EQ(tier(1), hot);
+    EXPECT_EQ(tier(2), Tier::CLOSURE);
+
+    // A string fails the guards of `price + (...)` until the JIT gives up
+    // on it, and the statement drops back to closures.
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(run(Token::Literal{std::string("x")}), "big\nx815.5\n");
+    }
+    auto report = program.tiers();
+    EXPECT_EQ(report[0].entries, 104U);
+    EXPECT_EQ(report[0].tier, Tier::CLOSURE);
+    EXPECT_EQ(report[1].tier, hot);
+    EXPECT_TRUE(report[0].promotedAt[1].has_value());
+    EXPECT_EQ(report[0].deoptimizedAt.has_value(), Jit::available());
+    EXPECT_GT(report[0].seconds[0], 0.0);
+}
+
+TEST(LoopTest, EnginesAgree) {
+    const std::vector<std::string> scripts = {
+        "var i = 0;\nvar total = 0;\nwhile (i < 10) {\n  i += 1;\n"
+        "  if (i == 3) continue;\n  if (i > 8) { break; }\n"
+        "  total = total + i * 2;\n}\nprint total;\nprint i;\n",
+        "for (var i = 0; i < 3; i = i + 1) {\n"
+        "  for (var j = 0; j < 3; j += 1) {\n"
+        "    if (j == 1) continue; else print $\"{i}-{j}\";\n  }\n}\n",
+        "var a = 1;\nprint a + (a = 5);\nprint a = a * 2;\nvar b;\n"
+        "print b = a -= 4;\nprint a;\n",
+        "var n = 0;\nfor (;;) { n += 1; if (n >= 4) break; }\nprint n;\n"
+        "while (false) print 1;\nvar s = \"\";\nvar k = 0;\n"
+        "while (k < 3) { s = s + k; k += 1; }\nprint s;\n",
+        "var i = 0;\nwhile (i < 5) { print 10 / (2 - i); i += 1; }\n"
+        "print i;\n",
+        "var i = 0;\nwhile (i < 3) { print i % (1 - i); i += 1; }\n"
+        "print \"after\";\n",
+    };
+    expectEnginesAgree(scripts);
+
+    auto program = Thor::compile(scripts[0]);
+    EXPECT_EQ(program.run(program.inputs()).output, "66\n9\n");
+    EXPECT_FALSE(Thor::compile("break;\n").ok());
+    EXPECT_FALSE(Thor::compile("var a = 1;\n1 + a = 2;\n").ok());
+}
+
+TEST(LoopTest, HotLoopIsPromotedWhileRunning) {
+    Tiering::setOptions({3, 10, false});
+    auto program = Thor::compile(
+        "var s = 0;\n"
+        "for (var i = 0; i < 50; i += 1) {\n"
+        "  s = s + (i * 2 + 1) * (i - 3) / (i + 7) - (i * i + 4) / (i + 2)"
+        " + i * 3 - 1;\n}\nprint s > 0;\n",
+        Interpreter::Engine::TIERED);
+    Tiering::setOptions({});
+    EXPECT_EQ(program.run(program.inputs()).output, "true\n");
+
+    // The script ran once: its statements never left the tree walker, but
+    // the loop moved up between iterations.
+    auto report = program.tiers();
+    ASSERT_EQ(report.size(), 4U);
+    EXPECT_EQ(report[1].tier, Tiering::Tier::TREE);
+    EXPECT_EQ(report[3].label, "loop 0");
+    EXPECT_EQ(report[3].entries, 50U);
+    EXPECT_EQ(report[3].tier, Jit::available() ? Tiering::Tier::JIT
+                                                : Tiering::Tier::CLOSURE);
+}
+
+TEST(SwitchTest, EnginesAgree) {
+    const std::vector<std::string> scripts = {
+        "var total = 0;\nfor (var i = 0; i < 12; i += 1) {\n"
+        "  switch (i % 6) {\n    case 0: total += 1;\n"
+        "    case 1, 2: total += 10;\n"
+        "    case 3: if (i > 6) break; total += 100;\n"
+        "    case 4: continue;\n    else: total += 1000;\n  }\n"
+        "  total += 10000;\n}\nprint total;\n",
+        "func f(x) {\n  switch (x) {\n    case -5: return \"neg\";\n"
+        "    case 1000, 7: return \"sparse\";\n"
+        "    case 0.5: return \"half\";\n    case 7: return \"dup\";\n"
+        "  }\n  return \"none\";\n}\n"
+        "print f(-5);\nprint f(7);\nprint f(1000);\nprint f(0.5);\n"
+        "print f(3);\nprint f(\"7\");\nprint f(nil);\n",
+        "val names = [\"red\", \"green\", \"blue\", \"cyan\", \"red2\"];\n"
+        "for (var i = 0; i < 5; i += 1) {\n  switch (names[i]) {\n"
+        "    case \"red\", \"re\" + \"d2\": print 1;\n"
+        "    case \"green\": print 2;\n    case \"blue\": print 3;\n"
+        "    else: print \"other \" + names[i];\n  }\n}\n",
+        "var calls = 0;\nfunc probe(v) { calls += 1; return v; }\n"
+        "func g(x) {\n  switch (x) {\n"
+        "    case probe(1): return \"first\";\n"
+        "    case 2: return \"constant\";\n"
+        "    case probe(2): return \"shadowed\";\n"
+        "    case probe(3), 4: return \"late\";\n  }\n"
+        "  return \"none\";\n}\n"
+        "print g(1);\nprint g(2);\nprint g(3);\nprint g(4);\nprint g(5);\n"
+        "print calls;\n",
+        "var n = 0;\nfunc next() { n += 1; return n; }\n"
+        "switch (next()) { case 1: print \"one\"; case 2: print \"two\"; }\n"
+        "switch (next()) { else: print \"only else\"; }\n"
+        "switch (next()) { }\nswitch (true) {\n"
+        "  case n > 5: print \"big\";\n  case n > 1: print \"mid\";\n"
+        "  else: print \"small\";\n}\nprint n;\n",
+    };
+    expectEnginesAgree(scripts);
+
+    auto run = [](const std::string& script) {
+        auto program = Thor::compile(script);
+        return program.run(program.inputs()).output;
+    };
+    // The loop breaks at i = 9, from inside the switch.
+    EXPECT_EQ(run(scripts[0]), "81142\n");
+    EXPECT_EQ(run(scripts[1]), "neg\nsparse\nsparse\nhalf\nnone\nnone\nnone\n");
+    EXPECT_EQ(run(scripts[2]), "1\n2\n3\nother cyan\n1\n");
+    // Only labels before the case a constant picks are evaluated.
+    EXPECT_EQ(run(scripts[3]), "first\nconstant\nlate\nlate\nnone\n10\n");
+    EXPECT_EQ(run(scripts[4]), "one\nonly else\nmid\n3\n");
+    EXPECT_FALSE(Thor::compile("switch (1) { else: print 1; case 1: }\n").ok());
+    EXPECT_FALSE(Thor::compile("switch (1) { print 1; }\n").ok());
+}
+
+TEST(SwitchTest, LabelsPickALookup) {
+    Runtime::Context context;
+    auto             parse = [&context](std::string source) {
+        Thor::Lexer    lexer(context);
+        Parser::Parser parser(context);
+        auto           text   = "var x = 1;\n" + source;
+        auto           tokens = lexer.tokenize(text);
+        return parser.parse(tokens);
+    };
+    auto cases = [](std::vector<std::string> labels) {
+        std::string text = "switch (x) {\n";
+        for (const auto& label : labels) {
+            text += "case " + label + ": print 0;\n";
+        }
+        return text + "}\n";
+    };
+    using Numbers = Stmt::Dispatch::Numbers;
+
+    std::vector<std::string> dense;
+    for (int i = -3; i < 60; i += 2) {
+        dense.push_back(std::to_string(i));
+    }
+    auto table    = parse(cases(dense));
+    const auto& d = table[1]->as<Stmt::Switch>().dispatch;
+    EXPECT_EQ(d.numbers(), Numbers::TABLE);
+    EXPECT_EQ(d.constant(Token::Literal{-3.0}), 0U);
+    EXPECT_EQ(d.constant(Token::Literal{57.0}), 30U);
+    EXPECT_EQ(d.constant(Token::Literal{2.0}), Stmt::Dispatch::NONE);
+    EXPECT_EQ(d.constant(Token::Literal{1.5}), Stmt::Dispatch::NONE);
+    EXPECT_EQ(d.constant(Token::Literal{99.0}), Stmt::Dispatch::NONE);
+
+    auto sparse   = parse(cases({"1", "1000", "100000", "2.5", "1000"}));
+    const auto& s = sparse[1]->as<Stmt::Switch>().dispatch;
+    EXPECT_EQ(s.numbers(), Numbers::SEARCH);
+    EXPECT_EQ(s.constant(Token::Literal{1000.0}), 1U);
+    EXPECT_EQ(s.constant(Token::Literal{2.5}), 3U);
+    EXPECT_EQ(s.constant(Token::Literal{999.0}), Stmt::Dispatch::NONE);
+
+    std::vector<std::string> names;
+    for (int i = 0; i < 300; ++i) {
+        names.push_back("\"name" + std::to_string(i) + "\"");
+    }
+    auto hashed   = parse(cases(names));
+    const auto& h = hashed[1]->as<Stmt::Switch>().dispatch;
+    EXPECT_EQ(h.numbers(), Numbers::NONE);
+    EXPECT_EQ(h.strings(), 300U);
+    EXPECT_TRUE(h.dynamic().empty());
+    for (int i = 0; i < 300; ++i) {
+        auto name = "name" + std::to_string(i);
+        EXPECT_EQ(h.constant(Token::Literal{name}), std::uint32_t(i));
+    }
+    EXPECT_EQ(h.constant(Token::Literal{std::string("name300")}),
+              Stmt::Dispatch::NONE);
+    EXPECT_EQ(h.constant(Token::Literal{7.0}), Stmt::Dispatch::NONE);
+
+    // Only `x + 1` is compared; the VM looks the subject up before it and
+    // again after it.
+    auto mixed    = parse(cases({"1", "x + 1", "\"a\" + \"b\"", "-4"}));
+    const auto& m = mixed[1]->as<Stmt::Switch>().dispatch;
+    ASSERT_EQ(m.dynamic().size(), 1U);
+    EXPECT_EQ(m.dynamic()[0].index, 1U);
+    EXPECT_EQ(m.before(1), 0U);
+    EXPECT_EQ(m.before(2), 1U);
+    EXPECT_EQ(m.constant(Token::Literal{std::string("ab")}), 2U);
+    EXPECT_EQ(m.constant(Token::Literal{-4.0}), 3U);
+    EXPECT_EQ(countOpcode(Vm::Program::compile(mixed), Vm::Opcode::SWITCH), 2);
+}
+
+TEST(TryTest, EnginesAgree) {
+    const std::vector<std::string> scripts = {
+        "try { throw \"boom\"; } catch (e) { print \"caught \" + e; }\n"
+        "try { print 1 + nil; } catch (e) { print e; }\n"
+        "try { throw {code: 7}; } catch (e) { print e.code; }\n"
+        "try { throw nil; } catch (e) { print e; }\nprint \"after\";\n",
+        "var total = 0;\nfor (var i = 0; i < 300; i += 1) {\n"
+        "  try {\n    if (i % 10 == 0) throw i;\n    total += 1;\n"
+        "  } catch (e) {\n    total += e;\n  } finally {\n    total += 2;\n"
+        "  }\n}\nprint total;\n",
+        "var n = 0;\nwhile (n < 8) {\n  n += 1;\n  try {\n    try {\n"
+        "      if (n % 2 == 0) continue;\n      if (n == 7) break;\n"
+        "      throw n;\n    } catch (e) {\n      print \"c\" + e;\n"
+        "    } finally {\n      print \"f\" + n;\n    }\n"
+        "  } finally {\n    print \"o\" + n;\n  }\n}\n",
+        "func f(x) {\n  try {\n    if (x > 0) return x * 2;\n"
+        "    throw \"neg\";\n  } catch (e) {\n    return \"c:\" + e;\n"
+        "  } finally {\n    print \"cleanup \" + x;\n  }\n}\n"
+        "print f(2);\nprint f(0);\n"
+        "func g() {\n  var v = 1;\n  try { return v; } finally { v = 2; }\n}\n"
+        "print g();\n"
+        "func h() {\n  try { throw 1; } finally { return 5; }\n}\nprint h();\n"
+        "func k() {\n  try {\n    try { throw \"first\"; } "
+        "finally { throw \"second\"; }\n  } catch (e) { return e; }\n}\n"
+        "print k();\n",
+        "func deep(n) {\n  if (n == 0) throw \"bottom\";\n"
+        "  return deep(n - 1) + 1;\n}\n"
+        "try { deep(200); } catch (e) { print e; }\n"
+        "func picky(x) { if (x == 2) throw \"map\"; return x; }\n"
+        "try { [1, 2, 3].map(picky); } catch (e) { print \"from \" + e; }\n"
+        "func r(n) { return r(n + 1) + 1; }\n"
+        "try { r(0); } catch (e) { print \"overflow\"; }\n"
+        "func make() {\n  try { throw 3; } catch (err) {\n"
+        "    func get() { return err; }\n    return get;\n  }\n}\n"
+        "print make()();\n",
+        "try {\n  try { throw \"in\"; } finally { print \"inner\"; }\n"
+        "} catch (e) { print \"outer \" + e; }\n"
+        "try { throw \"a\"; } catch (e) { print e; }\n"
+        "throw \"end\";\nprint \"unreached\";\n",
+    };
+    expectEnginesAgree(scripts);
+
+    auto run = [](const std::string& script) {
+        auto program = Thor::compile(script);
+        return program.run(program.inputs());
+    };
+    EXPECT_EQ(run(scripts[0]).output,
+              "caught boom\n[line 2, column 15] Error at '+': operator can't "
+              "work on these types\n7\nnil\nafter\n");
+    EXPECT_EQ(run(scripts[1]).output, "5220\n");
+    EXPECT_EQ(run(scripts[2]).output,
+              "c1\nf1\no1\nf2\no2\nc3\nf3\no3\nf4\no4\nc5\nf5\no5\nf6\no6\n"
+              "f7\no7\n");
+    EXPECT_EQ(run(scripts[3]).output,
+              "cleanup 2\n4\ncleanup 0\nc:neg\n1\n5\nsecond\n");
+    EXPECT_EQ(run(scripts[4]).output, "bottom\nfrom map\noverflow\n3\n");
+    auto uncaught = run(scripts[5]);
+    EXPECT_EQ(uncaught.output, "inner\nouter in\na\n");
+    EXPECT_NE(uncaught.diagnostics.find("Uncaught end"), std::string::npos);
+    EXPECT_FALSE(Thor::compile("try { print 1; }\n").ok());
+    EXPECT_FALSE(Thor::compile("throw;\n").ok());
+}
+
+TEST(TryTest, HandlersAreATableNotInstructions) {
+    // The try statement starts with its body's own STORE.
+    auto caught =
+        lowerToVm("var x = 0;\ntry { x = 1; } catch (e) { print e; }\n");
+    EXPECT_EQ(caught.handlers(), 1U);
+    const auto& code = caught.instructions();
+    auto        halt = std::find_if(code.begin(), code.end(), [](auto& each) {
+        return each.opcode == Vm::Opcode::HALT;
+    });
+    ASSERT_NE(halt + 1, code.end());
+    EXPECT_EQ((halt + 1)->opcode, Vm::Opcode::STORE);
+    EXPECT_EQ(countOpcode(caught, Vm::Opcode::CATCH), 1);
+
+    // The `finally` is copied onto the normal path, the `break` and the
+    // handler, and the `break` splits the guarded range in two.
+    auto cleaned = lowerToVm(
+        "for (var i = 0; i < 3; i += 1) {\n"
+        "  try { if (i == 1) break; print i; } finally { print 0; }\n}\n");
+    EXPECT_EQ(cleaned.handlers(), 2U);
+    EXPECT_EQ(countOpcode(cleaned, Vm::Opcode::PRINT), 4);
+    EXPECT_EQ(countOpcode(cleaned, Vm::Opcode::CAUGHT), 1);
+    EXPECT_EQ(countOpcode(cleaned, Vm::Opcode::RETHROW), 1);
+}
+
+TEST(FunctionTest, EnginesAgree) {
+    const std::vector<std::string> scripts = {
+        "func fib(n) {\n  if (n < 2) return n;\n"
+        "  return fib(n - 1) + fib(n - 2);\n}\nprint fib(15);\n",
+        "func ack(m, n) {\n  if (m == 0) return n + 1;\n"
+        "  if (n == 0) return ack(m - 1, 1);\n"
+        "  return ack(m - 1, ack(m, n - 1));\n}\nprint ack(2, 3);\n",
+        "func first(n) {\n  var s = 0;\n"
+        "  for (var i = 0; i < n; i += 1) {\n"
+        "    if (i == 4) return s;\n    s += i;\n  }\n}\n"
+        "print first(9);\nprint first(2);\nprint first;\n",
+        "var g = 1;\nfunc bump() { g += 1; return g; }\n"
+        "print g + bump();\nfor (var i = 0; i < 3; i += 1) print bump();\n"
+        "func twice(f, x) { return f(f(x)); }\n"
+        "func inc(x) {\n  func one() { return 1; }\n  return x + one();\n}\n"
+        "print twice(inc, 5);\nprint $\"{inc(1)}-{twice(inc, 0)}\";\n",
+        "func f(a, b) { return a; }\nprint f(1);\nprint 2;\n",
+        "var x = 3;\nprint x(1, 2 + nil);\n",
+        "func h(n) { return 1 + n; }\nprint h(2);\nprint h(\"s\" - 1);\n",
+        "func deep(n) { return deep(n + 1) + 1; }\nprint deep(0);\n",
+    };
+    expectEnginesAgree(scripts);
+
+    auto program = Thor::compile(scripts[0]);
+    EXPECT_EQ(program.run(program.inputs()).output, "610\n");
+    auto overflow = Thor::compile(scripts.back());
+    EXPECT_NE(overflow.run(overflow.inputs()).diagnostics.find(
+                  "Stack overflow."),
+              std::string::npos);
+    EXPECT_FALSE(Thor::compile("return 1;\n").ok());
+    EXPECT_FALSE(Thor::compile("while (true) {\n  func f() { break; }\n}\n")
+                     .ok());
+}
+
+TEST(FunctionTest, TailCallsRunInConstantStack) {
+    // Far deeper than either the native stack or the value stack allows
+    // for calls that return to their caller.
+    const std::string script =
+        "func count(n, total) {\n  if (n == 0) return total;\n"
+        "  return count(n - 1, total + 2);\n}\nprint count(2000000, 0);\n";
+    const Interpreter::Engine engines[] = {
+        Interpreter::Engine::TREE, Interpreter::Engine::CLOSURE,
+        Interpreter::Engine::TIERED, Interpreter::Engine::VM};
+    for (auto engine : engines) {
+        auto program = Thor::compile(script, engine);
+        auto run     = program.run(program.inputs());
+        EXPECT_EQ(run.output, "4000000\n");
+        EXPECT_EQ(run.diagnostics, "");
+    }
+
+    // Once hot, the tiered engine runs a function's body as closures.
+    Tiering::setOptions({3, 100, false});
+    auto fib = Thor::compile(
+        "func fib(n) {\n  if (n < 2) return n;\n"
+        "  return fib(n - 1) + fib(n - 2);\n}\nprint fib(10);\n",
+        Interpreter::Engine::TIERED);
+    Tiering::setOptions({});
+    EXPECT_EQ(fib.run(fib.inputs()).output, "55\n");
+    auto report = fib.tiers();
+    ASSERT_EQ(report.size(), 3U);
+    EXPECT_EQ(report[2].label, "func fib");
+    // Calls from closures go straight to the body, so the count stops
+    // short of all 177.
+    EXPECT_GE(report[2].entries, 3U);
+    EXPECT_LT(report[2].entries, 177U);
+    EXPECT_EQ(report[2].tier, Tiering::Tier::CLOSURE);
+}
+
+TEST(FunctionTest, ClosuresCaptureWhatTheyUse) {
+    const std::vector<std::string> scripts = {
+        // A counter: the assigned local lives in a cell both share.
+        "func counter(start) {\n  var count = start;\n"
+        "  func next() { count += 1; return count; }\n  return next;\n}\n"
+        "val a = counter(10);\nval b = counter(100);\n"
+        "print a();\nprint a();\nprint b();\nprint a();\n",
+        // Parameters and locals copied, through two levels.
+        "func outer(x) {\n  val k = x * 2;\n  func middle(y) {\n"
+        "    func inner(z) { return x + y + z + k; }\n    return inner;\n"
+        "  }\n  return middle;\n}\nprint outer(1)(20)(300);\n",
+        // A nested function calling itself, in a tail call too.
+        "func sum(n) {\n  func go(i, total) {\n"
+        "    if (i == 0) return total + n;\n    return go(i - 1, total + i);\n"
+        "  }\n  func down(i) { if (i == 0) return 0; return i + down(i - 1); }"
+        "\n  return go(n, 0) + down(n);\n}\nprint sum(100);\n",
+        // Each iteration declares a `val` of its own; the loop variable is
+        // one binding, assigned, so shared.
+        "func pick() {\n  var last;\n"
+        "  for (var i = 0; i < 3; i += 1) {\n    val j = i * 10;\n"
+        "    func f() { return j + i; }\n    if (i == 1) last = f;\n  }\n"
+        "  return last;\n}\nprint pick()();\n",
+        // An assigned parameter, a setter and a hole.
+        "func box(v) {\n  func get() { return $\"<{v}>\"; }\n"
+        "  func set(x) { v = x; }\n  set(42);\n  print get();\n"
+        "  v = 7;\n  return get;\n}\nprint box(1)();\n",
+        "func same() {\n  func me() { return me; }\n"
+        "  val one = 1;\n  func a() { return one; }\n"
+        "  print me() == me;\n  print a == a;\n  return a;\n}\n"
+        "print same() == same();\n",
+    };
+    const std::vector<std::string> expected = {
+        "11\n12\n101\n13\n", "323\n", "10200\n", "13\n",
+        "<42>\n<7>\n", "true\ntrue\ntrue\ntrue\nfalse\n",
+    };
+    const Interpreter::Engine engines[] = {
+        Interpreter::Engine::TREE, Interpreter::Engine::CLOSURE,
+        Interpreter::Engine::TIERED, Interpreter::Engine::VM};
+    Tiering::setOptions({1, 2, false});
+    for (std::size_t index = 0; index < scripts.size(); ++index) {
+        for (auto engine : engines) {
+            auto program = Thor::compile(scripts[index], engine);
+            EXPECT_TRUE(program.ok()) << program.diagnostics();
+            auto run = program.run(program.inputs());
+            EXPECT_EQ(run.output, expected[index]) << scripts[index];
+            EXPECT_EQ(run.diagnostics, "") << scripts[index];
+        }
+    }
+    Tiering::setOptions({});
+
+    // Only what the body uses is captured, and only what is captured and
+    // assigned is boxed.
+    Runtime::Context context;
+    Thor::Lexer      lexer(context);
+    Parser::Parser   parser(context);
+    std::string      source =
+        "func f(a, b, c) {\n  var d = a;\n  var e = 0;\n"
+        "  func g() { e = b; return d; }\n  return g;\n}\n";
+    auto        tokens     = lexer.tokenize(source);
+    auto        statements = parser.parse(tokens);
+    const auto& outer =
+        *statements.front()->as<Stmt::Function>().definition;
+    EXPECT_EQ(outer.cells, std::vector<std::uint32_t>{4});
+    const auto& inner = *outer.body[2]->as<Stmt::Function>().definition;
+    ASSERT_EQ(inner.captures.size(), 3U);
+    EXPECT_EQ(inner.captures[0].index, 4U);
+    EXPECT_EQ(inner.captures[1].index, 1U);
+    EXPECT_EQ(inner.captures[2].index, 3U);
+}
+
+TEST(VmTest, LoopsJumpBackAndHoistInvariants) {
+    // `k * 2 + 1` reads nothing the loop writes.
+    auto hoisted = lowerToVm(
+        "var i = 0;\nvar s = 0;\nvar k = 3;\n"
+        "while (i < 9) { s = s + i * (k * 2 + 1); i += 1; }\n");
+    EXPECT_EQ(countOpcode(hoisted, Vm::Opcode::JUMP_SET), 1);
+    const auto& code = hoisted.instructions();
+    EXPECT_EQ(code.back().opcode, Vm::Opcode::HALT);
+    const auto& back = code[code.size() - 2];
+    EXPECT_EQ(back.opcode, Vm::Opcode::JUMP_IF);
+    // The body starts two past the loop's CLEAR and JUMP.
+    EXPECT_EQ(back.aux, 2U);
+
+    auto written = lowerToVm(
+        "var i = 0;\nvar s = 0;\nvar k = 3;\n"
+        "while (i < 9) { s = s + i * (k * 2 + 1); k += 1; i += 1; }\n");
+    EXPECT_EQ(countOpcode(written, Vm::Opcode::JUMP_SET), 0);
+}
+
+TEST(VmTest, MatchesTreeWalkerInFewRegisters) {
+    const std::vector<std::string> scripts = {
+        "val a = (5 + 3 * 2 ** 2 - -1) >> 1 & 7 | 15 ^ 10;\n"
+        "print a;\nprint !a;\nprint ++a;\nprint -a * 2 + a / 4;\n"
+        "print a > 3 && a != 7 ? \"big\" : \"small\";\n",
+        "var name = \"thor\";\nvar n = 3;\n"
+        "print $\"{name}:{n * 2}:{true}\";\nprint $\"{1 + 1}\";\n"
+        "print $\"{$\"<{name + n}>\"}|{n > 2 ? n : -n}\";\n"
+        "print name + n + nil;\nprint \"abc\" < \"abd\";\n",
+        "print 1;\nprint 10 % 0;\nprint 2;\n",
+        "var x = 4;\nprint x % 3;\nprint \"a\" - x;\nprint 3;\n",
+        "var y = 2;\nvar x = y;\nvar y = y + x;\nprint x * y;\nprint 4--;\n",
+        "print unknown;\nprint 1 == true;\nprint nil == nil;\n",
+    };
+    for (const auto& script : scripts) {
+        auto program   = Thor::compile(script);
+        auto registers = Thor::compile(script, Interpreter::Engine::VM);
+        auto tree      = program.run(program.inputs());
+        auto vm        = registers.run(registers.inputs());
+        EXPECT_EQ(vm.output, tree.output) << script;
+        EXPECT_EQ(vm.diagnostics, tree.diagnostics) << script;
+        EXPECT_EQ(vm.globals.size(), tree.globals.size());
+    }
+
+    // Leaves are operands, not instructions, and temporaries whose lives
+    // do not overlap share a register.
+    Runtime::Context context;
+    Thor::Lexer      lexer(context);
+    Parser::Parser   parser(context);
+    std::string      source =
+        "var r = ((a + b) * (a - b)) / ((a * 2) - (b * 3)) > c ? a : b;\n";
+    auto tokens     = lexer.tokenize(source);
+    auto statements = parser.parse(tokens);
+    auto program    = Vm::Program::compile(statements);
+    // Eight operators, two jumps, a move on each side, the define and the
+    // HALT ending the statement.
+    EXPECT_EQ(program.instructions().size(), 14U);
+    EXPECT_EQ(program.registers(), 3U);
+}
+
+TEST(ObjectTest, EnginesAgree) {
+    const std::vector<std::string> scripts = {
+        "class Point {\n  init(x, y) { this.x = x; this.y = y; }\n"
+        "  sum() { return this.x + this.y; }\n"
+        "  scaled(k) { return Point(this.x * k, this.y * k); }\n}\n"
+        "val p = Point(1, 2);\nprint p.sum();\nprint p.scaled(3).sum();\n"
+        "p.x += 10;\nval sum = p.sum;\nprint sum();\nprint p;\nprint Point;\n",
+        // Inheritance, `super`, and a method returning `this`.
+        "class Animal {\n  init(name) { this.name = name; }\n"
+        "  speak() { return this.name + \" speaks\"; }\n}\n"
+        "class Dog : Animal {\n"
+        "  init(name) { super.init(name); this.tricks = 0; }\n"
+        "  speak() { return super.speak() + \" (woof)\"; }\n"
+        "  learn() { this.tricks += 1; return this; }\n}\n"
+        "val d = Dog(\"rex\");\nprint d.speak();\n"
+        "print d.learn().learn().tricks;\n",
+        // Literals, a duplicate key, and a field added later.
+        "val o = {a: 1, \"b\": 2, a: 3,};\nprint o.a + o.b;\n"
+        "o.c = o;\nprint o.c.c.a;\nprint o == o.c;\n",
+        // A closure capturing `this`, and fields called as functions.
+        "class Counter {\n  init() { this.n = 0; }\n"
+        "  next() {\n    this.n += 1;\n"
+        "    func get() { return this.n; }\n    return get;\n  }\n}\n"
+        "val c = Counter();\nc.next();\nprint c.next()();\n"
+        "func make(n) { return Counter(); }\nval box = {make: make};\n"
+        "print box.make(1).n;\n",
+        // One site seeing several shapes, in a loop and a function.
+        "class A { init() { this.v = 1; } }\n"
+        "class B { init() { this.w = 0; this.v = 2; } }\n"
+        "func read(o) { return o.v; }\nvar total = 0;\n"
+        "for (var i = 0; i < 20; i += 1) {\n"
+        "  total += read(A()) + read(B()) + read({v: 3}) + read({u: 0, v: 4});"
+        "\n}\nprint total;\n",
+        "class A {}\nprint A().nope;\n",
+        "val x = 3;\nprint x.y;\n",
+        "val x = 3;\nx.y = 1;\n",
+        "class A { init(x) {} }\nprint A();\n",
+        "class A {}\nval a = A();\na.f = 1;\nprint a.f(2);\n",
+        "val B = 3;\nclass A : B {}\n",
+        "class A { m() { return 1; } }\n"
+        "class B : A { m() { return super.nope(); } }\nB().m();\n",
+    };
+    expectEnginesAgree(scripts);
+
+    auto program = Thor::compile(scripts[0]);
+    EXPECT_EQ(program.run(program.inputs()).output,
+              "3\n9\n13\n<Point instance>\n<class Point>\n");
+    auto shapes = Thor::compile(scripts[4]);
+    EXPECT_EQ(shapes.run(shapes.inputs()).output, "200\n");
+    auto undefined = Thor::compile(scripts[5]);
+    EXPECT_NE(undefined.run(undefined.inputs())
+                  .diagnostics.find("Undefined property 'nope'."),
+              std::string::npos);
+    EXPECT_FALSE(Thor::compile("print this;\n").ok());
+    EXPECT_FALSE(Thor::compile("class A { init() { return 1; } }\n").ok());
+    EXPECT_FALSE(Thor::compile("class A : A {}\n").ok());
+    EXPECT_FALSE(Thor::compile("class A { m() { super.m(); } }\n").ok());
+}
+
+TEST(ObjectTest, InstancesShareShapesAndSitesHit) {
+    Runtime::Class point("Point", nullptr,
+                         {{"init", Runtime::Function{nullptr}}});
+    Runtime::Object a(point.shape(), &point);
+    Runtime::Object b(point.shape(), &point);
+    EXPECT_EQ(&a.shape(), &b.shape());
+    auto x = point.shape()->with("x");
+    a.reshape(x, Token::Literal{1.0});
+    b.reshape(point.shape()->with("x"), Token::Literal{2.0});
+    EXPECT_EQ(&a.shape(), &b.shape());
+    EXPECT_EQ(a.shape().find("x"), 0U);
+    EXPECT_EQ(a.shape().find("y"), Runtime::Shape::NONE);
+    // Literals have shapes of their own, as do other classes.
+    EXPECT_NE(Runtime::Shape::empty()->with("x").get(), x.get());
+    EXPECT_EQ(point.width(), 1U);
+
+    // Once warm, a site only misses for the shapes it has not seen.
+    const std::string script =
+        "class P {\n  init(x) { this.x = x; this.y = 0; }\n"
+        "  get() { return this.x; }\n}\nvar s = 0;\n"
+        "for (var i = 0; i < 1000; i += 1) {\n"
+        "  val p = P(i);\n  s += p.get() + p.y;\n  p.y = 1;\n}\nprint s;\n";
+    const Interpreter::Engine engines[] = {
+        Interpreter::Engine::TREE, Interpreter::Engine::CLOSURE,
+        Interpreter::Engine::VM};
+    for (auto engine : engines) {
+        auto program = Thor::compile(script, engine);
+        auto before  = Runtime::InlineCache::misses();
+        EXPECT_EQ(program.run(program.inputs()).output, "499500\n");
+        EXPECT_LT(Runtime::InlineCache::misses() - before, 20U);
+    }
+}
+
+TEST(ArrayTest, EnginesAgree) {
+    const std::vector<std::string> scripts = {
+        "val a = [1, 2, 3.5,];\nprint a;\nprint a.length + a.sum();\n"
+        "a[0] = 10;\na[1] += 5;\nprint a[0] + a[1];\nprint a * 2 - a;\n"
+        "print 1 / [1, 2, 4];\nprint \"a\" + a;\nprint a == a;\n"
+        "print a == [10, 7, 3.5];\n",
+        // Builtins, on numbers and on boxed values.
+        "val a = [5, 1, 4, 1];\nprint a.indexOf(1);\nprint a.indexOf(9);\n"
+        "print a.sort();\nprint a;\nprint a.push(\"x\");\nprint a;\n"
+        "print a.indexOf(\"x\");\nprint [\"b\", \"c\", \"a\"].sort();\n",
+        // `map` calling back into whichever engine runs, with closures.
+        "func f(x) { return x * 2 + 1; }\nprint [1, 2, 3].map(f);\n"
+        "func scale(k) {\n  func by(x) { return x * k; }\n"
+        "  return [1, 2].map(by);\n}\nprint scale(3);\n"
+        "var big = [];\nfor (var i = 0; i < 2000; i += 1) big.push(i % 5);\n"
+        "print big.map(f).sum();\nprint big.map(scale).length;\n",
+        // A loop that changes the array its invariant subtree reads.
+        "func grow() {\n  var a = [1];\n  var s = \"\";\n"
+        "  for (var i = 0; i < 3; i += 1) { a.push(i); s = s + (\"-\" + a); }"
+        "\n  return s;\n}\nprint grow();\n",
+        "val n = [[1], [2, 3]];\nn[0].push(n);\nprint n;\nprint n[1][1];\n",
+        "val a = [1, 2];\nprint a[2];\n",
+        "val a = [1, 2];\nprint a[0.5];\n",
+        "print 3[0];\n",
+        "val a = [1];\nprint a.sum;\n",
+        "val a = [1];\nprint a.sum(1);\n",
+        "print [1, 2] + [1];\n",
+        "print [1, nil].sum();\n",
+        "print [true, 1].sort();\n",
+    };
+    expectEnginesAgree(scripts);
+
+    auto program = Thor::compile(scripts[0]);
+    EXPECT_EQ(program.run(program.inputs()).output,
+              "[1, 2, 3.5]\n9.5\n17\n[10, 7, 3.5]\n[1, 0.5, 0.25]\n"
+              "a[10, 7, 3.5]\ntrue\nfalse\n");
+    auto builtins = Thor::compile(scripts[1]);
+    EXPECT_EQ(builtins.run(builtins.inputs()).output,
+              "1\n-1\n[1, 1, 4, 5]\n[1, 1, 4, 5]\n5\n[1, 1, 4, 5, x]\n4\n"
+              "[a, b, c]\n");
+    auto grow = Thor::compile(scripts[3]);
+    EXPECT_EQ(grow.run(grow.inputs()).output,
+              "-[1, 0]-[1, 0, 1]-[1, 0, 1, 2]\n");
+    auto range = Thor::compile(scripts[5]);
+    EXPECT_NE(range.run(range.inputs()).diagnostics.find("Index out of range."),
+              std::string::npos);
+    EXPECT_FALSE(Thor::compile("print [1, 2;\n").ok());
+}
+
+TEST(ArrayTest, PackedUntilBoxedAndKernelsMatchLoops) {
+    using Token::Literal;
+    Runtime::Array numbers{std::vector<Literal>{Literal{1.0}, Literal{2.0}}};
+    EXPECT_TRUE(numbers.packed());
+    numbers.set(0, Literal{5.0});
+    numbers.push(Literal{3.0});
+    EXPECT_TRUE(numbers.packed());
+    numbers.push(Literal{std::string("s")});
+    EXPECT_FALSE(numbers.packed());
+    EXPECT_EQ(numbers.describe(), "[5, 2, 3, s]");
+    numbers.set(3, Literal{4.0});
+    EXPECT_FALSE(numbers.packed());  // Boxed for good
+    EXPECT_EQ(numbers.get(3).asNumber(), 4.0);
+    auto program = Thor::compile("a.sort();\nprint a;\n");
+    auto inputs  = program.inputs();
+    inputs.set("a", Literal{numbers});
+    EXPECT_EQ(program.run(inputs).output, "[2, 3, 4, 5]\n");
+
+    // Lengths around the vector width, so tails are covered too.
+    auto op = opToken(Token::Type::STAR);
+    for (std::size_t n : {0U, 1U, 3U, 4U, 5U, 15U, 16U, 17U, 1000U}) {
+        std::vector<double> values(n);
+        double              total = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            values[i] = static_cast<double>(i % 13) - 6;
+            total += values[i];
+        }
+        Literal array{Runtime::Array{values}};
+        auto    product = Runtime::Array::arith(array, Literal{2.0}, op);
+        ASSERT_TRUE(product.packed());
+        for (std::size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(product.numbers()[i], values[i] * 2);
+        }
+        auto program = Thor::compile("print a.sum();\nprint a.indexOf(6);\n");
+        auto inputs  = program.inputs();
+        inputs.set("a", array);
+        auto found  = std::find(values.begin(), values.end(), 6.0);
+        auto index  = found == values.end() ? -1 : found - values.begin();
+        auto output = program.run(inputs).output;
+        EXPECT_EQ(output, Literal{total}.stringify() + "\n" +
+                              std::to_string(index) + "\n")
+            << n;
+    }
+}
+
+TEST(HashMapTest, MatchesUnorderedMapInInsertionOrder) {
+    Runtime::HashMap<std::uint64_t, std::uint64_t>   map;
+    std::unordered_map<std::uint64_t, std::uint64_t> expected;
+    std::vector<std::uint64_t>                       order;
+    std::uint64_t                                    state = 1;
+    for (int step = 0; step < 20000; ++step) {
+        state    = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        auto key = (state >> 33) % 2000;
+        if (state % 3 == 0) {
+            EXPECT_EQ(map.erase(key), expected.erase(key) == 1);
+            order.erase(std::remove(order.begin(), order.end(), key),
+                        order.end());
+        } else if (expected.count(key) == 0) {
+            EXPECT_TRUE(map.tryEmplace(key, key * 2).second);
+            expected.emplace(key, key * 2);
+            order.push_back(key);
+        } else {
+            EXPECT_FALSE(map.tryEmplace(key, 0U).second);
+        }
+    }
+    ASSERT_EQ(map.size(), expected.size());
+    for (const auto& [key, value] : expected) {
+        const auto* found = map.find(key);
+        ASSERT_NE(found, nullptr);
+        EXPECT_EQ(*found, value);
+    }
+    EXPECT_EQ(map.find(std::uint64_t{5000}), nullptr);
+    std::vector<std::uint64_t> keys;
+    for (const auto& entry : map) {
+        keys.push_back(entry.key);
+    }
+    EXPECT_EQ(keys, order);
+
+    // Keys of the same text are the same symbol.
+    auto one = Runtime::Symbol::intern("field");
+    EXPECT_EQ(one, Runtime::Symbol::intern(std::string("fie") + "ld"));
+    EXPECT_EQ(one.text(), "field");
+    EXPECT_FALSE(Runtime::Symbol::find("never interned anywhere"));
+}
+
+TEST(ObjectTest, ManyFieldsMakeADictionary) {
+    const std::vector<std::string> scripts = {
+        "val o = {a: 1, b: 2};\nprint o[\"a\"] + o[\"b\"];\n"
+        "o[\"c\"] = 3;\nprint o.c;\n"
+        "for (var i = 0; i < 40; i += 1) o[\"k\" + i] = i;\n"
+        "print o.k39 + o[\"k0\"] + o.a;\no.a = 10;\no[\"a\"] += 5;\n"
+        "print o.a;\n",
+        // A site reading both kinds of object, and methods of a dictionary.
+        "class P {\n  init() { this.x = 1; }\n  get() { return this.x; }\n}\n"
+        "val p = P();\n"
+        "for (var i = 0; i < 40; i += 1) p[\"f\" + i] = i * 2;\n"
+        "func read(q) { return q.x; }\nvar total = 0;\n"
+        "for (var i = 0; i < 10; i += 1) total += read(p) + read({x: 5});\n"
+        "print total + p.get() + p[\"get\"]();\n",
+        "val o = {a: 1};\nprint o[\"b\"];\n",
+        "val o = {a: 1};\nprint o[1];\n",
+        "val n = 1;\nn[\"a\"] = 2;\n",
+    };
+    expectEnginesAgree(scripts);
+    auto program = Thor::compile(scripts[0]);
+    EXPECT_EQ(program.run(program.inputs()).output, "3\n3\n40\n15\n");
+    auto methods = Thor::compile(scripts[1]);
+    EXPECT_EQ(methods.run(methods.inputs()).output, "62\n");
+    auto missing = Thor::compile(scripts[2]);
+    EXPECT_NE(missing.run(missing.inputs())
+                  .diagnostics.find("Undefined property 'b'."),
+              std::string::npos);
+
+    // Fields keep the order they were added in, across the move.
+    Runtime::Object object(Runtime::Shape::empty(), nullptr);
+    for (std::uint32_t i = 0; i < Runtime::Object::MAX_FIELDS; ++i) {
+        object.reshape(object.shape().with("f" + std::to_string(i)),
+                       Token::Literal{double(i)});
+    }
+    EXPECT_EQ(object.dictionary(), nullptr);
+    object.makeDictionary();
+    ASSERT_NE(object.dictionary(), nullptr);
+    EXPECT_EQ(&object.shape(), Runtime::Shape::dictionary().get());
+    double expected = 0;
+    for (const auto& [key, value] : *object.dictionary()) {
+        EXPECT_EQ(key.text(), "f" + std::to_string(int(expected)));
+        EXPECT_EQ(value.asNumber(), expected++);
+    }
+    EXPECT_EQ(expected, Runtime::Object::MAX_FIELDS);
+}
+
+TEST(HeapTest, CyclesAreFreedAndLiveValuesKept) {
+    auto& heap = Runtime::Heap::current();
+    heap.collect();
+    auto before = heap.stats().freed;
+    {
+        Runtime::Object object(Runtime::Shape::empty(), nullptr);
+        object.reshape(object.shape().with("self"), Token::Literal{object});
+        Runtime::Array array;
+        array.push(Token::Literal{array});
+    }
+    Runtime::Object kept(Runtime::Shape::empty(), nullptr);
+    kept.reshape(kept.shape().with("self"), Token::Literal{kept});
+    heap.collect();
+    EXPECT_EQ(heap.stats().freed - before, 2U);
+    EXPECT_EQ(kept.fields()[0].as<Runtime::Object>(), kept);
+    EXPECT_EQ(heap.stats().youngValues, 0U);
+
+    // Each call leaves a closure in the cell it captured and an object
+    // holding itself, wherever the frames and registers are.
+    const std::string script =
+        "func cycle(n) {\n  var f = nil;\n  func g() { return f; }\n"
+        "  f = g;\n  val o = {next: nil, n: n};\n  o.next = o;\n"
+        "  return o.next.n;\n}\nvar total = 0;\n"
+        "for (var i = 0; i < 100; i += 1) total += cycle(i);\n"
+        "val keep = {};\nkeep.self = keep;\nprint total;\n";
+    for (auto engine :
+         {Interpreter::Engine::TREE, Interpreter::Engine::CLOSURE,
+          Interpreter::Engine::TIERED, Interpreter::Engine::VM}) {
+        auto program = Thor::compile(script, engine);
+        ASSERT_TRUE(program.ok()) << program.diagnostics();
+        heap.collect();
+        before = heap.stats().freed;
+        // The outputs hold the globals until they go.
+        EXPECT_EQ(program.run(program.inputs()).output, "4950\n");
+        heap.collect();
+        EXPECT_EQ(heap.stats().freed - before, 301U);
+    }
+
+    EXPECT_FALSE(Runtime::parseHeapOptions("off")->enabled);
+    EXPECT_EQ(Runtime::parseHeapOptions("64,1.5")->nursery, 64U * 1024);
+    EXPECT_FALSE(Runtime::parseHeapOptions("64"));
+    EXPECT_FALSE(Runtime::parseHeapOptions("64,0.5"));
+}
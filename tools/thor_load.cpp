@@ -0,0 +1,170 @@
+// thor-load: load generator for `krypton --serve=<socket>`.
+//
+//     thor-load --socket=<path> [--clients=N] [--requests=N]
+//               [--distinct=N] [--script=<file>]
+//
+// Each client opens one connection and sends its requests back to back,
+// binding `n` to the request number. With --distinct above one, requests
+// cycle through that many different sources, so some miss the program
+// cache. Prints latency percentiles and throughput.
+
+#include "Thor/Protocol.hpp"
+
+#include <fmt/format.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    constexpr std::string_view USAGE =
+        "Usage: thor-load --socket=<path> [--clients=N] [--requests=N] "
+        "[--distinct=N] [--script=<file>]\n";
+
+    constexpr std::string_view DEFAULT_SCRIPT =
+        "val price = n * 1.25;\n"
+        "val bulk = n > 500;\n"
+        "print $\"order {n}: {price} bulk={bulk}\";\n"
+        "print price > 100 && bulk ? \"review\" : \"auto\";\n";
+
+    struct Options {
+        std::string socket;
+        std::string script{DEFAULT_SCRIPT};
+        std::size_t clients  = 4;
+        std::size_t requests = 1000;
+        std::size_t distinct = 1;
+    };
+
+    auto parseOptions(int argc, char* argv[], Options& options) -> bool {
+        auto value = [](std::string_view arg, std::string_view name,
+                        std::string& out) {
+            if (arg.rfind(name, 0) != 0) {
+                return false;
+            }
+            out = std::string(arg.substr(name.size()));
+            return true;
+        };
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            std::string      text;
+            if (value(arg, "--socket=", options.socket)) {
+                continue;
+            }
+            if (value(arg, "--script=", text)) {
+                std::ifstream     file(text);
+                std::stringstream source;
+                source << file.rdbuf();
+                options.script = source.str();
+            } else if (value(arg, "--clients=", text)) {
+                options.clients = std::strtoul(text.c_str(), nullptr, 10);
+            } else if (value(arg, "--requests=", text)) {
+                options.requests = std::strtoul(text.c_str(), nullptr, 10);
+            } else if (value(arg, "--distinct=", text)) {
+                options.distinct = std::strtoul(text.c_str(), nullptr, 10);
+            } else {
+                return false;
+            }
+        }
+        return !options.socket.empty() && options.clients > 0 &&
+               options.requests > 0 && options.distinct > 0;
+    }
+
+    // Sends `options.requests` requests on one connection and records the
+    // latency of each in nanoseconds. Returns the number that failed.
+    auto runClient(const Options& options, std::size_t client,
+                   std::vector<double>& latencies) -> std::size_t {
+        int fd = Protocol::connectTo(options.socket);
+        if (fd < 0) {
+            return options.requests;
+        }
+
+        std::vector<std::string> sources;
+        for (std::size_t i = 0; i < options.distinct; ++i) {
+            sources.push_back(i == 0 ? options.script
+                                     : fmt::format("print {};\n{}", i,
+                                                   options.script));
+        }
+
+        std::size_t       failed = 0;
+        Protocol::Request request;
+        for (std::size_t i = 0; i < options.requests; ++i) {
+            auto n         = client * options.requests + i;
+            request.text   = sources[n % sources.size()];
+            request.params = {{"n", Token::Literal{static_cast<double>(n)}}};
+
+            auto start    = Clock::now();
+            auto response = Protocol::call(fd, request);
+            latencies.push_back(
+                std::chrono::duration<double, std::nano>(Clock::now() - start)
+                    .count());
+            if (!response) {
+                failed += options.requests - i;
+                break;
+            }
+            failed += response->ok ? 0 : 1;
+        }
+        ::close(fd);
+        return failed;
+    }
+
+    auto percentile(const std::vector<double>& sorted, double p) -> double {
+        auto index = static_cast<std::size_t>(
+            p * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[index];
+    }
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fputs(USAGE.data(), stderr);
+        return 1;
+    }
+
+    std::vector<std::vector<double>> latencies(options.clients);
+    std::vector<std::size_t>         failures(options.clients);
+    std::vector<std::thread>         clients;
+    auto                             start = Clock::now();
+    for (std::size_t i = 0; i < options.clients; ++i) {
+        clients.emplace_back([&, i] {
+            failures[i] = runClient(options, i, latencies[i]);
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> all;
+    std::size_t         failed = 0;
+    for (std::size_t i = 0; i < options.clients; ++i) {
+        all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+        failed += failures[i];
+    }
+    if (all.empty()) {
+        fmt::print(stderr, "No responses from {}\n", options.socket);
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+
+    fmt::print("{} requests over {} clients, {} distinct sources, {} failed\n",
+               all.size(), options.clients, options.distinct, failed);
+    fmt::print("  p50 {:>9.1f} us\n", percentile(all, 0.50) / 1e3);
+    fmt::print("  p99 {:>9.1f} us\n", percentile(all, 0.99) / 1e3);
+    fmt::print("  max {:>9.1f} us\n", all.back() / 1e3);
+    fmt::print("  {:.0f} requests/s\n",
+               static_cast<double>(all.size()) / seconds);
+    return failed == 0 ? 0 : 1;
+}
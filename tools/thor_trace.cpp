@@ -0,0 +1,155 @@
+// thor-trace: decodes a binary trace written with `krypton --trace=<file>`.
+//
+//     thor-trace [--format=text|chrome] <file>
+//
+// `text` prints one event per line; `chrome` prints Chrome trace JSON for
+// chrome://tracing or Perfetto.
+
+#include "Thor/Tokens.hpp"
+#include "Thor/Trace.hpp"
+
+#include <fmt/format.h>
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace {
+
+    constexpr std::string_view USAGE =
+        "Usage: thor-trace [--format=text|chrome] <file>\n";
+
+    // Microseconds since the trace was opened.
+    auto micros(const Trace::TraceFile& file, const Trace::Record& record)
+        -> double {
+        auto ticks = static_cast<double>(record.ticks) -
+                     static_cast<double>(file.header.startTicks);
+        return ticks / file.header.ticksPerNano / 1e3;
+    }
+
+    auto text(const Trace::TraceFile& file, std::uint32_t id)
+        -> std::string_view {
+        auto found = file.strings.find(id);
+        return found == file.strings.end() ? std::string_view("?")
+                                           : std::string_view(found->second);
+    }
+
+    auto argument(const Trace::Record& record, bool first) -> std::string {
+        if (record.event == Trace::Event::TOKEN) {
+            if (first) {
+                return fmt::format("{}", static_cast<Token::Type>(record.a));
+            }
+            return fmt::format("{}:{}", record.b >> 32U,
+                               record.b & 0xFFFFFFFFU);
+        }
+        return fmt::format("{}", first ? std::uint64_t{record.a} : record.b);
+    }
+
+    auto escapeJson(std::string_view input) -> std::string {
+        std::string escaped;
+        for (char ch : input) {
+            switch (ch) {
+                case '"':
+                    escaped += "\\\"";
+                    break;
+                case '\\':
+                    escaped += "\\\\";
+                    break;
+                case '\n':
+                    escaped += "\\n";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(ch) < 0x20) {
+                        escaped += fmt::format("\\u{:04x}", ch);
+                    } else {
+                        escaped += ch;
+                    }
+            }
+        }
+        return escaped;
+    }
+
+    void printText(const Trace::TraceFile& file) {
+        for (const auto& record : file.records) {
+            const auto& info = Trace::eventInfo(record.event);
+            std::string line = fmt::format("{:>14.3f} us  T{:<3} {} {:<13}",
+                                           micros(file, record), record.thread,
+                                           info.phase, info.name);
+            if (info.argA != nullptr) {
+                line +=
+                    fmt::format(" {}={}", info.argA, argument(record, true));
+            }
+            if (info.argB != nullptr) {
+                line +=
+                    fmt::format(" {}={}", info.argB, argument(record, false));
+            }
+            if (info.hasText && record.text != 0) {
+                line += fmt::format(" \"{}\"", text(file, record.text));
+            }
+            line.erase(line.find_last_not_of(' ') + 1);
+            fmt::print("{}\n", line);
+        }
+    }
+
+    void printChrome(const Trace::TraceFile& file) {
+        fmt::print("{{\"traceEvents\":[\n");
+        auto first = true;
+        for (const auto& record : file.records) {
+            const auto& info = Trace::eventInfo(record.event);
+            std::string args;
+            auto        add = [&args](std::string_view key, std::string value) {
+                args += fmt::format("{}\"{}\":\"{}\"", args.empty() ? "" : ",",
+                                    key, escapeJson(value));
+            };
+            if (info.argA != nullptr) {
+                add(info.argA, argument(record, true));
+            }
+            if (info.argB != nullptr) {
+                add(info.argB, argument(record, false));
+            }
+            if (info.hasText && record.text != 0) {
+                add("text", std::string(text(file, record.text)));
+            }
+            fmt::print("{}{{\"name\":\"{}\",\"ph\":\"{}\",\"ts\":{:.3f},"
+                       "\"pid\":1,\"tid\":{}{},\"args\":{{{}}}}}",
+                       first ? "" : ",\n", info.name, info.phase,
+                       micros(file, record), record.thread,
+                       info.phase == 'i' ? ",\"s\":\"t\"" : "", args);
+            first = false;
+        }
+        fmt::print("\n]}}\n");
+    }
+}  // namespace
+
+auto main(int argc, char const* argv[]) -> int {
+    std::string_view format = "text";
+    std::string      path;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg.rfind("--format=", 0) == 0) {
+            format = arg.substr(std::string_view("--format=").size());
+        } else if (path.empty() && arg.rfind("--", 0) != 0) {
+            path = arg;
+        } else {
+            fmt::print(stderr, "{}", USAGE);
+            return 1;
+        }
+    }
+    if (path.empty() || (format != "text" && format != "chrome")) {
+        fmt::print(stderr, "{}", USAGE);
+        return 1;
+    }
+
+    try {
+        auto file = Trace::readFile(path);
+        if (format == "text") {
+            printText(file);
+        } else {
+            printChrome(file);
+        }
+    } catch (const std::exception& e) {
+        fmt::print(stderr, "thor-trace: {}\n", e.what());
+        return 1;
+    }
+    return 0;
+}